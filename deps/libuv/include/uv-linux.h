@@ -26,9 +26,14 @@
   uv__io_t inotify_read_watcher;                                              \
   void* inotify_watchers;                                                     \
   int inotify_fd;                                                             \
+  void* iou;                                                                  \
+  void* epoll_events;                                                         \
+  unsigned int epoll_nevents;                                                 \
+  unsigned int epoll_shrink;                                                  \
 
 #define UV_PLATFORM_FS_EVENT_FIELDS                                           \
   void* watchers[2];                                                          \
   int wd;                                                                     \
+  void* batch;                                                                \
 
 #endif /* UV_LINUX_H */
@@ -32,6 +32,8 @@ struct uv__work {
   void (*done)(struct uv__work *w, int status);
   struct uv_loop_s* loop;
   void* wq[2];
+  unsigned int kind;
+  uint64_t time;  /* When it was queued, how long it waited once started. */
 };
 
 #endif /* UV_THREADPOOL_H_ */
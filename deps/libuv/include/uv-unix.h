@@ -217,18 +217,37 @@ typedef struct {
   void* wq[2];                                                                \
   uv_mutex_t wq_mutex;                                                        \
   uv_async_t wq_async;                                                        \
+  void* wq_pool;                                                              \
+  void* wq_done;                                                              \
+  unsigned int wq_next;                                                       \
+  unsigned int fs_work_kind;                                                  \
+  uv_loop_metrics_t metrics;                                                  \
+  void* metrics_shared;                                                       \
+  unsigned int poll_budget;                                                   \
+  void* write_bufs_pool;                                                      \
+  unsigned int write_bufs_pooled;                                             \
+  void* write_iov;                                                            \
+  void* read_buf_pool;                                                        \
+  unsigned int read_buf_size;                                                 \
+  void* tcp_pool;                                                             \
+  void* write_pool;                                                           \
+  void* dns_resolver;                                                         \
+  unsigned int dns_cache_ttl;                                                 \
+  void* fs_poll_groups[2];                                                    \
   uv_rwlock_t cloexec_lock;                                                   \
   uv_handle_t* closing_handles;                                               \
   void* process_handles[2];                                                   \
   void* prepare_handles[2];                                                   \
   void* check_handles[2];                                                     \
   void* idle_handles[2];                                                      \
-  void* async_handles[2];                                                     \
+  void* async_ready[2];                                                       \
+  void* async_stack;                                                          \
   struct uv__async async_watcher;                                             \
   struct {                                                                    \
     void* min;                                                                \
     unsigned int nelts;                                                       \
   } timer_heap;                                                               \
+  void* timer_wheel;                                                          \
   uint64_t timer_counter;                                                     \
   uint64_t time;                                                              \
   int signal_pipefd[2];                                                       \
@@ -250,6 +269,7 @@ typedef struct {
   unsigned int nbufs;                                                         \
   int error;                                                                  \
   uv_buf_t bufsml[4];                                                         \
+  void* file_source;                                                          \
 
 #define UV_CONNECT_PRIVATE_FIELDS                                             \
   void* queue[2];                                                             \
@@ -310,8 +330,11 @@ typedef struct {
 
 #define UV_ASYNC_PRIVATE_FIELDS                                               \
   uv_async_cb async_cb;                                                       \
+  uv_async_msg_cb msg_cb;                                                     \
   void* queue[2];                                                             \
   int pending;                                                                \
+  void* next_pending;                                                         \
+  void* msgs;                                                                 \
 
 #define UV_TIMER_PRIVATE_FIELDS                                               \
   uv_timer_cb timer_cb;                                                       \
@@ -343,7 +343,21 @@ RB_HEAD(uv_timer_tree_s, uv_timer_s);
   /* Threadpool */                                                            \
   void* wq[2];                                                                \
   uv_mutex_t wq_mutex;                                                        \
-  uv_async_t wq_async;
+  uv_async_t wq_async;                                                        \
+  void* wq_pool;                                                              \
+  void* wq_done;                                                              \
+  unsigned int wq_next;                                                       \
+  unsigned int fs_work_kind;                                                  \
+  /* Counters reported by uv_loop_metrics() */                                \
+  uv_loop_metrics_t metrics;                                                  \
+  /* Read buffer pool, see uv_read_buf_alloc() */                            \
+  void* read_buf_pool;                                                        \
+  unsigned int read_buf_size;                                                 \
+  /* Free handles and reqs, see uv_tcp_alloc() and uv_write_req_alloc() */    \
+  void* tcp_pool;                                                             \
+  void* write_pool;                                                           \
+  /* uv_fs_poll_t handles grouped by interval, see src/fs-poll.c */           \
+  void* fs_poll_groups[2];
 
 #define UV_REQ_TYPE_PRIVATE                                                   \
   /* TODO: remove the req suffix */                                           \
@@ -534,6 +548,9 @@ RB_HEAD(uv_timer_tree_s, uv_timer_s);
 #define UV_ASYNC_PRIVATE_FIELDS                                               \
   struct uv_req_s async_req;                                                  \
   uv_async_cb async_cb;                                                       \
+  uv_async_msg_cb msg_cb;                                                     \
+  /* Lock-free stack of uv_async_msg_t, see uv_async_send_msg() */            \
+  void* volatile msgs;                                                        \
   /* char to avoid alignment issues */                                        \
   char volatile async_sent;
 
@@ -229,9 +229,22 @@ typedef struct uv_work_s uv_work_t;
 typedef struct uv_cpu_info_s uv_cpu_info_t;
 typedef struct uv_interface_address_s uv_interface_address_t;
 typedef struct uv_dirent_s uv_dirent_t;
+typedef struct uv_fs_walk_entry_s uv_fs_walk_entry_t;
+typedef struct uv_fs_event_change_s uv_fs_event_change_t;
+typedef struct uv_async_msg_s uv_async_msg_t;
 
 typedef enum {
-  UV_LOOP_BLOCK_SIGNAL
+  UV_LOOP_BLOCK_SIGNAL,
+  UV_LOOP_THREADPOOL_SIZE,
+  UV_LOOP_THREADPOOL_LIMIT,     /* Needs a private pool, see THREADPOOL_SIZE. */
+  UV_LOOP_FS_WORK_KIND,
+  UV_LOOP_USE_IO_URING,
+  UV_LOOP_POLL_BUDGET,
+  UV_LOOP_TIMER_WHEEL,
+  UV_LOOP_READ_BUF_SIZE,
+  UV_LOOP_DNS_CACHE,
+  UV_LOOP_DNS_RESOLVER,
+  UV_LOOP_METRICS
 } uv_loop_option;
 
 typedef enum {
@@ -240,6 +253,37 @@ typedef enum {
   UV_RUN_NOWAIT
 } uv_run_mode;
 
+typedef enum {
+  UV_PHASE_TIMERS,
+  UV_PHASE_PENDING,
+  UV_PHASE_IDLE,            /* Idle and prepare handles. */
+  UV_PHASE_IO,              /* I/O callbacks, not the time blocked polling. */
+  UV_PHASE_CHECK,
+  UV_PHASE_CLOSING,
+  UV_PHASE_MAX
+} uv_loop_phase;
+
+#define UV_LOOP_LAG_BUCKETS 20
+
+typedef struct {
+  uint64_t poll_ctl;        /* Changes made to the kernel's interest set. */
+  uint64_t poll_wakeups;    /* Times the poll for i/o returned. */
+  uint64_t poll_events;     /* Events it returned, summed over all wakeups. */
+  uint64_t poll_time;       /* Total nanoseconds spent blocked in it. */
+  uint64_t stream_writes;   /* Syscalls made to write to streams. */
+  uint64_t read_buf_allocs; /* Chunks the read buffer pool got from malloc. */
+  uint64_t pool_allocs;     /* Handles and reqs the pools got from malloc. */
+  uint64_t work_completed;  /* Thread pool requests that ran to completion. */
+  uint64_t work_wait_time;  /* Total nanoseconds they sat in the queue. */
+  /* Only maintained while enabled with UV_LOOP_METRICS. */
+  uint64_t iterations;
+  uint64_t phase_time[UV_PHASE_MAX];  /* Total nanoseconds per phase. */
+  uint64_t callbacks;       /* Callbacks run by the loop itself. */
+  uint64_t max_callbacks;   /* Most callbacks run by a single iteration. */
+  uint64_t max_callback_time;
+  uint64_t lag[UV_LOOP_LAG_BUCKETS];  /* Busy time per iteration, see docs. */
+} uv_loop_metrics_t;
+
 
 UV_EXTERN unsigned int uv_version(void);
 UV_EXTERN const char* uv_version_string(void);
@@ -272,6 +316,8 @@ UV_EXTERN void uv_loop_delete(uv_loop_t*);
 UV_EXTERN size_t uv_loop_size(void);
 UV_EXTERN int uv_loop_alive(const uv_loop_t* loop);
 UV_EXTERN int uv_loop_configure(uv_loop_t* loop, uv_loop_option option, ...);
+UV_EXTERN int uv_loop_metrics(const uv_loop_t* loop,
+                              uv_loop_metrics_t* metrics);
 
 UV_EXTERN int uv_run(uv_loop_t*, uv_run_mode mode);
 UV_EXTERN void uv_stop(uv_loop_t*);
@@ -300,6 +346,7 @@ typedef void (*uv_close_cb)(uv_handle_t* handle);
 typedef void (*uv_poll_cb)(uv_poll_t* handle, int status, int events);
 typedef void (*uv_timer_cb)(uv_timer_t* handle);
 typedef void (*uv_async_cb)(uv_async_t* handle);
+typedef void (*uv_async_msg_cb)(uv_async_t* handle, uv_async_msg_t* msg);
 typedef void (*uv_prepare_cb)(uv_prepare_t* handle);
 typedef void (*uv_check_cb)(uv_check_t* handle);
 typedef void (*uv_idle_cb)(uv_idle_t* handle);
@@ -347,6 +394,11 @@ typedef void (*uv_fs_event_cb)(uv_fs_event_t* handle,
                                int events,
                                int status);
 
+typedef void (*uv_fs_event_batch_cb)(uv_fs_event_t* handle,
+                                     const uv_fs_event_change_t* changes,
+                                     unsigned int nchanges,
+                                     int status);
+
 typedef void (*uv_fs_poll_cb)(uv_fs_poll_t* handle,
                               int status,
                               const uv_stat_t* prev,
@@ -462,6 +514,12 @@ UV_EXTERN int uv_read_start(uv_stream_t*,
                             uv_read_cb read_cb);
 UV_EXTERN int uv_read_stop(uv_stream_t*);
 
+UV_EXTERN void uv_read_buf_alloc(uv_handle_t* handle,
+                                 size_t suggested_size,
+                                 uv_buf_t* buf);
+UV_EXTERN void uv_read_buf_ref(char* base);
+UV_EXTERN void uv_read_buf_unref(char* base);
+
 UV_EXTERN int uv_write(uv_write_t* req,
                        uv_stream_t* handle,
                        const uv_buf_t bufs[],
@@ -476,6 +534,15 @@ UV_EXTERN int uv_write2(uv_write_t* req,
 UV_EXTERN int uv_try_write(uv_stream_t* handle,
                            const uv_buf_t bufs[],
                            unsigned int nbufs);
+UV_EXTERN int uv_stream_sendfile(uv_write_t* req,
+                                 uv_stream_t* handle,
+                                 uv_file file,
+                                 int64_t offset,
+                                 size_t length,
+                                 uv_write_cb cb);
+
+UV_EXTERN uv_write_t* uv_write_req_alloc(uv_loop_t* loop);
+UV_EXTERN void uv_write_req_free(uv_write_t* req);
 
 /* uv_write_t is a subclass of uv_req_t. */
 struct uv_write_s {
@@ -492,6 +559,10 @@ UV_EXTERN int uv_is_writable(const uv_stream_t* handle);
 
 UV_EXTERN int uv_stream_set_blocking(uv_stream_t* handle, int blocking);
 
+UV_EXTERN int uv_stream_set_write_coalescing(uv_stream_t* handle, int on);
+
+UV_EXTERN int uv_stream_set_read_batching(uv_stream_t* handle, int on);
+
 UV_EXTERN int uv_is_closing(const uv_handle_t* handle);
 
 
@@ -508,6 +579,7 @@ struct uv_tcp_s {
 
 UV_EXTERN int uv_tcp_init(uv_loop_t*, uv_tcp_t* handle);
 UV_EXTERN int uv_tcp_init_ex(uv_loop_t*, uv_tcp_t* handle, unsigned int flags);
+UV_EXTERN uv_tcp_t* uv_tcp_alloc(uv_loop_t*);
 UV_EXTERN int uv_tcp_open(uv_tcp_t* handle, uv_os_sock_t sock);
 UV_EXTERN int uv_tcp_nodelay(uv_tcp_t* handle, int enable);
 UV_EXTERN int uv_tcp_keepalive(uv_tcp_t* handle,
@@ -517,7 +589,13 @@ UV_EXTERN int uv_tcp_simultaneous_accepts(uv_tcp_t* handle, int enable);
 
 enum uv_tcp_flags {
   /* Used with uv_tcp_bind, when an IPv6 address is used. */
-  UV_TCP_IPV6ONLY = 1
+  UV_TCP_IPV6ONLY = 1,
+  /*
+   * Used with uv_tcp_bind. Sets SO_REUSEPORT so that several listeners, each
+   * on its own loop, can bind the same address and have the kernel spread
+   * incoming connections across them. Linux 3.9+ and FreeBSD 12+ only.
+   */
+  UV_TCP_REUSEPORT = 2
 };
 
 UV_EXTERN int uv_tcp_bind(uv_tcp_t* handle,
@@ -563,7 +641,31 @@ enum uv_udp_flags {
    * (provided they all set the flag) but only the last one to bind will receive
    * any traffic, in effect "stealing" the port from the previous listener.
    */
-  UV_UDP_REUSEADDR = 4
+  UV_UDP_REUSEADDR = 4,
+  /*
+   * Indicates that the message was received by recvmmsg() and that buf->base
+   * points into a larger buffer that must not be freed in this callback. The
+   * buffer itself is passed back with UV_UDP_MMSG_FREE when all its messages
+   * have been handed out. Used in uv_udp_recv_cb.
+   */
+  UV_UDP_MMSG_CHUNK = 8,
+  /*
+   * Indicates that the buffer filled by recvmmsg() may now be freed. nread is
+   * 0 and addr is NULL. Used in uv_udp_recv_cb.
+   */
+  UV_UDP_MMSG_FREE = 16,
+  /*
+   * Receive up to 20 datagrams per system call with recvmmsg() when the
+   * buffer returned by the alloc callback has room for more than one. Only
+   * has an effect on Linux. Used in uv_udp_init_ex.
+   */
+  UV_UDP_RECVMMSG = 256,
+  /*
+   * Queue the sends made during a loop iteration and flush them with
+   * sendmmsg() at the start of the next one. Only has an effect on Linux.
+   * Used in uv_udp_init_ex.
+   */
+  UV_UDP_SENDMMSG = 512
 };
 
 typedef void (*uv_udp_send_cb)(uv_udp_send_t* req, int status);
@@ -755,10 +857,21 @@ struct uv_async_s {
   UV_ASYNC_PRIVATE_FIELDS
 };
 
+/* A message for uv_async_send_msg(), owned by the caller. */
+struct uv_async_msg_s {
+  void* data;
+  /* private */
+  uv_async_msg_t* next_msg;
+};
+
 UV_EXTERN int uv_async_init(uv_loop_t*,
                             uv_async_t* async,
                             uv_async_cb async_cb);
+UV_EXTERN int uv_async_init_msg(uv_loop_t*,
+                                uv_async_t* async,
+                                uv_async_msg_cb msg_cb);
 UV_EXTERN int uv_async_send(uv_async_t* async);
+UV_EXTERN int uv_async_send_msg(uv_async_t* async, uv_async_msg_t* msg);
 
 
 /*
@@ -961,10 +1074,36 @@ struct uv_work_s {
   UV_WORK_PRIVATE_FIELDS
 };
 
+typedef enum {
+  UV_WORK_CPU = 0,
+  UV_WORK_FAST_IO,
+  UV_WORK_SLOW_IO,
+  UV_WORK_KIND_MAX
+} uv_work_kind;
+
+typedef struct {
+  uint64_t submitted;
+  uint64_t completed;
+  uint64_t cancelled;
+  uint64_t queued;
+  uint64_t running;
+  uint64_t wait_time;      /* Total nanoseconds spent in the queue. */
+  uint64_t max_wait_time;
+  unsigned int limit;
+} uv_work_stats_t;
+
 UV_EXTERN int uv_queue_work(uv_loop_t* loop,
                             uv_work_t* req,
                             uv_work_cb work_cb,
                             uv_after_work_cb after_work_cb);
+UV_EXTERN int uv_queue_work_ex(uv_loop_t* loop,
+                               uv_work_t* req,
+                               uv_work_kind kind,
+                               uv_work_cb work_cb,
+                               uv_after_work_cb after_work_cb);
+UV_EXTERN int uv_threadpool_stats(const uv_loop_t* loop,
+                                  uv_work_kind kind,
+                                  uv_work_stats_t* stats);
 
 UV_EXTERN int uv_cancel(uv_req_t* req);
 
@@ -1083,7 +1222,8 @@ typedef enum {
   UV_FS_SYMLINK,
   UV_FS_READLINK,
   UV_FS_CHOWN,
-  UV_FS_FCHOWN
+  UV_FS_FCHOWN,
+  UV_FS_WALK
 } uv_fs_type;
 
 /* uv_fs_t is a subclass of uv_req_t. */
@@ -1148,6 +1288,28 @@ UV_EXTERN int uv_fs_scandir(uv_loop_t* loop,
                             uv_fs_cb cb);
 UV_EXTERN int uv_fs_scandir_next(uv_fs_t* req,
                                  uv_dirent_t* ent);
+
+struct uv_fs_walk_entry_s {
+  const char* name;  /* Relative to the directory the walk started at. */
+  uv_dirent_type_t type;
+  uv_stat_t statbuf;
+};
+
+/*
+ * This flag can be used with uv_fs_walk() to only report the entry types,
+ * not their stat() information.
+ */
+#define UV_FS_WALK_NOSTAT          0x0001
+
+UV_EXTERN int uv_fs_walk(uv_loop_t* loop,
+                         uv_fs_t* req,
+                         const char* path,
+                         int flags,
+                         uv_fs_cb cb);
+UV_EXTERN int uv_fs_walk_continue(uv_loop_t* loop,
+                                  uv_fs_t* req,
+                                  uv_fs_cb cb);
+UV_EXTERN int uv_fs_walk_next(uv_fs_t* req, uv_fs_walk_entry_t* ent);
 UV_EXTERN int uv_fs_stat(uv_loop_t* loop,
                          uv_fs_t* req,
                          const char* path,
@@ -1334,6 +1496,11 @@ enum uv_fs_event_flags {
   UV_FS_EVENT_RECURSIVE = 4
 };
 
+struct uv_fs_event_change_s {
+  const char* filename;
+  int events;
+};
+
 
 UV_EXTERN int uv_fs_event_init(uv_loop_t* loop, uv_fs_event_t* handle);
 UV_EXTERN int uv_fs_event_start(uv_fs_event_t* handle,
@@ -1341,6 +1508,9 @@ UV_EXTERN int uv_fs_event_start(uv_fs_event_t* handle,
                                 const char* path,
                                 unsigned int flags);
 UV_EXTERN int uv_fs_event_stop(uv_fs_event_t* handle);
+UV_EXTERN int uv_fs_event_set_batching(uv_fs_event_t* handle,
+                                       uint64_t window,
+                                       uv_fs_event_batch_cb cb);
 UV_EXTERN int uv_fs_event_getpath(uv_fs_event_t* handle,
                                   char* buffer,
                                   size_t* size);
@@ -1420,6 +1590,11 @@ UV_EXTERN int uv_thread_create(uv_thread_t* tid, uv_thread_cb entry, void* arg);
 UV_EXTERN uv_thread_t uv_thread_self(void);
 UV_EXTERN int uv_thread_join(uv_thread_t *tid);
 UV_EXTERN int uv_thread_equal(const uv_thread_t* t1, const uv_thread_t* t2);
+UV_EXTERN int uv_cpumask_size(void);
+UV_EXTERN int uv_thread_setaffinity(uv_thread_t* tid,
+                                    char* cpumask,
+                                    char* oldmask,
+                                    size_t mask_size);
 
 /* The presence of these unions force similar struct layout. */
 #define XX(_, name) uv_ ## name ## _t name;
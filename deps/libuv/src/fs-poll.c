@@ -18,7 +18,6 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  */
-
 #include "uv.h"
 #include "uv-common.h"
 
@@ -26,23 +25,97 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__linux__)
+# include <limits.h>
+# include <sys/stat.h>
+# include <sys/vfs.h>
+#endif
+
+/* All handles that poll at the same interval share a poll_group: one timer
+ * and one threadpool request that stats every path that is due, instead of
+ * a timer and a uv_fs_stat() request per handle.
+ *
+ * On Linux, a path that lives on a local file system is additionally watched
+ * with inotify once it has been stat'ed successfully. A watched path is only
+ * stat'ed again when an event arrives, so an idle path costs nothing. Paths
+ * that can't be watched (remote or pseudo file systems, symlinks, missing
+ * files, watch limit reached) stay in the sweep.
+ *
+ * Every directory on the way to a watched path is watched as well, so that
+ * renaming, removing or replacing any of them marks the path dirty; the watch
+ * on the path itself never hears about that. Paths with a symlink in them
+ * stay in the sweep for the same reason as symlinks do.
+ */
+
+enum {
+  POLL_SWEEP,       /* Stat on every tick. */
+  POLL_UNWATCHABLE, /* Stat on every tick, don't try to watch. */
+  POLL_WATCHED      /* Stat when an event marked the path dirty. */
+};
+
+struct poll_group {
+  QUEUE member;        /* In loop->fs_poll_groups. */
+  QUEUE ctxs;          /* Started handles. */
+  QUEUE sweep;         /* Contexts being stat'ed by work_req. */
+  unsigned int interval;
+  unsigned int nctxs;
+  unsigned int nfresh; /* Contexts that still need their first stat. */
+  int busy;
+  uint64_t due;
+  uv_loop_t* loop;
+  uv_timer_t timer_handle;
+  uv_work_t work_req;
+};
+
 struct poll_ctx {
   uv_fs_poll_t* parent_handle; /* NULL if parent has been stopped or closed */
+  struct poll_group* group;
+  QUEUE member;
+  QUEUE sweep_member;
   int busy_polling;
-  unsigned int interval;
-  uint64_t start_time;
-  uv_loop_t* loop;
+  int in_sweep;
+  int fresh;
+  int dirty;
+  int state;
+  int probe;
+  int watchable;
+  int result;
   uv_fs_poll_cb poll_cb;
-  uv_timer_t timer_handle;
-  uv_fs_t fs_req; /* TODO(bnoordhuis) mark fs_req internal */
   uv_stat_t statbuf;
+  uv_stat_t sweep_statbuf;
+#if defined(__linux__)
+  int event_init;
+  unsigned int ndirs;
+  unsigned int nclosing;
+  uv_fs_event_t* dir_handles;  /* One per directory in path, see poll_dir(). */
+  uv_fs_event_t event_handle;
+#endif
   char path[1]; /* variable length */
 };
 
 static int statbuf_eq(const uv_stat_t* a, const uv_stat_t* b);
-static void poll_cb(uv_fs_t* req);
+static struct poll_group* group_get(uv_loop_t* loop, unsigned int interval);
+static void group_schedule(struct poll_group* group);
+static void group_close_cb(uv_handle_t* handle);
 static void timer_cb(uv_timer_t* timer);
-static void timer_close_cb(uv_handle_t* handle);
+static void sweep_work(uv_work_t* req);
+static void sweep_done(uv_work_t* req, int status);
+static void poll_report(struct poll_ctx* ctx);
+static void poll_ctx_free(struct poll_ctx* ctx);
+
+#if defined(__linux__)
+static size_t poll_dir(const char* path, size_t pos);
+static int poll_watchable(const char* path);
+static int poll_init_watch(struct poll_ctx* ctx);
+static int poll_start_watch(struct poll_ctx* ctx);
+static void poll_stop_watch(struct poll_ctx* ctx);
+static void poll_update_watch(struct poll_ctx* ctx, int moved);
+static void poll_event_cb(uv_fs_event_t* handle,
+                          const char* filename,
+                          int events,
+                          int status);
+static void poll_event_close_cb(uv_handle_t* handle);
+#endif
 
 static uv_stat_t zero_statbuf;
 
@@ -57,10 +130,10 @@ int uv_fs_poll_start(uv_fs_poll_t* handle,
                      uv_fs_poll_cb cb,
                      const char* path,
                      unsigned int interval) {
+  struct poll_group* group;
   struct poll_ctx* ctx;
   uv_loop_t* loop;
   size_t len;
-  int err;
 
   if (uv__is_active(handle))
     return 0;
@@ -72,36 +145,33 @@ int uv_fs_poll_start(uv_fs_poll_t* handle,
   if (ctx == NULL)
     return UV_ENOMEM;
 
-  ctx->loop = loop;
+  group = group_get(loop, interval ? interval : 1);
+  if (group == NULL) {
+    uv__free(ctx);
+    return UV_ENOMEM;
+  }
+
   ctx->poll_cb = cb;
-  ctx->interval = interval ? interval : 1;
-  ctx->start_time = uv_now(loop);
   ctx->parent_handle = handle;
+  ctx->group = group;
+  ctx->state = POLL_SWEEP;
+  ctx->fresh = 1;
   memcpy(ctx->path, path, len + 1);
 
-  err = uv_timer_init(loop, &ctx->timer_handle);
-  if (err < 0)
-    goto error;
-
-  ctx->timer_handle.flags |= UV__HANDLE_INTERNAL;
-  uv__handle_unref(&ctx->timer_handle);
-
-  err = uv_fs_stat(loop, &ctx->fs_req, ctx->path, poll_cb);
-  if (err < 0)
-    goto error;
+  QUEUE_INSERT_TAIL(&group->ctxs, &ctx->member);
+  group->nctxs++;
+  group->nfresh++;
+  group_schedule(group);
 
   handle->poll_ctx = ctx;
   uv__handle_start(handle);
 
   return 0;
-
-error:
-  uv__free(ctx);
-  return err;
 }
 
 
 int uv_fs_poll_stop(uv_fs_poll_t* handle) {
+  struct poll_group* group;
   struct poll_ctx* ctx;
 
   if (!uv__is_active(handle))
@@ -113,11 +183,21 @@ int uv_fs_poll_stop(uv_fs_poll_t* handle) {
   ctx->parent_handle = NULL;
   handle->poll_ctx = NULL;
 
-  /* Close the timer if it's active. If it's inactive, there's a stat request
-   * in progress and poll_cb will take care of the cleanup.
-   */
-  if (uv__is_active(&ctx->timer_handle))
-    uv_close((uv_handle_t*)&ctx->timer_handle, timer_close_cb);
+  group = ctx->group;
+  QUEUE_REMOVE(&ctx->member);
+  group->nctxs--;
+  if (ctx->fresh)
+    group->nfresh--;
+
+  /* A context that is being stat'ed is freed by sweep_done(). */
+  if (!ctx->in_sweep)
+    poll_ctx_free(ctx);
+
+  /* Likewise for the group, sweep_done() closes it when it's empty. */
+  if (group->nctxs == 0 && !group->busy) {
+    QUEUE_REMOVE(&group->member);
+    uv_close((uv_handle_t*)&group->timer_handle, group_close_cb);
+  }
 
   uv__handle_stop(handle);
 
@@ -155,44 +235,209 @@ void uv__fs_poll_close(uv_fs_poll_t* handle) {
 }
 
 
+static struct poll_group* group_get(uv_loop_t* loop, unsigned int interval) {
+  struct poll_group* group;
+  QUEUE* q;
+
+  QUEUE_FOREACH(q, &loop->fs_poll_groups) {
+    group = QUEUE_DATA(q, struct poll_group, member);
+    if (group->interval == interval)
+      return group;
+  }
+
+  group = uv__calloc(1, sizeof(*group));
+  if (group == NULL)
+    return NULL;
+
+  group->loop = loop;
+  group->interval = interval;
+  group->due = uv_now(loop);
+  QUEUE_INIT(&group->ctxs);
+  QUEUE_INIT(&group->sweep);
+
+  if (uv_timer_init(loop, &group->timer_handle))
+    abort();
+
+  group->timer_handle.flags |= UV__HANDLE_INTERNAL;
+  uv__handle_unref(&group->timer_handle);
+
+  QUEUE_INSERT_TAIL(&loop->fs_poll_groups, &group->member);
+
+  return group;
+}
+
+
+/* Arms the timer for the next sweep. Newly started handles are stat'ed right
+ * away, everything else waits for the next tick. Like the per-handle poller
+ * this replaces, a sweep that overran the interval skips the missed ticks.
+ */
+static void group_schedule(struct poll_group* group) {
+  uint64_t timeout;
+  uint64_t now;
+
+  if (group->busy)
+    return;
+
+  now = uv_now(group->loop);
+  if (now >= group->due)
+    group->due += ((now - group->due) / group->interval + 1) * group->interval;
+
+  timeout = group->due - now;
+  if (group->nfresh > 0)
+    timeout = 0;
+
+  if (uv_timer_start(&group->timer_handle, timer_cb, timeout, 0))
+    abort();
+}
+
+
+static void group_close_cb(uv_handle_t* handle) {
+  uv__free(container_of(handle, struct poll_group, timer_handle));
+}
+
+
 static void timer_cb(uv_timer_t* timer) {
+  struct poll_group* group;
   struct poll_ctx* ctx;
+  uv_loop_t* loop;
+  int tick;
+  QUEUE* q;
+
+  group = container_of(timer, struct poll_group, timer_handle);
+  loop = group->loop;
+  assert(!group->busy);
+  assert(QUEUE_EMPTY(&group->sweep));
+
+  tick = uv_now(loop) >= group->due;
+  if (tick)
+    group->due = uv_now(loop) + group->interval;
+
+  QUEUE_FOREACH(q, &group->ctxs) {
+    ctx = QUEUE_DATA(q, struct poll_ctx, member);
+
+    if (!ctx->fresh) {
+      if (!tick)
+        continue;
+      if (ctx->state == POLL_WATCHED && !ctx->dirty)
+        continue;
+    }
 
-  ctx = container_of(timer, struct poll_ctx, timer_handle);
-  assert(ctx->parent_handle != NULL);
-  assert(ctx->parent_handle->poll_ctx == ctx);
-  ctx->start_time = uv_now(ctx->loop);
+    if (ctx->fresh)
+      group->nfresh--;
 
-  if (uv_fs_stat(ctx->loop, &ctx->fs_req, ctx->path, poll_cb))
+    ctx->fresh = 0;
+    ctx->dirty = 0;
+    ctx->probe = (ctx->state == POLL_SWEEP);
+    ctx->in_sweep = 1;
+    QUEUE_INSERT_TAIL(&group->sweep, &ctx->sweep_member);
+  }
+
+  if (QUEUE_EMPTY(&group->sweep)) {
+    group_schedule(group);
+    return;
+  }
+
+  group->busy = 1;
+  if (uv_queue_work_ex(loop,
+                       &group->work_req,
+                       loop->fs_work_kind,
+                       sweep_work,
+                       sweep_done)) {
     abort();
+  }
 }
 
 
-static void poll_cb(uv_fs_t* req) {
-  uv_stat_t* statbuf;
+/* Runs on the threadpool. The loop thread doesn't touch the sweep queue or
+ * the fields below while the request is in flight.
+ */
+static void sweep_work(uv_work_t* req) {
+  struct poll_group* group;
+  struct poll_ctx* ctx;
+  uv_fs_t fs_req;
+  QUEUE* q;
+
+  group = container_of(req, struct poll_group, work_req);
+
+  QUEUE_FOREACH(q, &group->sweep) {
+    ctx = QUEUE_DATA(q, struct poll_ctx, sweep_member);
+    ctx->result = uv_fs_stat(group->loop, &fs_req, ctx->path, NULL);
+    if (ctx->result == 0)
+      ctx->sweep_statbuf = fs_req.statbuf;
+    uv_fs_req_cleanup(&fs_req);
+
+#if defined(__linux__)
+    if (ctx->probe && ctx->result == 0)
+      ctx->watchable = poll_watchable(ctx->path);
+#endif
+  }
+}
+
+
+static void sweep_done(uv_work_t* req, int status) {
+  struct poll_group* group;
   struct poll_ctx* ctx;
-  uint64_t interval;
+  int moved;
+  QUEUE* q;
+
+  group = container_of(req, struct poll_group, work_req);
+  assert(status == 0);
+
+  while (!QUEUE_EMPTY(&group->sweep)) {
+    q = QUEUE_HEAD(&group->sweep);
+    QUEUE_REMOVE(q);
+    ctx = QUEUE_DATA(q, struct poll_ctx, sweep_member);
+
+    if (ctx->parent_handle != NULL) {
+      moved = ctx->result != 0 ||
+              ctx->statbuf.st_ino != ctx->sweep_statbuf.st_ino ||
+              ctx->statbuf.st_dev != ctx->sweep_statbuf.st_dev;
+
+      /* The callback may stop this or any other handle. Contexts that are
+       * still on the sweep queue are kept alive until they're dequeued.
+       */
+      poll_report(ctx);
+
+#if defined(__linux__)
+      if (ctx->parent_handle != NULL)
+        poll_update_watch(ctx, moved);
+#else
+      (void) moved;
+#endif
+    }
 
-  ctx = container_of(req, struct poll_ctx, fs_req);
+    ctx->in_sweep = 0;
+    if (ctx->parent_handle == NULL)
+      poll_ctx_free(ctx);
+  }
+
+  group->busy = 0;
 
-  if (ctx->parent_handle == NULL) { /* handle has been stopped or closed */
-    uv_close((uv_handle_t*)&ctx->timer_handle, timer_close_cb);
-    uv_fs_req_cleanup(req);
+  if (group->nctxs == 0) {
+    QUEUE_REMOVE(&group->member);
+    uv_close((uv_handle_t*)&group->timer_handle, group_close_cb);
     return;
   }
 
-  if (req->result != 0) {
-    if (ctx->busy_polling != req->result) {
+  group_schedule(group);
+}
+
+
+static void poll_report(struct poll_ctx* ctx) {
+  uv_stat_t* statbuf;
+
+  if (ctx->result != 0) {
+    if (ctx->busy_polling != ctx->result) {
       ctx->poll_cb(ctx->parent_handle,
-                   req->result,
+                   ctx->result,
                    &ctx->statbuf,
                    &zero_statbuf);
-      ctx->busy_polling = req->result;
+      ctx->busy_polling = ctx->result;
     }
-    goto out;
+    return;
   }
 
-  statbuf = &req->statbuf;
+  statbuf = &ctx->sweep_statbuf;
 
   if (ctx->busy_polling != 0)
     if (ctx->busy_polling < 0 || !statbuf_eq(&ctx->statbuf, statbuf))
@@ -200,26 +445,22 @@ static void poll_cb(uv_fs_t* req) {
 
   ctx->statbuf = *statbuf;
   ctx->busy_polling = 1;
+}
+
 
-out:
-  uv_fs_req_cleanup(req);
+static void poll_ctx_free(struct poll_ctx* ctx) {
+#if defined(__linux__)
+  unsigned int i;
 
-  if (ctx->parent_handle == NULL) { /* handle has been stopped by callback */
-    uv_close((uv_handle_t*)&ctx->timer_handle, timer_close_cb);
+  if (ctx->event_init) {
+    ctx->nclosing = 1 + ctx->ndirs;
+    uv_close((uv_handle_t*)&ctx->event_handle, poll_event_close_cb);
+    for (i = 0; i < ctx->ndirs; i++)
+      uv_close((uv_handle_t*)&ctx->dir_handles[i], poll_event_close_cb);
     return;
   }
-
-  /* Reschedule timer, subtract the delay from doing the stat(). */
-  interval = ctx->interval;
-  interval -= (uv_now(ctx->loop) - ctx->start_time) % interval;
-
-  if (uv_timer_start(&ctx->timer_handle, timer_cb, interval, 0))
-    abort();
-}
-
-
-static void timer_close_cb(uv_handle_t* handle) {
-  uv__free(container_of(handle, struct poll_ctx, timer_handle));
+#endif
+  uv__free(ctx);
 }
 
 
@@ -241,6 +482,221 @@ static int statbuf_eq(const uv_stat_t* a, const uv_stat_t* b) {
 }
 
 
+#if defined(__linux__)
+
+/* Returns the length of the next directory in path after the first pos
+ * characters, e.g. 2 and then 4 for "/a/b/c", or 0 when there is none left.
+ * The root directory can't be replaced and isn't reported.
+ */
+static size_t poll_dir(const char* path, size_t pos) {
+  size_t i;
+
+  for (i = pos + 1; path[i] != '\0' && path[i + 1] != '\0'; i++)
+    if (path[i] == '/' && path[i - 1] != '/')
+      return i;
+
+  return 0;
+}
+
+
+/* Called on the threadpool. inotify only sees changes made through the local
+ * kernel, so network and cluster file systems keep being polled. The same
+ * goes for pseudo file systems whose contents change without events, and for
+ * symlinks, because a watch follows the link and misses it being repointed.
+ */
+static int poll_watchable(const char* path) {
+  char buf[PATH_MAX];
+  struct statfs s;
+  struct stat st;
+  size_t len;
+  size_t end;
+
+  len = strlen(path);
+  if (len >= sizeof(buf))
+    return 0;
+
+  if (lstat(path, &st))
+    return 0;
+
+  if (!S_ISREG(st.st_mode) && !S_ISDIR(st.st_mode))
+    return 0;
+
+  memcpy(buf, path, len + 1);
+  for (end = poll_dir(path, 0); end != 0; end = poll_dir(path, end)) {
+    buf[end] = '\0';
+    if (lstat(buf, &st) || S_ISLNK(st.st_mode))
+      return 0;
+    buf[end] = '/';
+  }
+
+  if (statfs(path, &s))
+    return 0;
+
+  switch ((unsigned long) s.f_type) {
+    case 0x6969:      /* NFS_SUPER_MAGIC */
+    case 0x517B:      /* SMB_SUPER_MAGIC */
+    case 0xFE534D42:  /* SMB2_MAGIC_NUMBER */
+    case 0xFF534D42:  /* CIFS_MAGIC_NUMBER */
+    case 0x65735546:  /* FUSE_SUPER_MAGIC */
+    case 0x01021997:  /* V9FS_MAGIC */
+    case 0x5346414F:  /* AFS_SUPER_MAGIC */
+    case 0x6B414653:  /* AFS_FS_MAGIC */
+    case 0x73757245:  /* CODA_SUPER_MAGIC */
+    case 0x00C36400:  /* CEPH_SUPER_MAGIC */
+    case 0x01161970:  /* GFS2_MAGIC */
+    case 0x7461636F:  /* OCFS2_SUPER_MAGIC */
+    case 0x0BD00BD0:  /* LUSTRE_SUPER_MAGIC */
+    case 0x9FA0:      /* PROC_SUPER_MAGIC */
+    case 0x62656572:  /* SYSFS_MAGIC */
+    case 0x64626720:  /* DEBUGFS_MAGIC */
+    case 0x27E0EB:    /* CGROUP_SUPER_MAGIC */
+    case 0x63677270:  /* CGROUP2_SUPER_MAGIC */
+      return 0;
+  }
+
+  return 1;
+}
+
+
+static int poll_init_watch(struct poll_ctx* ctx) {
+  uv_loop_t* loop;
+  unsigned int i;
+  size_t end;
+
+  for (end = poll_dir(ctx->path, 0); end != 0; end = poll_dir(ctx->path, end))
+    ctx->ndirs++;
+
+  if (ctx->ndirs > 0) {
+    ctx->dir_handles = uv__calloc(ctx->ndirs, sizeof(ctx->dir_handles[0]));
+    if (ctx->dir_handles == NULL) {
+      ctx->ndirs = 0;
+      return UV_ENOMEM;
+    }
+  }
+
+  loop = ctx->group->loop;
+
+  uv_fs_event_init(loop, &ctx->event_handle);
+  ctx->event_handle.flags |= UV__HANDLE_INTERNAL;
+  ctx->event_handle.data = ctx;
+  uv__handle_unref(&ctx->event_handle);
+
+  for (i = 0; i < ctx->ndirs; i++) {
+    uv_fs_event_init(loop, &ctx->dir_handles[i]);
+    ctx->dir_handles[i].flags |= UV__HANDLE_INTERNAL;
+    ctx->dir_handles[i].data = ctx;
+    uv__handle_unref(&ctx->dir_handles[i]);
+  }
+
+  ctx->event_init = 1;
+  return 0;
+}
+
+
+static int poll_start_watch(struct poll_ctx* ctx) {
+  char buf[PATH_MAX];
+  unsigned int i;
+  size_t end;
+  int err;
+
+  err = uv_fs_event_start(&ctx->event_handle, poll_event_cb, ctx->path, 0);
+  if (err)
+    return err;
+
+  /* poll_watchable() made sure that the path fits. */
+  memcpy(buf, ctx->path, strlen(ctx->path) + 1);
+  i = 0;
+  for (end = poll_dir(buf, 0); end != 0; end = poll_dir(buf, end)) {
+    buf[end] = '\0';
+    err = uv_fs_event_start(&ctx->dir_handles[i++], poll_event_cb, buf, 0);
+    buf[end] = '/';
+    if (err)
+      return err;
+  }
+
+  return 0;
+}
+
+
+static void poll_stop_watch(struct poll_ctx* ctx) {
+  unsigned int i;
+
+  uv_fs_event_stop(&ctx->event_handle);
+  for (i = 0; i < ctx->ndirs; i++)
+    uv_fs_event_stop(&ctx->dir_handles[i]);
+}
+
+
+/* Starts or drops the inotify watches after a stat. The watch is tied to an
+ * inode, so it's dropped when the path disappears or now refers to another
+ * file, and the path goes back into the sweep until it can be watched again.
+ */
+static void poll_update_watch(struct poll_ctx* ctx, int moved) {
+  if (ctx->state == POLL_WATCHED) {
+    if (moved) {
+      poll_stop_watch(ctx);
+      ctx->state = POLL_SWEEP; /* Probed again on the next tick. */
+    }
+    return;
+  }
+
+  if (ctx->state == POLL_UNWATCHABLE) {
+    if (moved)
+      ctx->state = POLL_SWEEP;
+    return;
+  }
+
+  if (ctx->result != 0)
+    return;
+
+  if (!ctx->watchable) {
+    ctx->state = POLL_UNWATCHABLE;
+    return;
+  }
+
+  if (!ctx->event_init && poll_init_watch(ctx)) {
+    ctx->state = POLL_UNWATCHABLE;
+    return;
+  }
+
+  /* Typically fails with ENOSPC when fs.inotify.max_user_watches is hit. */
+  if (poll_start_watch(ctx)) {
+    poll_stop_watch(ctx);
+    ctx->state = POLL_UNWATCHABLE;
+    return;
+  }
+
+  /* The path may have changed between the stat and the watch. */
+  ctx->state = POLL_WATCHED;
+  ctx->dirty = 1;
+}
+
+
+static void poll_event_cb(uv_fs_event_t* handle,
+                          const char* filename,
+                          int events,
+                          int status) {
+  struct poll_ctx* ctx;
+
+  ctx = handle->data;
+  ctx->dirty = 1;
+}
+
+
+static void poll_event_close_cb(uv_handle_t* handle) {
+  struct poll_ctx* ctx;
+
+  ctx = handle->data;
+  if (--ctx->nclosing > 0)
+    return;
+
+  uv__free(ctx->dir_handles);
+  uv__free(ctx);
+}
+
+#endif /* __linux__ */
+
+
 #if defined(_WIN32)
 
 #include "win/internal.h"
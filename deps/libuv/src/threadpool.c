@@ -23,6 +23,9 @@
 
 #if !defined(_WIN32)
 # include "unix/internal.h"
+# include "unix/atomic-ops.h"
+# define uv__cmpxchgp(ptr, oldval, newval)                                    \
+    ((void*) cmpxchgl((long*) (ptr), (long) (oldval), (long) (newval)))
 #else
 # include "win/req-inl.h"
 /* TODO(saghul): unify internal req functions */
@@ -35,21 +38,67 @@ static void uv__req_init(uv_loop_t* loop,
 }
 # define uv__req_init(loop, req, type) \
     uv__req_init((loop), (uv_req_t*)(req), (type))
+# define uv__cmpxchgp(ptr, oldval, newval)                                    \
+    InterlockedCompareExchangePointer((ptr), (newval), (oldval))
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 
 #define MAX_THREADPOOL_SIZE 128
 
+/* Every worker owns a queue of pending requests per kind of work (a lane).
+ * Requests are posted to an idle worker when there is one and otherwise
+ * distributed round-robin; workers that run out of work steal from their
+ * siblings before going to sleep. Workers visit the lanes round-robin and
+ * skip lanes that are at their concurrency limit, so that e.g. slow DNS
+ * lookups can't occupy all threads while cheap stat() calls wait.
+ *
+ * Finished requests are pushed onto the loop's lock-free wq_done stack. Only
+ * the push that finds the stack empty calls uv_async_send(), the loop picks
+ * up everything that was pushed in the meantime in one go.
+ *
+ * Lock ordering: worker mutexes are taken in array order, then either the
+ * pool's lane_mutex or the loop's wq_mutex. The idle_mutex is never held
+ * together with any other lock.
+ */
+struct uv__lane_stats {
+  uint64_t submitted;         /* Guarded by the owning worker's mutex. */
+  uint64_t started;           /* Only written by the worker itself. */
+  uint64_t completed;
+  uint64_t cancelled;         /* Written with all worker mutexes held. */
+  uint64_t wait_time;
+  uint64_t max_wait_time;
+};
+
+struct uv__worker {
+  uv_mutex_t mutex;
+  uv_cond_t cond;
+  QUEUE queue[UV_WORK_KIND_MAX];  /* Pending work, guarded by mutex. */
+  unsigned int next_kind;     /* Lane to look at first. */
+  int slot;                   /* Lane slot held by the running request. */
+  int wakeup;
+  void* idle_queue[2];        /* Guarded by the pool's idle_mutex. */
+  struct uv__threadpool* pool;
+  struct uv__lane_stats stats[UV_WORK_KIND_MAX];
+  uv_thread_t thread;
+};
+
+struct uv__threadpool {
+  struct uv__worker* workers;
+  unsigned int nworkers;
+  uv_mutex_t idle_mutex;
+  void* idle_workers[2];
+  volatile unsigned int nidle;
+  volatile int exiting;
+  uv_mutex_t lane_mutex;
+  volatile unsigned int limit[UV_WORK_KIND_MAX];
+  volatile unsigned int running[UV_WORK_KIND_MAX];  /* Limited lanes only. */
+};
+
 static uv_once_t once = UV_ONCE_INIT;
-static uv_cond_t cond;
-static uv_mutex_t mutex;
-static unsigned int idle_threads;
-static unsigned int nthreads;
-static uv_thread_t* threads;
-static uv_thread_t default_threads[4];
-static QUEUE exit_message;
-static QUEUE wq;
+static struct uv__threadpool default_pool;
+static struct uv__worker default_workers[4];
 static volatile int initialized;
 
 
@@ -58,92 +107,465 @@ static void uv__cancelled(struct uv__work* w) {
 }
 
 
+static int uv__lane_limited(struct uv__threadpool* pool, unsigned int kind) {
+  return pool->limit[kind] < pool->nworkers;
+}
+
+
+static int uv__lane_acquire(struct uv__worker* self, unsigned int kind) {
+  struct uv__threadpool* pool;
+  int acquired;
+
+  pool = self->pool;
+  self->slot = -1;
+
+  if (!uv__lane_limited(pool, kind))
+    return 1;
+
+  uv_mutex_lock(&pool->lane_mutex);
+  acquired = pool->running[kind] < pool->limit[kind];
+  if (acquired)
+    pool->running[kind] += 1;
+  uv_mutex_unlock(&pool->lane_mutex);
+
+  if (acquired)
+    self->slot = kind;
+
+  return acquired;
+}
+
+
+/* Take the next request off wk's lanes. Called with wk->mutex held. */
+static QUEUE* uv__worker_take(struct uv__worker* self, struct uv__worker* wk) {
+  unsigned int kind;
+  unsigned int i;
+  QUEUE* q;
+
+  for (i = 0; i < UV_WORK_KIND_MAX; i++) {
+    kind = (self->next_kind + i) % UV_WORK_KIND_MAX;
+
+    if (QUEUE_EMPTY(&wk->queue[kind]))
+      continue;
+
+    if (!uv__lane_acquire(self, kind))
+      continue;
+
+    q = QUEUE_HEAD(&wk->queue[kind]);
+    QUEUE_REMOVE(q);
+    QUEUE_INIT(q);  /* Signal uv_cancel() that the work req is
+                       executing. */
+    self->next_kind = kind + 1;
+    return q;
+  }
+
+  return NULL;
+}
+
+
+static QUEUE* uv__worker_pop(struct uv__worker* self) {
+  QUEUE* q;
+
+  uv_mutex_lock(&self->mutex);
+  q = uv__worker_take(self, self);
+  uv_mutex_unlock(&self->mutex);
+
+  return q;
+}
+
+
+/* Unlocked check, good enough to skip queues that are obviously empty or
+ * that only hold requests for lanes that are at their limit.
+ */
+static int uv__worker_runnable(struct uv__worker* wk) {
+  struct uv__threadpool* pool;
+  unsigned int kind;
+
+  pool = wk->pool;
+
+  for (kind = 0; kind < UV_WORK_KIND_MAX; kind++) {
+    if (*(QUEUE* volatile*) &wk->queue[kind][0] == &wk->queue[kind])
+      continue;
+
+    if (!uv__lane_limited(pool, kind))
+      return 1;
+
+    if (pool->running[kind] < pool->limit[kind])
+      return 1;
+  }
+
+  return 0;
+}
+
+
+static QUEUE* uv__worker_steal(struct uv__worker* self) {
+  struct uv__threadpool* pool;
+  struct uv__worker* wk;
+  unsigned int index;
+  unsigned int i;
+  QUEUE* q;
+
+  pool = self->pool;
+  index = self - pool->workers;
+
+  for (i = 1; i < pool->nworkers; i++) {
+    wk = pool->workers + (index + i) % pool->nworkers;
+
+    if (!uv__worker_runnable(wk))
+      continue;
+
+    /* Don't queue up behind the owner or another thief, try the next one. */
+    if (uv_mutex_trylock(&wk->mutex))
+      continue;
+
+    q = uv__worker_take(self, wk);
+    uv_mutex_unlock(&wk->mutex);
+
+    if (q != NULL)
+      return q;
+  }
+
+  return NULL;
+}
+
+
+static void uv__work_push(uv_loop_t* loop, struct uv__work* w) {
+  void* head;
+
+  /* Link through wq[1] so that wq stays empty as far as uv_cancel() is
+   * concerned.
+   */
+  do {
+    head = *(void* volatile*) &loop->wq_done;
+    w->wq[1] = head;
+  } while (uv__cmpxchgp(&loop->wq_done, head, w) != head);
+
+  if (head == NULL)
+    uv_async_send(&loop->wq_async);
+}
+
+
+static struct uv__worker* uv__threadpool_idle_worker(
+    struct uv__threadpool* pool) {
+  struct uv__worker* wk;
+  QUEUE* q;
+
+  if (pool->nidle == 0)
+    return NULL;
+
+  wk = NULL;
+  uv_mutex_lock(&pool->idle_mutex);
+
+  if (!QUEUE_EMPTY(&pool->idle_workers)) {
+    q = QUEUE_HEAD(&pool->idle_workers);
+    QUEUE_REMOVE(q);
+    QUEUE_INIT(q);
+    pool->nidle -= 1;
+    wk = QUEUE_DATA(q, struct uv__worker, idle_queue);
+  }
+
+  uv_mutex_unlock(&pool->idle_mutex);
+  return wk;
+}
+
+
+static void uv__worker_kick(struct uv__worker* wk) {
+  uv_mutex_lock(&wk->mutex);
+  wk->wakeup = 1;
+  uv_cond_signal(&wk->cond);
+  uv_mutex_unlock(&wk->mutex);
+}
+
+
+static void uv__worker_start(struct uv__worker* self, struct uv__work* w) {
+  struct uv__lane_stats* stats;
+  uint64_t wait_time;
+
+  wait_time = uv_hrtime() - w->time;
+  stats = self->stats + w->kind;
+  stats->started += 1;
+  stats->wait_time += wait_time;
+  if (wait_time > stats->max_wait_time)
+    stats->max_wait_time = wait_time;
+
+  /* Handed back to the loop thread, see uv__work_done(). */
+  w->time = wait_time;
+}
+
+
+static void uv__worker_complete(struct uv__worker* self, struct uv__work* w) {
+  struct uv__threadpool* pool;
+  struct uv__worker* thief;
+
+  pool = self->pool;
+  self->stats[w->kind].completed += 1;
+
+  if (self->slot != -1) {
+    uv_mutex_lock(&pool->lane_mutex);
+    pool->running[self->slot] -= 1;
+    uv_mutex_unlock(&pool->lane_mutex);
+    self->slot = -1;
+
+    /* Requests held back by the limit may sit with a worker that went to
+     * sleep, let somebody pick them up.
+     */
+    thief = uv__threadpool_idle_worker(pool);
+    if (thief != NULL)
+      uv__worker_kick(thief);
+  }
+
+  w->work = NULL;  /* Signal uv_cancel() that the work req is done
+                      executing. */
+  uv__work_push(w->loop, w);
+}
+
+
+static int uv__worker_has_work(struct uv__threadpool* pool) {
+  struct uv__worker* wk;
+
+  for (wk = pool->workers; wk < pool->workers + pool->nworkers; wk++)
+    if (uv__worker_runnable(wk))
+      return 1;
+
+  return 0;
+}
+
+
+static void uv__worker_wait(struct uv__worker* self) {
+  struct uv__threadpool* pool;
+
+  pool = self->pool;
+
+  /* Most recently idled first, its cache is still warm and it's likely
+   * not asleep yet.
+   */
+  uv_mutex_lock(&pool->idle_mutex);
+  QUEUE_INSERT_HEAD(&pool->idle_workers, &self->idle_queue);
+  pool->nidle += 1;
+  uv_mutex_unlock(&pool->idle_mutex);
+
+  /* Now that we're visible as idle, look at the other queues one more time.
+   * A request that was posted to a busy worker before we got on the idle
+   * list would otherwise have to wait until that worker is done. Requests
+   * are never lost this way, the owner always drains its own queue.
+   */
+  if (!uv__worker_has_work(pool)) {
+    uv_mutex_lock(&self->mutex);
+    while (!uv__worker_runnable(self) &&
+           self->wakeup == 0 &&
+           pool->exiting == 0) {
+      uv_cond_wait(&self->cond, &self->mutex);
+    }
+    self->wakeup = 0;
+    uv_mutex_unlock(&self->mutex);
+  }
+
+  uv_mutex_lock(&pool->idle_mutex);
+  if (!QUEUE_EMPTY(&self->idle_queue)) {
+    QUEUE_REMOVE(&self->idle_queue);
+    QUEUE_INIT(&self->idle_queue);
+    pool->nidle -= 1;
+  }
+  uv_mutex_unlock(&pool->idle_mutex);
+}
+
+
 /* To avoid deadlock with uv_cancel() it's crucial that the worker
- * never holds the global mutex and the loop-local mutex at the same time.
+ * never holds its own mutex while waiting for a sibling's mutex.
  */
 static void worker(void* arg) {
+  struct uv__worker* self;
   struct uv__work* w;
   QUEUE* q;
 
-  (void) arg;
+  self = arg;
 
   for (;;) {
-    uv_mutex_lock(&mutex);
+    q = uv__worker_pop(self);
 
-    while (QUEUE_EMPTY(&wq)) {
-      idle_threads += 1;
-      uv_cond_wait(&cond, &mutex);
-      idle_threads -= 1;
-    }
+    if (q == NULL)
+      q = uv__worker_steal(self);
 
-    q = QUEUE_HEAD(&wq);
+    if (q == NULL) {
+      if (self->pool->exiting)
+        break;
 
-    if (q == &exit_message)
-      uv_cond_signal(&cond);
-    else {
-      QUEUE_REMOVE(q);
-      QUEUE_INIT(q);  /* Signal uv_cancel() that the work req is
-                             executing. */
+      uv__worker_wait(self);
+      continue;
     }
 
-    uv_mutex_unlock(&mutex);
-
-    if (q == &exit_message)
-      break;
-
     w = QUEUE_DATA(q, struct uv__work, wq);
+    uv__worker_start(self, w);
     w->work(w);
-
-    uv_mutex_lock(&w->loop->wq_mutex);
-    w->work = NULL;  /* Signal uv_cancel() that the work req is done
-                        executing. */
-    QUEUE_INSERT_TAIL(&w->loop->wq, &w->wq);
-    uv_async_send(&w->loop->wq_async);
-    uv_mutex_unlock(&w->loop->wq_mutex);
+    uv__worker_complete(self, w);
   }
 }
 
 
-static void post(QUEUE* q) {
-  uv_mutex_lock(&mutex);
-  QUEUE_INSERT_TAIL(&wq, q);
-  if (idle_threads > 0)
-    uv_cond_signal(&cond);
-  uv_mutex_unlock(&mutex);
+static void post(struct uv__threadpool* pool, uv_loop_t* loop, QUEUE* q) {
+  struct uv__worker* thief;
+  struct uv__worker* wk;
+  struct uv__work* w;
+
+  w = QUEUE_DATA(q, struct uv__work, wq);
+
+  /* Prefer a sleeping worker, fall back to round-robin when all are busy. */
+  wk = uv__threadpool_idle_worker(pool);
+
+  if (wk != NULL) {
+    uv_mutex_lock(&wk->mutex);
+    QUEUE_INSERT_TAIL(&wk->queue[w->kind], q);
+    wk->stats[w->kind].submitted += 1;
+    /* It's off the idle list now. Make sure it wakes up and gets back on it
+     * even when a thief gets to the request first.
+     */
+    wk->wakeup = 1;
+    uv_cond_signal(&wk->cond);
+    uv_mutex_unlock(&wk->mutex);
+    return;
+  }
+
+  wk = pool->workers + (loop->wq_next++ % pool->nworkers);
+
+  uv_mutex_lock(&wk->mutex);
+  QUEUE_INSERT_TAIL(&wk->queue[w->kind], q);
+  wk->stats[w->kind].submitted += 1;
+  uv_cond_signal(&wk->cond);
+  uv_mutex_unlock(&wk->mutex);
+
+  /* A worker may have gone idle after we looked and without seeing the
+   * request. Kick it so it steals the request from the busy owner.
+   */
+  thief = uv__threadpool_idle_worker(pool);
+
+  if (thief != NULL && thief != wk)
+    uv__worker_kick(thief);
 }
 
 
-#ifndef _WIN32
-UV_DESTRUCTOR(static void cleanup(void)) {
+static void uv__threadpool_join(struct uv__threadpool* pool,
+                                unsigned int nthreads) {
   unsigned int i;
 
-  if (initialized == 0)
-    return;
+  pool->exiting = 1;
 
-  post(&exit_message);
+  for (i = 0; i < pool->nworkers; i++) {
+    uv_mutex_lock(&pool->workers[i].mutex);
+    uv_cond_signal(&pool->workers[i].cond);
+    uv_mutex_unlock(&pool->workers[i].mutex);
+  }
 
   for (i = 0; i < nthreads; i++)
-    if (uv_thread_join(threads + i))
+    if (uv_thread_join(&pool->workers[i].thread))
       abort();
 
-  if (threads != default_threads)
-    uv__free(threads);
+  for (i = 0; i < pool->nworkers; i++) {
+    uv_mutex_destroy(&pool->workers[i].mutex);
+    uv_cond_destroy(&pool->workers[i].cond);
+  }
+
+  uv_mutex_destroy(&pool->lane_mutex);
+  uv_mutex_destroy(&pool->idle_mutex);
+}
+
 
-  uv_mutex_destroy(&mutex);
-  uv_cond_destroy(&cond);
+static void uv__threadpool_stop(struct uv__threadpool* pool) {
+  uv__threadpool_join(pool, pool->nworkers);
+}
+
+
+static int uv__threadpool_start(struct uv__threadpool* pool,
+                                struct uv__worker* workers,
+                                unsigned int nworkers) {
+  struct uv__worker* wk;
+  unsigned int kind;
+  unsigned int i;
+  int err;
+
+  memset(pool, 0, sizeof(*pool));
+  memset(workers, 0, nworkers * sizeof(workers[0]));
+  pool->workers = workers;
+  QUEUE_INIT(&pool->idle_workers);
+
+  /* Slow I/O gets at most half of the threads, the other lanes are only
+   * bounded by the size of the pool.
+   */
+  for (kind = 0; kind < UV_WORK_KIND_MAX; kind++)
+    pool->limit[kind] = nworkers;
+  pool->limit[UV_WORK_SLOW_IO] = (nworkers + 1) / 2;
+
+  err = uv_mutex_init(&pool->idle_mutex);
+  if (err)
+    return err;
+
+  err = uv_mutex_init(&pool->lane_mutex);
+  if (err) {
+    uv_mutex_destroy(&pool->idle_mutex);
+    return err;
+  }
+
+  for (i = 0; i < nworkers; i++) {
+    wk = workers + i;
+    wk->pool = pool;
+    wk->slot = -1;
+    for (kind = 0; kind < UV_WORK_KIND_MAX; kind++)
+      QUEUE_INIT(&wk->queue[kind]);
+    QUEUE_INIT(&wk->idle_queue);
+
+    err = uv_mutex_init(&wk->mutex);
+    if (err)
+      goto fail;
+
+    err = uv_cond_init(&wk->cond);
+    if (err) {
+      uv_mutex_destroy(&wk->mutex);
+      goto fail;
+    }
+  }
+
+  pool->nworkers = nworkers;
+
+  for (i = 0; i < nworkers; i++) {
+    err = uv_thread_create(&workers[i].thread, worker, workers + i);
+    if (err) {
+      uv__threadpool_join(pool, i);
+      return err;
+    }
+  }
+
+  return 0;
+
+fail:
+  while (i-- > 0) {
+    uv_mutex_destroy(&workers[i].mutex);
+    uv_cond_destroy(&workers[i].cond);
+  }
+  uv_mutex_destroy(&pool->lane_mutex);
+  uv_mutex_destroy(&pool->idle_mutex);
+  return err;
+}
+
+
+#ifndef _WIN32
+UV_DESTRUCTOR(static void cleanup(void)) {
+  if (initialized == 0)
+    return;
+
+  uv__threadpool_stop(&default_pool);
+
+  if (default_pool.workers != default_workers)
+    uv__free(default_pool.workers);
 
-  threads = NULL;
-  nthreads = 0;
   initialized = 0;
 }
 #endif
 
 
 static void init_once(void) {
-  unsigned int i;
+  struct uv__worker* workers;
+  unsigned int nthreads;
   const char* val;
 
-  nthreads = ARRAY_SIZE(default_threads);
+  nthreads = ARRAY_SIZE(default_workers);
   val = getenv("UV_THREADPOOL_SIZE");
   if (val != NULL)
     nthreads = atoi(val);
@@ -152,55 +574,152 @@ static void init_once(void) {
   if (nthreads > MAX_THREADPOOL_SIZE)
     nthreads = MAX_THREADPOOL_SIZE;
 
-  threads = default_threads;
-  if (nthreads > ARRAY_SIZE(default_threads)) {
-    threads = uv__malloc(nthreads * sizeof(threads[0]));
-    if (threads == NULL) {
-      nthreads = ARRAY_SIZE(default_threads);
-      threads = default_threads;
+  workers = default_workers;
+  if (nthreads > ARRAY_SIZE(default_workers)) {
+    workers = uv__malloc(nthreads * sizeof(workers[0]));
+    if (workers == NULL) {
+      nthreads = ARRAY_SIZE(default_workers);
+      workers = default_workers;
     }
   }
 
-  if (uv_cond_init(&cond))
+  if (uv__threadpool_start(&default_pool, workers, nthreads))
     abort();
 
-  if (uv_mutex_init(&mutex))
-    abort();
+  initialized = 1;
+}
 
-  QUEUE_INIT(&wq);
 
-  for (i = 0; i < nthreads; i++)
-    if (uv_thread_create(threads + i, worker, NULL))
-      abort();
+static struct uv__threadpool* uv__loop_threadpool(uv_loop_t* loop) {
+  if (loop->wq_pool != NULL)
+    return loop->wq_pool;
 
-  initialized = 1;
+  uv_once(&once, init_once);
+  return &default_pool;
+}
+
+
+int uv__threadpool_configure(uv_loop_t* loop, unsigned int nthreads) {
+  struct uv__threadpool* pool;
+  int err;
+
+  if (nthreads > MAX_THREADPOOL_SIZE)
+    return UV_EINVAL;
+
+  /* Work that is in flight holds on to the current pool. */
+  if (uv__has_active_reqs(loop))
+    return UV_EBUSY;
+
+  uv__threadpool_close(loop);
+
+  if (nthreads == 0)
+    return 0;
+
+  pool = uv__malloc(sizeof(*pool) + nthreads * sizeof(pool->workers[0]));
+  if (pool == NULL)
+    return UV_ENOMEM;
+
+  err = uv__threadpool_start(pool, (struct uv__worker*) (pool + 1), nthreads);
+  if (err) {
+    uv__free(pool);
+    return err;
+  }
+
+  loop->wq_pool = pool;
+  return 0;
+}
+
+
+int uv__threadpool_limit(uv_loop_t* loop, int kind, unsigned int limit) {
+  struct uv__threadpool* pool;
+
+  if (kind < 0 || kind >= UV_WORK_KIND_MAX)
+    return UV_EINVAL;
+
+  /* The global pool is shared with every other loop in the process. */
+  pool = loop->wq_pool;
+  if (pool == NULL)
+    return UV_EINVAL;
+
+  if (limit == 0 || limit > pool->nworkers)
+    limit = pool->nworkers;
+
+  uv_mutex_lock(&pool->lane_mutex);
+  pool->limit[kind] = limit;
+  uv_mutex_unlock(&pool->lane_mutex);
+
+  return 0;
+}
+
+
+void uv__threadpool_close(uv_loop_t* loop) {
+  struct uv__threadpool* pool;
+
+  pool = loop->wq_pool;
+  if (pool == NULL)
+    return;
+
+  uv__threadpool_stop(pool);
+  uv__free(pool);
+  loop->wq_pool = NULL;
 }
 
 
 void uv__work_submit(uv_loop_t* loop,
                      struct uv__work* w,
+                     uv_work_kind kind,
                      void (*work)(struct uv__work* w),
                      void (*done)(struct uv__work* w, int status)) {
-  uv_once(&once, init_once);
+  struct uv__threadpool* pool;
+
+  pool = uv__loop_threadpool(loop);
   w->loop = loop;
   w->work = work;
   w->done = done;
-  post(&w->wq);
+  w->kind = kind;
+  w->time = uv_hrtime();
+  post(pool, loop, &w->wq);
+}
+
+
+/* Completes a request that never went to the threadpool, `done` runs on the
+ * next loop iteration. uv_cancel() sees it as already executing.
+ */
+void uv__work_complete(uv_loop_t* loop,
+                       struct uv__work* w,
+                       void (*done)(struct uv__work* w, int status)) {
+  w->loop = loop;
+  w->work = NULL;
+  w->done = done;
+  w->kind = UV_WORK_KIND_MAX;  /* Keeps it out of the loop's metrics. */
+  QUEUE_INIT(&w->wq);
+  uv__work_push(loop, w);
 }
 
 
 static int uv__work_cancel(uv_loop_t* loop, uv_req_t* req, struct uv__work* w) {
+  struct uv__threadpool* pool;
+  unsigned int i;
   int cancelled;
 
-  uv_mutex_lock(&mutex);
+  pool = uv__loop_threadpool(w->loop);
+
+  /* The request may have been stolen by any worker in the meantime, so
+   * freeze all of them. Cancellation is rare enough to make this acceptable.
+   */
+  for (i = 0; i < pool->nworkers; i++)
+    uv_mutex_lock(&pool->workers[i].mutex);
   uv_mutex_lock(&w->loop->wq_mutex);
 
   cancelled = !QUEUE_EMPTY(&w->wq) && w->work != NULL;
-  if (cancelled)
+  if (cancelled) {
     QUEUE_REMOVE(&w->wq);
+    pool->workers[0].stats[w->kind].cancelled += 1;
+  }
 
   uv_mutex_unlock(&w->loop->wq_mutex);
-  uv_mutex_unlock(&mutex);
+  while (i-- > 0)
+    uv_mutex_unlock(&pool->workers[i].mutex);
 
   if (!cancelled)
     return UV_EBUSY;
@@ -218,6 +737,7 @@ static int uv__work_cancel(uv_loop_t* loop, uv_req_t* req, struct uv__work* w) {
 void uv__work_done(uv_async_t* handle) {
   struct uv__work* w;
   uv_loop_t* loop;
+  void* head;
   QUEUE* q;
   QUEUE wq;
   int err;
@@ -225,6 +745,7 @@ void uv__work_done(uv_async_t* handle) {
   loop = container_of(handle, uv_loop_t, wq_async);
   QUEUE_INIT(&wq);
 
+  /* Cancelled requests first... */
   uv_mutex_lock(&loop->wq_mutex);
   if (!QUEUE_EMPTY(&loop->wq)) {
     q = QUEUE_HEAD(&loop->wq);
@@ -232,12 +753,32 @@ void uv__work_done(uv_async_t* handle) {
   }
   uv_mutex_unlock(&loop->wq_mutex);
 
+  /* ...then the finished ones. Take the whole stack and restore the order in
+   * which the requests completed.
+   */
+  do
+    head = *(void* volatile*) &loop->wq_done;
+  while (head != NULL && uv__cmpxchgp(&loop->wq_done, head, NULL) != head);
+
+  q = QUEUE_PREV(&wq);
+  while (head != NULL) {
+    w = head;
+    head = w->wq[1];
+    QUEUE_INSERT_HEAD(q, &w->wq);
+  }
+
   while (!QUEUE_EMPTY(&wq)) {
     q = QUEUE_HEAD(&wq);
     QUEUE_REMOVE(q);
 
     w = container_of(q, struct uv__work, wq);
     err = (w->work == uv__cancelled) ? UV_ECANCELED : 0;
+
+    if (err == 0 && w->kind != UV_WORK_KIND_MAX) {
+      loop->metrics.work_completed++;
+      loop->metrics.work_wait_time += w->time;
+    }
+
     w->done(w, err);
   }
 }
@@ -267,14 +808,73 @@ int uv_queue_work(uv_loop_t* loop,
                   uv_work_t* req,
                   uv_work_cb work_cb,
                   uv_after_work_cb after_work_cb) {
+  return uv_queue_work_ex(loop, req, UV_WORK_CPU, work_cb, after_work_cb);
+}
+
+
+int uv_queue_work_ex(uv_loop_t* loop,
+                     uv_work_t* req,
+                     uv_work_kind kind,
+                     uv_work_cb work_cb,
+                     uv_after_work_cb after_work_cb) {
   if (work_cb == NULL)
     return UV_EINVAL;
 
+  if ((int) kind < 0 || kind >= UV_WORK_KIND_MAX)
+    return UV_EINVAL;
+
   uv__req_init(loop, req, UV_WORK);
   req->loop = loop;
   req->work_cb = work_cb;
   req->after_work_cb = after_work_cb;
-  uv__work_submit(loop, &req->work_req, uv__queue_work, uv__queue_done);
+  uv__work_submit(loop, &req->work_req, kind, uv__queue_work, uv__queue_done);
+  return 0;
+}
+
+
+int uv_threadpool_stats(const uv_loop_t* loop,
+                        uv_work_kind kind,
+                        uv_work_stats_t* stats) {
+  struct uv__threadpool* pool;
+  struct uv__lane_stats* ls;
+  uint64_t started;
+  unsigned int i;
+
+  if ((int) kind < 0 || kind >= UV_WORK_KIND_MAX)
+    return UV_EINVAL;
+
+  memset(stats, 0, sizeof(*stats));
+
+  /* Don't start the global pool just to report that it's idle. */
+  pool = loop->wq_pool;
+  if (pool == NULL) {
+    if (initialized == 0)
+      return 0;
+    pool = &default_pool;
+  }
+
+  /* The counters are read without locking, the numbers are a snapshot that
+   * may be off by a request or two when the pool is busy.
+   */
+  started = 0;
+  for (i = 0; i < pool->nworkers; i++) {
+    ls = pool->workers[i].stats + kind;
+    stats->submitted += ls->submitted;
+    stats->completed += ls->completed;
+    stats->cancelled += ls->cancelled;
+    stats->wait_time += ls->wait_time;
+    if (ls->max_wait_time > stats->max_wait_time)
+      stats->max_wait_time = ls->max_wait_time;
+    started += ls->started;
+  }
+
+  if (started > stats->completed)
+    stats->running = started - stats->completed;
+
+  if (stats->submitted > started + stats->cancelled)
+    stats->queued = stats->submitted - started - stats->cancelled;
+
+  stats->limit = pool->limit[kind];
   return 0;
 }
 
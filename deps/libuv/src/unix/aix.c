@@ -173,7 +173,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
   assert(timeout >= -1);
   base = loop->time;
-  count = 48; /* Benchmarks suggest this gives the best throughput. */
+  count = loop->poll_budget;
 
   for (;;) {
     nfds = pollset_poll(loop->backend_fd,
@@ -237,7 +237,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
         continue;
       }
 
-      w->cb(loop, w, pe->revents);
+      uv__metered_call(loop, w->cb(loop, w, pe->revents));
       nevents++;
     }
 
@@ -876,6 +876,13 @@ int uv_fs_event_stop(uv_fs_event_t* handle) {
 }
 
 
+int uv_fs_event_set_batching(uv_fs_event_t* handle,
+                             uint64_t window,
+                             uv_fs_event_batch_cb cb) {
+  return -ENOSYS;
+}
+
+
 void uv__fs_event_close(uv_fs_event_t* handle) {
 #ifdef HAVE_SYS_AHAFS_EVPRODS_H
   uv_fs_event_stop(handle);
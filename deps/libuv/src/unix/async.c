@@ -33,13 +33,61 @@
 #include <string.h>
 #include <unistd.h>
 
+#define uv__cmpxchgp(ptr, oldval, newval)                                     \
+  ((void*) cmpxchgl((long*) (ptr), (long) (oldval), (long) (newval)))
+
 static void uv__async_event(uv_loop_t* loop,
                             struct uv__async* w,
                             unsigned int nevents);
 static int uv__async_eventfd(void);
 
 
-int uv_async_init(uv_loop_t* loop, uv_async_t* handle, uv_async_cb async_cb) {
+/* Signalled handles are pushed onto loop->async_stack, a lock-free stack
+ * that any thread can push to and only the loop thread empties. The pending
+ * flag makes sure a handle is on it at most once. Only the thread that finds
+ * the stack empty wakes up the loop, everyone else piggybacks on that wakeup.
+ *
+ * The loop thread moves the whole stack over to loop->async_ready in the
+ * order in which the handles were signalled, and runs their callbacks from
+ * there. A wakeup costs O(signalled handles), not O(handles).
+ */
+static void uv__async_push(uv_async_t* handle) {
+  uv_loop_t* loop;
+  void* head;
+
+  loop = handle->loop;
+
+  do {
+    head = *(void* volatile*) &loop->async_stack;
+    handle->next_pending = head;
+  } while (uv__cmpxchgp(&loop->async_stack, head, handle) != head);
+
+  if (head == NULL)
+    uv__async_send(&loop->async_watcher);
+}
+
+
+/* Moves the handles on the stack over to the end of loop->async_ready. */
+static void uv__async_drain(uv_loop_t* loop) {
+  uv_async_t* h;
+  void* head;
+  QUEUE* q;
+
+  do
+    head = *(void* volatile*) &loop->async_stack;
+  while (head != NULL && uv__cmpxchgp(&loop->async_stack, head, NULL) != head);
+
+  /* The stack is last in, first out. Restore the order of arrival. */
+  q = QUEUE_PREV(&loop->async_ready);
+  while (head != NULL) {
+    h = head;
+    head = h->next_pending;
+    QUEUE_INSERT_HEAD(q, &h->queue);
+  }
+}
+
+
+static int uv__async_handle_init(uv_loop_t* loop, uv_async_t* handle) {
   int err;
 
   err = uv__async_start(loop, &loop->async_watcher, uv__async_event);
@@ -47,49 +95,159 @@ int uv_async_init(uv_loop_t* loop, uv_async_t* handle, uv_async_cb async_cb) {
     return err;
 
   uv__handle_init(loop, (uv_handle_t*)handle, UV_ASYNC);
-  handle->async_cb = async_cb;
+  handle->async_cb = NULL;
+  handle->msg_cb = NULL;
+  handle->msgs = NULL;
   handle->pending = 0;
-
-  QUEUE_INSERT_TAIL(&loop->async_handles, &handle->queue);
+  handle->next_pending = NULL;
+  QUEUE_INIT(&handle->queue);
   uv__handle_start(handle);
 
   return 0;
 }
 
 
+int uv_async_init(uv_loop_t* loop, uv_async_t* handle, uv_async_cb async_cb) {
+  int err;
+
+  err = uv__async_handle_init(loop, handle);
+  if (err)
+    return err;
+
+  handle->async_cb = async_cb;
+  return 0;
+}
+
+
+int uv_async_init_msg(uv_loop_t* loop,
+                      uv_async_t* handle,
+                      uv_async_msg_cb msg_cb) {
+  int err;
+
+  if (msg_cb == NULL)
+    return -EINVAL;
+
+  err = uv__async_handle_init(loop, handle);
+  if (err)
+    return err;
+
+  handle->msg_cb = msg_cb;
+  return 0;
+}
+
+
 int uv_async_send(uv_async_t* handle) {
+  /* Message handles are signalled by uv_async_send_msg() only. */
+  if (handle->msg_cb != NULL)
+    return -EINVAL;
+
   /* Do a cheap read first. */
   if (ACCESS_ONCE(int, handle->pending) != 0)
     return 0;
 
   if (cmpxchgi(&handle->pending, 0, 1) == 0)
-    uv__async_send(&handle->loop->async_watcher);
+    uv__async_push(handle);
+
+  return 0;
+}
+
+
+int uv_async_send_msg(uv_async_t* handle, uv_async_msg_t* msg) {
+  void* head;
+
+  if (handle->msg_cb == NULL)
+    return -EINVAL;
+
+  do {
+    head = *(void* volatile*) &handle->msgs;
+    msg->next_msg = head;
+  } while (uv__cmpxchgp(&handle->msgs, head, msg) != head);
+
+  /* The message stack takes the place of the pending flag: only the sender
+   * that finds it empty puts the handle on the ready list, and the loop
+   * doesn't take the messages before it gets the handle off that list. No
+   * sender touches the handle after its message can be seen, which makes
+   * it safe to close the handle from the callback that gets the last one.
+   */
+  if (head == NULL)
+    uv__async_push(handle);
 
   return 0;
 }
 
 
 void uv__async_close(uv_async_t* handle) {
-  QUEUE_REMOVE(&handle->queue);
+  /* Take it off the ready list. The pending flag stays set so that stray
+   * uv_async_send() calls after this point don't put it back on.
+   */
+  if (cmpxchgi(&handle->pending, 0, 1) != 0 || handle->msgs != NULL) {
+    uv__async_drain(handle->loop);
+    QUEUE_REMOVE(&handle->queue);
+    QUEUE_INIT(&handle->queue);
+  }
+
   uv__handle_stop(handle);
 }
 
 
+static void uv__async_deliver(uv_async_t* h) {
+  uv_async_msg_t* next;
+  uv_async_msg_t* msg;
+  void* head;
+
+  do
+    head = *(void* volatile*) &h->msgs;
+  while (head != NULL && uv__cmpxchgp(&h->msgs, head, NULL) != head);
+
+  /* Same as above, reverse the stack into arrival order. */
+  msg = NULL;
+  while (head != NULL) {
+    next = head;
+    head = next->next_msg;
+    next->next_msg = msg;
+    msg = next;
+  }
+
+  /* What's left when a callback closes the handle is dropped. */
+  while (msg != NULL && !uv__is_closing(h)) {
+    next = msg->next_msg;
+    h->msg_cb(h, msg);
+    msg = next;
+  }
+}
+
+
 static void uv__async_event(uv_loop_t* loop,
                             struct uv__async* w,
                             unsigned int nevents) {
-  QUEUE* q;
   uv_async_t* h;
+  QUEUE* q;
 
-  QUEUE_FOREACH(q, &loop->async_handles) {
+  uv__async_drain(loop);
+
+  /* Callbacks may close other handles on the list, so don't hold on to the
+   * next entry. Handles signalled while this runs wait for the next wakeup.
+   */
+  while (!QUEUE_EMPTY(&loop->async_ready)) {
+    q = QUEUE_HEAD(&loop->async_ready);
+    QUEUE_REMOVE(q);
+    QUEUE_INIT(q);
     h = QUEUE_DATA(q, uv_async_t, queue);
 
-    if (cmpxchgi(&h->pending, 1, 0) == 0)
+    /* Signalled after it was closed, which uv_async_send() doesn't allow. */
+    if (uv__is_closing(h))
       continue;
 
-    if (h->async_cb == NULL)
+    if (h->msg_cb != NULL) {
+      uv__async_deliver(h);
       continue;
-    h->async_cb(h);
+    }
+
+    if (cmpxchgi(&h->pending, 1, 0) == 0)
+      abort();
+
+    if (h->async_cb != NULL)
+      h->async_cb(h);
   }
 }
 
@@ -21,6 +21,7 @@
 UV_UNUSED(static int cmpxchgi(int* ptr, int oldval, int newval));
 UV_UNUSED(static long cmpxchgl(long* ptr, long oldval, long newval));
 UV_UNUSED(static void cpu_relax(void));
+UV_UNUSED(static void smp_barrier(void));
 
 /* Prefer hand-rolled assembly over the gcc builtins because the latter also
  * issue full memory barriers.
@@ -69,4 +70,15 @@ UV_UNUSED(static void cpu_relax(void)) {
 #endif
 }
 
+/* Orders loads against loads and stores against stores, enough for a seqlock.
+ * x86 doesn't reorder those, so there only the compiler needs to be stopped.
+ */
+UV_UNUSED(static void smp_barrier(void)) {
+#if defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__ ("" ::: "memory");
+#else
+  __sync_synchronize();
+#endif
+}
+
 #endif  /* UV_ATOMIC_OPS_H_ */
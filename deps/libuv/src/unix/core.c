@@ -20,6 +20,7 @@
 
 #include "uv.h"
 #include "internal.h"
+#include "atomic-ops.h"
 
 #include <stddef.h> /* NULL */
 #include <stdio.h> /* printf */
@@ -255,8 +256,13 @@ static void uv__finish_close(uv_handle_t* handle) {
   uv__handle_unref(handle);
   QUEUE_REMOVE(&handle->handle_queue);
 
-  if (handle->close_cb) {
-    handle->close_cb(handle);
+  /* The close callback may free the handle unless it's from a pool. */
+  if (handle->flags & UV__HANDLE_POOLED) {
+    if (handle->close_cb)
+      uv__metered_call(handle->loop, handle->close_cb(handle));
+    uv__handle_recycle(handle);
+  } else if (handle->close_cb) {
+    uv__metered_call(handle->loop, handle->close_cb(handle));
   }
 }
 
@@ -318,8 +324,159 @@ int uv_loop_alive(const uv_loop_t* loop) {
 }
 
 
+/* State of UV_LOOP_METRICS. The loop thread counts in loop->metrics and
+ * copies that into `published` at the end of an iteration, at most once per
+ * millisecond, and when uv_run() returns. Other threads only ever read
+ * `published`, bracketed by `seq`, which is odd while a copy is in progress.
+ */
+struct uv__metrics {
+  unsigned int seq;
+  uv_loop_metrics_t published;
+  uint64_t published_at;
+  uint64_t mark;            /* When the current phase started. */
+  uint64_t iteration_start;
+  uint64_t poll_time;       /* loop->metrics.poll_time when it started. */
+  uint64_t callbacks;       /* Run by the current iteration. */
+};
+
+
+static void uv__metrics_publish(uv_loop_t* loop) {
+  struct uv__metrics* m;
+
+  m = loop->metrics_shared;
+  m->published_at = m->mark;
+  *(volatile unsigned int*) &m->seq = m->seq + 1;
+  smp_barrier();
+  m->published = loop->metrics;
+  smp_barrier();
+  *(volatile unsigned int*) &m->seq = m->seq + 1;
+}
+
+
+int uv__metrics_configure(uv_loop_t* loop, int on) {
+  if (!on) {
+    loop->flags &= ~UV_LOOP_COLLECT_METRICS;
+    return 0;
+  }
+
+  /* Never freed before the loop is closed, other threads may be reading. */
+  if (loop->metrics_shared == NULL) {
+    loop->metrics_shared = uv__calloc(1, sizeof(struct uv__metrics));
+    if (loop->metrics_shared == NULL)
+      return -ENOMEM;
+  }
+
+  uv__metrics_publish(loop);
+  loop->flags |= UV_LOOP_COLLECT_METRICS;
+  return 0;
+}
+
+
+void uv__metrics_delete(uv_loop_t* loop) {
+  uv__free(loop->metrics_shared);
+  loop->metrics_shared = NULL;
+  loop->flags &= ~UV_LOOP_COLLECT_METRICS;
+}
+
+
+void uv__metrics_callback(uv_loop_t* loop, uint64_t start) {
+  struct uv__metrics* m;
+  uint64_t t;
+
+  m = loop->metrics_shared;
+  t = uv__hrtime(UV_CLOCK_PRECISE) - start;
+  m->callbacks++;
+  loop->metrics.callbacks++;
+  if (t > loop->metrics.max_callback_time)
+    loop->metrics.max_callback_time = t;
+}
+
+
+static void uv__metrics_begin(uv_loop_t* loop) {
+  struct uv__metrics* m;
+
+  m = loop->metrics_shared;
+  m->mark = uv__hrtime(UV_CLOCK_PRECISE);
+  m->iteration_start = m->mark;
+  m->poll_time = loop->metrics.poll_time;
+  m->callbacks = 0;
+}
+
+
+static void uv__metrics_phase(uv_loop_t* loop, uv_loop_phase phase) {
+  struct uv__metrics* m;
+  uint64_t now;
+  uint64_t t;
+
+  m = loop->metrics_shared;
+  now = uv__hrtime(UV_CLOCK_PRECISE);
+  t = now - m->mark;
+  m->mark = now;
+
+  /* Only the poll for i/o blocks, it happens at the start of the phase. */
+  if (phase == UV_PHASE_IO)
+    t -= loop->metrics.poll_time - m->poll_time;
+
+  loop->metrics.phase_time[phase] += t;
+}
+
+
+/* The lag of an iteration is the time it spent not blocked in the poll for
+ * i/o, i.e. the longest an event could have waited for the loop to get to it.
+ */
+static void uv__metrics_end(uv_loop_t* loop) {
+  struct uv__metrics* m;
+  uint64_t lag;
+  unsigned int i;
+
+  m = loop->metrics_shared;
+  lag = m->mark - m->iteration_start;
+  lag -= loop->metrics.poll_time - m->poll_time;
+  lag /= 1000;
+
+  for (i = 0; lag != 0 && i < UV_LOOP_LAG_BUCKETS - 1; i++)
+    lag >>= 1;
+
+  loop->metrics.lag[i]++;
+  loop->metrics.iterations++;
+  if (m->callbacks > loop->metrics.max_callbacks)
+    loop->metrics.max_callbacks = m->callbacks;
+
+  if (m->mark - m->published_at >= 1000000)
+    uv__metrics_publish(loop);
+}
+
+
+int uv_loop_metrics(const uv_loop_t* loop, uv_loop_metrics_t* metrics) {
+  struct uv__metrics* m;
+  unsigned int seq;
+
+  if (loop == NULL || metrics == NULL)
+    return -EINVAL;
+
+  if (!(loop->flags & UV_LOOP_COLLECT_METRICS)) {
+    *metrics = loop->metrics;
+    return 0;
+  }
+
+  m = loop->metrics_shared;
+  for (;;) {
+    seq = *(volatile unsigned int*) &m->seq;
+    smp_barrier();
+    *metrics = m->published;
+    smp_barrier();
+    if ((seq & 1) == 0 && seq == *(volatile unsigned int*) &m->seq)
+      break;
+    cpu_relax();
+  }
+
+  return 0;
+}
+
+
 int uv_run(uv_loop_t* loop, uv_run_mode mode) {
   int timeout;
+  int metered;
   int r;
   int ran_pending;
 
@@ -329,18 +486,38 @@ int uv_run(uv_loop_t* loop, uv_run_mode mode) {
 
   while (r != 0 && loop->stop_flag == 0) {
     uv__update_time(loop);
+    metered = loop->flags & UV_LOOP_COLLECT_METRICS;
+    if (metered)
+      uv__metrics_begin(loop);
+
     uv__run_timers(loop);
+    if (metered)
+      uv__metrics_phase(loop, UV_PHASE_TIMERS);
+
     ran_pending = uv__run_pending(loop);
+    if (metered)
+      uv__metrics_phase(loop, UV_PHASE_PENDING);
+
     uv__run_idle(loop);
     uv__run_prepare(loop);
+    if (metered)
+      uv__metrics_phase(loop, UV_PHASE_IDLE);
 
     timeout = 0;
     if ((mode == UV_RUN_ONCE && !ran_pending) || mode == UV_RUN_DEFAULT)
       timeout = uv_backend_timeout(loop);
 
     uv__io_poll(loop, timeout);
+    if (metered)
+      uv__metrics_phase(loop, UV_PHASE_IO);
+
     uv__run_check(loop);
+    if (metered)
+      uv__metrics_phase(loop, UV_PHASE_CHECK);
+
     uv__run_closing_handles(loop);
+    if (metered)
+      uv__metrics_phase(loop, UV_PHASE_CLOSING);
 
     if (mode == UV_RUN_ONCE) {
       /* UV_RUN_ONCE implies forward progress: at least one callback must have
@@ -353,13 +530,21 @@ int uv_run(uv_loop_t* loop, uv_run_mode mode) {
        */
       uv__update_time(loop);
       uv__run_timers(loop);
+      if (metered)
+        uv__metrics_phase(loop, UV_PHASE_TIMERS);
     }
 
+    if (metered)
+      uv__metrics_end(loop);
+
     r = uv__loop_alive(loop);
     if (mode == UV_RUN_ONCE || mode == UV_RUN_NOWAIT)
       break;
   }
 
+  if (loop->flags & UV_LOOP_COLLECT_METRICS)
+    uv__metrics_publish(loop);
+
   /* The if statement lets gcc compile it to a conditional store. Avoids
    * dirtying a cache line.
    */
@@ -730,7 +915,7 @@ static int uv__run_pending(uv_loop_t* loop) {
     QUEUE_REMOVE(q);
     QUEUE_INIT(q);
     w = QUEUE_DATA(q, uv__io_t, pending_queue);
-    w->cb(loop, w, UV__POLLOUT);
+    uv__metered_call(loop, w->cb(loop, w, UV__POLLOUT));
   }
 
   return 1;
@@ -0,0 +1,1842 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* The getaddrinfo() cache and the stub resolver behind UV_LOOP_DNS_CACHE and
+ * UV_LOOP_DNS_RESOLVER.
+ *
+ * The cache is shared by every loop in the process. The resolver belongs to a
+ * loop: it answers from the hosts file or sends A/AAAA queries to the
+ * nameservers in resolv.conf over UDP (TCP when the answer is truncated or
+ * with `options use-vc`) and never touches the threadpool. Anything it can't
+ * express, like service names or AI_CANONNAME, goes to getaddrinfo() as
+ * before.
+ *
+ * Every UDP query goes out from its own socket, bound to a random port, with
+ * transaction ids from the kernel's random number generator.
+ */
+
+#include "uv.h"
+#include "internal.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>  /* strcasecmp() */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <unistd.h>
+
+/* Lists handed out by uv_getaddrinfo() are released with uv_freeaddrinfo(),
+ * which is the C library's freeaddrinfo(). glibc and the BSDs free every node
+ * and its ai_canonname with free() and keep ai_addr in the node's block, so
+ * lists built the same way can be mixed with the ones getaddrinfo() returns.
+ * Other C libraries use their own layout, no cache or resolver there.
+ */
+#if defined(__GLIBC__) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+    defined(__OpenBSD__) || defined(__DragonFly__)
+# define UV__HAVE_DNS 1
+#endif
+
+#ifdef UV__HAVE_DNS
+
+#define UV__DNS_PORT              53
+#define UV__DNS_MAXNS             3
+#define UV__DNS_MAXSEARCH         6
+#define UV__DNS_MAXNAME           253
+#define UV__DNS_MAXQUERY          (12 + UV__DNS_MAXNAME + 2 + 4)
+#define UV__DNS_MAXADDRS          32
+#define UV__DNS_CACHE_BUCKETS     256
+#define UV__DNS_CACHE_MAX         1024
+#define UV__DNS_RELOAD_INTERVAL   1000  /* ms between stat()s of the files */
+#define UV__DNS_BIND_TRIES        4     /* Random source ports to try. */
+
+#define UV__DNS_T_A               1
+#define UV__DNS_T_CNAME           5
+#define UV__DNS_T_SOA             6
+#define UV__DNS_T_AAAA            28
+#define UV__DNS_C_IN              1
+
+/* Query types, also the index into uv__dns_query.addrs. */
+#define UV__DNS_Q_A               1
+#define UV__DNS_Q_AAAA            2
+
+enum {
+  UV__DNS_IGNORE,     /* Not an answer to an outstanding question. */
+  UV__DNS_ANSWER,     /* NOERROR, with or without addresses. */
+  UV__DNS_NXDOMAIN,
+  UV__DNS_TRUNCATED,
+  UV__DNS_SERVFAIL
+};
+
+struct uv__dns_conf {
+  struct sockaddr_storage servers[UV__DNS_MAXNS];
+  unsigned int nservers;
+  char search[UV__DNS_MAXSEARCH][UV__DNS_MAXNAME + 1];
+  unsigned int nsearch;
+  unsigned int ndots;
+  unsigned int timeout;   /* ms */
+  unsigned int attempts;
+  int use_vc;
+};
+
+struct uv__dns_host {
+  int family;
+  unsigned char addr[16];
+  const char* name;       /* Points into uv__dns_resolver.hosts_buf. */
+};
+
+struct uv__dns_file {
+  char* path;
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+  time_t mtime;
+  int exists;
+};
+
+struct uv__dns_resolver {
+  uv_loop_t* loop;
+  uv_timer_t timer;
+  void* queries[2];
+  struct uv__dns_file conf_file;
+  struct uv__dns_file hosts_file;
+  struct uv__dns_conf conf;
+  struct uv__dns_host* hosts;
+  unsigned int nhosts;
+  char* hosts_buf;
+  uv_getaddrinfo_t* starting;  /* Inside uv_getaddrinfo() for this one. */
+  uint64_t checked;
+  int loaded;
+  int have_ipv4;
+  int have_ipv6;
+};
+
+struct uv__dns_query {
+  void* queue[2];
+  struct uv__dns_resolver* resolver;
+  uv_getaddrinfo_t* req;
+  uv__io_t io;
+  uint64_t deadline;
+  unsigned int tries;
+  unsigned int candidate;
+  unsigned int ncandidates;
+  int qtypes;
+  int answered;
+  int tcp;
+  int cacheable;
+  unsigned short ids[3];
+  unsigned short port;
+  int socktypes[3][2];
+  unsigned int nsocktypes;
+  unsigned int ttl;
+  unsigned int negative_ttl;
+  unsigned int naddrs[3];
+  unsigned char addrs[3][UV__DNS_MAXADDRS][16];
+  char name[UV__DNS_MAXNAME + 1];
+  unsigned char out[2 * (2 + UV__DNS_MAXQUERY)];
+  size_t out_len;
+  size_t out_pos;
+  unsigned char* in;
+  size_t in_len;
+  size_t in_cap;
+};
+
+struct uv__dns_cache_entry {
+  void* lru[2];
+  struct uv__dns_cache_entry* next;
+  uint64_t expires;
+  unsigned int hash;
+  int retcode;
+  struct addrinfo* addrinfo;
+  char key[1];
+};
+
+static uv_once_t uv__dns_cache_once = UV_ONCE_INIT;
+static uv_mutex_t uv__dns_cache_mutex;
+static struct uv__dns_cache_entry* uv__dns_cache[UV__DNS_CACHE_BUCKETS];
+static QUEUE uv__dns_cache_lru;
+static unsigned int uv__dns_cache_size;
+
+static void uv__dns_query_send(struct uv__dns_query* q);
+static void uv__dns_query_next(struct uv__dns_query* q);
+static void uv__dns_timer_cb(uv_timer_t* handle);
+
+
+/* Allocated with malloc() instead of uv__malloc(), the list is released with
+ * freeaddrinfo().
+ */
+static struct addrinfo* uv__dns_ai_new(int family,
+                                       const unsigned char* addr,
+                                       unsigned short port,
+                                       int socktype,
+                                       int protocol) {
+  struct sockaddr_in6* sin6;
+  struct sockaddr_in* sin;
+  struct addrinfo* ai;
+  size_t addrlen;
+
+  if (family == AF_INET6)
+    addrlen = sizeof(*sin6);
+  else
+    addrlen = sizeof(*sin);
+
+  ai = malloc(sizeof(*ai) + addrlen);
+  if (ai == NULL)
+    return NULL;
+
+  memset(ai, 0, sizeof(*ai) + addrlen);
+  ai->ai_family = family;
+  ai->ai_socktype = socktype;
+  ai->ai_protocol = protocol;
+  ai->ai_addrlen = addrlen;
+  ai->ai_addr = (struct sockaddr*) (ai + 1);
+
+  if (family == AF_INET6) {
+    sin6 = (struct sockaddr_in6*) ai->ai_addr;
+#ifndef __GLIBC__
+    sin6->sin6_len = sizeof(*sin6);
+#endif
+    sin6->sin6_family = AF_INET6;
+    sin6->sin6_port = htons(port);
+    memcpy(&sin6->sin6_addr, addr, 16);
+  } else {
+    sin = (struct sockaddr_in*) ai->ai_addr;
+#ifndef __GLIBC__
+    sin->sin_len = sizeof(*sin);
+#endif
+    sin->sin_family = AF_INET;
+    sin->sin_port = htons(port);
+    memcpy(&sin->sin_addr, addr, 4);
+  }
+
+  return ai;
+}
+
+
+static struct addrinfo* uv__dns_ai_copy(const struct addrinfo* ai) {
+  struct addrinfo** tail;
+  struct addrinfo* head;
+  struct addrinfo* node;
+
+  head = NULL;
+  tail = &head;
+
+  for (; ai != NULL; ai = ai->ai_next) {
+    node = malloc(sizeof(*node) + ai->ai_addrlen);
+    if (node == NULL)
+      goto fail;
+
+    memcpy(node, ai, sizeof(*node));
+    node->ai_next = NULL;
+    node->ai_canonname = NULL;
+    node->ai_addr = (struct sockaddr*) (node + 1);
+    memcpy(node->ai_addr, ai->ai_addr, ai->ai_addrlen);
+    *tail = node;
+    tail = &node->ai_next;
+
+    if (ai->ai_canonname != NULL) {
+      node->ai_canonname = strdup(ai->ai_canonname);
+      if (node->ai_canonname == NULL)
+        goto fail;
+    }
+  }
+
+  return head;
+
+fail:
+  if (head != NULL)
+    freeaddrinfo(head);
+  return NULL;
+}
+
+
+static void uv__dns_cache_init(void) {
+  if (uv_mutex_init(&uv__dns_cache_mutex))
+    abort();
+
+  QUEUE_INIT(&uv__dns_cache_lru);
+}
+
+
+static char* uv__dns_cache_key(const uv_getaddrinfo_t* req,
+                               unsigned int* hash) {
+  const struct addrinfo* hints;
+  const char* hostname;
+  const char* service;
+  unsigned int h;
+  size_t len;
+  char* key;
+  char* p;
+
+  hints = req->hints;
+  hostname = req->hostname != NULL ? req->hostname : "";
+  service = req->service != NULL ? req->service : "";
+
+  len = strlen(hostname) + strlen(service) + 64;
+  key = uv__malloc(len);
+  if (key == NULL)
+    return NULL;
+
+  snprintf(key,
+           len,
+           "%d %d %d %d\n%s\n%s",
+           hints != NULL ? hints->ai_family : 0,
+           hints != NULL ? hints->ai_socktype : 0,
+           hints != NULL ? hints->ai_protocol : 0,
+           hints != NULL ? hints->ai_flags : 0,
+           service,
+           hostname);
+
+  /* FNV-1a */
+  h = 2166136261u;
+  for (p = key; *p != '\0'; p++)
+    h = (h ^ (unsigned char) *p) * 16777619u;
+
+  *hash = h;
+  return key;
+}
+
+
+static void uv__dns_cache_unlink(struct uv__dns_cache_entry* e) {
+  struct uv__dns_cache_entry** pe;
+
+  pe = &uv__dns_cache[e->hash % UV__DNS_CACHE_BUCKETS];
+  while (*pe != e)
+    pe = &(*pe)->next;
+
+  *pe = e->next;
+  QUEUE_REMOVE(&e->lru);
+  uv__dns_cache_size--;
+
+  if (e->addrinfo != NULL)
+    freeaddrinfo(e->addrinfo);
+  uv__free(e);
+}
+
+
+static struct uv__dns_cache_entry* uv__dns_cache_find(const char* key,
+                                                      unsigned int hash) {
+  struct uv__dns_cache_entry* e;
+
+  for (e = uv__dns_cache[hash % UV__DNS_CACHE_BUCKETS]; e != NULL; e = e->next)
+    if (e->hash == hash && strcmp(e->key, key) == 0)
+      return e;
+
+  return NULL;
+}
+
+
+/* Returns 1 and sets req->addrinfo and req->retcode when the cache has a live
+ * answer for the request, 0 otherwise.
+ */
+int uv__dns_cache_lookup(uv_getaddrinfo_t* req) {
+  struct uv__dns_cache_entry* e;
+  struct addrinfo* ai;
+  unsigned int hash;
+  uint64_t now;
+  char* key;
+  int hit;
+
+  uv_once(&uv__dns_cache_once, uv__dns_cache_init);
+
+  key = uv__dns_cache_key(req, &hash);
+  if (key == NULL)
+    return 0;
+
+  now = uv_hrtime();
+  hit = 0;
+
+  uv_mutex_lock(&uv__dns_cache_mutex);
+  e = uv__dns_cache_find(key, hash);
+
+  if (e != NULL && e->expires <= now) {
+    uv__dns_cache_unlink(e);
+    e = NULL;
+  }
+
+  if (e != NULL) {
+    ai = NULL;
+    if (e->retcode == 0)
+      ai = uv__dns_ai_copy(e->addrinfo);
+
+    if (e->retcode != 0 || ai != NULL) {
+      QUEUE_REMOVE(&e->lru);
+      QUEUE_INSERT_TAIL(&uv__dns_cache_lru, &e->lru);
+      req->addrinfo = ai;
+      req->retcode = e->retcode;
+      hit = 1;
+    }
+  }
+  uv_mutex_unlock(&uv__dns_cache_mutex);
+
+  uv__free(key);
+  return hit;
+}
+
+
+/* Remembers the outcome of `req` for `ttl` seconds. Only answers and "no such
+ * name" are cached, everything else may be transient.
+ */
+void uv__dns_cache_store(const uv_getaddrinfo_t* req,
+                         int retcode,
+                         const struct addrinfo* ai,
+                         unsigned int ttl) {
+  struct uv__dns_cache_entry* old;
+  struct uv__dns_cache_entry* e;
+  struct addrinfo* copy;
+  unsigned int hash;
+  char* key;
+  QUEUE* q;
+
+  if (ttl == 0)
+    return;
+
+  if (retcode != 0 && retcode != UV_EAI_NONAME && retcode != UV_EAI_NODATA)
+    return;
+
+  if (retcode == 0 && ai == NULL)
+    return;
+
+  uv_once(&uv__dns_cache_once, uv__dns_cache_init);
+
+  copy = NULL;
+  if (retcode == 0) {
+    copy = uv__dns_ai_copy(ai);
+    if (copy == NULL)
+      return;
+  }
+
+  key = uv__dns_cache_key(req, &hash);
+  if (key == NULL)
+    goto fail;
+
+  e = uv__malloc(sizeof(*e) + strlen(key));
+  if (e == NULL)
+    goto fail;
+
+  strcpy(e->key, key);
+  uv__free(key);
+  e->hash = hash;
+  e->retcode = retcode;
+  e->addrinfo = copy;
+  e->expires = uv_hrtime() + (uint64_t) ttl * 1000000000;
+
+  uv_mutex_lock(&uv__dns_cache_mutex);
+  old = uv__dns_cache_find(e->key, hash);
+  if (old != NULL)
+    uv__dns_cache_unlink(old);
+
+  if (uv__dns_cache_size >= UV__DNS_CACHE_MAX) {
+    q = QUEUE_HEAD(&uv__dns_cache_lru);
+    uv__dns_cache_unlink(QUEUE_DATA(q, struct uv__dns_cache_entry, lru));
+  }
+
+  e->next = uv__dns_cache[hash % UV__DNS_CACHE_BUCKETS];
+  uv__dns_cache[hash % UV__DNS_CACHE_BUCKETS] = e;
+  QUEUE_INSERT_TAIL(&uv__dns_cache_lru, &e->lru);
+  uv__dns_cache_size++;
+  uv_mutex_unlock(&uv__dns_cache_mutex);
+  return;
+
+fail:
+  uv__free(key);
+  if (copy != NULL)
+    freeaddrinfo(copy);
+}
+
+
+int uv__dns_cache_configure(uv_loop_t* loop, unsigned int ttl) {
+  loop->dns_cache_ttl = ttl;
+  return 0;
+}
+
+
+/* Returns the file's contents, NUL-terminated, or NULL if it can't be read.
+ * Updates the stamp that uv__dns_file_changed() compares against.
+ */
+static char* uv__dns_file_read(struct uv__dns_file* file) {
+  struct stat st;
+  ssize_t n;
+  size_t len;
+  char* buf;
+  int fd;
+
+  file->exists = 0;
+
+  fd = uv__open_cloexec(file->path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  buf = NULL;
+  if (fstat(fd, &st))
+    goto out;
+
+  file->exists = 1;
+  file->dev = st.st_dev;
+  file->ino = st.st_ino;
+  file->size = st.st_size;
+  file->mtime = st.st_mtime;
+
+  /* Not meant for multi-megabyte hosts files. */
+  if (st.st_size > 1024 * 1024)
+    goto out;
+
+  buf = uv__malloc(st.st_size + 1);
+  if (buf == NULL)
+    goto out;
+
+  len = 0;
+  while (len < (size_t) st.st_size) {
+    n = read(fd, buf + len, st.st_size - len);
+    if (n == -1 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    len += n;
+  }
+  buf[len] = '\0';
+
+out:
+  uv__close(fd);
+  return buf;
+}
+
+
+static int uv__dns_file_changed(const struct uv__dns_file* file) {
+  struct stat st;
+
+  if (stat(file->path, &st))
+    return file->exists;
+
+  return !file->exists ||
+         st.st_dev != file->dev ||
+         st.st_ino != file->ino ||
+         st.st_size != file->size ||
+         st.st_mtime != file->mtime;
+}
+
+
+/* Cuts the line at `*s` off the buffer and returns it, NULL at the end. */
+static char* uv__dns_line(char** s) {
+  char* line;
+  char* p;
+
+  line = *s;
+  if (line == NULL || *line == '\0')
+    return NULL;
+
+  p = strchr(line, '\n');
+  if (p != NULL)
+    *p++ = '\0';
+
+  *s = p;
+  return line;
+}
+
+
+/* Returns the next whitespace separated token on the line or NULL at its end.
+ * Comments start with '#' or ';'.
+ */
+static char* uv__dns_token(char** s) {
+  char* p;
+  char* t;
+
+  p = *s;
+  while (*p == ' ' || *p == '\t' || *p == '\r')
+    p++;
+
+  if (*p == '\0' || *p == '#' || *p == ';') {
+    *s = p;
+    return NULL;
+  }
+
+  t = p;
+  while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r')
+    p++;
+
+  if (*p != '\0')
+    *p++ = '\0';
+
+  *s = p;
+  return t;
+}
+
+
+/* Accepts "addr" and, like the BSD resolvers, "[addr]:port". */
+static int uv__dns_parse_server(const char* s, struct sockaddr_storage* ss) {
+  char host[INET6_ADDRSTRLEN + 32];
+  const char* end;
+  unsigned int port;
+  size_t len;
+
+  port = UV__DNS_PORT;
+
+  if (*s == '[') {
+    end = strchr(s, ']');
+    if (end == NULL)
+      return -1;
+
+    len = end - s - 1;
+    if (len >= sizeof(host))
+      return -1;
+
+    memcpy(host, s + 1, len);
+    host[len] = '\0';
+
+    if (end[1] == ':') {
+      port = strtoul(end + 2, NULL, 10);
+      if (port == 0 || port > 65535)
+        return -1;
+    }
+  } else {
+    len = strlen(s);
+    if (len >= sizeof(host))
+      return -1;
+    memcpy(host, s, len + 1);
+  }
+
+  memset(ss, 0, sizeof(*ss));
+  if (uv_ip4_addr(host, port, (struct sockaddr_in*) ss) == 0)
+    return 0;
+  if (uv_ip6_addr(host, port, (struct sockaddr_in6*) ss) == 0)
+    return 0;
+
+  return -1;
+}
+
+
+static void uv__dns_parse_conf(struct uv__dns_conf* conf, char* buf) {
+  unsigned int n;
+  char* tok;
+  char* s;
+
+  memset(conf, 0, sizeof(*conf));
+  conf->ndots = 1;
+  conf->timeout = 5000;
+  conf->attempts = 2;
+
+  while ((s = uv__dns_line(&buf)) != NULL) {
+    tok = uv__dns_token(&s);
+    if (tok == NULL)
+      continue;
+
+    if (strcmp(tok, "nameserver") == 0) {
+      tok = uv__dns_token(&s);
+      if (tok != NULL &&
+          conf->nservers < UV__DNS_MAXNS &&
+          uv__dns_parse_server(tok, conf->servers + conf->nservers) == 0) {
+        conf->nservers++;
+      }
+    } else if (strcmp(tok, "domain") == 0 || strcmp(tok, "search") == 0) {
+      /* The last of these lines wins. */
+      conf->nsearch = 0;
+      while ((tok = uv__dns_token(&s)) != NULL) {
+        if (conf->nsearch == UV__DNS_MAXSEARCH || strlen(tok) > UV__DNS_MAXNAME)
+          continue;
+        strcpy(conf->search[conf->nsearch++], tok);
+      }
+    } else if (strcmp(tok, "options") == 0) {
+      while ((tok = uv__dns_token(&s)) != NULL) {
+        if (strncmp(tok, "ndots:", 6) == 0) {
+          n = strtoul(tok + 6, NULL, 10);
+          conf->ndots = n > 15 ? 15 : n;
+        } else if (strncmp(tok, "timeout:", 8) == 0) {
+          n = strtoul(tok + 8, NULL, 10);
+          conf->timeout = 1000 * (n < 1 ? 1 : n > 30 ? 30 : n);
+        } else if (strncmp(tok, "attempts:", 9) == 0) {
+          n = strtoul(tok + 9, NULL, 10);
+          conf->attempts = n < 1 ? 1 : n > 5 ? 5 : n;
+        } else if (strcmp(tok, "use-vc") == 0 || strcmp(tok, "usevc") == 0) {
+          conf->use_vc = 1;
+        }
+      }
+    }
+  }
+
+  if (conf->nservers == 0) {
+    uv_ip4_addr("127.0.0.1",
+                UV__DNS_PORT,
+                (struct sockaddr_in*) conf->servers);
+    conf->nservers = 1;
+  }
+}
+
+
+static void uv__dns_parse_hosts(struct uv__dns_resolver* r, char* buf) {
+  struct uv__dns_host* hosts;
+  struct uv__dns_host host;
+  unsigned int cap;
+  char* name;
+  char* tok;
+  char* s;
+
+  r->hosts = NULL;
+  r->nhosts = 0;
+  cap = 0;
+
+  while ((s = uv__dns_line(&buf)) != NULL) {
+    tok = uv__dns_token(&s);
+    if (tok == NULL)
+      continue;
+
+    memset(&host, 0, sizeof(host));
+    if (uv_inet_pton(AF_INET, tok, host.addr) == 0)
+      host.family = AF_INET;
+    else if (uv_inet_pton(AF_INET6, tok, host.addr) == 0)
+      host.family = AF_INET6;
+    else
+      continue;
+
+    while ((name = uv__dns_token(&s)) != NULL) {
+      if (r->nhosts == cap) {
+        cap = cap == 0 ? 16 : 2 * cap;
+        hosts = uv__realloc(r->hosts, cap * sizeof(*hosts));
+        if (hosts == NULL)
+          return;
+        r->hosts = hosts;
+      }
+
+      host.name = name;
+      r->hosts[r->nhosts++] = host;
+    }
+  }
+}
+
+
+/* What AI_ADDRCONFIG looks at: is there a non-loopback address of the
+ * family? Link-local IPv6 addresses don't count either.
+ */
+static void uv__dns_addrconfig(struct uv__dns_resolver* r) {
+  uv_interface_address_t* addrs;
+  const unsigned char* a6;
+  int count;
+  int i;
+
+  r->have_ipv4 = 0;
+  r->have_ipv6 = 0;
+
+  if (uv_interface_addresses(&addrs, &count))
+    return;
+
+  for (i = 0; i < count; i++) {
+    if (addrs[i].is_internal)
+      continue;
+
+    if (addrs[i].address.address4.sin_family == AF_INET) {
+      r->have_ipv4 = 1;
+    } else if (addrs[i].address.address6.sin6_family == AF_INET6) {
+      a6 = (const unsigned char*) &addrs[i].address.address6.sin6_addr;
+      if (!(a6[0] == 0xfe && (a6[1] & 0xc0) == 0x80))
+        r->have_ipv6 = 1;
+    }
+  }
+
+  uv_free_interface_addresses(addrs, count);
+}
+
+
+static void uv__dns_reload(struct uv__dns_resolver* r) {
+  char* buf;
+
+  if (r->loaded && r->loop->time - r->checked < UV__DNS_RELOAD_INTERVAL)
+    return;
+
+  if (!r->loaded || uv__dns_file_changed(&r->conf_file)) {
+    buf = uv__dns_file_read(&r->conf_file);
+    uv__dns_parse_conf(&r->conf, buf);
+    uv__free(buf);
+  }
+
+  if (!r->loaded || uv__dns_file_changed(&r->hosts_file)) {
+    uv__free(r->hosts);
+    uv__free(r->hosts_buf);
+    r->hosts = NULL;
+    r->nhosts = 0;
+    r->hosts_buf = uv__dns_file_read(&r->hosts_file);
+    if (r->hosts_buf != NULL)
+      uv__dns_parse_hosts(r, r->hosts_buf);
+  }
+
+  uv__dns_addrconfig(r);
+  r->checked = r->loop->time;
+  r->loaded = 1;
+}
+
+
+static int uv__dns_encode_query(unsigned char* buf,
+                                unsigned short id,
+                                const char* name,
+                                int qtype) {
+  const char* label;
+  const char* dot;
+  unsigned char* p;
+  size_t len;
+
+  p = buf;
+  *p++ = id >> 8;
+  *p++ = id & 255;
+  *p++ = 0x01;  /* RD */
+  *p++ = 0;
+  *p++ = 0;
+  *p++ = 1;     /* QDCOUNT */
+  memset(p, 0, 6);
+  p += 6;
+
+  for (label = name; *label != '\0'; label = dot + 1) {
+    dot = strchr(label, '.');
+    if (dot == NULL)
+      dot = label + strlen(label);
+
+    len = dot - label;
+    if (len == 0 || len > 63)
+      return -1;
+
+    *p++ = len;
+    memcpy(p, label, len);
+    p += len;
+
+    if (*dot == '\0')
+      break;
+  }
+
+  *p++ = 0;
+  *p++ = qtype >> 8;
+  *p++ = qtype & 255;
+  *p++ = 0;
+  *p++ = UV__DNS_C_IN;
+
+  return p - buf;
+}
+
+
+static int uv__dns_skip_name(const unsigned char* msg,
+                             size_t len,
+                             size_t* off) {
+  size_t o;
+
+  for (o = *off; o < len; o += msg[o] + 1) {
+    if (msg[o] == 0) {
+      *off = o + 1;
+      return 0;
+    }
+
+    if ((msg[o] & 0xc0) == 0xc0) {
+      if (o + 2 > len)
+        return -1;
+      *off = o + 2;
+      return 0;
+    }
+
+    if (msg[o] & 0xc0)
+      return -1;
+  }
+
+  return -1;
+}
+
+
+/* Compares the (uncompressed) question name at `*off` with `name`. */
+static int uv__dns_match_name(const unsigned char* msg,
+                              size_t len,
+                              size_t* off,
+                              const char* name) {
+  const char* p;
+  size_t o;
+  size_t n;
+
+  p = name;
+  o = *off;
+
+  while (o < len && msg[o] != 0) {
+    n = msg[o++];
+    if (n > 63 || o + n > len)
+      return -1;
+
+    if (p != name) {
+      if (*p != '.')
+        return -1;
+      p++;
+    }
+
+    if (strncasecmp((const char*) msg + o, p, n) != 0)
+      return -1;
+
+    p += n;
+    o += n;
+  }
+
+  if (o >= len || *p != '\0')
+    return -1;
+
+  *off = o + 1;
+  return 0;
+}
+
+
+static unsigned int uv__dns_get32(const unsigned char* p) {
+  return ((unsigned int) p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+
+static int uv__dns_parse(struct uv__dns_query* q,
+                         const unsigned char* msg,
+                         size_t len,
+                         int* which) {
+  unsigned int ancount;
+  unsigned int nscount;
+  unsigned int rdlen;
+  unsigned int type;
+  unsigned int ttl;
+  unsigned int min;
+  size_t off;
+  int rcode;
+  int qtype;
+  int i;
+
+  if (len < 12 || (msg[2] & 0x80) == 0)
+    return UV__DNS_IGNORE;
+
+  *which = 0;
+  for (i = UV__DNS_Q_A; i <= UV__DNS_Q_AAAA; i++)
+    if ((q->qtypes & i) && !(q->answered & i) &&
+        q->ids[i] == ((msg[0] << 8) | msg[1]))
+      *which = i;
+
+  if (*which == 0)
+    return UV__DNS_IGNORE;
+
+  qtype = *which == UV__DNS_Q_A ? UV__DNS_T_A : UV__DNS_T_AAAA;
+
+  if (((msg[4] << 8) | msg[5]) != 1)
+    return UV__DNS_IGNORE;
+
+  off = 12;
+  if (uv__dns_match_name(msg, len, &off, q->name) ||
+      off + 4 > len ||
+      ((msg[off] << 8) | msg[off + 1]) != qtype ||
+      ((msg[off + 2] << 8) | msg[off + 3]) != UV__DNS_C_IN) {
+    return UV__DNS_IGNORE;
+  }
+  off += 4;
+
+  if (msg[2] & 0x02)
+    return UV__DNS_TRUNCATED;
+
+  rcode = msg[3] & 15;
+  if (rcode != 0 && rcode != 3)
+    return UV__DNS_SERVFAIL;
+
+  ancount = (msg[6] << 8) | msg[7];
+  nscount = (msg[8] << 8) | msg[9];
+
+  /* The answer section holds the CNAME chain, if any, and the addresses it
+   * ends in. Take every address of the right type.
+   */
+  for (; ancount > 0; ancount--) {
+    if (uv__dns_skip_name(msg, len, &off) || off + 10 > len)
+      return UV__DNS_SERVFAIL;
+
+    type = (msg[off] << 8) | msg[off + 1];
+    ttl = uv__dns_get32(msg + off + 4);
+    rdlen = (msg[off + 8] << 8) | msg[off + 9];
+    off += 10;
+
+    if (off + rdlen > len)
+      return UV__DNS_SERVFAIL;
+
+    if (type == (unsigned int) qtype || type == UV__DNS_T_CNAME)
+      if (ttl < q->ttl)
+        q->ttl = ttl;
+
+    if (type == (unsigned int) qtype &&
+        rdlen == (qtype == UV__DNS_T_A ? 4u : 16u) &&
+        q->naddrs[*which] < UV__DNS_MAXADDRS) {
+      memcpy(q->addrs[*which][q->naddrs[*which]++], msg + off, rdlen);
+    }
+
+    off += rdlen;
+  }
+
+  /* No addresses: the SOA in the authority section says for how long the
+   * name or type is known not to exist (RFC 2308).
+   */
+  for (; nscount > 0 && q->naddrs[*which] == 0; nscount--) {
+    if (uv__dns_skip_name(msg, len, &off) || off + 10 > len)
+      break;
+
+    type = (msg[off] << 8) | msg[off + 1];
+    ttl = uv__dns_get32(msg + off + 4);
+    rdlen = (msg[off + 8] << 8) | msg[off + 9];
+    off += 10;
+
+    if (off + rdlen > len)
+      break;
+
+    if (type == UV__DNS_T_SOA && rdlen >= 20) {
+      min = uv__dns_get32(msg + off + rdlen - 4);
+      q->negative_ttl = ttl < min ? ttl : min;
+    }
+
+    off += rdlen;
+  }
+
+  return rcode == 3 ? UV__DNS_NXDOMAIN : UV__DNS_ANSWER;
+}
+
+
+static void uv__dns_arm(struct uv__dns_resolver* r) {
+  struct uv__dns_query* q;
+  uint64_t deadline;
+  QUEUE* qq;
+
+  deadline = 0;
+  QUEUE_FOREACH(qq, &r->queries) {
+    q = QUEUE_DATA(qq, struct uv__dns_query, queue);
+    if (q->io.fd != -1 && (deadline == 0 || q->deadline < deadline))
+      deadline = q->deadline;
+  }
+
+  if (deadline == 0) {
+    uv_timer_stop(&r->timer);
+    return;
+  }
+
+  if (deadline < r->loop->time)
+    deadline = r->loop->time;
+
+  uv_timer_start(&r->timer, uv__dns_timer_cb, deadline - r->loop->time, 0);
+}
+
+
+static void uv__dns_query_close(struct uv__dns_query* q) {
+  if (q->io.fd == -1)
+    return;
+
+  uv__io_close(q->resolver->loop, &q->io);
+  uv__close(q->io.fd);
+  q->io.fd = -1;
+  q->in_len = 0;
+}
+
+
+static void uv__dns_query_finish(struct uv__dns_query* q, int status) {
+  struct uv__dns_resolver* r;
+  struct addrinfo** tail;
+  struct addrinfo* head;
+  struct addrinfo* ai;
+  uv_getaddrinfo_t* req;
+  unsigned int order[2];
+  unsigned int i;
+  unsigned int j;
+  unsigned int k;
+  unsigned int ttl;
+
+  r = q->resolver;
+  req = q->req;
+
+  uv__dns_query_close(q);
+  QUEUE_REMOVE(&q->queue);
+  uv__dns_arm(r);
+
+  /* Like getaddrinfo() with the default RFC 6724 policy, prefer IPv6 when
+   * there is a route for it.
+   */
+  order[0] = r->have_ipv6 ? UV__DNS_Q_AAAA : UV__DNS_Q_A;
+  order[1] = r->have_ipv6 ? UV__DNS_Q_A : UV__DNS_Q_AAAA;
+
+  head = NULL;
+  tail = &head;
+
+  for (i = 0; status == 0 && i < ARRAY_SIZE(order); i++) {
+    for (j = 0; status == 0 && j < q->naddrs[order[i]]; j++) {
+      for (k = 0; k < q->nsocktypes; k++) {
+        ai = uv__dns_ai_new(order[i] == UV__DNS_Q_A ? AF_INET : AF_INET6,
+                            q->addrs[order[i]][j],
+                            q->port,
+                            q->socktypes[k][0],
+                            q->socktypes[k][1]);
+        if (ai == NULL) {
+          status = UV_EAI_MEMORY;
+          break;
+        }
+        *tail = ai;
+        tail = &ai->ai_next;
+      }
+    }
+  }
+
+  if (status != 0 && head != NULL) {
+    freeaddrinfo(head);
+    head = NULL;
+  }
+
+  if (r->loop->dns_cache_ttl != 0 && q->cacheable) {
+    ttl = status == 0 ? q->ttl : q->negative_ttl;
+    if (ttl > r->loop->dns_cache_ttl)
+      ttl = r->loop->dns_cache_ttl;
+    uv__dns_cache_store(req, status, head, ttl);
+  }
+
+  req->addrinfo = head;
+  req->retcode = status;
+
+  /* Never call back from inside uv_getaddrinfo(). */
+  if (r->starting == req)
+    uv__work_complete(r->loop, &req->work_req, req->work_req.done);
+  else
+    req->work_req.done(&req->work_req, 0);
+
+  uv__free(q->in);
+  uv__free(q);
+}
+
+
+/* Returns non-zero when the query moved on to another socket or finished,
+ * `q` may be gone then.
+ */
+static int uv__dns_query_answer(struct uv__dns_query* q,
+                                const unsigned char* msg,
+                                size_t len) {
+  int which;
+
+  switch (uv__dns_parse(q, msg, len, &which)) {
+  case UV__DNS_IGNORE:
+    return 0;
+
+  case UV__DNS_TRUNCATED:
+    if (!q->tcp) {
+      /* Ask the same server again, over TCP. */
+      q->tcp = 1;
+      q->tries--;
+    }
+    uv__dns_query_send(q);
+    return 1;
+
+  case UV__DNS_SERVFAIL:
+    uv__dns_query_send(q);
+    return 1;
+
+  case UV__DNS_NXDOMAIN:
+    uv__dns_query_next(q);
+    return 1;
+
+  default:
+    q->answered |= which;
+    if (q->answered != q->qtypes)
+      return 0;
+
+    if (q->naddrs[UV__DNS_Q_A] + q->naddrs[UV__DNS_Q_AAAA] > 0)
+      uv__dns_query_finish(q, 0);
+    else
+      uv__dns_query_next(q);  /* NODATA */
+    return 1;
+  }
+}
+
+
+static void uv__dns_query_read_udp(struct uv__dns_query* q) {
+  unsigned char buf[4096];
+  ssize_t n;
+
+  for (;;) {
+    do
+      n = recv(q->io.fd, buf, sizeof(buf), 0);
+    while (n == -1 && errno == EINTR);
+
+    if (n == -1) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        uv__dns_query_send(q);  /* E.g. ECONNREFUSED, try the next server. */
+      return;
+    }
+
+    if (uv__dns_query_answer(q, buf, n))
+      return;
+  }
+}
+
+
+static void uv__dns_query_read_tcp(struct uv__dns_query* q) {
+  unsigned char* buf;
+  size_t framelen;
+  ssize_t n;
+
+  for (;;) {
+    if (q->in_cap - q->in_len < 4096) {
+      buf = uv__realloc(q->in, q->in_cap + 65536 + 2);
+      if (buf == NULL) {
+        uv__dns_query_finish(q, UV_EAI_MEMORY);
+        return;
+      }
+      q->in = buf;
+      q->in_cap += 65536 + 2;
+    }
+
+    do
+      n = read(q->io.fd, q->in + q->in_len, q->in_cap - q->in_len);
+    while (n == -1 && errno == EINTR);
+
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+
+    if (n <= 0) {
+      uv__dns_query_send(q);
+      return;
+    }
+
+    q->in_len += n;
+
+    while (q->in_len >= 2) {
+      framelen = (q->in[0] << 8) | q->in[1];
+      if (q->in_len < 2 + framelen)
+        break;
+
+      if (uv__dns_query_answer(q, q->in + 2, framelen))
+        return;
+
+      q->in_len -= 2 + framelen;
+      memmove(q->in, q->in + 2 + framelen, q->in_len);
+    }
+  }
+}
+
+
+/* Returns non-zero when `q` moved on to another socket or is gone. */
+static int uv__dns_query_write_tcp(struct uv__dns_query* q) {
+  socklen_t len;
+  ssize_t n;
+  int err;
+
+  if (q->out_pos == 0) {
+    /* First UV__POLLOUT, find out if the connect() went through. */
+    err = 0;
+    len = sizeof(err);
+    if (getsockopt(q->io.fd, SOL_SOCKET, SO_ERROR, &err, &len) || err) {
+      uv__dns_query_send(q);
+      return 1;
+    }
+  }
+
+  do
+    n = write(q->io.fd, q->out + q->out_pos, q->out_len - q->out_pos);
+  while (n == -1 && errno == EINTR);
+
+  if (n == -1) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return 0;
+    uv__dns_query_send(q);
+    return 1;
+  }
+
+  q->out_pos += n;
+  if (q->out_pos == q->out_len)
+    uv__io_stop(q->resolver->loop, &q->io, UV__POLLOUT);
+
+  return 0;
+}
+
+
+static void uv__dns_query_io(uv_loop_t* loop,
+                             uv__io_t* w,
+                             unsigned int events) {
+  struct uv__dns_query* q;
+
+  q = container_of(w, struct uv__dns_query, io);
+
+  if (q->tcp && (events & (UV__POLLOUT | UV__POLLERR | UV__POLLHUP)) &&
+      q->out_pos < q->out_len) {
+    if (uv__dns_query_write_tcp(q))
+      return;
+  }
+
+  if (events & (UV__POLLIN | UV__POLLERR | UV__POLLHUP)) {
+    if (q->tcp)
+      uv__dns_query_read_tcp(q);
+    else
+      uv__dns_query_read_udp(q);
+  }
+}
+
+
+/* Fills `buf` from the kernel's random number generator. Answers go into the
+ * cache that every loop shares, the transaction ids and source ports that keep
+ * forged ones out must not be predictable.
+ */
+static int uv__dns_random(void* buf, size_t len) {
+  unsigned char* p;
+  ssize_t n;
+  int err;
+  int fd;
+
+  p = buf;
+
+#if defined(__linux__)
+  while (len > 0) {
+    n = uv__getrandom(p, len, 0);
+    if (n == -1) {
+      if (errno == EINTR)
+        continue;
+      if (errno == ENOSYS)
+        break;  /* Older than 3.17, read /dev/urandom instead. */
+      return -errno;
+    }
+    p += n;
+    len -= n;
+  }
+
+  if (len == 0)
+    return 0;
+#elif defined(__FreeBSD__) || defined(__NetBSD__) || \
+      defined(__OpenBSD__) || defined(__DragonFly__)
+  arc4random_buf(p, len);
+  return 0;
+#endif
+
+  fd = uv__open_cloexec("/dev/urandom", O_RDONLY);
+  if (fd < 0)
+    return fd;
+
+  err = 0;
+  while (len > 0) {
+    do
+      n = read(fd, p, len);
+    while (n == -1 && errno == EINTR);
+
+    if (n <= 0) {
+      err = n == 0 ? -EIO : -errno;
+      break;
+    }
+    p += n;
+    len -= n;
+  }
+
+  uv__close(fd);
+  return err;
+}
+
+
+/* Binds a UDP socket to one of the random `ports`, so that a forged answer
+ * has to guess the port on top of the transaction id. If they're all taken,
+ * the port the kernel picks on connect() will have to do.
+ */
+static void uv__dns_bind_random(int fd,
+                                int family,
+                                const unsigned short* ports) {
+  struct sockaddr_storage ss;
+  struct sockaddr_in6* addr6;
+  struct sockaddr_in* addr4;
+  socklen_t addrlen;
+  unsigned short port;
+  int i;
+
+  memset(&ss, 0, sizeof(ss));
+  addr4 = (struct sockaddr_in*) &ss;
+  addr6 = (struct sockaddr_in6*) &ss;
+  ss.ss_family = family;
+
+  for (i = 0; i < UV__DNS_BIND_TRIES; i++) {
+    /* Stay clear of the privileged ports. */
+    port = htons(1024 + ports[i] % (65536 - 1024));
+
+    if (family == AF_INET6) {
+      addr6->sin6_port = port;
+      addrlen = sizeof(*addr6);
+    } else {
+      addr4->sin_port = port;
+      addrlen = sizeof(*addr4);
+    }
+
+    if (bind(fd, (const struct sockaddr*) &ss, addrlen) == 0)
+      return;
+
+    if (errno != EADDRINUSE)
+      return;
+  }
+}
+
+
+/* (Re)sends the unanswered questions for the current name, to the next
+ * nameserver in line, until every server was tried `attempts` times.
+ */
+static void uv__dns_query_send(struct uv__dns_query* q) {
+  const struct sockaddr_storage* server;
+  struct uv__dns_resolver* r;
+  unsigned short rnd[2 + UV__DNS_BIND_TRIES];
+  unsigned char* p;
+  socklen_t addrlen;
+  int qtype;
+  int len;
+  int fd;
+  int i;
+
+  r = q->resolver;
+
+  for (;;) {
+    uv__dns_query_close(q);
+
+    if (q->tries >= r->conf.attempts * r->conf.nservers) {
+      uv__dns_query_finish(q, UV_EAI_AGAIN);
+      return;
+    }
+
+    server = r->conf.servers + q->tries % r->conf.nservers;
+    q->tries++;
+
+    /* A transaction id for each question, then the source ports. */
+    if (uv__dns_random(rnd, sizeof(rnd))) {
+      uv__dns_query_finish(q, UV_EAI_FAIL);
+      return;
+    }
+
+    if (server->ss_family == AF_INET6)
+      addrlen = sizeof(struct sockaddr_in6);
+    else
+      addrlen = sizeof(struct sockaddr_in);
+
+    fd = uv__socket(server->ss_family, q->tcp ? SOCK_STREAM : SOCK_DGRAM, 0);
+    if (fd < 0)
+      continue;
+
+    if (!q->tcp)
+      uv__dns_bind_random(fd, server->ss_family, rnd + 2);
+
+    if (connect(fd, (const struct sockaddr*) server, addrlen) &&
+        errno != EINPROGRESS) {
+      uv__close(fd);
+      continue;
+    }
+
+    uv__io_init(&q->io, uv__dns_query_io, fd);
+    q->out_len = 0;
+    q->out_pos = 0;
+
+    for (i = UV__DNS_Q_A; i <= UV__DNS_Q_AAAA; i++) {
+      if (!(q->qtypes & i) || (q->answered & i))
+        continue;
+
+      qtype = i == UV__DNS_Q_A ? UV__DNS_T_A : UV__DNS_T_AAAA;
+      q->ids[i] = rnd[i - UV__DNS_Q_A];
+      p = q->out + q->out_len;
+      len = uv__dns_encode_query(p + 2, q->ids[i], q->name, qtype);
+      assert(len > 0);  /* The name was checked in uv__dns_query_next(). */
+
+      if (q->tcp) {
+        p[0] = len >> 8;
+        p[1] = len & 255;
+        q->out_len += 2 + len;
+      } else if (send(fd, p + 2, len, 0) == -1) {
+        break;
+      }
+    }
+
+    if (i <= UV__DNS_Q_AAAA)
+      continue;
+
+    if (q->tcp)
+      uv__io_start(r->loop, &q->io, UV__POLLIN | UV__POLLOUT);
+    else
+      uv__io_start(r->loop, &q->io, UV__POLLIN);
+    q->deadline = r->loop->time + r->conf.timeout;
+    uv__dns_arm(r);
+    return;
+  }
+}
+
+
+/* Moves on to the next name in the search order: with fewer than `ndots`
+ * dots the search domains come first, otherwise the name as given does.
+ */
+static void uv__dns_query_next(struct uv__dns_query* q) {
+  struct uv__dns_resolver* r;
+  const char* hostname;
+  unsigned int dots;
+  unsigned int i;
+  size_t len;
+  int n;
+
+  r = q->resolver;
+  hostname = q->req->hostname;
+  len = strlen(hostname);
+
+  for (dots = 0, i = 0; i < len; i++)
+    dots += hostname[i] == '.';
+
+  for (q->candidate++; q->candidate < q->ncandidates; q->candidate++) {
+    if (hostname[len - 1] == '.') {
+      /* Absolute name, no search. */
+      n = snprintf(q->name, sizeof(q->name), "%.*s", (int) len - 1, hostname);
+    } else {
+      i = q->candidate;
+      if (dots >= r->conf.ndots)
+        i = (i + r->conf.nsearch) % (r->conf.nsearch + 1);
+
+      if (i == r->conf.nsearch)
+        n = snprintf(q->name, sizeof(q->name), "%s", hostname);
+      else
+        n = snprintf(q->name,
+                     sizeof(q->name),
+                     "%s.%s",
+                     hostname,
+                     r->conf.search[i]);
+    }
+
+    if (n <= 0 || (size_t) n >= sizeof(q->name))
+      continue;
+
+    if (uv__dns_encode_query(q->out, 0, q->name, UV__DNS_T_A) < 0)
+      continue;
+
+    q->answered = 0;
+    q->naddrs[UV__DNS_Q_A] = 0;
+    q->naddrs[UV__DNS_Q_AAAA] = 0;
+    q->ttl = (unsigned int) -1;
+    q->tries = 0;
+    q->tcp = r->conf.use_vc;
+    uv__dns_query_send(q);
+    return;
+  }
+
+  uv__dns_query_finish(q, UV_EAI_NONAME);
+}
+
+
+static int uv__dns_query_hosts(struct uv__dns_query* q) {
+  struct uv__dns_resolver* r;
+  struct uv__dns_host* h;
+  unsigned int i;
+  int which;
+
+  r = q->resolver;
+
+  for (i = 0; i < r->nhosts; i++) {
+    h = r->hosts + i;
+    which = h->family == AF_INET ? UV__DNS_Q_A : UV__DNS_Q_AAAA;
+
+    if (!(q->qtypes & which) ||
+        q->naddrs[which] == UV__DNS_MAXADDRS ||
+        strcasecmp(h->name, q->req->hostname) != 0) {
+      continue;
+    }
+
+    memcpy(q->addrs[which][q->naddrs[which]++], h->addr, 16);
+  }
+
+  return q->naddrs[UV__DNS_Q_A] + q->naddrs[UV__DNS_Q_AAAA] > 0;
+}
+
+
+/* Fills in the (socktype, protocol) pairs getaddrinfo() would return, or
+ * returns -1 for combinations that are left to getaddrinfo().
+ */
+static int uv__dns_socktypes(struct uv__dns_query* q,
+                             const struct addrinfo* hints,
+                             int has_service) {
+  int socktype;
+  int protocol;
+
+  socktype = hints != NULL ? hints->ai_socktype : 0;
+  protocol = hints != NULL ? hints->ai_protocol : 0;
+  q->nsocktypes = 0;
+
+  if ((socktype == 0 || socktype == SOCK_STREAM) &&
+      (protocol == 0 || protocol == IPPROTO_TCP)) {
+    q->socktypes[q->nsocktypes][0] = SOCK_STREAM;
+    q->socktypes[q->nsocktypes][1] = IPPROTO_TCP;
+    q->nsocktypes++;
+  }
+
+  if ((socktype == 0 || socktype == SOCK_DGRAM) &&
+      (protocol == 0 || protocol == IPPROTO_UDP)) {
+    q->socktypes[q->nsocktypes][0] = SOCK_DGRAM;
+    q->socktypes[q->nsocktypes][1] = IPPROTO_UDP;
+    q->nsocktypes++;
+  }
+
+  if (((socktype == 0 && protocol == 0) || socktype == SOCK_RAW) &&
+      !has_service) {
+    q->socktypes[q->nsocktypes][0] = SOCK_RAW;
+    q->socktypes[q->nsocktypes][1] = protocol;
+    q->nsocktypes++;
+  }
+
+  return q->nsocktypes > 0 ? 0 : -1;
+}
+
+
+/* Takes over `req` if the resolver can answer it. Returns 0 when it did,
+ * `done` is then called once the answer is in. Anything else means the
+ * request should go to getaddrinfo().
+ */
+int uv__dns_resolve(uv_loop_t* loop,
+                    uv_getaddrinfo_t* req,
+                    void (*done)(struct uv__work* w, int status)) {
+  const struct addrinfo* hints;
+  struct uv__dns_resolver* r;
+  struct uv__dns_query* q;
+  unsigned long port;
+  struct in_addr addr4;
+  const char* s;
+  size_t len;
+  char* end;
+  int family;
+  int flags;
+
+  r = loop->dns_resolver;
+  hints = req->hints;
+
+  if (r == NULL || req->hostname == NULL)
+    return UV_ENOSYS;
+
+  /* Numeric hosts, including the odd inet_aton() forms. */
+  len = strlen(req->hostname);
+  if (len == 0 || len > UV__DNS_MAXNAME + 1 ||
+      strchr(req->hostname, ':') != NULL ||
+      inet_aton(req->hostname, &addr4) != 0) {
+    return UV_ENOSYS;
+  }
+
+  /* Port numbers, but no service names. */
+  port = 0;
+  if (req->service != NULL) {
+    s = req->service;
+    if (*s < '0' || *s > '9')
+      return UV_ENOSYS;
+    port = strtoul(s, &end, 10);
+    if (*end != '\0' || port > 65535)
+      return UV_ENOSYS;
+  }
+
+  family = hints != NULL ? hints->ai_family : AF_UNSPEC;
+  flags = hints != NULL ? hints->ai_flags : 0;
+
+  if (family != AF_UNSPEC && family != AF_INET && family != AF_INET6)
+    return UV_ENOSYS;
+
+  /* AI_V4MAPPED only has an effect with AF_INET6. */
+  if (family != AF_INET6)
+    flags &= ~AI_V4MAPPED;
+
+  if (flags & ~(AI_ADDRCONFIG | AI_PASSIVE | AI_NUMERICSERV))
+    return UV_ENOSYS;
+
+  q = uv__calloc(1, sizeof(*q));
+  if (q == NULL)
+    return UV_ENOMEM;
+
+  if (uv__dns_socktypes(q, hints, req->service != NULL)) {
+    uv__free(q);
+    return UV_ENOSYS;
+  }
+
+  uv__dns_reload(r);
+
+  q->resolver = r;
+  q->req = req;
+  q->port = port;
+  q->io.fd = -1;
+  q->negative_ttl = UV__DNS_NEGATIVE_TTL;
+
+  if (family != AF_INET6)
+    q->qtypes |= UV__DNS_Q_A;
+  if (family != AF_INET)
+    q->qtypes |= UV__DNS_Q_AAAA;
+
+  if ((flags & AI_ADDRCONFIG) && (r->have_ipv4 || r->have_ipv6)) {
+    if (!r->have_ipv4)
+      q->qtypes &= ~UV__DNS_Q_A;
+    if (!r->have_ipv6)
+      q->qtypes &= ~UV__DNS_Q_AAAA;
+  }
+
+  if (q->qtypes == 0) {
+    uv__free(q);
+    return UV_ENOSYS;
+  }
+
+  req->work_req.loop = loop;
+  req->work_req.work = NULL;
+  req->work_req.done = done;
+  QUEUE_INIT(&req->work_req.wq);
+
+  QUEUE_INSERT_TAIL(&r->queries, &q->queue);
+  r->starting = req;
+
+  if (uv__dns_query_hosts(q)) {
+    /* The hosts file is its own cache, don't copy it into ours. */
+    uv__dns_query_finish(q, 0);
+  } else {
+    q->cacheable = 1;
+    q->candidate = (unsigned int) -1;
+    q->ncandidates = req->hostname[len - 1] == '.' ? 1 : r->conf.nsearch + 1;
+    uv__dns_query_next(q);
+  }
+
+  r->starting = NULL;
+  return 0;
+}
+
+
+static void uv__dns_timer_cb(uv_timer_t* handle) {
+  struct uv__dns_resolver* r;
+  struct uv__dns_query* q;
+  QUEUE expired;
+  QUEUE* qq;
+
+  r = container_of(handle, struct uv__dns_resolver, timer);
+
+  /* uv__dns_query_send() may finish and free the query, collect the ones to
+   * retry first.
+   */
+  QUEUE_INIT(&expired);
+  qq = QUEUE_HEAD(&r->queries);
+  while (qq != &r->queries) {
+    q = QUEUE_DATA(qq, struct uv__dns_query, queue);
+    qq = QUEUE_NEXT(qq);
+
+    if (q->io.fd != -1 && q->deadline <= r->loop->time) {
+      QUEUE_REMOVE(&q->queue);
+      QUEUE_INSERT_TAIL(&expired, &q->queue);
+    }
+  }
+
+  while (!QUEUE_EMPTY(&expired)) {
+    qq = QUEUE_HEAD(&expired);
+    QUEUE_REMOVE(qq);
+    QUEUE_INSERT_TAIL(&r->queries, qq);
+    uv__dns_query_send(QUEUE_DATA(qq, struct uv__dns_query, queue));
+  }
+
+  uv__dns_arm(r);
+}
+
+
+static char* uv__dns_strdup_or(const char* s, const char* fallback) {
+  return uv__strdup(s != NULL ? s : fallback);
+}
+
+
+int uv__dns_resolver_configure(uv_loop_t* loop,
+                               const char* conf_path,
+                               const char* hosts_path) {
+  struct uv__dns_resolver* r;
+  char* conf;
+  char* hosts;
+
+  r = loop->dns_resolver;
+  if (r != NULL && !QUEUE_EMPTY(&r->queries))
+    return UV_EBUSY;
+
+  conf = uv__dns_strdup_or(conf_path, "/etc/resolv.conf");
+  hosts = uv__dns_strdup_or(hosts_path, "/etc/hosts");
+  if (conf == NULL || hosts == NULL)
+    goto fail;
+
+  if (r == NULL) {
+    r = uv__calloc(1, sizeof(*r));
+    if (r == NULL)
+      goto fail;
+
+    r->loop = loop;
+    QUEUE_INIT(&r->queries);
+    uv_timer_init(loop, &r->timer);
+    r->timer.timer_cb = uv__dns_timer_cb;
+    uv__handle_unref(&r->timer);
+    r->timer.flags |= UV__HANDLE_INTERNAL;
+    loop->dns_resolver = r;
+  }
+
+  uv__free(r->conf_file.path);
+  uv__free(r->hosts_file.path);
+  r->conf_file.path = conf;
+  r->hosts_file.path = hosts;
+  r->loaded = 0;
+
+  return 0;
+
+fail:
+  uv__free(conf);
+  uv__free(hosts);
+  return UV_ENOMEM;
+}
+
+
+void uv__dns_resolver_delete(uv_loop_t* loop) {
+  struct uv__dns_resolver* r;
+
+  r = loop->dns_resolver;
+  if (r == NULL)
+    return;
+
+  assert(QUEUE_EMPTY(&r->queries));
+  uv_timer_stop(&r->timer);
+  /* Internal handle, there is no loop left to run its close callback. */
+  QUEUE_REMOVE(&r->timer.handle_queue);
+
+  uv__free(r->conf_file.path);
+  uv__free(r->hosts_file.path);
+  uv__free(r->hosts);
+  uv__free(r->hosts_buf);
+  uv__free(r);
+  loop->dns_resolver = NULL;
+}
+
+#else  /* !UV__HAVE_DNS */
+
+int uv__dns_cache_lookup(uv_getaddrinfo_t* req) {
+  return 0;
+}
+
+
+void uv__dns_cache_store(const uv_getaddrinfo_t* req,
+                         int retcode,
+                         const struct addrinfo* ai,
+                         unsigned int ttl) {
+}
+
+
+int uv__dns_cache_configure(uv_loop_t* loop, unsigned int ttl) {
+  return UV_ENOSYS;
+}
+
+
+int uv__dns_resolve(uv_loop_t* loop,
+                    uv_getaddrinfo_t* req,
+                    void (*done)(struct uv__work* w, int status)) {
+  return UV_ENOSYS;
+}
+
+
+int uv__dns_resolver_configure(uv_loop_t* loop,
+                               const char* conf_path,
+                               const char* hosts_path) {
+  return UV_ENOSYS;
+}
+
+
+void uv__dns_resolver_delete(uv_loop_t* loop) {
+}
+
+#endif  /* UV__HAVE_DNS */
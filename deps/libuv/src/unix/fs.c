@@ -44,6 +44,7 @@
 #include <fcntl.h>
 #include <utime.h>
 #include <poll.h>
+#include <dirent.h>
 
 #if defined(__DragonFly__)  ||                                            \
     defined(__FreeBSD__)    ||                                            \
@@ -58,6 +59,44 @@
 # include <sys/sendfile.h>
 #endif
 
+#ifndef O_CLOEXEC
+# define O_CLOEXEC 0
+#endif
+
+#ifndef O_DIRECTORY
+# define O_DIRECTORY 0
+#endif
+
+#ifndef O_NOFOLLOW
+# define O_NOFOLLOW 0
+#endif
+
+/* Entries per uv_fs_walk() batch. */
+#define UV__FS_WALK_BATCH 1024
+
+typedef struct {
+  size_t name;  /* Offset into names. */
+  uv_dirent_type_t type;
+  uv_stat_t statbuf;
+} uv__fs_walk_entry_t;
+
+typedef struct {
+  int rootfd;
+  int flags;
+  int error;          /* Deferred to the next batch. */
+  DIR* dir;           /* The directory being read, */
+  char* dirpath;      /* and its path relative to rootfd. */
+  char** pending;     /* Directories still to be read. */
+  unsigned int npending;
+  unsigned int pending_size;
+  uv__fs_walk_entry_t entries[UV__FS_WALK_BATCH];
+  unsigned int nentries;
+  unsigned int next;  /* Index for uv_fs_walk_next(). */
+  char* names;
+  size_t names_len;
+  size_t names_size;
+} uv__fs_walker_t;
+
 #define INIT(subtype)                                                         \
   do {                                                                        \
     req->type = UV_FS;                                                        \
@@ -109,7 +148,13 @@
 #define POST                                                                  \
   do {                                                                        \
     if (cb != NULL) {                                                         \
-      uv__work_submit(loop, &req->work_req, uv__fs_work, uv__fs_done);        \
+      if (uv__iou_fs_submit(loop, req))                                       \
+        return 0;                                                             \
+      uv__work_submit(loop,                                                   \
+                      &req->work_req,                                         \
+                      loop->fs_work_kind,                                     \
+                      uv__fs_work,                                            \
+                      uv__fs_done);                                           \
       return 0;                                                               \
     }                                                                         \
     else {                                                                    \
@@ -790,6 +835,278 @@ static int uv__fs_fstat(int fd, uv_stat_t *buf) {
 }
 
 
+static uv_dirent_type_t uv__fs_walk_type(mode_t mode) {
+  if (S_ISREG(mode))
+    return UV_DIRENT_FILE;
+  if (S_ISDIR(mode))
+    return UV_DIRENT_DIR;
+  if (S_ISLNK(mode))
+    return UV_DIRENT_LINK;
+  if (S_ISFIFO(mode))
+    return UV_DIRENT_FIFO;
+  if (S_ISSOCK(mode))
+    return UV_DIRENT_SOCKET;
+  if (S_ISCHR(mode))
+    return UV_DIRENT_CHAR;
+  if (S_ISBLK(mode))
+    return UV_DIRENT_BLOCK;
+  return UV_DIRENT_UNKNOWN;
+}
+
+
+static uv_dirent_type_t uv__fs_walk_dtype(const uv__dirent_t* dent) {
+#ifdef HAVE_DIRENT_TYPES
+  switch (dent->d_type) {
+    case UV__DT_DIR:
+      return UV_DIRENT_DIR;
+    case UV__DT_FILE:
+      return UV_DIRENT_FILE;
+    case UV__DT_LINK:
+      return UV_DIRENT_LINK;
+    case UV__DT_FIFO:
+      return UV_DIRENT_FIFO;
+    case UV__DT_SOCKET:
+      return UV_DIRENT_SOCKET;
+    case UV__DT_CHAR:
+      return UV_DIRENT_CHAR;
+    case UV__DT_BLOCK:
+      return UV_DIRENT_BLOCK;
+  }
+#endif
+  return UV_DIRENT_UNKNOWN;
+}
+
+
+static void uv__fs_walk_cleanup(uv_fs_t* req) {
+  uv__fs_walker_t* w;
+
+  w = req->ptr;
+  if (w->dir != NULL)
+    closedir(w->dir);
+  if (w->rootfd != -1)
+    uv__close(w->rootfd);
+
+  while (w->npending > 0)
+    uv__free(w->pending[--w->npending]);
+
+  uv__free(w->pending);
+  uv__free(w->dirpath);
+  uv__free(w->names);
+  uv__free(w);
+  req->ptr = NULL;
+}
+
+
+/* Appends `name` to the path of the directory being read and returns the
+ * offset of the result in w->names.
+ */
+static ssize_t uv__fs_walk_name(uv__fs_walker_t* w, const char* name) {
+  size_t dirlen;
+  size_t len;
+  size_t off;
+  char* names;
+
+  dirlen = strlen(w->dirpath);
+  len = strlen(name);
+
+  if (w->names_len + dirlen + len + 2 > w->names_size) {
+    w->names_size = 2 * w->names_size + dirlen + len + 2;
+    names = uv__realloc(w->names, w->names_size);
+    if (names == NULL) {
+      errno = ENOMEM;
+      return -1;
+    }
+    w->names = names;
+  }
+
+  off = w->names_len;
+  if (dirlen > 0) {
+    memcpy(w->names + w->names_len, w->dirpath, dirlen);
+    w->names_len += dirlen;
+    w->names[w->names_len++] = '/';
+  }
+
+  memcpy(w->names + w->names_len, name, len + 1);
+  w->names_len += len + 1;
+
+  return off;
+}
+
+
+static int uv__fs_walk_push(uv__fs_walker_t* w, const char* path) {
+  unsigned int size;
+  char** pending;
+
+  if (w->npending == w->pending_size) {
+    size = 2 * w->pending_size + 16;
+    pending = uv__realloc(w->pending, size * sizeof(*pending));
+    if (pending == NULL) {
+      errno = ENOMEM;
+      return -1;
+    }
+    w->pending = pending;
+    w->pending_size = size;
+  }
+
+  w->pending[w->npending] = uv__strdup(path);
+  if (w->pending[w->npending] == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  w->npending++;
+  return 0;
+}
+
+
+/* Opens the next directory from the pending list. Returns 0 when there is
+ * none left. Directories that went away since they were seen are skipped.
+ */
+static int uv__fs_walk_open(uv__fs_walker_t* w) {
+  char* path;
+  int fd;
+
+  while (w->npending > 0) {
+    path = w->pending[--w->npending];
+    fd = openat(w->rootfd,
+                *path == '\0' ? "." : path,
+                O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+    if (fd == -1) {
+      if (errno == ENOENT || errno == ENOTDIR || errno == ELOOP) {
+        uv__free(path);
+        continue;
+      }
+      uv__free(path);
+      return -1;
+    }
+
+    w->dir = fdopendir(fd);
+    if (w->dir == NULL) {
+      uv__close(fd);
+      uv__free(path);
+      return -1;
+    }
+
+    uv__free(w->dirpath);
+    w->dirpath = path;
+    return 1;
+  }
+
+  return 0;
+}
+
+
+/* Reads the next batch of entries with one readdir() and one fstatat() per
+ * entry, relative to the open directory. Everything stays in req->ptr
+ * between batches. An error after some entries were read is held back so
+ * that the entries are not lost.
+ */
+static ssize_t uv__fs_walk(uv_fs_t* req) {
+  uv__fs_walk_entry_t* e;
+  uv__fs_walker_t* w;
+  uv__dirent_t* dent;
+  struct stat st;
+  ssize_t off;
+  int r;
+
+  w = req->ptr;
+  if (w == NULL) {
+    w = uv__calloc(1, sizeof(*w));
+    if (w == NULL) {
+      errno = ENOMEM;
+      return -1;
+    }
+
+    w->flags = req->flags;
+    w->rootfd = open(req->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (w->rootfd == -1) {
+      r = errno;
+      uv__free(w);
+      errno = r;
+      return -1;
+    }
+
+    req->ptr = w;
+    if (uv__fs_walk_push(w, ""))
+      return -1;
+  }
+
+  if (w->error != 0) {
+    errno = w->error;
+    w->error = 0;
+    return -1;
+  }
+
+  while (w->nentries < ARRAY_SIZE(w->entries)) {
+    if (w->dir == NULL) {
+      r = uv__fs_walk_open(w);
+      if (r == 0)
+        break;
+      if (r == -1)
+        goto error;
+    }
+
+    errno = 0;
+    dent = readdir(w->dir);
+
+    if (dent == NULL) {
+      if (errno != 0)
+        goto error;
+      closedir(w->dir);
+      w->dir = NULL;
+      continue;
+    }
+
+    if (strcmp(dent->d_name, ".") == 0 || strcmp(dent->d_name, "..") == 0)
+      continue;
+
+    e = &w->entries[w->nentries];
+    memset(&e->statbuf, 0, sizeof(e->statbuf));
+    e->type = uv__fs_walk_dtype(dent);
+
+    if (!(w->flags & UV_FS_WALK_NOSTAT) || e->type == UV_DIRENT_UNKNOWN) {
+      if (fstatat(dirfd(w->dir), dent->d_name, &st, AT_SYMLINK_NOFOLLOW)) {
+        if (errno == ENOENT)
+          continue;  /* Unlinked since readdir() saw it. */
+        goto error;
+      }
+      e->type = uv__fs_walk_type(st.st_mode);
+      if (!(w->flags & UV_FS_WALK_NOSTAT))
+        uv__to_stat(&st, &e->statbuf);
+    }
+
+    off = uv__fs_walk_name(w, dent->d_name);
+    if (off == -1)
+      goto error;
+    e->name = off;
+
+    if (e->type == UV_DIRENT_DIR)
+      if (uv__fs_walk_push(w, w->names + off))
+        goto error;
+
+    w->nentries++;
+  }
+
+  return w->nentries;
+
+error:
+  /* Give up on the current directory, the walk can be continued. */
+  if (w->dir != NULL) {
+    r = errno;
+    closedir(w->dir);
+    w->dir = NULL;
+    errno = r;
+  }
+
+  if (w->nentries == 0)
+    return -1;
+
+  w->error = errno;
+  return w->nentries;
+}
+
+
 typedef ssize_t (*uv__fs_buf_iter_processor)(uv_fs_t* req);
 static ssize_t uv__fs_buf_iter(uv_fs_t* req, uv__fs_buf_iter_processor process) {
   unsigned int iovmax;
@@ -874,6 +1191,7 @@ static void uv__fs_work(struct uv__work* w) {
     X(SYMLINK, symlink(req->path, req->new_path));
     X(UNLINK, unlink(req->path));
     X(UTIME, uv__fs_utime(req));
+    X(WALK, uv__fs_walk(req));
     X(WRITE, uv__fs_buf_iter(req, uv__fs_write));
     default: abort();
     }
@@ -1121,6 +1439,60 @@ int uv_fs_scandir(uv_loop_t* loop,
 }
 
 
+int uv_fs_walk(uv_loop_t* loop,
+               uv_fs_t* req,
+               const char* path,
+               int flags,
+               uv_fs_cb cb) {
+  INIT(WALK);
+  /* Always a copy, the walk may be continued in the other mode. */
+  req->path = uv__strdup(path);
+  if (req->path == NULL)
+    return -ENOMEM;
+  req->flags = flags;
+  POST;
+}
+
+
+int uv_fs_walk_continue(uv_loop_t* loop, uv_fs_t* req, uv_fs_cb cb) {
+  uv__fs_walker_t* w;
+
+  if (req->fs_type != UV_FS_WALK || req->ptr == NULL)
+    return -EINVAL;
+
+  w = req->ptr;
+  w->nentries = 0;
+  w->next = 0;
+  w->names_len = 0;
+
+  if (cb != NULL)
+    uv__req_init(loop, req, UV_FS);
+  req->result = 0;
+  req->loop = loop;
+  req->cb = cb;
+  POST;
+}
+
+
+int uv_fs_walk_next(uv_fs_t* req, uv_fs_walk_entry_t* ent) {
+  uv__fs_walk_entry_t* e;
+  uv__fs_walker_t* w;
+
+  w = req->ptr;
+  if (req->fs_type != UV_FS_WALK || w == NULL || req->result <= 0)
+    return UV_EOF;
+
+  if (w->next == w->nentries)
+    return UV_EOF;
+
+  e = &w->entries[w->next++];
+  ent->name = w->names + e->name;
+  ent->type = e->type;
+  ent->statbuf = e->statbuf;
+  return 0;
+}
+
+
 int uv_fs_readlink(uv_loop_t* loop,
                    uv_fs_t* req,
                    const char* path,
@@ -1237,10 +1609,12 @@ int uv_fs_write(uv_loop_t* loop,
 void uv_fs_req_cleanup(uv_fs_t* req) {
   /* Only necessary for asychronous requests, i.e., requests with a callback.
    * Synchronous ones don't copy their arguments and have req->path and
-   * req->new_path pointing to user-owned memory.  UV_FS_MKDTEMP is the
-   * exception to the rule, it always allocates memory.
+   * req->new_path pointing to user-owned memory.  UV_FS_MKDTEMP and
+   * UV_FS_WALK are the exception to the rule, they always allocate memory.
    */
-  if (req->path != NULL && (req->cb != NULL || req->fs_type == UV_FS_MKDTEMP))
+  if (req->path != NULL && (req->cb != NULL ||
+                            req->fs_type == UV_FS_MKDTEMP ||
+                            req->fs_type == UV_FS_WALK))
     uv__free((void*) req->path);  /* Memory is shared with req->new_path. */
 
   req->path = NULL;
@@ -1249,6 +1623,9 @@ void uv_fs_req_cleanup(uv_fs_t* req) {
   if (req->fs_type == UV_FS_SCANDIR && req->ptr != NULL)
     uv__fs_scandir_cleanup(req);
 
+  if (req->fs_type == UV_FS_WALK && req->ptr != NULL)
+    uv__fs_walk_cleanup(req);
+
   if (req->ptr != &req->statbuf)
     uv__free(req->ptr);
   req->ptr = NULL;
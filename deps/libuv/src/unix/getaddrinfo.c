@@ -96,11 +96,22 @@ int uv__getaddrinfo_translate_error(int sys_err) {
 
 static void uv__getaddrinfo_work(struct uv__work* w) {
   uv_getaddrinfo_t* req;
+  unsigned int ttl;
   int err;
 
   req = container_of(w, uv_getaddrinfo_t, work_req);
   err = getaddrinfo(req->hostname, req->service, req->hints, &req->addrinfo);
   req->retcode = uv__getaddrinfo_translate_error(err);
+
+  /* getaddrinfo() doesn't say how long the answer is good for. Negative
+   * answers aren't kept for long, the name may be about to appear.
+   */
+  ttl = req->loop->dns_cache_ttl;
+  if (ttl != 0) {
+    if (req->retcode != 0 && ttl > UV__DNS_NEGATIVE_TTL)
+      ttl = UV__DNS_NEGATIVE_TTL;
+    uv__dns_cache_store(req, req->retcode, req->addrinfo, ttl);
+  }
 }
 
 
@@ -182,9 +193,23 @@ int uv_getaddrinfo(uv_loop_t* loop,
   if (hostname)
     req->hostname = memcpy(buf + len, hostname, hostname_len);
 
+  if (loop->dns_cache_ttl != 0 && uv__dns_cache_lookup(req)) {
+    if (cb == NULL) {
+      uv__getaddrinfo_done(&req->work_req, 0);
+      return req->retcode;
+    }
+
+    uv__work_complete(loop, &req->work_req, uv__getaddrinfo_done);
+    return 0;
+  }
+
+  if (cb && uv__dns_resolve(loop, req, uv__getaddrinfo_done) == 0)
+    return 0;
+
   if (cb) {
     uv__work_submit(loop,
                     &req->work_req,
+                    UV_WORK_SLOW_IO,
                     uv__getaddrinfo_work,
                     uv__getaddrinfo_done);
     return 0;
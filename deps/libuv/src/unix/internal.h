@@ -144,12 +144,18 @@ enum {
   UV_TCP_KEEPALIVE        = 0x800,  /* Turn on keep-alive. */
   UV_TCP_SINGLE_ACCEPT    = 0x1000, /* Only accept() when idle. */
   UV_HANDLE_IPV6          = 0x10000, /* Handle is bound to a IPv6 socket. */
-  UV_UDP_PROCESSING       = 0x20000  /* Handle is running the send callback queue. */
+  UV_UDP_PROCESSING       = 0x20000, /* Handle is running the send callback queue. */
+  UV_STREAM_COALESCE      = 0x40000, /* Defer writes to the next iteration. */
+  UV_STREAM_READ_BATCH    = 0x80000, /* Fill the read buffer before read_cb. */
+  UV_UDP_RECVMMSG_MODE    = 0x100000, /* Receive with recvmmsg(). */
+  UV_UDP_SENDMMSG_MODE    = 0x200000  /* Defer sends, flush with sendmmsg(). */
 };
 
 /* loop flags */
 enum {
-  UV_LOOP_BLOCK_SIGPROF = 1
+  UV_LOOP_BLOCK_SIGPROF = 1,
+  UV_LOOP_ENABLE_IO_URING = 2,
+  UV_LOOP_COLLECT_METRICS = 4
 };
 
 typedef enum {
@@ -198,6 +204,7 @@ void uv__stream_init(uv_loop_t* loop, uv_stream_t* stream,
     uv_handle_type type);
 int uv__stream_open(uv_stream_t*, int fd, int flags);
 void uv__stream_destroy(uv_stream_t* stream);
+void uv__write_pool_delete(uv_loop_t* loop);
 #if defined(__APPLE__)
 int uv__stream_try_select(uv_stream_t* stream, int* fd);
 #endif /* defined(__APPLE__) */
@@ -214,9 +221,46 @@ int uv__tcp_keepalive(int fd, int on, unsigned int delay);
 /* pipe */
 int uv_pipe_listen(uv_pipe_t* handle, int backlog, uv_connection_cb cb);
 
+/* metrics */
+int uv__metrics_configure(uv_loop_t* loop, int on);
+void uv__metrics_delete(uv_loop_t* loop);
+void uv__metrics_callback(uv_loop_t* loop, uint64_t start);
+
+/* Runs `call`, timing it when the loop collects metrics. */
+#define uv__metered_call(loop, call)                                          \
+  do {                                                                        \
+    if ((loop)->flags & UV_LOOP_COLLECT_METRICS) {                            \
+      uint64_t uv__call_start;                                                \
+      uv__call_start = uv__hrtime(UV_CLOCK_PRECISE);                          \
+      call;                                                                   \
+      uv__metrics_callback((loop), uv__call_start);                           \
+    } else {                                                                  \
+      call;                                                                   \
+    }                                                                         \
+  }                                                                           \
+  while (0)
+
 /* timer */
 void uv__run_timers(uv_loop_t* loop);
 int uv__next_timeout(const uv_loop_t* loop);
+int uv__timer_wheel_configure(uv_loop_t* loop, int on);
+void uv__timer_wheel_delete(uv_loop_t* loop);
+
+/* dns */
+#define UV__DNS_NEGATIVE_TTL 5  /* Seconds to remember unknown names. */
+int uv__dns_cache_configure(uv_loop_t* loop, unsigned int ttl);
+int uv__dns_cache_lookup(uv_getaddrinfo_t* req);
+void uv__dns_cache_store(const uv_getaddrinfo_t* req,
+                         int retcode,
+                         const struct addrinfo* ai,
+                         unsigned int ttl);
+int uv__dns_resolve(uv_loop_t* loop,
+                    uv_getaddrinfo_t* req,
+                    void (*done)(struct uv__work* w, int status));
+int uv__dns_resolver_configure(uv_loop_t* loop,
+                               const char* conf_path,
+                               const char* hosts_path);
+void uv__dns_resolver_delete(uv_loop_t* loop);
 
 /* signal */
 void uv__signal_close(uv_signal_t* handle);
@@ -288,6 +332,15 @@ static const int kFSEventStreamEventFlagItemIsSymlink = 0x00040000;
 
 #endif /* defined(__APPLE__) */
 
+#if defined(__linux__)
+int uv__iou_fs_submit(uv_loop_t* loop, uv_fs_t* req);
+int uv__iou_flush(uv_loop_t* loop);
+void uv__iou_loop_delete(uv_loop_t* loop);
+#else
+# define uv__iou_fs_submit(loop, req) 0
+# define uv__iou_flush(loop) 0
+#endif /* defined(__linux__) */
+
 UV_UNUSED(static void uv__req_init(uv_loop_t* loop,
                                    uv_req_t* req,
                                    uv_req_type type)) {
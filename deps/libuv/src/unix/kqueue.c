@@ -58,6 +58,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   uv__io_t* w;
   sigset_t* pset;
   sigset_t set;
+  uint64_t start;
   uint64_t base;
   uint64_t diff;
   int filter;
@@ -128,7 +129,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
   assert(timeout >= -1);
   base = loop->time;
-  count = 48; /* Benchmarks suggest this gives the best throughput. */
+  count = loop->poll_budget;
 
   for (;; nevents = 0) {
     if (timeout != -1) {
@@ -139,6 +140,9 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (pset != NULL)
       pthread_sigmask(SIG_BLOCK, pset, NULL);
 
+    if (timeout != 0)
+      start = uv__hrtime(UV_CLOCK_PRECISE);
+
     nfds = kevent(loop->backend_fd,
                   events,
                   nevents,
@@ -146,6 +150,14 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
                   ARRAY_SIZE(events),
                   timeout == -1 ? NULL : &spec);
 
+    if (timeout != 0)
+      loop->metrics.poll_time += uv__hrtime(UV_CLOCK_PRECISE) - start;
+
+    if (nfds >= 0) {
+      loop->metrics.poll_wakeups++;
+      loop->metrics.poll_events += nfds;
+    }
+
     if (pset != NULL)
       pthread_sigmask(SIG_UNBLOCK, pset, NULL);
 
@@ -203,7 +215,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       if (ev->filter == EVFILT_VNODE) {
         assert(w->events == UV__POLLIN);
         assert(w->pevents == UV__POLLIN);
-        w->cb(loop, w, ev->fflags); /* XXX always uv__fs_event() */
+        /* XXX always uv__fs_event() */
+        uv__metered_call(loop, w->cb(loop, w, ev->fflags));
         nevents++;
         continue;
       }
@@ -244,7 +257,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       if (revents == 0)
         continue;
 
-      w->cb(loop, w, revents);
+      uv__metered_call(loop, w->cb(loop, w, revents));
       nevents++;
     }
     loop->watchers[loop->nwatchers] = NULL;
@@ -421,6 +434,13 @@ int uv_fs_event_stop(uv_fs_event_t* handle) {
 }
 
 
+int uv_fs_event_set_batching(uv_fs_event_t* handle,
+                             uint64_t window,
+                             uv_fs_event_batch_cb cb) {
+  return -ENOSYS;
+}
+
+
 void uv__fs_event_close(uv_fs_event_t* handle) {
   uv_fs_event_stop(handle);
 }
@@ -68,6 +68,11 @@
 # define CLOCK_BOOTTIME 7
 #endif
 
+/* Bounds of the epoll_wait() event buffer, see uv__epoll_resize(). */
+#define UV__EPOLL_MIN_EVENTS 1024
+#define UV__EPOLL_MAX_EVENTS (64 * 1024)
+#define UV__EPOLL_SHRINK_TICKS 64
+
 static int read_models(unsigned int numcpus, uv_cpu_info_t* ci);
 static int read_times(unsigned int numcpus, uv_cpu_info_t* ci);
 static void read_speeds(unsigned int numcpus, uv_cpu_info_t* ci);
@@ -75,6 +80,7 @@ static unsigned long read_cpufreq(unsigned int cpunum);
 
 
 int uv__platform_loop_init(uv_loop_t* loop) {
+  const char* val;
   int fd;
 
   fd = uv__epoll_create1(UV__EPOLL_CLOEXEC);
@@ -92,6 +98,14 @@ int uv__platform_loop_init(uv_loop_t* loop) {
   loop->backend_fd = fd;
   loop->inotify_fd = -1;
   loop->inotify_watchers = NULL;
+  loop->iou = NULL;
+  loop->epoll_events = NULL;
+
+  val = getenv("UV_USE_IO_URING");
+  if (val != NULL && atoi(val) != 0)
+    loop->flags |= UV_LOOP_ENABLE_IO_URING;
+  loop->epoll_nevents = 0;
+  loop->epoll_shrink = 0;
 
   if (fd == -1)
     return -errno;
@@ -101,6 +115,9 @@ int uv__platform_loop_init(uv_loop_t* loop) {
 
 
 void uv__platform_loop_delete(uv_loop_t* loop) {
+  uv__iou_loop_delete(loop);
+  uv__free(loop->epoll_events);
+  loop->epoll_events = NULL;
   if (loop->inotify_fd == -1) return;
   uv__io_stop(loop, &loop->inotify_read_watcher, UV__POLLIN);
   uv__close(loop->inotify_fd);
@@ -135,11 +152,50 @@ void uv__platform_invalidate_fd(uv_loop_t* loop, int fd) {
      * has the EPOLLWAKEUP flag set generates spurious audit syslog warnings.
      */
     memset(&dummy, 0, sizeof(dummy));
+    loop->metrics.poll_ctl++;
     uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_DEL, fd, &dummy);
   }
 }
 
 
+/* Size the event buffer for the next epoll_wait() call. A buffer that came
+ * back full is doubled right away, one that stays mostly empty for a while
+ * is halved. The smallest size lives on the stack of uv__io_poll().
+ */
+static void uv__epoll_resize(uv_loop_t* loop, int nfds, unsigned int size) {
+  struct uv__epoll_event* events;
+
+  if ((unsigned) nfds == size) {
+    loop->epoll_shrink = 0;
+
+    if (size >= UV__EPOLL_MAX_EVENTS)
+      return;
+
+    size *= 2;
+  } else if (size > UV__EPOLL_MIN_EVENTS && (unsigned) nfds < size / 4) {
+    if (++loop->epoll_shrink < UV__EPOLL_SHRINK_TICKS)
+      return;
+
+    loop->epoll_shrink = 0;
+    size /= 2;
+  } else {
+    loop->epoll_shrink = 0;
+    return;
+  }
+
+  events = NULL;
+  if (size > UV__EPOLL_MIN_EVENTS) {
+    events = uv__malloc(size * sizeof(*events));
+    if (events == NULL)
+      return;  /* Keep using the current buffer. */
+  }
+
+  uv__free(loop->epoll_events);
+  loop->epoll_events = events;
+  loop->epoll_nevents = size;
+}
+
+
 void uv__io_poll(uv_loop_t* loop, int timeout) {
   /* A bug in kernels < 2.6.37 makes timeouts larger than ~30 minutes
    * effectively infinite on 32 bits architectures.  To avoid blocking
@@ -152,15 +208,18 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   static const int max_safe_timeout = 1789569;
   static int no_epoll_pwait;
   static int no_epoll_wait;
-  struct uv__epoll_event events[1024];
+  struct uv__epoll_event stack_events[UV__EPOLL_MIN_EVENTS];
+  struct uv__epoll_event* events;
   struct uv__epoll_event* pe;
   struct uv__epoll_event e;
+  unsigned int size;
   int real_timeout;
   QUEUE* q;
   uv__io_t* w;
   sigset_t sigset;
   uint64_t sigmask;
   uint64_t base;
+  uint64_t start;
   int nevents;
   int count;
   int nfds;
@@ -168,6 +227,13 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   int op;
   int i;
 
+  /* Hand the file system requests queued since the last tick to the kernel
+   * in one go. If the kernel didn't take all of them, don't block: nothing
+   * may be left that could wake us up to try again.
+   */
+  if (uv__iou_flush(loop) != 0)
+    timeout = 0;
+
   if (loop->nfds == 0) {
     assert(QUEUE_EMPTY(&loop->watcher_queue));
     return;
@@ -183,6 +249,14 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     assert(w->fd >= 0);
     assert(w->fd < (int) loop->nwatchers);
 
+    /* Interest that only shrank is left registered with the kernel. The
+     * surplus events are squelched and disarmed after epoll_wait() when and
+     * if they fire, which for a stream that toggles UV__POLLOUT on and off
+     * with every partial write is usually never.
+     */
+    if (w->events != 0 && (w->pevents & ~w->events) == 0)
+      continue;
+
     e.events = w->pevents;
     e.data = w->fd;
 
@@ -191,9 +265,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     else
       op = UV__EPOLL_CTL_MOD;
 
-    /* XXX Future optimization: do EPOLL_CTL_MOD lazily if we stop watching
-     * events, skip the syscall and squelch the events after epoll_wait().
-     */
+    loop->metrics.poll_ctl++;
     if (uv__epoll_ctl(loop->backend_fd, op, w->fd, &e)) {
       if (errno != EEXIST)
         abort();
@@ -201,6 +273,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       assert(op == UV__EPOLL_CTL_ADD);
 
       /* We've reactivated a file descriptor that's been watched before. */
+      loop->metrics.poll_ctl++;
       if (uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_MOD, w->fd, &e))
         abort();
     }
@@ -217,8 +290,9 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
   assert(timeout >= -1);
   base = loop->time;
-  count = 48; /* Benchmarks suggest this gives the best throughput. */
+  count = loop->poll_budget;
   real_timeout = timeout;
+  start = 0;
 
   for (;;) {
     /* See the comment for max_safe_timeout for an explanation of why
@@ -227,14 +301,24 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (sizeof(int32_t) == sizeof(long) && timeout >= max_safe_timeout)
       timeout = max_safe_timeout;
 
+    events = loop->epoll_events;
+    size = loop->epoll_nevents;
+    if (events == NULL) {
+      events = stack_events;
+      size = ARRAY_SIZE(stack_events);
+    }
+
     if (sigmask != 0 && no_epoll_pwait != 0)
       if (pthread_sigmask(SIG_BLOCK, &sigset, NULL))
         abort();
 
+    if (timeout != 0)
+      start = uv__hrtime(UV_CLOCK_PRECISE);
+
     if (no_epoll_wait != 0 || (sigmask != 0 && no_epoll_pwait == 0)) {
       nfds = uv__epoll_pwait(loop->backend_fd,
                              events,
-                             ARRAY_SIZE(events),
+                             size,
                              timeout,
                              sigmask);
       if (nfds == -1 && errno == ENOSYS)
@@ -242,12 +326,20 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     } else {
       nfds = uv__epoll_wait(loop->backend_fd,
                             events,
-                            ARRAY_SIZE(events),
+                            size,
                             timeout);
       if (nfds == -1 && errno == ENOSYS)
         no_epoll_wait = 1;
     }
 
+    if (timeout != 0)
+      loop->metrics.poll_time += uv__hrtime(UV_CLOCK_PRECISE) - start;
+
+    if (nfds >= 0) {
+      loop->metrics.poll_wakeups++;
+      loop->metrics.poll_events += nfds;
+    }
+
     if (sigmask != 0 && no_epoll_pwait != 0)
       if (pthread_sigmask(SIG_UNBLOCK, &sigset, NULL))
         abort();
@@ -312,10 +404,23 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
          * Ignore all errors because we may be racing with another thread
          * when the file descriptor is closed.
          */
+        loop->metrics.poll_ctl++;
         uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_DEL, fd, pe);
         continue;
       }
 
+      /* An event the watcher lost interest in but that we didn't bother
+       * to disarm, see above. Catch up with the kernel now; the event itself
+       * is filtered out below.
+       */
+      if (pe->events & ~w->pevents & (UV__POLLIN | UV__POLLOUT)) {
+        e.events = w->pevents;
+        e.data = fd;
+        loop->metrics.poll_ctl++;
+        if (uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_MOD, fd, &e) == 0)
+          w->events = w->pevents;
+      }
+
       /* Give users only events they're interested in. Prevents spurious
        * callbacks when previous callback invocation in this loop has stopped
        * the current watcher. Also, filters out events that users has not
@@ -342,15 +447,17 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
         pe->events |= w->pevents & (UV__EPOLLIN | UV__EPOLLOUT);
 
       if (pe->events != 0) {
-        w->cb(loop, w, pe->events);
+        uv__metered_call(loop, w->cb(loop, w, pe->events));
         nevents++;
       }
     }
     loop->watchers[loop->nwatchers] = NULL;
     loop->watchers[loop->nwatchers + 1] = NULL;
 
+    uv__epoll_resize(loop, nfds, size);
+
     if (nevents != 0) {
-      if (nfds == ARRAY_SIZE(events) && --count != 0) {
+      if ((unsigned) nfds == size && --count != 0) {
         /* Poll for more events but don't block this time. */
         timeout = 0;
         continue;
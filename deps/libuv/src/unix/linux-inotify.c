@@ -28,13 +28,31 @@
 #include <string.h>
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
 
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
 #include <unistd.h>
 
+#ifndef PATH_MAX
+# define PATH_MAX 4096
+#endif
+
+#define UV__INOTIFY_EVENTS                                                    \
+  (UV__IN_ATTRIB                                                              \
+   | UV__IN_CREATE                                                            \
+   | UV__IN_MODIFY                                                            \
+   | UV__IN_DELETE                                                            \
+   | UV__IN_DELETE_SELF                                                       \
+   | UV__IN_MOVE_SELF                                                         \
+   | UV__IN_MOVED_FROM                                                        \
+   | UV__IN_MOVED_TO)
+
 struct watcher_list {
   RB_ENTRY(watcher_list) entry;
   QUEUE watchers;
+  int iterating;
   char* path;
   int wd;
 };
@@ -44,6 +62,43 @@ struct watcher_root {
 };
 #define CAST(p) ((struct watcher_root*)(p))
 
+/* One per handle and watched directory. A recursive handle has one for every
+ * directory below the one it was started on, a plain handle just the one.
+ */
+struct watcher_sub {
+  QUEUE member;         /* In watcher_list.watchers. */
+  QUEUE handle_member;  /* In uv_fs_event_t.watchers. */
+  uv_fs_event_t* handle;
+  struct watcher_list* list;
+  int recursive;
+  size_t prefix_len;
+  char prefix[1];       /* Relative to handle->path, "" for the handle's own. */
+};
+
+struct watcher_change {
+  size_t name;          /* Offset into watcher_batch.names. */
+  int events;
+};
+
+/* Changes collected for a handle with uv_fs_event_set_batching(), one per
+ * file name, until the window is over.
+ */
+struct watcher_batch {
+  uv_timer_t timer;
+  uv_fs_event_t* handle;
+  uv_fs_event_batch_cb cb;
+  uint64_t window;
+  struct watcher_change* changes;
+  uv_fs_event_change_t* out;
+  unsigned int nchanges;
+  unsigned int changes_size;
+  unsigned int* index;  /* Hash of names to changes + 1, 0 is a free slot. */
+  unsigned int index_size;
+  char* names;
+  size_t names_len;
+  size_t names_size;
+};
+
 
 static int compare_watchers(const struct watcher_list* a,
                             const struct watcher_list* b) {
@@ -60,6 +115,10 @@ static void uv__inotify_read(uv_loop_t* loop,
                              uv__io_t* w,
                              unsigned int revents);
 
+static int watch_children(uv_fs_event_t* handle,
+                          const char* prefix,
+                          size_t prefix_len);
+
 
 static int new_inotify_fd(void) {
   int err;
@@ -114,14 +173,479 @@ static struct watcher_list* find_watcher(uv_loop_t* loop, int wd) {
 }
 
 
+static int add_watcher(uv_loop_t* loop,
+                       const char* path,
+                       int events,
+                       struct watcher_list** result) {
+  struct watcher_list* w;
+  int wd;
+
+  wd = uv__inotify_add_watch(loop->inotify_fd, path, events);
+  if (wd == -1)
+    return -errno;
+
+  w = find_watcher(loop, wd);
+  if (w != NULL)
+    goto done;
+
+  w = uv__malloc(sizeof(*w) + strlen(path) + 1);
+  if (w == NULL)
+    return -ENOMEM;
+
+  w->wd = wd;
+  w->iterating = 0;
+  w->path = strcpy((char*)(w + 1), path);
+  QUEUE_INIT(&w->watchers);
+  RB_INSERT(watcher_root, CAST(&loop->inotify_watchers), w);
+
+done:
+  *result = w;
+  return 0;
+}
+
+
+static void maybe_free_watcher_list(struct watcher_list* w, uv_loop_t* loop) {
+  /* if the watcher_list->watchers is being iterated over, we can't free it. */
+  if (w->iterating || !QUEUE_EMPTY(&w->watchers))
+    return;
+
+  /* No watchers left for this path. Clean up. */
+  RB_REMOVE(watcher_root, CAST(&loop->inotify_watchers), w);
+  uv__inotify_rm_watch(loop->inotify_fd, w->wd);
+  uv__free(w);
+}
+
+
+static struct watcher_sub* find_sub(struct watcher_list* w,
+                                    uv_fs_event_t* handle) {
+  struct watcher_sub* sub;
+  QUEUE* q;
+
+  QUEUE_FOREACH(q, &w->watchers) {
+    sub = QUEUE_DATA(q, struct watcher_sub, member);
+    if (sub->handle == handle)
+      return sub;
+  }
+
+  return NULL;
+}
+
+
+static struct watcher_sub* add_sub(uv_fs_event_t* handle,
+                                   struct watcher_list* w,
+                                   const char* prefix,
+                                   size_t prefix_len,
+                                   int recursive) {
+  struct watcher_sub* sub;
+
+  sub = uv__malloc(sizeof(*sub) + prefix_len);
+  if (sub == NULL)
+    return NULL;
+
+  sub->handle = handle;
+  sub->list = w;
+  sub->recursive = recursive;
+  sub->prefix_len = prefix_len;
+  memcpy(sub->prefix, prefix, prefix_len);
+  sub->prefix[prefix_len] = '\0';
+  QUEUE_INSERT_TAIL(&w->watchers, &sub->member);
+  QUEUE_INSERT_TAIL(&handle->watchers, &sub->handle_member);
+
+  return sub;
+}
+
+
+static void remove_sub(struct watcher_sub* sub) {
+  uv_loop_t* loop;
+
+  loop = sub->handle->loop;
+  QUEUE_REMOVE(&sub->member);
+  QUEUE_REMOVE(&sub->handle_member);
+  maybe_free_watcher_list(sub->list, loop);
+  uv__free(sub);
+}
+
+
+/* Drops the handle's watches on `prefix` and everything below it, after the
+ * directory went away or was renamed.
+ */
+static void remove_subtree(uv_fs_event_t* handle,
+                           const char* prefix,
+                           size_t prefix_len) {
+  struct watcher_sub* sub;
+  QUEUE queue;
+  QUEUE* q;
+
+  QUEUE_INIT(&queue);
+  while (!QUEUE_EMPTY(&handle->watchers)) {
+    q = QUEUE_HEAD(&handle->watchers);
+    sub = QUEUE_DATA(q, struct watcher_sub, handle_member);
+    QUEUE_REMOVE(q);
+    QUEUE_INSERT_TAIL(&queue, q);
+
+    if (sub->prefix_len < prefix_len)
+      continue;
+    if (memcmp(sub->prefix, prefix, prefix_len) != 0)
+      continue;
+    if (sub->prefix[prefix_len] != '\0' && sub->prefix[prefix_len] != '/')
+      continue;
+
+    remove_sub(sub);
+  }
+
+  while (!QUEUE_EMPTY(&queue)) {
+    q = QUEUE_HEAD(&queue);
+    QUEUE_REMOVE(q);
+    QUEUE_INSERT_TAIL(&handle->watchers, q);
+  }
+}
+
+
+static int join_path(char* buf,
+                     size_t size,
+                     const char* a,
+                     const char* b,
+                     size_t* len) {
+  int n;
+
+  if (*a == '\0')
+    n = snprintf(buf, size, "%s", b);
+  else if (*b == '\0')
+    n = snprintf(buf, size, "%s", a);
+  else
+    n = snprintf(buf, size, "%s/%s", a, b);
+
+  if (n < 0 || (size_t) n >= size)
+    return -ENAMETOOLONG;
+
+  if (len != NULL)
+    *len = n;
+
+  return 0;
+}
+
+
+/* Watches directory `prefix` of a recursive handle and everything below it.
+ * Directories that can't be watched, or are gone already, are left out.
+ */
+static int watch_dir(uv_fs_event_t* handle,
+                     const char* prefix,
+                     size_t prefix_len) {
+  struct watcher_list* w;
+  char path[PATH_MAX];
+  int err;
+
+  if (join_path(path, sizeof(path), handle->path, prefix, NULL))
+    return 0;
+
+  err = add_watcher(handle->loop,
+                    path,
+                    UV__INOTIFY_EVENTS | UV__IN_ONLYDIR,
+                    &w);
+  if (err == -ENOSPC || err == -ENOMEM)
+    return err;
+  if (err)
+    return 0;
+
+  /* Already watched, seen both when it was created and when its parent was
+   * scanned.
+   */
+  if (find_sub(w, handle) != NULL)
+    return 0;
+
+  if (add_sub(handle, w, prefix, prefix_len, 1) == NULL) {
+    maybe_free_watcher_list(w, handle->loop);
+    return -ENOMEM;
+  }
+
+  return watch_children(handle, prefix, prefix_len);
+}
+
+
+static int watch_children(uv_fs_event_t* handle,
+                          const char* prefix,
+                          size_t prefix_len) {
+  uv__dirent_t* dent;
+  char path[PATH_MAX];
+  char child[PATH_MAX];
+  size_t child_len;
+  struct stat st;
+  DIR* dir;
+  int err;
+
+  if (join_path(path, sizeof(path), handle->path, prefix, NULL))
+    return 0;
+
+  dir = opendir(path);
+  if (dir == NULL)
+    return 0;
+
+  err = 0;
+  while (err == 0 && (dent = readdir(dir)) != NULL) {
+    if (strcmp(dent->d_name, ".") == 0 || strcmp(dent->d_name, "..") == 0)
+      continue;
+
+#ifdef HAVE_DIRENT_TYPES
+    if (dent->d_type != UV__DT_DIR && dent->d_type != DT_UNKNOWN)
+      continue;
+#endif
+
+    if (join_path(child, sizeof(child), prefix, dent->d_name, &child_len))
+      continue;
+
+#ifdef HAVE_DIRENT_TYPES
+    if (dent->d_type == DT_UNKNOWN)
+#endif
+    {
+      if (fstatat(dirfd(dir), dent->d_name, &st, AT_SYMLINK_NOFOLLOW))
+        continue;
+      if (!S_ISDIR(st.st_mode))
+        continue;
+    }
+
+    err = watch_dir(handle, child, child_len);
+  }
+
+  closedir(dir);
+  return err;
+}
+
+
+static void batch_flush(uv_timer_t* timer) {
+  struct watcher_change* changes;
+  struct watcher_batch* b;
+  uv_fs_event_change_t* out;
+  uv_fs_event_t* handle;
+  unsigned int changes_size;
+  unsigned int nchanges;
+  unsigned int i;
+  size_t names_size;
+  char* names;
+
+  b = container_of(timer, struct watcher_batch, timer);
+  handle = b->handle;
+  nchanges = b->nchanges;
+  if (nchanges == 0)
+    return;
+
+  /* Take the buffers out of the batch, the callback may stop or close the
+   * handle.
+   */
+  changes = b->changes;
+  changes_size = b->changes_size;
+  names = b->names;
+  names_size = b->names_size;
+  out = b->out;
+  b->changes = NULL;
+  b->names = NULL;
+  b->out = NULL;
+  b->nchanges = 0;
+  b->changes_size = 0;
+  b->names_len = 0;
+  b->names_size = 0;
+  memset(b->index, 0, b->index_size * sizeof(*b->index));
+
+  for (i = 0; i < nchanges; i++) {
+    out[i].filename = names + changes[i].name;
+    out[i].events = changes[i].events;
+  }
+
+  b->cb(handle, out, nchanges, 0);
+
+  /* Hand the buffers back for reuse if the batch is still around and empty,
+   * the callback has no way to add changes to it.
+   */
+  if (handle->batch == b && b->changes == NULL) {
+    b->changes = changes;
+    b->names = names;
+    b->out = out;
+    b->changes_size = changes_size;
+    b->names_size = names_size;
+    return;
+  }
+
+  uv__free(changes);
+  uv__free(names);
+  uv__free(out);
+}
+
+
+static unsigned int batch_hash(const char* s) {
+  unsigned int h;
+
+  /* FNV-1a */
+  for (h = 2166136261u; *s != '\0'; s++)
+    h = (h ^ (unsigned char) *s) * 16777619u;
+
+  return h;
+}
+
+
+static int batch_grow(struct watcher_batch* b, size_t name_len) {
+  struct watcher_change* changes;
+  uv_fs_event_change_t* out;
+  unsigned int* index;
+  unsigned int size;
+  unsigned int mask;
+  unsigned int i;
+  unsigned int j;
+  size_t names_size;
+  char* names;
+
+  if (b->names_len + name_len + 1 > b->names_size) {
+    names_size = 2 * b->names_size + name_len + 1;
+    if (names_size < 4096)
+      names_size = 4096;
+    names = uv__realloc(b->names, names_size);
+    if (names == NULL)
+      return -ENOMEM;
+    b->names = names;
+    b->names_size = names_size;
+  }
+
+  if (b->nchanges == b->changes_size) {
+    size = 2 * b->changes_size + 64;
+    changes = uv__realloc(b->changes, size * sizeof(*changes));
+    if (changes == NULL)
+      return -ENOMEM;
+    b->changes = changes;
+    out = uv__realloc(b->out, size * sizeof(*out));
+    if (out == NULL)
+      return -ENOMEM;
+    b->out = out;
+    b->changes_size = size;
+  }
+
+  /* Keep the index at most half full. */
+  if (2 * (b->nchanges + 1) > b->index_size) {
+    size = b->index_size == 0 ? 128 : 2 * b->index_size;
+    index = uv__calloc(size, sizeof(*index));
+    if (index == NULL)
+      return -ENOMEM;
+
+    mask = size - 1;
+    for (i = 0; i < b->nchanges; i++) {
+      j = batch_hash(b->names + b->changes[i].name) & mask;
+      while (index[j] != 0)
+        j = (j + 1) & mask;
+      index[j] = i + 1;
+    }
+
+    uv__free(b->index);
+    b->index = index;
+    b->index_size = size;
+  }
+
+  return 0;
+}
+
+
+static void batch_add(struct watcher_batch* b, const char* name, int events) {
+  struct watcher_change* c;
+  uv_fs_event_change_t one;
+  unsigned int mask;
+  unsigned int i;
+  size_t len;
+
+  if (b->index_size > 0) {
+    mask = b->index_size - 1;
+    for (i = batch_hash(name) & mask; b->index[i] != 0; i = (i + 1) & mask) {
+      c = &b->changes[b->index[i] - 1];
+      if (strcmp(b->names + c->name, name) == 0) {
+        c->events |= events;
+        return;
+      }
+    }
+  }
+
+  len = strlen(name);
+  if (batch_grow(b, len)) {
+    /* Out of memory, don't lose the change. */
+    batch_flush(&b->timer);
+    one.filename = name;
+    one.events = events;
+    b->cb(b->handle, &one, 1, 0);
+    return;
+  }
+
+  c = &b->changes[b->nchanges];
+  c->name = b->names_len;
+  c->events = events;
+  memcpy(b->names + b->names_len, name, len + 1);
+  b->names_len += len + 1;
+
+  mask = b->index_size - 1;
+  for (i = batch_hash(name) & mask; b->index[i] != 0; i = (i + 1) & mask);
+  b->index[i] = ++b->nchanges;
+
+  /* The window starts with the first change, so a steady stream of changes
+   * can't hold them back forever.
+   */
+  if (b->nchanges == 1)
+    uv_timer_start(&b->timer, batch_flush, b->window, 0);
+}
+
+
+static void batch_reset(struct watcher_batch* b) {
+  uv_timer_stop(&b->timer);
+  b->nchanges = 0;
+  b->names_len = 0;
+  if (b->index != NULL)
+    memset(b->index, 0, b->index_size * sizeof(*b->index));
+}
+
+
+static void batch_free(uv_fs_event_t* handle) {
+  struct watcher_batch* b;
+
+  b = handle->batch;
+  if (b == NULL)
+    return;
+
+  /* The timer is internal and never started closing, so take it off the
+   * loop's handle queue by hand.
+   */
+  uv_timer_stop(&b->timer);
+  QUEUE_REMOVE(&b->timer.handle_queue);
+  uv__free(b->changes);
+  uv__free(b->out);
+  uv__free(b->index);
+  uv__free(b->names);
+  uv__free(b);
+  handle->batch = NULL;
+}
+
+
+static void deliver(struct watcher_sub* sub, const char* name, int events) {
+  uv_fs_event_t* handle;
+  char path[PATH_MAX];
+
+  handle = sub->handle;
+
+  if (sub->prefix_len > 0) {
+    if (join_path(path, sizeof(path), sub->prefix, name, NULL))
+      return;
+    name = path;
+  }
+
+  if (handle->batch != NULL)
+    batch_add(handle->batch, name, events);
+  else
+    handle->cb(handle, name, events, 0);
+}
+
+
 static void uv__inotify_read(uv_loop_t* loop,
                              uv__io_t* dummy,
                              unsigned int events) {
   const struct uv__inotify_event* e;
   struct watcher_list* w;
-  uv_fs_event_t* h;
+  struct watcher_sub* sub;
+  QUEUE queue;
   QUEUE* q;
   const char* path;
+  char child[PATH_MAX];
+  size_t child_len;
   ssize_t size;
   const char *p;
   /* needs to be large enough for sizeof(inotify_event) + strlen(path) */
@@ -153,16 +677,63 @@ static void uv__inotify_read(uv_loop_t* loop,
       if (w == NULL)
         continue; /* Stale event, no watchers left. */
 
-      /* inotify does not return the filename when monitoring a single file
-       * for modifications. Repurpose the filename for API compatibility.
-       * I'm not convinced this is a good thing, maybe it should go.
+      /* Callbacks may stop handles, which removes them from w->watchers.
+       * Walk a private copy of the queue and keep w alive while doing so.
        */
-      path = e->len ? (const char*) (e + 1) : uv__basename_r(w->path);
+      w->iterating = 1;
+      QUEUE_INIT(&queue);
+      if (!QUEUE_EMPTY(&w->watchers)) {
+        q = QUEUE_HEAD(&w->watchers);
+        QUEUE_SPLIT(&w->watchers, q, &queue);
+      }
 
-      QUEUE_FOREACH(q, &w->watchers) {
-        h = QUEUE_DATA(q, uv_fs_event_t, watchers);
-        h->cb(h, path, events, 0);
+      while (!QUEUE_EMPTY(&queue)) {
+        q = QUEUE_HEAD(&queue);
+        sub = QUEUE_DATA(q, struct watcher_sub, member);
+        QUEUE_REMOVE(q);
+        QUEUE_INSERT_TAIL(&w->watchers, q);
+
+        if (sub->prefix_len > 0) {
+          /* A subdirectory of a recursive handle. The parent directory
+           * reports what happens to the directory itself.
+           */
+          if (e->mask & UV__IN_IGNORED)
+            remove_sub(sub);
+          if (e->len == 0)
+            continue;
+        }
+
+        if (e->len == 0) {
+          /* inotify does not return the filename when monitoring a single
+           * file for modifications. Repurpose the filename for API
+           * compatibility. I'm not convinced this is a good thing, maybe it
+           * should go.
+           */
+          path = uv__basename_r(sub->handle->path);
+          deliver(sub, path, events);
+          continue;
+        }
+
+        path = (const char*) (e + 1);
+
+        if (sub->recursive && (e->mask & UV__IN_ISDIR)) {
+          if (join_path(child,
+                        sizeof(child),
+                        sub->prefix,
+                        path,
+                        &child_len) == 0) {
+            if (e->mask & (UV__IN_DELETE | UV__IN_MOVED_FROM))
+              remove_subtree(sub->handle, child, child_len);
+            if (e->mask & (UV__IN_CREATE | UV__IN_MOVED_TO))
+              watch_dir(sub->handle, child, child_len);
+          }
+        }
+
+        deliver(sub, path, events);
       }
+
+      w->iterating = 0;
+      maybe_free_watcher_list(w, loop);
     }
   }
 }
@@ -170,6 +741,9 @@ static void uv__inotify_read(uv_loop_t* loop,
 
 int uv_fs_event_init(uv_loop_t* loop, uv_fs_event_t* handle) {
   uv__handle_init(loop, (uv_handle_t*)handle, UV_FS_EVENT);
+  QUEUE_INIT(&handle->watchers);
+  handle->wd = -1;
+  handle->batch = NULL;
   return 0;
 }
 
@@ -179,9 +753,8 @@ int uv_fs_event_start(uv_fs_event_t* handle,
                       const char* path,
                       unsigned int flags) {
   struct watcher_list* w;
-  int events;
+  int recursive;
   int err;
-  int wd;
 
   if (uv__is_active(handle))
     return -EINVAL;
@@ -190,68 +763,97 @@ int uv_fs_event_start(uv_fs_event_t* handle,
   if (err)
     return err;
 
-  events = UV__IN_ATTRIB
-         | UV__IN_CREATE
-         | UV__IN_MODIFY
-         | UV__IN_DELETE
-         | UV__IN_DELETE_SELF
-         | UV__IN_MOVE_SELF
-         | UV__IN_MOVED_FROM
-         | UV__IN_MOVED_TO;
-
-  wd = uv__inotify_add_watch(handle->loop->inotify_fd, path, events);
-  if (wd == -1)
-    return -errno;
-
-  w = find_watcher(handle->loop, wd);
-  if (w)
-    goto no_insert;
+  err = add_watcher(handle->loop, path, UV__INOTIFY_EVENTS, &w);
+  if (err)
+    return err;
 
-  w = uv__malloc(sizeof(*w) + strlen(path) + 1);
-  if (w == NULL)
+  handle->path = uv__strdup(path);
+  if (handle->path == NULL) {
+    maybe_free_watcher_list(w, handle->loop);
     return -ENOMEM;
+  }
 
-  w->wd = wd;
-  w->path = strcpy((char*)(w + 1), path);
-  QUEUE_INIT(&w->watchers);
-  RB_INSERT(watcher_root, CAST(&handle->loop->inotify_watchers), w);
+  recursive = (flags & UV_FS_EVENT_RECURSIVE) != 0;
+  if (add_sub(handle, w, "", 0, recursive) == NULL) {
+    maybe_free_watcher_list(w, handle->loop);
+    uv__free(handle->path);
+    handle->path = NULL;
+    return -ENOMEM;
+  }
 
-no_insert:
   uv__handle_start(handle);
-  QUEUE_INSERT_TAIL(&w->watchers, &handle->watchers);
-  handle->path = w->path;
   handle->cb = cb;
-  handle->wd = wd;
+  handle->wd = w->wd;
+
+  if (recursive) {
+    err = watch_children(handle, "", 0);
+    if (err) {
+      uv_fs_event_stop(handle);
+      return err;
+    }
+  }
 
   return 0;
 }
 
 
 int uv_fs_event_stop(uv_fs_event_t* handle) {
-  struct watcher_list* w;
+  QUEUE* q;
 
   if (!uv__is_active(handle))
     return 0;
 
-  w = find_watcher(handle->loop, handle->wd);
-  assert(w != NULL);
+  while (!QUEUE_EMPTY(&handle->watchers)) {
+    q = QUEUE_HEAD(&handle->watchers);
+    remove_sub(QUEUE_DATA(q, struct watcher_sub, handle_member));
+  }
+
+  if (handle->batch != NULL)
+    batch_reset(handle->batch);
 
+  uv__free(handle->path);
   handle->wd = -1;
   handle->path = NULL;
   uv__handle_stop(handle);
-  QUEUE_REMOVE(&handle->watchers);
 
-  if (QUEUE_EMPTY(&w->watchers)) {
-    /* No watchers left for this path. Clean up. */
-    RB_REMOVE(watcher_root, CAST(&handle->loop->inotify_watchers), w);
-    uv__inotify_rm_watch(handle->loop->inotify_fd, w->wd);
-    uv__free(w);
+  return 0;
+}
+
+
+int uv_fs_event_set_batching(uv_fs_event_t* handle,
+                             uint64_t window,
+                             uv_fs_event_batch_cb cb) {
+  struct watcher_batch* b;
+
+  if (uv__is_active(handle))
+    return -EINVAL;
+
+  if (window == 0 || cb == NULL) {
+    batch_free(handle);
+    return 0;
   }
 
+  b = handle->batch;
+  if (b == NULL) {
+    b = uv__calloc(1, sizeof(*b));
+    if (b == NULL)
+      return -ENOMEM;
+
+    uv_timer_init(handle->loop, &b->timer);
+    uv__handle_unref(&b->timer);
+    b->timer.flags |= UV__HANDLE_INTERNAL;
+    b->handle = handle;
+    handle->batch = b;
+  }
+
+  b->window = window;
+  b->cb = cb;
+
   return 0;
 }
 
 
 void uv__fs_event_close(uv_fs_event_t* handle) {
   uv_fs_event_stop(handle);
+  batch_free(handle);
 }
@@ -0,0 +1,491 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Asynchronous file system requests through io_uring.
+ *
+ * Loops opt in with the UV_LOOP_USE_IO_URING option or the UV_USE_IO_URING
+ * environment variable; requests on the ring can't be cancelled, so it's not
+ * the default. Such a loop lazily creates a ring the first time it sees a
+ * request that the ring can handle. Requests are only written to the submission queue, the
+ * whole batch is handed to the kernel with a single io_uring_enter() call
+ * right before the loop polls for I/O. The ring's file descriptor is watched
+ * like any other, it becomes readable when there are completions to reap.
+ *
+ * Anything the ring can't do (unsupported operation, old kernel, ring full)
+ * goes to the thread pool like before.
+ */
+
+#include "uv.h"
+#include "internal.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#define UV__IOU_ENTRIES 256
+
+struct uv__iou {
+  uv__io_t watcher;
+  uint32_t* sqhead;
+  uint32_t* sqtail;
+  uint32_t* sqarray;
+  uint32_t sqmask;
+  uint32_t* cqhead;
+  uint32_t* cqtail;
+  uint32_t cqmask;
+  struct uv__io_uring_sqe* sqes;
+  struct uv__io_uring_cqe* cqes;
+  void* ring;
+  size_t ringlen;
+  size_t sqeslen;
+  unsigned int cqentries;
+  unsigned int in_flight;     /* Submitted or queued, not yet reaped. */
+  unsigned int unsubmitted;   /* In the submission queue, not yet entered. */
+  unsigned int ops;           /* Bit mask of supported uv_fs_type values. */
+  int fd;
+};
+
+static int no_io_uring;
+
+
+static void uv__iou_io(uv_loop_t* loop, uv__io_t* w, unsigned int events);
+
+
+static unsigned int uv__iou_probe(int ringfd) {
+  struct uv__io_uring_probe probe;
+  unsigned int ops;
+  unsigned int i;
+  unsigned char supported[UV__IORING_OP_MAX];
+
+  memset(&probe, 0, sizeof(probe));
+  if (uv__io_uring_register(ringfd,
+                            UV__IORING_REGISTER_PROBE,
+                            &probe,
+                            ARRAY_SIZE(probe.ops))) {
+    return 0;
+  }
+
+  memset(supported, 0, sizeof(supported));
+  for (i = 0; i < probe.ops_len && i < ARRAY_SIZE(probe.ops); i++)
+    if (probe.ops[i].op < UV__IORING_OP_MAX)
+      if (probe.ops[i].flags & UV__IO_URING_OP_SUPPORTED)
+        supported[probe.ops[i].op] = 1;
+
+#define X(type, op)                                                           \
+  if (supported[UV__IORING_OP_ ## op])                                        \
+    ops |= 1u << UV_FS_ ## type;
+
+  ops = 0;
+  X(OPEN, OPENAT)
+  X(CLOSE, CLOSE)
+  X(FSYNC, FSYNC)
+  X(FDATASYNC, FSYNC)
+  X(STAT, STATX)
+  X(LSTAT, STATX)
+  X(FSTAT, STATX)
+  if (supported[UV__IORING_OP_READ] && supported[UV__IORING_OP_READV])
+    ops |= 1u << UV_FS_READ;
+  if (supported[UV__IORING_OP_WRITE] && supported[UV__IORING_OP_WRITEV])
+    ops |= 1u << UV_FS_WRITE;
+#undef X
+
+  return ops;
+}
+
+
+static int uv__iou_init(uv_loop_t* loop) {
+  struct uv__io_uring_params params;
+  struct uv__iou* iou;
+  uint32_t sqentries;
+  uint32_t i;
+  size_t sqlen;
+  size_t cqlen;
+  char* ring;
+  void* sqes;
+  int ringfd;
+
+  memset(&params, 0, sizeof(params));
+  ringfd = uv__io_uring_setup(UV__IOU_ENTRIES, &params);
+  if (ringfd == -1) {
+    if (errno == ENOSYS || errno == EPERM || errno == EINVAL)
+      no_io_uring = 1;
+    return -errno;
+  }
+
+  /* Need a single mmap for both rings (5.4), no dropped completions (5.5)
+   * and read/write at the current file position (5.6).
+   */
+  if ((params.features & UV__IORING_FEAT_SINGLE_MMAP) == 0 ||
+      (params.features & UV__IORING_FEAT_NODROP) == 0 ||
+      (params.features & UV__IORING_FEAT_RW_CUR_POS) == 0) {
+    no_io_uring = 1;
+    uv__close(ringfd);
+    return -ENOSYS;
+  }
+
+  iou = uv__malloc(sizeof(*iou));
+  if (iou == NULL) {
+    uv__close(ringfd);
+    return -ENOMEM;
+  }
+
+  iou->ops = uv__iou_probe(ringfd);
+  if (iou->ops == 0) {
+    no_io_uring = 1;
+    uv__free(iou);
+    uv__close(ringfd);
+    return -ENOSYS;
+  }
+
+  sqlen = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cqlen = params.cq_off.cqes +
+          params.cq_entries * sizeof(struct uv__io_uring_cqe);
+  iou->ringlen = sqlen > cqlen ? sqlen : cqlen;
+  iou->sqeslen = params.sq_entries * sizeof(struct uv__io_uring_sqe);
+
+  ring = mmap(NULL,
+              iou->ringlen,
+              PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE,
+              ringfd,
+              UV__IORING_OFF_SQ_RING);
+
+  sqes = mmap(NULL,
+              iou->sqeslen,
+              PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE,
+              ringfd,
+              UV__IORING_OFF_SQES);
+
+  if (ring == MAP_FAILED || sqes == MAP_FAILED) {
+    if (ring != MAP_FAILED)
+      munmap(ring, iou->ringlen);
+    if (sqes != MAP_FAILED)
+      munmap(sqes, iou->sqeslen);
+    uv__free(iou);
+    uv__close(ringfd);
+    return -ENOMEM;
+  }
+
+  iou->ring = ring;
+  iou->sqes = sqes;
+  iou->sqhead = (uint32_t*) (ring + params.sq_off.head);
+  iou->sqtail = (uint32_t*) (ring + params.sq_off.tail);
+  iou->sqarray = (uint32_t*) (ring + params.sq_off.array);
+  iou->sqmask = *(uint32_t*) (ring + params.sq_off.ring_mask);
+  iou->cqhead = (uint32_t*) (ring + params.cq_off.head);
+  iou->cqtail = (uint32_t*) (ring + params.cq_off.tail);
+  iou->cqmask = *(uint32_t*) (ring + params.cq_off.ring_mask);
+  iou->cqes = (struct uv__io_uring_cqe*) (ring + params.cq_off.cqes);
+  iou->cqentries = params.cq_entries;
+  iou->in_flight = 0;
+  iou->unsubmitted = 0;
+  iou->fd = ringfd;
+
+  /* Submission queue entries are used in order, map them one to one. */
+  sqentries = *(uint32_t*) (ring + params.sq_off.ring_entries);
+  for (i = 0; i < sqentries; i++)
+    iou->sqarray[i] = i;
+
+  uv__io_init(&iou->watcher, uv__iou_io, ringfd);
+  uv__io_start(loop, &iou->watcher, UV__POLLIN);
+  loop->iou = iou;
+
+  return 0;
+}
+
+
+void uv__iou_loop_delete(uv_loop_t* loop) {
+  struct uv__iou* iou;
+
+  iou = loop->iou;
+  if (iou == NULL)
+    return;
+
+  assert(iou->in_flight == 0);
+  uv__io_stop(loop, &iou->watcher, UV__POLLIN);
+  munmap(iou->sqes, iou->sqeslen);
+  munmap(iou->ring, iou->ringlen);
+  uv__close(iou->fd);
+  uv__free(iou);
+  loop->iou = NULL;
+}
+
+
+/* Returns the number of requests that are still waiting for submission. */
+int uv__iou_flush(uv_loop_t* loop) {
+  struct uv__iou* iou;
+  int rc;
+
+  iou = loop->iou;
+  if (iou == NULL || iou->unsubmitted == 0)
+    return 0;
+
+  do
+    rc = uv__io_uring_enter(iou->fd, iou->unsubmitted, 0, 0);
+  while (rc == -1 && errno == EINTR);
+
+  /* EAGAIN, EBUSY and ENOMEM mean the kernel is short on resources or has
+   * completions it couldn't post yet, try again on the next tick.
+   */
+  if (rc == -1) {
+    if (errno != EAGAIN && errno != EBUSY && errno != ENOMEM)
+      abort();
+    return iou->unsubmitted;
+  }
+
+  iou->unsubmitted -= rc;
+  return iou->unsubmitted;
+}
+
+
+static struct uv__io_uring_sqe* uv__iou_get_sqe(struct uv__iou* iou) {
+  struct uv__io_uring_sqe* sqe;
+  uint32_t head;
+  uint32_t tail;
+
+  /* Every request needs room for its completion, don't rely on the
+   * kernel buffering overflowing completions.
+   */
+  if (iou->in_flight >= iou->cqentries)
+    return NULL;
+
+  head = __atomic_load_n(iou->sqhead, __ATOMIC_ACQUIRE);
+  tail = *iou->sqtail;
+  if (tail - head > iou->sqmask)
+    return NULL;
+
+  sqe = iou->sqes + (tail & iou->sqmask);
+  memset(sqe, 0, sizeof(*sqe));
+
+  return sqe;
+}
+
+
+static void uv__iou_submit(struct uv__iou* iou,
+                           struct uv__io_uring_sqe* sqe,
+                           uv_fs_t* req) {
+  sqe->user_data = (uintptr_t) req;
+  __atomic_store_n(iou->sqtail, *iou->sqtail + 1, __ATOMIC_RELEASE);
+  iou->in_flight++;
+  iou->unsubmitted++;
+}
+
+
+/* Returns 1 if the request is now owned by the ring, 0 if the caller should
+ * hand it to the thread pool instead.
+ */
+int uv__iou_fs_submit(uv_loop_t* loop, uv_fs_t* req) {
+  struct uv__io_uring_sqe* sqe;
+  struct uv__statx* statxbuf;
+  struct uv__iou* iou;
+
+  if (no_io_uring || !(loop->flags & UV_LOOP_ENABLE_IO_URING))
+    return 0;
+
+  iou = loop->iou;
+  if (iou == NULL) {
+    if (uv__iou_init(loop))
+      return 0;
+    iou = loop->iou;
+  }
+
+  if ((iou->ops & (1u << req->fs_type)) == 0)
+    return 0;
+
+  if (req->fs_type == UV_FS_READ || req->fs_type == UV_FS_WRITE)
+    if (req->nbufs > (unsigned int) uv__getiovmax())
+      return 0;
+
+  sqe = uv__iou_get_sqe(iou);
+  if (sqe == NULL) {
+    /* Submission queue full, make room and try again. */
+    uv__iou_flush(loop);
+    sqe = uv__iou_get_sqe(iou);
+    if (sqe == NULL)
+      return 0;
+  }
+
+  switch (req->fs_type) {
+  case UV_FS_OPEN:
+    sqe->opcode = UV__IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (uintptr_t) req->path;
+    sqe->len = req->mode;
+    sqe->op_flags = req->flags | O_CLOEXEC;
+    break;
+
+  case UV_FS_CLOSE:
+    sqe->opcode = UV__IORING_OP_CLOSE;
+    sqe->fd = req->file;
+    break;
+
+  case UV_FS_FSYNC:
+  case UV_FS_FDATASYNC:
+    sqe->opcode = UV__IORING_OP_FSYNC;
+    sqe->fd = req->file;
+    if (req->fs_type == UV_FS_FDATASYNC)
+      sqe->op_flags = UV__IORING_FSYNC_DATASYNC;
+    break;
+
+  case UV_FS_READ:
+  case UV_FS_WRITE:
+    sqe->fd = req->file;
+    sqe->off = req->off < 0 ? (uint64_t) -1 : (uint64_t) req->off;
+    if (req->nbufs == 1 && req->bufs[0].len <= UINT32_MAX) {
+      sqe->opcode = req->fs_type == UV_FS_READ ? UV__IORING_OP_READ
+                                               : UV__IORING_OP_WRITE;
+      sqe->addr = (uintptr_t) req->bufs[0].base;
+      sqe->len = req->bufs[0].len;
+    } else {
+      sqe->opcode = req->fs_type == UV_FS_READ ? UV__IORING_OP_READV
+                                               : UV__IORING_OP_WRITEV;
+      sqe->addr = (uintptr_t) req->bufs;
+      sqe->len = req->nbufs;
+    }
+    break;
+
+  case UV_FS_STAT:
+  case UV_FS_LSTAT:
+  case UV_FS_FSTAT:
+    statxbuf = uv__malloc(sizeof(*statxbuf));
+    if (statxbuf == NULL)
+      return 0;
+    req->ptr = statxbuf;
+    sqe->opcode = UV__IORING_OP_STATX;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (uintptr_t) req->path;
+    sqe->off = (uintptr_t) statxbuf;
+    sqe->len = UV__STATX_BASIC_STATS;
+    if (req->fs_type == UV_FS_LSTAT)
+      sqe->op_flags = UV__AT_SYMLINK_NOFOLLOW;
+    if (req->fs_type == UV_FS_FSTAT) {
+      sqe->fd = req->file;
+      sqe->addr = (uintptr_t) "";
+      sqe->op_flags = UV__AT_EMPTY_PATH;
+    }
+    break;
+
+  default:
+    abort();
+  }
+
+  /* Not on any thread pool queue, uv_cancel() must report UV_EBUSY. */
+  req->work_req.loop = loop;
+  req->work_req.work = NULL;
+  QUEUE_INIT(&req->work_req.wq);
+
+  uv__iou_submit(iou, sqe, req);
+  return 1;
+}
+
+
+static void uv__iou_statx_to_stat(const struct uv__statx* src,
+                                  uv_stat_t* dst) {
+  dst->st_dev = makedev(src->stx_dev_major, src->stx_dev_minor);
+  dst->st_mode = src->stx_mode;
+  dst->st_nlink = src->stx_nlink;
+  dst->st_uid = src->stx_uid;
+  dst->st_gid = src->stx_gid;
+  dst->st_rdev = makedev(src->stx_rdev_major, src->stx_rdev_minor);
+  dst->st_ino = src->stx_ino;
+  dst->st_size = src->stx_size;
+  dst->st_blksize = src->stx_blksize;
+  dst->st_blocks = src->stx_blocks;
+  dst->st_atim.tv_sec = src->stx_atime.tv_sec;
+  dst->st_atim.tv_nsec = src->stx_atime.tv_nsec;
+  dst->st_mtim.tv_sec = src->stx_mtime.tv_sec;
+  dst->st_mtim.tv_nsec = src->stx_mtime.tv_nsec;
+  dst->st_ctim.tv_sec = src->stx_ctime.tv_sec;
+  dst->st_ctim.tv_nsec = src->stx_ctime.tv_nsec;
+  /* Same as uv__to_stat(), stat() doesn't report the birth time either. */
+  dst->st_birthtim.tv_sec = src->stx_ctime.tv_sec;
+  dst->st_birthtim.tv_nsec = src->stx_ctime.tv_nsec;
+  dst->st_flags = 0;
+  dst->st_gen = 0;
+}
+
+
+static void uv__iou_fs_done(uv_loop_t* loop, uv_fs_t* req, int res) {
+  req->result = res;
+
+  switch (req->fs_type) {
+  case UV_FS_READ:
+  case UV_FS_WRITE:
+    if (req->bufs != req->bufsml)
+      uv__free(req->bufs);
+    req->bufs = NULL;
+    break;
+
+  case UV_FS_STAT:
+  case UV_FS_LSTAT:
+  case UV_FS_FSTAT:
+    if (res == 0)
+      uv__iou_statx_to_stat(req->ptr, &req->statbuf);
+    uv__free(req->ptr);
+    req->ptr = NULL;
+    if (res == 0)
+      req->ptr = &req->statbuf;
+    break;
+
+  default:
+    break;
+  }
+
+  uv__req_unregister(loop, req);
+  req->cb(req);
+}
+
+
+static void uv__iou_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
+  struct uv__io_uring_cqe* cqe;
+  struct uv__iou* iou;
+  uv_fs_t* req;
+  uint32_t head;
+  uint32_t tail;
+  int res;
+
+  iou = container_of(w, struct uv__iou, watcher);
+
+  for (;;) {
+    head = *iou->cqhead;
+    tail = __atomic_load_n(iou->cqtail, __ATOMIC_ACQUIRE);
+    if (head == tail)
+      break;
+
+    /* Release the slot before running the callback, which may well start
+     * the next request.
+     */
+    cqe = iou->cqes + (head & iou->cqmask);
+    req = (uv_fs_t*) (uintptr_t) cqe->user_data;
+    res = cqe->res;
+    __atomic_store_n(iou->cqhead, head + 1, __ATOMIC_RELEASE);
+    iou->in_flight--;
+
+    uv__iou_fs_done(loop, req, res);
+  }
+}
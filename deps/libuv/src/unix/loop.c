@@ -37,10 +37,11 @@ int uv_loop_init(uv_loop_t* loop) {
   QUEUE_INIT(&loop->wq);
   QUEUE_INIT(&loop->active_reqs);
   QUEUE_INIT(&loop->idle_handles);
-  QUEUE_INIT(&loop->async_handles);
+  QUEUE_INIT(&loop->async_ready);
   QUEUE_INIT(&loop->check_handles);
   QUEUE_INIT(&loop->prepare_handles);
   QUEUE_INIT(&loop->handle_queue);
+  QUEUE_INIT(&loop->fs_poll_groups);
 
   loop->nfds = 0;
   loop->watchers = NULL;
@@ -58,6 +59,10 @@ int uv_loop_init(uv_loop_t* loop) {
 
   loop->timer_counter = 0;
   loop->stop_flag = 0;
+  loop->fs_work_kind = UV_WORK_FAST_IO;
+  /* Benchmarks suggest this gives the best throughput. */
+  loop->poll_budget = 48;
+  loop->read_buf_size = 64 * 1024;
 
   err = uv__platform_loop_init(loop);
   if (err)
@@ -107,6 +112,10 @@ fail_signal_init:
 void uv__loop_close(uv_loop_t* loop) {
   uv__signal_loop_cleanup(loop);
   uv__platform_loop_delete(loop);
+  uv__timer_wheel_delete(loop);
+  uv__write_pool_delete(loop);
+  uv__dns_resolver_delete(loop);
+  uv__metrics_delete(loop);
   uv__async_stop(loop, &loop->async_watcher);
 
   if (loop->emfile_fd != -1) {
@@ -121,6 +130,7 @@ void uv__loop_close(uv_loop_t* loop) {
 
   uv_mutex_lock(&loop->wq_mutex);
   assert(QUEUE_EMPTY(&loop->wq) && "thread pool work queue not empty!");
+  assert(loop->wq_done == NULL && "thread pool work queue not empty!");
   assert(!uv__has_active_reqs(loop));
   uv_mutex_unlock(&loop->wq_mutex);
   uv_mutex_destroy(&loop->wq_mutex);
@@ -144,6 +154,43 @@ void uv__loop_close(uv_loop_t* loop) {
 
 
 int uv__loop_configure(uv_loop_t* loop, uv_loop_option option, va_list ap) {
+  const char* resolv_conf;
+  const char* hosts;
+  unsigned int budget;
+
+  if (option == UV_LOOP_DNS_CACHE)
+    return uv__dns_cache_configure(loop, va_arg(ap, unsigned int));
+
+  if (option == UV_LOOP_DNS_RESOLVER) {
+    resolv_conf = va_arg(ap, const char*);
+    hosts = va_arg(ap, const char*);
+    return uv__dns_resolver_configure(loop, resolv_conf, hosts);
+  }
+
+  if (option == UV_LOOP_TIMER_WHEEL)
+    return uv__timer_wheel_configure(loop, va_arg(ap, int));
+
+  if (option == UV_LOOP_METRICS)
+    return uv__metrics_configure(loop, va_arg(ap, int));
+
+  if (option == UV_LOOP_POLL_BUDGET) {
+    budget = va_arg(ap, unsigned int);
+    if (budget == 0)
+      return UV_EINVAL;
+    loop->poll_budget = budget;
+    return 0;
+  }
+
+#if defined(__linux__)
+  if (option == UV_LOOP_USE_IO_URING) {
+    if (va_arg(ap, int))
+      loop->flags |= UV_LOOP_ENABLE_IO_URING;
+    else
+      loop->flags &= ~UV_LOOP_ENABLE_IO_URING;
+    return 0;
+  }
+#endif
+
   if (option != UV_LOOP_BLOCK_SIGNAL)
     return UV_ENOSYS;
 
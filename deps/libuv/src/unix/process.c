@@ -44,6 +44,21 @@ extern char **environ;
 # include <grp.h>
 #endif
 
+/* Since glibc 2.24 posix_spawn() is implemented with
+ * clone(CLONE_VM | CLONE_VFORK): the child runs on the parent's address space
+ * until it calls execve(), so spawning doesn't copy the page tables of a large
+ * parent, and exec errors are reported by posix_spawn() itself.
+ */
+#if defined(__linux__) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 24))
+# define UV__HAVE_POSIX_SPAWN 1
+# include <spawn.h>
+# include <string.h>
+# if __GLIBC__ > 2 || __GLIBC_MINOR__ >= 29
+#  define UV__HAVE_POSIX_SPAWN_CHDIR 1
+# endif
+#endif
+
 
 static void uv__chld(uv_signal_t* handle, int signum) {
   uv_process_t* process;
@@ -377,6 +392,179 @@ static void uv__process_child_init(const uv_process_options_t* options,
 }
 
 
+#ifdef UV__HAVE_POSIX_SPAWN
+/* Returns 1 if posix_spawn() can do everything uv__process_child_init() would
+ * do for these options, 0 if uv_spawn() should fork() instead.
+ */
+static int uv__spawn_can_use_posix_spawn(const uv_process_options_t* options,
+                                         int stdio_count,
+                                         int (*pipes)[2]) {
+  static int use_fork = -1;
+  const char* parent_path;
+  const char* path;
+  char** env;
+  int use_fd;
+  int flags;
+  int fd;
+
+  if (use_fork == -1) {
+    const char* val = getenv("UV_SPAWN_USE_FORK");
+    use_fork = (val != NULL && atoi(val) != 0);  /* Off by default. */
+  }
+
+  if (use_fork)
+    return 0;
+
+  if (options->flags & (UV_PROCESS_SETUID | UV_PROCESS_SETGID))
+    return 0;
+
+#ifndef POSIX_SPAWN_SETSID
+  if (options->flags & UV_PROCESS_DETACHED)
+    return 0;
+#endif
+
+#ifndef UV__HAVE_POSIX_SPAWN_CHDIR
+  if (options->cwd != NULL)
+    return 0;
+#endif
+
+  /* posix_spawnp() searches the PATH of the parent, execvp() in the forked
+   * child searches the PATH in options->env.
+   */
+  if (options->env != NULL && strchr(options->file, '/') == NULL) {
+    path = NULL;
+    for (env = options->env; *env != NULL; env++) {
+      if (strncmp(*env, "PATH=", 5) == 0) {
+        path = *env + 5;
+        break;
+      }
+    }
+
+    parent_path = getenv("PATH");
+    if (path == NULL || parent_path == NULL) {
+      if (path != parent_path)
+        return 0;
+    } else if (strcmp(path, parent_path) != 0) {
+      return 0;
+    }
+  }
+
+  for (fd = 0; fd < stdio_count; fd++) {
+    use_fd = pipes[fd][1];
+    if (use_fd < 0)
+      continue;
+
+    /* Swapping low numbered fds needs the F_DUPFD dance from
+     * uv__process_child_init(), a list of dup2() calls can't express it.
+     */
+    if (use_fd != fd && use_fd < stdio_count)
+      return 0;
+
+    /* File actions can't clear FD_CLOEXEC on an fd that is passed on as is. */
+    if (use_fd == fd) {
+      flags = fcntl(fd, F_GETFD);
+      if (flags == -1 || (flags & FD_CLOEXEC))
+        return 0;
+    }
+  }
+
+  return 1;
+}
+
+
+/* The posix_spawn() equivalent of fork() + uv__process_child_init(). Returns
+ * the error of the exec, the child has been reaped by then.
+ */
+static int uv__spawn_posix_spawn(const uv_process_options_t* options,
+                                 int stdio_count,
+                                 int (*pipes)[2],
+                                 pid_t* pid) {
+  posix_spawn_file_actions_t actions;
+  posix_spawnattr_t attr;
+  char** env;
+  int use_fd;
+  int err;
+  int fd;
+  int i;
+
+  err = posix_spawn_file_actions_init(&actions);
+  if (err)
+    return -err;
+
+  err = posix_spawnattr_init(&attr);
+  if (err) {
+    posix_spawn_file_actions_destroy(&actions);
+    return -err;
+  }
+
+  for (fd = 0; fd < stdio_count && err == 0; fd++) {
+    use_fd = pipes[fd][1];
+
+    if (use_fd < 0) {
+      /* redirect stdin, stdout and stderr to /dev/null even if UV_IGNORE is
+       * set
+       */
+      if (fd < 3)
+        err = posix_spawn_file_actions_addopen(&actions,
+                                               fd,
+                                               "/dev/null",
+                                               fd == 0 ? O_RDONLY : O_RDWR,
+                                               0);
+      continue;
+    }
+
+    if (use_fd != fd)
+      err = posix_spawn_file_actions_adddup2(&actions, use_fd, fd);
+
+    /* The child would do this on its copy, which shares the file status
+     * flags with ours anyway.
+     */
+    if (fd <= 2)
+      uv__nonblock(use_fd, 0);
+  }
+
+  for (fd = 0; fd < stdio_count && err == 0; fd++) {
+    use_fd = pipes[fd][1];
+    if (use_fd < stdio_count)
+      continue;
+
+    /* Closing the same fd twice would make posix_spawn() fail with EBADF. */
+    for (i = 0; i < fd; i++)
+      if (pipes[i][1] == use_fd)
+        break;
+
+    if (i == fd)
+      err = posix_spawn_file_actions_addclose(&actions, use_fd);
+  }
+
+#ifdef UV__HAVE_POSIX_SPAWN_CHDIR
+  if (err == 0 && options->cwd != NULL)
+    err = posix_spawn_file_actions_addchdir_np(&actions, options->cwd);
+#endif
+
+#ifdef POSIX_SPAWN_SETSID
+  if (err == 0 && (options->flags & UV_PROCESS_DETACHED))
+    err = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+#endif
+
+  env = options->env != NULL ? options->env : environ;
+
+  if (err == 0)
+    err = posix_spawnp(pid,
+                       options->file,
+                       &actions,
+                       &attr,
+                       options->args,
+                       env);
+
+  posix_spawnattr_destroy(&attr);
+  posix_spawn_file_actions_destroy(&actions);
+
+  return -err;
+}
+#endif  /* UV__HAVE_POSIX_SPAWN */
+
+
 int uv_spawn(uv_loop_t* loop,
              uv_process_t* process,
              const uv_process_options_t* options) {
@@ -420,6 +608,19 @@ int uv_spawn(uv_loop_t* loop,
       goto error;
   }
 
+  uv_signal_start(&loop->child_watcher, uv__chld, SIGCHLD);
+
+#ifdef UV__HAVE_POSIX_SPAWN
+  if (uv__spawn_can_use_posix_spawn(options, stdio_count, pipes)) {
+    pid = 0;
+    uv_rwlock_wrlock(&loop->cloexec_lock);
+    exec_errorno = uv__spawn_posix_spawn(options, stdio_count, pipes, &pid);
+    uv_rwlock_wrunlock(&loop->cloexec_lock);
+    process->status = 0;
+    goto spawned;
+  }
+#endif
+
   /* This pipe is used by the parent to wait until
    * the child has called `execve()`. We need this
    * to avoid the following race condition:
@@ -444,8 +645,6 @@ int uv_spawn(uv_loop_t* loop,
   if (err)
     goto error;
 
-  uv_signal_start(&loop->child_watcher, uv__chld, SIGCHLD);
-
   /* Acquire write lock to prevent opening new fds in worker threads */
   uv_rwlock_wrlock(&loop->cloexec_lock);
   pid = fork();
@@ -490,6 +689,9 @@ int uv_spawn(uv_loop_t* loop,
 
   uv__close(signal_pipe[0]);
 
+#ifdef UV__HAVE_POSIX_SPAWN
+spawned:
+#endif
   for (i = 0; i < options->stdio_count; i++) {
     err = uv__process_open_stream(options->stdio + i, pipes[i], i == 0);
     if (err == 0)
@@ -30,11 +30,18 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <limits.h> /* IOV_MAX */
 
+#if defined(__linux__)
+# include <sys/sendfile.h>
+#endif
+
 #if defined(__APPLE__)
 # include <sys/event.h>
 # include <sys/time.h>
@@ -66,6 +73,16 @@ static void uv__read(uv_stream_t* stream);
 static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events);
 static void uv__write_callbacks(uv_stream_t* stream);
 static size_t uv__write_req_size(uv_write_t* req);
+static void uv__write_bufs_free(uv_write_t* req);
+
+/* Where the bytes of a uv_stream_sendfile() request come from. */
+typedef struct {
+  uv__io_t watcher;  /* Pipe sources, while they have nothing to give. */
+  uv_write_t* req;
+  int64_t offset;    /* -1 for pipes. */
+  int fd;
+  int emulate;       /* pread() and write() instead of sendfile(). */
+} uv__file_source_t;
 
 
 void uv__stream_init(uv_loop_t* loop,
@@ -712,8 +729,7 @@ static void uv__write_req_finish(uv_write_t* req) {
    * to revisit in future revisions of the libuv API.
    */
   if (req->error == 0) {
-    if (req->bufs != req->bufsml)
-      uv__free(req->bufs);
+    uv__write_bufs_free(req);
     req->bufs = NULL;
   }
 
@@ -739,10 +755,323 @@ static int uv__handle_fd(uv_handle_t* handle) {
   }
 }
 
+/* uv_write_t.bufs arrays that don't fit in bufsml come from a per-loop free
+ * list of arrays with room for UV__WRITE_POOL_NBUFS buffers when they fit in
+ * one of those, from the heap otherwise.
+ */
+#define UV__WRITE_POOL_NBUFS 64
+#define UV__WRITE_POOL_MAX 64
+
+/* Upper bound on the number of iovecs handed to a single writev(). */
+#define UV__WRITE_MAX_IOV 1024
+
+
+static uv_buf_t* uv__write_bufs_alloc(uv_loop_t* loop, unsigned int nbufs) {
+  void** bufs;
+
+  if (nbufs > UV__WRITE_POOL_NBUFS)
+    return uv__malloc(nbufs * sizeof(uv_buf_t));
+
+  bufs = loop->write_bufs_pool;
+  if (bufs == NULL)
+    return uv__malloc(UV__WRITE_POOL_NBUFS * sizeof(uv_buf_t));
+
+  loop->write_bufs_pool = *bufs;
+  loop->write_bufs_pooled--;
+  return (uv_buf_t*) bufs;
+}
+
+
+static void uv__write_bufs_free(uv_write_t* req) {
+  uv_loop_t* loop;
+  void** bufs;
+
+  if (req->bufs == req->bufsml)
+    return;
+
+  loop = req->handle->loop;
+  if (req->nbufs > UV__WRITE_POOL_NBUFS ||
+      loop->write_bufs_pooled >= UV__WRITE_POOL_MAX) {
+    uv__free(req->bufs);
+    return;
+  }
+
+  bufs = (void**) req->bufs;
+  *bufs = loop->write_bufs_pool;
+  loop->write_bufs_pool = bufs;
+  loop->write_bufs_pooled++;
+}
+
+
+void uv__write_pool_delete(uv_loop_t* loop) {
+  void** bufs;
+
+  while (loop->write_bufs_pool != NULL) {
+    bufs = loop->write_bufs_pool;
+    loop->write_bufs_pool = *bufs;
+    uv__free(bufs);
+  }
+
+  loop->write_bufs_pooled = 0;
+  uv__free(loop->write_iov);
+  loop->write_iov = NULL;
+}
+
+
+/* Gather the buffers of the requests at the head of the write queue into the
+ * loop's iovec array, so they can go out with a single writev(). Stops at
+ * the first request that passes a handle because that one has to go out on
+ * its own with sendmsg(), and at uv_stream_sendfile() requests. Returns the
+ * number of iovecs, 0 if the array can't be allocated.
+ */
+static int uv__write_gather(uv_stream_t* stream, int iovmax) {
+  struct iovec* iov;
+  uv_write_t* req;
+  unsigned int i;
+  int iovcnt;
+  QUEUE* q;
+
+  iov = stream->loop->write_iov;
+  if (iov == NULL) {
+    iov = uv__malloc(UV__WRITE_MAX_IOV * sizeof(*iov));
+    if (iov == NULL)
+      return 0;
+    stream->loop->write_iov = iov;
+  }
+
+  if (iovmax > UV__WRITE_MAX_IOV)
+    iovmax = UV__WRITE_MAX_IOV;
+
+  iovcnt = 0;
+
+  QUEUE_FOREACH(q, &stream->write_queue) {
+    req = QUEUE_DATA(q, uv_write_t, queue);
+    if (req->send_handle != NULL || req->file_source != NULL)
+      break;
+
+    for (i = req->write_index; i < req->nbufs && iovcnt < iovmax; i++) {
+      iov[iovcnt].iov_base = req->bufs[i].base;
+      iov[iovcnt].iov_len = req->bufs[i].len;
+      iovcnt++;
+    }
+
+    if (iovcnt == iovmax)
+      break;
+  }
+
+  return iovcnt;
+}
+
+
+static void uv__file_source_io(uv_loop_t* loop,
+                               uv__io_t* w,
+                               unsigned int events) {
+  uv__file_source_t* src;
+  uv_stream_t* stream;
+
+  src = container_of(w, uv__file_source_t, watcher);
+  stream = src->req->handle;
+  uv__io_stop(loop, w, UV__POLLIN);
+
+  if (uv__stream_fd(stream) == -1)
+    return;  /* Closing, the request is about to be cancelled. */
+
+  uv__write(stream);
+  uv__write_callbacks(stream);
+
+  if (QUEUE_EMPTY(&stream->write_queue))
+    uv__drain(stream);
+}
+
+
+/* Copies through one of the loop's read buffers, for sources or streams
+ * sendfile() can't deal with. Reads are positional so the part of a chunk the
+ * stream didn't take is simply read again next time.
+ */
+static ssize_t uv__file_source_emul(uv_stream_t* stream,
+                                    uv__file_source_t* src,
+                                    size_t len) {
+  ssize_t nread;
+  ssize_t n;
+  uv_buf_t buf;
+
+  uv_read_buf_alloc((uv_handle_t*) stream, len, &buf);
+  if (buf.base == NULL) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  if (len > buf.len)
+    len = buf.len;
+
+  do
+    nread = pread(src->fd, buf.base, len, src->offset);
+  while (nread == -1 && errno == EINTR);
+
+  n = nread;
+  if (nread > 0) {
+    do
+      n = write(uv__stream_fd(stream), buf.base, nread);
+    while (n == -1 && errno == EINTR);
+  }
+
+  uv_read_buf_unref(buf.base);
+
+  if (n > 0)
+    src->offset += n;
+
+  return n;
+}
+
+
+/* Moves up to `len` bytes from the request's source to the stream. Returns
+ * the number of bytes moved, 0 at the end of the source or -1 with errno set.
+ */
+static ssize_t uv__file_source_send(uv_stream_t* stream,
+                                    uv__file_source_t* src,
+                                    size_t len) {
+  ssize_t n;
+  int fd;
+
+  fd = uv__stream_fd(stream);
+
+  /* Linux moves at most 2 GB per call, and the result has to fit a ssize_t. */
+  if (len > 1024 * 1024 * 1024)
+    len = 1024 * 1024 * 1024;
+
+#if defined(__linux__)
+  if (src->offset == -1) {
+    do
+      n = splice(src->fd,
+                 NULL,
+                 fd,
+                 NULL,
+                 len,
+                 SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    while (n == -1 && errno == EINTR);
+    return n;
+  }
+
+  if (!src->emulate) {
+    off_t off;
+
+    off = src->offset;
+    do
+      n = sendfile(fd, src->fd, &off, len);
+    while (n == -1 && errno == EINTR);
+
+    if (n != -1) {
+      src->offset = off;
+      return n;
+    }
+
+    if (errno != EINVAL && errno != ENOSYS && errno != EOVERFLOW)
+      return -1;
+
+    src->emulate = 1;
+  }
+#elif defined(__FreeBSD__) || defined(__DragonFly__) || defined(__APPLE__)
+  if (!src->emulate) {
+    off_t sbytes;
+    int r;
+
+    /* Like uv_fs_sendfile(), a partial send comes back as EAGAIN or EINTR
+     * with the number of bytes that did go out.
+     */
+    do {
+# if defined(__APPLE__)
+      sbytes = len;
+      r = sendfile(src->fd, fd, src->offset, &sbytes, NULL, 0);
+# else
+      sbytes = 0;
+      r = sendfile(src->fd, fd, src->offset, len, NULL, &sbytes, 0);
+# endif
+    } while (r == -1 && errno == EINTR && sbytes == 0);
+
+    if (r == 0 || sbytes != 0) {
+      src->offset += sbytes;
+      return sbytes;
+    }
+
+    if (errno != EINVAL && errno != ENOTSOCK && errno != EOPNOTSUPP)
+      return -1;
+
+    src->emulate = 1;
+  }
+#endif
+
+  return uv__file_source_emul(stream, src, len);
+}
+
+
+/* Sends the next part of a uv_stream_sendfile() request. Returns 1 when the
+ * request is done and the requests behind it can go out, 0 when it has to
+ * wait for the stream or, for pipes, the source.
+ */
+static int uv__write_file(uv_stream_t* stream, uv_write_t* req) {
+  uv__file_source_t* src;
+  struct pollfd pfd;
+  uv_buf_t* buf;
+  ssize_t n;
+
+  src = req->file_source;
+  buf = &req->bufs[0];
+
+  for (;;) {
+    n = uv__file_source_send(stream, src, buf->len);
+    stream->loop->metrics.stream_writes++;
+
+    if (n > 0) {
+      buf->len -= n;
+      stream->write_queue_size -= n;
+
+      if (buf->len > 0)
+        continue;
+
+      req->write_index = 1;
+      uv__write_req_finish(req);
+      return 1;
+    }
+
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (stream->flags & UV_STREAM_BLOCKING)
+        continue;
+
+      /* splice() doesn't say which side would block. */
+      if (src->offset == -1) {
+        pfd.fd = uv__stream_fd(stream);
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 0) == 1 && pfd.revents == POLLOUT) {
+          uv__io_stop(stream->loop, &stream->io_watcher, UV__POLLOUT);
+          uv__io_start(stream->loop, &src->watcher, UV__POLLIN);
+          uv__stream_osx_interrupt_select(stream);
+          return 0;
+        }
+      }
+
+      uv__io_start(stream->loop, &stream->io_watcher, UV__POLLOUT);
+      uv__stream_osx_interrupt_select(stream);
+      return 0;
+    }
+
+    /* The source ending early is an error, the stream has a hole now. */
+    req->error = n == 0 ? UV_EOF : -errno;
+    uv__write_req_finish(req);
+    uv__io_stop(stream->loop, &stream->io_watcher, UV__POLLOUT);
+    if (!uv__io_active(&stream->io_watcher, UV__POLLIN))
+      uv__handle_stop(stream);
+    uv__stream_osx_interrupt_select(stream);
+    return 0;
+  }
+}
+
+
 static void uv__write(uv_stream_t* stream) {
   struct iovec* iov;
   QUEUE* q;
   uv_write_t* req;
+  uv_buf_t* buf;
   int iovmax;
   int iovcnt;
   ssize_t n;
@@ -758,6 +1087,12 @@ start:
   req = QUEUE_DATA(q, uv_write_t, queue);
   assert(req->handle == stream);
 
+  if (req->file_source != NULL) {
+    if (uv__write_file(stream, req))
+      goto start;
+    return;
+  }
+
   /*
    * Cast to iovec. We had to have our own uv_buf_t instead of iovec
    * because Windows's WSABUF is not an iovec.
@@ -772,6 +1107,20 @@ start:
   if (iovcnt > iovmax)
     iovcnt = iovmax;
 
+  /* Write out the requests queued behind this one in the same go. Many small
+   * writes per tick, the typical RPC pattern, then cost one syscall instead
+   * of one per request.
+   */
+  if (req->send_handle == NULL &&
+      iovcnt < iovmax &&
+      QUEUE_NEXT(q) != &stream->write_queue) {
+    n = uv__write_gather(stream, iovmax);
+    if (n > 0) {
+      iov = stream->loop->write_iov;
+      iovcnt = n;
+    }
+  }
+
   /*
    * Now do the actual writev. Note that we've been updating the pointers
    * inside the iov each time we write. So there is no need to offset it.
@@ -842,6 +1191,7 @@ start:
   }
 
   if (n < 0) {
+    stream->loop->metrics.stream_writes++;
     if (errno != EAGAIN && errno != EWOULDBLOCK) {
       /* Error */
       req->error = -errno;
@@ -857,52 +1207,58 @@ start:
     }
   } else {
     /* Successful write */
-
-    while (n >= 0) {
-      uv_buf_t* buf = &(req->bufs[req->write_index]);
-      size_t len = buf->len;
-
-      assert(req->write_index < req->nbufs);
-
-      if ((size_t)n < len) {
-        buf->base += n;
-        buf->len -= n;
-        stream->write_queue_size -= n;
-        n = 0;
-
-        /* There is more to write. */
-        if (stream->flags & UV_STREAM_BLOCKING) {
-          /*
-           * If we're blocking then we should not be enabling the write
-           * watcher - instead we need to try again.
-           */
-          goto start;
-        } else {
-          /* Break loop and ensure the watcher is pending. */
-          break;
+    stream->loop->metrics.stream_writes++;
+
+    for (;;) {
+      q = QUEUE_HEAD(&stream->write_queue);
+      req = QUEUE_DATA(q, uv_write_t, queue);
+
+      while (req->write_index < req->nbufs && iovcnt > 0) {
+        buf = &(req->bufs[req->write_index]);
+
+        if ((size_t)n < buf->len) {
+          buf->base += n;
+          buf->len -= n;
+          stream->write_queue_size -= n;
+          n = 0;
+
+          /* There is more to write. */
+          if (stream->flags & UV_STREAM_BLOCKING) {
+            /*
+             * If we're blocking then we should not be enabling the write
+             * watcher - instead we need to try again.
+             */
+            goto start;
+          } else {
+            /* Break loop and ensure the watcher is pending. */
+            goto more;
+          }
         }
 
-      } else {
         /* Finished writing the buf at index req->write_index. */
         req->write_index++;
+        iovcnt--;
+        n -= buf->len;
 
-        assert((size_t)n >= len);
-        n -= len;
+        assert(stream->write_queue_size >= buf->len);
+        stream->write_queue_size -= buf->len;
+      }
 
-        assert(stream->write_queue_size >= len);
-        stream->write_queue_size -= len;
+      if (req->write_index == req->nbufs)
+        uv__write_req_finish(req);
 
-        if (req->write_index == req->nbufs) {
-          /* Then we're done! */
-          assert(n == 0);
-          uv__write_req_finish(req);
-          /* TODO: start trying to write the next request. */
-          return;
-        }
-      }
+      if (iovcnt == 0)
+        break;
     }
+
+    /* Everything we handed to the kernel got written; there is probably room
+     * for what's left in the queue as well.
+     */
+    assert(n == 0);
+    goto start;
   }
 
+more:
   /* Either we've counted n down to zero or we've got EAGAIN. */
   assert(n == 0 || n == -1);
 
@@ -918,6 +1274,7 @@ start:
 
 
 static void uv__write_callbacks(uv_stream_t* stream) {
+  uv__file_source_t* src;
   uv_write_t* req;
   QUEUE* q;
 
@@ -930,11 +1287,17 @@ static void uv__write_callbacks(uv_stream_t* stream) {
 
     if (req->bufs != NULL) {
       stream->write_queue_size -= uv__write_req_size(req);
-      if (req->bufs != req->bufsml)
-        uv__free(req->bufs);
+      uv__write_bufs_free(req);
       req->bufs = NULL;
     }
 
+    if (req->file_source != NULL) {
+      src = req->file_source;
+      uv__io_close(stream->loop, &src->watcher);
+      uv__free(src);
+      req->file_source = NULL;
+    }
+
     /* NOTE: call callback AFTER freeing the request data. */
     if (req->cb)
       req->cb(req, req->error);
@@ -1087,6 +1450,8 @@ static void uv__read(uv_stream_t* stream) {
   ssize_t nread;
   struct msghdr msg;
   char cmsg_space[CMSG_SPACE(UV__CMSG_FD_SIZE)];
+  ssize_t filled;
+  int batch;
   int count;
   int err;
   int is_ipc;
@@ -1100,6 +1465,13 @@ static void uv__read(uv_stream_t* stream) {
 
   is_ipc = stream->type == UV_NAMED_PIPE && ((uv_pipe_t*) stream)->ipc;
 
+  /* In batch mode the next read goes into the unused part of the buffer and
+   * read_cb only runs once the buffer is full or the stream runs dry. Not for
+   * IPC pipes, their reads may carry file descriptors.
+   */
+  batch = !is_ipc && (stream->flags & UV_STREAM_READ_BATCH);
+  filled = 0;
+
   /* XXX: Maybe instead of having UV_STREAM_READING we just test if
    * tcp->read_cb is NULL or not?
    */
@@ -1108,11 +1480,13 @@ static void uv__read(uv_stream_t* stream) {
       && (count-- > 0)) {
     assert(stream->alloc_cb != NULL);
 
-    stream->alloc_cb((uv_handle_t*)stream, 64 * 1024, &buf);
-    if (buf.len == 0) {
-      /* User indicates it can't or won't handle the read. */
-      stream->read_cb(stream, UV_ENOBUFS, &buf);
-      return;
+    if (filled == 0) {
+      stream->alloc_cb((uv_handle_t*)stream, 64 * 1024, &buf);
+      if (buf.len == 0) {
+        /* User indicates it can't or won't handle the read. */
+        stream->read_cb(stream, UV_ENOBUFS, &buf);
+        return;
+      }
     }
 
     assert(buf.base != NULL);
@@ -1120,7 +1494,9 @@ static void uv__read(uv_stream_t* stream) {
 
     if (!is_ipc) {
       do {
-        nread = read(uv__stream_fd(stream), buf.base, buf.len);
+        nread = read(uv__stream_fd(stream),
+                     buf.base + filled,
+                     buf.len - filled);
       }
       while (nread < 0 && errno == EINTR);
     } else {
@@ -1148,10 +1524,19 @@ static void uv__read(uv_stream_t* stream) {
           uv__io_start(stream->loop, &stream->io_watcher, UV__POLLIN);
           uv__stream_osx_interrupt_select(stream);
         }
-        stream->read_cb(stream, 0, &buf);
+        stream->read_cb(stream, filled, &buf);
       } else {
+        err = -errno;
+        if (filled > 0) {
+          /* Hand out what was read so far before reporting the error. */
+          stream->read_cb(stream, filled, &buf);
+          if (!(stream->flags & UV_STREAM_READING))
+            return;
+          buf = uv_buf_init(NULL, 0);
+        }
+
         /* Error. User should call uv_close(). */
-        stream->read_cb(stream, -errno, &buf);
+        stream->read_cb(stream, err, &buf);
         if (stream->flags & UV_STREAM_READING) {
           stream->flags &= ~UV_STREAM_READING;
           uv__io_stop(stream->loop, &stream->io_watcher, UV__POLLIN);
@@ -1162,6 +1547,13 @@ static void uv__read(uv_stream_t* stream) {
       }
       return;
     } else if (nread == 0) {
+      if (filled > 0) {
+        stream->read_cb(stream, filled, &buf);
+        if (!(stream->flags & UV_STREAM_READING))
+          return;
+        buf = uv_buf_init(NULL, 0);
+      }
+
       uv__stream_eof(stream, &buf);
       return;
     } else {
@@ -1175,6 +1567,19 @@ static void uv__read(uv_stream_t* stream) {
           return;
         }
       }
+
+      if (batch) {
+        filled += nread;
+        /* A short read from a socket or pipe means it's drained, the same as
+         * below, so don't go and find out with another read(). A tty in
+         * canonical mode hands out one line per read, there may be more.
+         */
+        if (filled < buflen && stream->type == UV_TTY)
+          continue;  /* Room left, keep reading into the same buffer. */
+        nread = filled;
+        filled = 0;
+      }
+
       stream->read_cb(stream, nread, &buf);
 
       /* Return if we didn't fill the buffer, there is no more data to read. */
@@ -1184,6 +1589,10 @@ static void uv__read(uv_stream_t* stream) {
       }
     }
   }
+
+  /* Out of reads for this round, deliver what the batch has collected. */
+  if (filled > 0)
+    stream->read_cb(stream, filled, &buf);
 }
 
 
@@ -1325,12 +1734,13 @@ static void uv__stream_connect(uv_stream_t* stream) {
 }
 
 
-int uv_write2(uv_write_t* req,
-              uv_stream_t* stream,
-              const uv_buf_t bufs[],
-              unsigned int nbufs,
-              uv_stream_t* send_handle,
-              uv_write_cb cb) {
+static int uv__write_start(uv_write_t* req,
+                           uv_stream_t* stream,
+                           const uv_buf_t bufs[],
+                           unsigned int nbufs,
+                           uv_stream_t* send_handle,
+                           uv__file_source_t* file_source,
+                           uv_write_cb cb) {
   int empty_queue;
 
   assert(nbufs > 0);
@@ -1370,11 +1780,12 @@ int uv_write2(uv_write_t* req,
   req->handle = stream;
   req->error = 0;
   req->send_handle = send_handle;
+  req->file_source = file_source;
   QUEUE_INIT(&req->queue);
 
   req->bufs = req->bufsml;
   if (nbufs > ARRAY_SIZE(req->bufsml))
-    req->bufs = uv__malloc(nbufs * sizeof(bufs[0]));
+    req->bufs = uv__write_bufs_alloc(stream->loop, nbufs);
 
   if (req->bufs == NULL)
     return -ENOMEM;
@@ -1394,6 +1805,14 @@ int uv_write2(uv_write_t* req,
   if (stream->connect_req) {
     /* Still connecting, do nothing. */
   }
+  else if (empty_queue &&
+           (stream->flags & UV_STREAM_COALESCE) &&
+           !(stream->flags & UV_STREAM_BLOCKING)) {
+    /* Let the writes made during this loop iteration pile up and flush them
+     * with a single writev() from the pending phase of the next one.
+     */
+    uv__io_feed(stream->loop, &stream->io_watcher);
+  }
   else if (empty_queue) {
     uv__write(stream);
   }
@@ -1412,6 +1831,70 @@ int uv_write2(uv_write_t* req,
 }
 
 
+int uv_write2(uv_write_t* req,
+              uv_stream_t* stream,
+              const uv_buf_t bufs[],
+              unsigned int nbufs,
+              uv_stream_t* send_handle,
+              uv_write_cb cb) {
+  return uv__write_start(req, stream, bufs, nbufs, send_handle, NULL, cb);
+}
+
+
+int uv_stream_sendfile(uv_write_t* req,
+                       uv_stream_t* stream,
+                       uv_file file,
+                       int64_t offset,
+                       size_t length,
+                       uv_write_cb cb) {
+  uv__file_source_t* src;
+  struct stat st;
+  uv_buf_t buf;
+  int err;
+
+  if (length == 0)
+    return -EINVAL;
+
+  if (fstat(file, &st))
+    return -errno;
+
+  if (S_ISFIFO(st.st_mode)) {
+#if !defined(__linux__)
+    return -ENOTSUP;
+#endif
+    /* An empty pipe would have a blocking stream spin. */
+    if (offset != -1 || (stream->flags & UV_STREAM_BLOCKING))
+      return -EINVAL;
+  } else if (!S_ISREG(st.st_mode) && !S_ISBLK(st.st_mode)) {
+    return -EINVAL;
+  } else if (offset < 0) {
+    return -EINVAL;
+  }
+
+  src = uv__malloc(sizeof(*src));
+  if (src == NULL)
+    return -ENOMEM;
+
+  uv__io_init(&src->watcher, uv__file_source_io, file);
+  src->req = req;
+  src->offset = offset;
+  src->fd = file;
+  src->emulate = 0;
+
+  /* The file's bytes are queued as a single buffer without data. That keeps
+   * write_queue_size, and the backpressure it signals, as it is for writes.
+   */
+  buf.base = NULL;
+  buf.len = length;
+
+  err = uv__write_start(req, stream, &buf, 1, NULL, src, cb);
+  if (err)
+    uv__free(src);
+
+  return err;
+}
+
+
 /* The buffers to be written must remain valid until the callback is called.
  * This is not required for the uv_buf_t array.
  */
@@ -1435,6 +1918,7 @@ int uv_try_write(uv_stream_t* stream,
                  unsigned int nbufs) {
   int r;
   int has_pollout;
+  unsigned int coalesce;
   size_t written;
   size_t req_size;
   uv_write_t req;
@@ -1445,7 +1929,11 @@ int uv_try_write(uv_stream_t* stream,
 
   has_pollout = uv__io_active(&stream->io_watcher, UV__POLLOUT);
 
+  /* uv_try_write() always writes immediately, even on coalescing streams. */
+  coalesce = stream->flags & UV_STREAM_COALESCE;
+  stream->flags &= ~UV_STREAM_COALESCE;
   r = uv_write(&req, stream, bufs, nbufs, uv_try_write_cb);
+  stream->flags |= coalesce;
   if (r != 0)
     return r;
 
@@ -1461,8 +1949,8 @@ int uv_try_write(uv_stream_t* stream,
   /* Unqueue request, regardless of immediateness */
   QUEUE_REMOVE(&req.queue);
   uv__req_unregister(stream->loop, &req);
-  if (req.bufs != req.bufsml)
-    uv__free(req.bufs);
+  if (req.bufs != NULL)
+    uv__write_bufs_free(&req);
   req.bufs = NULL;
 
   /* Do not poll for writable, if we wasn't before calling this */
@@ -1607,6 +2095,26 @@ void uv__stream_close(uv_stream_t* handle) {
 }
 
 
+int uv_stream_set_write_coalescing(uv_stream_t* handle, int on) {
+  if (on)
+    handle->flags |= UV_STREAM_COALESCE;
+  else
+    handle->flags &= ~UV_STREAM_COALESCE;
+
+  return 0;
+}
+
+
+int uv_stream_set_read_batching(uv_stream_t* handle, int on) {
+  if (on)
+    handle->flags |= UV_STREAM_READ_BATCH;
+  else
+    handle->flags &= ~UV_STREAM_READ_BATCH;
+
+  return 0;
+}
+
+
 int uv_stream_set_blocking(uv_stream_t* handle, int blocking) {
   /* Don't need to check the file descriptor, uv__nonblock()
    * will fail with EBADF if it's not valid.
@@ -162,7 +162,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
   assert(timeout >= -1);
   base = loop->time;
-  count = 48; /* Benchmarks suggest this gives the best throughput. */
+  count = loop->poll_budget;
 
   for (;;) {
     if (timeout != -1) {
@@ -241,7 +241,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       if (w == NULL)
         continue;
 
-      w->cb(loop, w, pe->portev_events);
+      uv__metered_call(loop, w->cb(loop, w, pe->portev_events));
       nevents++;
 
       if (w != loop->watchers[fd])
@@ -502,6 +502,13 @@ void uv__fs_event_close(uv_fs_event_t* handle) {
 #endif /* defined(PORT_SOURCE_FILE) */
 
 
+int uv_fs_event_set_batching(uv_fs_event_t* handle,
+                             uint64_t window,
+                             uv_fs_event_batch_cb cb) {
+  return -ENOSYS;
+}
+
+
 char** uv_setup_args(int argc, char** argv) {
   return argv;
 }
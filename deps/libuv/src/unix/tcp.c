@@ -107,6 +107,29 @@ int uv__tcp_bind(uv_tcp_t* tcp,
   if (setsockopt(tcp->io_watcher.fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)))
     return -errno;
 
+  if (flags & UV_TCP_REUSEPORT) {
+    /* Only where the kernel load-balances connections across the sockets;
+     * elsewhere SO_REUSEPORT lets the last listener steal the port.
+     */
+#if defined(__linux__) && defined(SO_REUSEPORT)
+    if (setsockopt(tcp->io_watcher.fd,
+                   SOL_SOCKET,
+                   SO_REUSEPORT,
+                   &on,
+                   sizeof(on)))
+      return -errno;
+#elif defined(__FreeBSD__) && defined(SO_REUSEPORT_LB)
+    if (setsockopt(tcp->io_watcher.fd,
+                   SOL_SOCKET,
+                   SO_REUSEPORT_LB,
+                   &on,
+                   sizeof(on)))
+      return -errno;
+#else
+    return -ENOTSUP;
+#endif
+  }
+
 #ifdef IPV6_V6ONLY
   if (addr->sa_family == AF_INET6) {
     on = (flags & UV_TCP_IPV6ONLY) != 0;
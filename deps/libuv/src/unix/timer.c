@@ -25,6 +25,40 @@
 #include <assert.h>
 #include <limits.h>
 
+/* Hierarchical timing wheel, used instead of the binary heap when the loop
+ * is configured with UV_LOOP_TIMER_WHEEL.
+ *
+ * Level n of the wheel has UV__WHEEL_SIZE slots that are 8^n milliseconds
+ * wide; a timer goes into the first level that can hold its timeout, rounded
+ * up to the slot width. Starting and stopping a timer is a list operation
+ * but timers on the higher levels expire up to one slot width (about 1/8th
+ * of the timeout) late. Timers are never cascaded down to a lower level
+ * and neither are they ever run early. Timeouts beyond the top level are
+ * parked in its last slot and put back into the wheel when that expires.
+ *
+ * The timer's heap_node doubles as its slot list node and slot index.
+ */
+#define UV__WHEEL_BITS 6
+#define UV__WHEEL_SIZE (1 << UV__WHEEL_BITS)
+#define UV__WHEEL_MASK (UV__WHEEL_SIZE - 1)
+#define UV__WHEEL_CLK_SHIFT 3
+#define UV__WHEEL_CLK_MASK ((1 << UV__WHEEL_CLK_SHIFT) - 1)
+#define UV__WHEEL_DEPTH 8
+
+#define UV__WHEEL_SHIFT(n) ((n) * UV__WHEEL_CLK_SHIFT)
+#define UV__WHEEL_GRAN(n) ((uint64_t) 1 << UV__WHEEL_SHIFT(n))
+#define UV__WHEEL_START(n)                                                    \
+  ((uint64_t) UV__WHEEL_MASK << UV__WHEEL_SHIFT((n) - 1))
+
+#define uv__timer_queue(handle) ((QUEUE*) (handle)->heap_node)
+#define uv__timer_slot(handle) ((uintptr_t) (handle)->heap_node[2])
+
+struct uv__timer_wheel {
+  uint64_t clk;  /* Slots due before this time have been run. */
+  uint64_t pending[UV__WHEEL_DEPTH];  /* Bitmaps of non-empty slots. */
+  QUEUE slots[UV__WHEEL_DEPTH * UV__WHEEL_SIZE];
+};
+
 
 static int timer_less_than(const struct heap_node* ha,
                            const struct heap_node* hb) {
@@ -51,6 +85,176 @@ static int timer_less_than(const struct heap_node* ha,
 }
 
 
+static void uv__wheel_insert(struct uv__timer_wheel* wheel,
+                             uv_timer_t* handle) {
+  unsigned int level;
+  uint64_t expires;
+  uint64_t delta;
+  uintptr_t slot;
+
+  expires = handle->timeout;
+  if (expires < wheel->clk)
+    expires = wheel->clk;
+
+  delta = expires - wheel->clk;
+  if (delta >= UV__WHEEL_START(UV__WHEEL_DEPTH)) {
+    delta = UV__WHEEL_START(UV__WHEEL_DEPTH) - 1;
+    expires = wheel->clk + delta;
+  }
+
+  for (level = 0; level < UV__WHEEL_DEPTH - 1; level++)
+    if (delta < UV__WHEEL_START(level + 1))
+      break;
+
+  expires += UV__WHEEL_GRAN(level) - 1;
+  slot = (expires >> UV__WHEEL_SHIFT(level)) & UV__WHEEL_MASK;
+  wheel->pending[level] |= (uint64_t) 1 << slot;
+
+  slot += level * UV__WHEEL_SIZE;
+  handle->heap_node[2] = (void*) slot;
+  QUEUE_INSERT_TAIL(&wheel->slots[slot], uv__timer_queue(handle));
+}
+
+
+static void uv__wheel_remove(struct uv__timer_wheel* wheel,
+                             uv_timer_t* handle) {
+  uintptr_t slot;
+
+  /* The slot may have been emptied by uv__wheel_collect() already, in which
+   * case the timer is on the list of expired timers. That's fine.
+   */
+  slot = uv__timer_slot(handle);
+  QUEUE_REMOVE(uv__timer_queue(handle));
+  if (QUEUE_EMPTY(&wheel->slots[slot]))
+    wheel->pending[slot / UV__WHEEL_SIZE] &=
+        ~((uint64_t) 1 << (slot & UV__WHEEL_MASK));
+}
+
+
+static unsigned int uv__wheel_ffs(uint64_t bits) {
+  unsigned int n;
+
+  assert(bits != 0);
+
+  n = 0;
+  if ((bits & 0xFFFFFFFF) == 0) { n += 32; bits >>= 32; }
+  if ((bits & 0xFFFF) == 0) { n += 16; bits >>= 16; }
+  if ((bits & 0xFF) == 0) { n += 8; bits >>= 8; }
+  if ((bits & 0xF) == 0) { n += 4; bits >>= 4; }
+  if ((bits & 0x3) == 0) { n += 2; bits >>= 2; }
+  if ((bits & 0x1) == 0) { n += 1; }
+
+  return n;
+}
+
+
+/* Returns the time at which the first non-empty slot is due, or
+ * (uint64_t) -1 if the wheel is empty.
+ */
+static uint64_t uv__wheel_next(const struct uv__timer_wheel* wheel) {
+  unsigned int level;
+  unsigned int offset;
+  uint64_t pending;
+  uint64_t next;
+  uint64_t due;
+  uint64_t now;
+
+  next = (uint64_t) -1;
+
+  for (level = 0; level < UV__WHEEL_DEPTH; level++) {
+    pending = wheel->pending[level];
+    if (pending == 0)
+      continue;
+
+    /* Rotate the bitmap so that bit 0 is the first slot that is due at or
+     * after wheel->clk.
+     */
+    now = wheel->clk + UV__WHEEL_GRAN(level) - 1;
+    now >>= UV__WHEEL_SHIFT(level);
+    offset = now & UV__WHEEL_MASK;
+    if (offset != 0)
+      pending = (pending >> offset) | (pending << (UV__WHEEL_SIZE - offset));
+
+    due = (now + uv__wheel_ffs(pending)) << UV__WHEEL_SHIFT(level);
+    if (due < next)
+      next = due;
+  }
+
+  return next;
+}
+
+
+/* Move the timers of all slots that are due at time `now` to `expired`. A
+ * slot on level n+1 can only be due when one on level n is, and only when
+ * `now` is a multiple of its width.
+ */
+static void uv__wheel_collect(struct uv__timer_wheel* wheel,
+                              uint64_t now,
+                              QUEUE* expired) {
+  unsigned int level;
+  unsigned int slot;
+
+  for (level = 0; level < UV__WHEEL_DEPTH; level++) {
+    slot = (now >> UV__WHEEL_SHIFT(level)) & UV__WHEEL_MASK;
+
+    if (wheel->pending[level] & ((uint64_t) 1 << slot)) {
+      wheel->pending[level] &= ~((uint64_t) 1 << slot);
+      QUEUE_ADD(expired, &wheel->slots[level * UV__WHEEL_SIZE + slot]);
+      QUEUE_INIT(&wheel->slots[level * UV__WHEEL_SIZE + slot]);
+    }
+
+    if ((now >> UV__WHEEL_SHIFT(level)) & UV__WHEEL_CLK_MASK)
+      break;
+  }
+}
+
+
+int uv__timer_wheel_configure(uv_loop_t* loop, int on) {
+  struct uv__timer_wheel* wheel;
+  unsigned int i;
+
+  wheel = loop->timer_wheel;
+
+  if (on == 0) {
+    if (wheel == NULL)
+      return 0;
+
+    for (i = 0; i < UV__WHEEL_DEPTH; i++)
+      if (wheel->pending[i] != 0)
+        return -EBUSY;
+
+    uv__free(wheel);
+    loop->timer_wheel = NULL;
+    return 0;
+  }
+
+  if (wheel != NULL)
+    return 0;
+
+  if (loop->timer_heap.nelts != 0)
+    return -EBUSY;
+
+  wheel = uv__malloc(sizeof(*wheel));
+  if (wheel == NULL)
+    return -ENOMEM;
+
+  wheel->clk = loop->time;
+  for (i = 0; i < UV__WHEEL_DEPTH; i++)
+    wheel->pending[i] = 0;
+  for (i = 0; i < ARRAY_SIZE(wheel->slots); i++)
+    QUEUE_INIT(&wheel->slots[i]);
+
+  loop->timer_wheel = wheel;
+  return 0;
+}
+
+
+void uv__timer_wheel_delete(uv_loop_t* loop) {
+  uv__free(loop->timer_wheel);
+  loop->timer_wheel = NULL;
+}
+
+
 int uv_timer_init(uv_loop_t* loop, uv_timer_t* handle) {
   uv__handle_init(loop, (uv_handle_t*)handle, UV_TIMER);
   handle->timer_cb = NULL;
@@ -81,9 +285,12 @@ int uv_timer_start(uv_timer_t* handle,
   /* start_id is the second index to be compared in uv__timer_cmp() */
   handle->start_id = handle->loop->timer_counter++;
 
-  heap_insert((struct heap*) &handle->loop->timer_heap,
-              (struct heap_node*) &handle->heap_node,
-              timer_less_than);
+  if (handle->loop->timer_wheel != NULL)
+    uv__wheel_insert(handle->loop->timer_wheel, handle);
+  else
+    heap_insert((struct heap*) &handle->loop->timer_heap,
+                (struct heap_node*) &handle->heap_node,
+                timer_less_than);
   uv__handle_start(handle);
 
   return 0;
@@ -94,9 +301,12 @@ int uv_timer_stop(uv_timer_t* handle) {
   if (!uv__is_active(handle))
     return 0;
 
-  heap_remove((struct heap*) &handle->loop->timer_heap,
-              (struct heap_node*) &handle->heap_node,
-              timer_less_than);
+  if (handle->loop->timer_wheel != NULL)
+    uv__wheel_remove(handle->loop->timer_wheel, handle);
+  else
+    heap_remove((struct heap*) &handle->loop->timer_heap,
+                (struct heap_node*) &handle->heap_node,
+                timer_less_than);
   uv__handle_stop(handle);
 
   return 0;
@@ -129,17 +339,26 @@ uint64_t uv_timer_get_repeat(const uv_timer_t* handle) {
 int uv__next_timeout(const uv_loop_t* loop) {
   const struct heap_node* heap_node;
   const uv_timer_t* handle;
+  uint64_t timeout;
   uint64_t diff;
 
-  heap_node = heap_min((const struct heap*) &loop->timer_heap);
-  if (heap_node == NULL)
-    return -1; /* block indefinitely */
+  if (loop->timer_wheel != NULL) {
+    timeout = uv__wheel_next(loop->timer_wheel);
+    if (timeout == (uint64_t) -1)
+      return -1; /* block indefinitely */
+  } else {
+    heap_node = heap_min((const struct heap*) &loop->timer_heap);
+    if (heap_node == NULL)
+      return -1; /* block indefinitely */
+
+    handle = container_of(heap_node, const uv_timer_t, heap_node);
+    timeout = handle->timeout;
+  }
 
-  handle = container_of(heap_node, const uv_timer_t, heap_node);
-  if (handle->timeout <= loop->time)
+  if (timeout <= loop->time)
     return 0;
 
-  diff = handle->timeout - loop->time;
+  diff = timeout - loop->time;
   if (diff > INT_MAX)
     diff = INT_MAX;
 
@@ -147,10 +366,54 @@ int uv__next_timeout(const uv_loop_t* loop) {
 }
 
 
+static void uv__run_wheel_timers(uv_loop_t* loop) {
+  struct uv__timer_wheel* wheel;
+  uv_timer_t* handle;
+  QUEUE expired;
+  uint64_t now;
+  QUEUE* q;
+
+  wheel = loop->timer_wheel;
+
+  while ((now = uv__wheel_next(wheel)) <= loop->time) {
+    QUEUE_INIT(&expired);
+    uv__wheel_collect(wheel, now, &expired);
+    wheel->clk = now;
+
+    while (!QUEUE_EMPTY(&expired)) {
+      q = QUEUE_HEAD(&expired);
+      handle = container_of((void*) q, uv_timer_t, heap_node);
+
+      /* Parked in the top level, see above. */
+      if (handle->timeout > loop->time) {
+        QUEUE_REMOVE(q);
+        uv__wheel_insert(wheel, handle);
+        continue;
+      }
+
+      uv_timer_stop(handle);
+      uv_timer_again(handle);
+      uv__metered_call(loop, handle->timer_cb(handle));
+    }
+  }
+
+  /* Nothing is due until after loop->time, catch up so that timers started
+   * from now on are measured against the current time.
+   */
+  if (wheel->clk < loop->time)
+    wheel->clk = loop->time;
+}
+
+
 void uv__run_timers(uv_loop_t* loop) {
   struct heap_node* heap_node;
   uv_timer_t* handle;
 
+  if (loop->timer_wheel != NULL) {
+    uv__run_wheel_timers(loop);
+    return;
+  }
+
   for (;;) {
     heap_node = heap_min((struct heap*) &loop->timer_heap);
     if (heap_node == NULL)
@@ -162,7 +425,7 @@ void uv__run_timers(uv_loop_t* loop) {
 
     uv_timer_stop(handle);
     uv_timer_again(handle);
-    handle->timer_cb(handle);
+    uv__metered_call(loop, handle->timer_cb(handle));
   }
 }
 
@@ -36,6 +36,20 @@
 # define IPV6_DROP_MEMBERSHIP IPV6_LEAVE_GROUP
 #endif
 
+/* Largest datagram we can receive, and so the size of every slot of a
+ * recvmmsg() buffer.
+ */
+#define UV__UDP_DGRAM_MAXSIZE (64 * 1024)
+
+/* Most datagrams moved by a single recvmmsg() or sendmmsg() call. */
+#define UV__MMSG_MAXWIDTH 20
+
+#if defined(__linux__)
+static uv_once_t once = UV_ONCE_INIT;
+static int uv__recvmmsg_avail;
+static int uv__sendmmsg_avail;
+#endif
+
 
 static void uv__udp_run_completed(uv_udp_t* handle);
 static void uv__udp_io(uv_loop_t* loop, uv__io_t* w, unsigned int revents);
@@ -46,6 +60,29 @@ static int uv__udp_maybe_deferred_bind(uv_udp_t* handle,
                                        unsigned int flags);
 
 
+#if defined(__linux__)
+/* The syscalls exist since Linux 2.6.33 and 3.0 respectively. */
+static void uv__udp_mmsg_init(void) {
+  int ret;
+  int s;
+
+  s = uv__socket(AF_INET, SOCK_DGRAM, 0);
+  if (s < 0)
+    return;
+
+  ret = uv__sendmmsg(s, NULL, 0, 0);
+  if (ret == 0 || errno != ENOSYS)
+    uv__sendmmsg_avail = 1;
+
+  ret = uv__recvmmsg(s, NULL, 0, 0, NULL);
+  if (ret == 0 || errno != ENOSYS)
+    uv__recvmmsg_avail = 1;
+
+  uv__close(s);
+}
+#endif
+
+
 void uv__udp_close(uv_udp_t* handle) {
   uv__io_close(handle->loop, &handle->io_watcher);
   uv__handle_stop(handle);
@@ -145,11 +182,80 @@ static void uv__udp_io(uv_loop_t* loop, uv__io_t* w, unsigned int revents) {
 }
 
 
+#if defined(__linux__)
+/* Fill the slots of `buf` with one datagram each. Every datagram is passed
+ * to recv_cb with UV_UDP_MMSG_CHUNK set, the buffer as a whole follows with
+ * UV_UDP_MMSG_FREE so it can be released. Returns the number of datagrams
+ * received or -1 like recvmsg().
+ */
+static ssize_t uv__udp_recvmmsg(uv_udp_t* handle, uv_buf_t* buf) {
+  struct sockaddr_storage peers[UV__MMSG_MAXWIDTH];
+  struct iovec iov[UV__MMSG_MAXWIDTH];
+  struct uv__mmsghdr msgs[UV__MMSG_MAXWIDTH];
+  uv_udp_recv_cb recv_cb;
+  uv_buf_t chunk_buf;
+  ssize_t nread;
+  size_t chunks;
+  size_t k;
+  int flags;
+
+  chunks = buf->len / UV__UDP_DGRAM_MAXSIZE;
+  if (chunks > ARRAY_SIZE(iov))
+    chunks = ARRAY_SIZE(iov);
+
+  for (k = 0; k < chunks; k++) {
+    iov[k].iov_base = buf->base + k * UV__UDP_DGRAM_MAXSIZE;
+    iov[k].iov_len = UV__UDP_DGRAM_MAXSIZE;
+    memset(&msgs[k].msg_hdr, 0, sizeof(msgs[k].msg_hdr));
+    msgs[k].msg_hdr.msg_iov = iov + k;
+    msgs[k].msg_hdr.msg_iovlen = 1;
+    msgs[k].msg_hdr.msg_name = peers + k;
+    msgs[k].msg_hdr.msg_namelen = sizeof(peers[0]);
+  }
+
+  do
+    nread = uv__recvmmsg(handle->io_watcher.fd, msgs, chunks, 0, NULL);
+  while (nread == -1 && errno == EINTR);
+
+  if (nread == -1) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      handle->recv_cb(handle, 0, buf, NULL, 0);
+    else
+      handle->recv_cb(handle, -errno, buf, NULL, 0);
+    return -1;
+  }
+
+  /* The callback may stop or close the handle; the buffer still has to be
+   * handed back.
+   */
+  recv_cb = handle->recv_cb;
+
+  for (k = 0; k < (size_t) nread && handle->recv_cb != NULL; k++) {
+    flags = UV_UDP_MMSG_CHUNK;
+    if (msgs[k].msg_hdr.msg_flags & MSG_TRUNC)
+      flags |= UV_UDP_PARTIAL;
+
+    chunk_buf = uv_buf_init(iov[k].iov_base, iov[k].iov_len);
+    handle->recv_cb(handle,
+                    msgs[k].msg_len,
+                    &chunk_buf,
+                    msgs[k].msg_hdr.msg_namelen == 0 ?
+                        NULL : (const struct sockaddr*) (peers + k),
+                    flags);
+  }
+
+  recv_cb(handle, 0, buf, NULL, UV_UDP_MMSG_FREE);
+  return nread;
+}
+#endif
+
+
 static void uv__udp_recvmsg(uv_udp_t* handle) {
   struct sockaddr_storage peer;
   struct msghdr h;
   ssize_t nread;
   uv_buf_t buf;
+  size_t size;
   int flags;
   int count;
 
@@ -161,17 +267,33 @@ static void uv__udp_recvmsg(uv_udp_t* handle) {
    */
   count = 32;
 
+  size = UV__UDP_DGRAM_MAXSIZE;
+#if defined(__linux__)
+  if (handle->flags & UV_UDP_RECVMMSG_MODE)
+    size = UV__MMSG_MAXWIDTH * UV__UDP_DGRAM_MAXSIZE;
+#endif
+
   memset(&h, 0, sizeof(h));
   h.msg_name = &peer;
 
   do {
-    handle->alloc_cb((uv_handle_t*) handle, 64 * 1024, &buf);
+    handle->alloc_cb((uv_handle_t*) handle, size, &buf);
     if (buf.len == 0) {
       handle->recv_cb(handle, UV_ENOBUFS, &buf, NULL, 0);
       return;
     }
     assert(buf.base != NULL);
 
+#if defined(__linux__)
+    if ((handle->flags & UV_UDP_RECVMMSG_MODE) &&
+        buf.len >= 2 * UV__UDP_DGRAM_MAXSIZE) {
+      nread = uv__udp_recvmmsg(handle, &buf);
+      if (nread > 0)
+        count -= nread - 1;
+      continue;
+    }
+#endif
+
     h.msg_namelen = sizeof(peer);
     h.msg_iov = (void*) &buf;
     h.msg_iovlen = 1;
@@ -209,12 +331,85 @@ static void uv__udp_recvmsg(uv_udp_t* handle) {
 }
 
 
+#if defined(__linux__)
+/* Send the requests at the head of the write queue with sendmmsg(), up to
+ * UV__MMSG_MAXWIDTH at a time. Stops when fewer than two requests are left
+ * or sendmmsg() fails; uv__udp_sendmsg() takes it from there. Returns
+ * -EAGAIN when the socket buffer is full, 0 otherwise.
+ */
+static int uv__udp_sendmmsg(uv_udp_t* handle) {
+  struct uv__mmsghdr msgs[UV__MMSG_MAXWIDTH];
+  struct msghdr* h;
+  uv_udp_send_t* req;
+  QUEUE* q;
+  size_t pkts;
+  size_t i;
+  int npkts;
+
+  for (;;) {
+    pkts = 0;
+    QUEUE_FOREACH(q, &handle->write_queue) {
+      if (pkts == ARRAY_SIZE(msgs))
+        break;
+
+      req = QUEUE_DATA(q, uv_udp_send_t, queue);
+      h = &msgs[pkts++].msg_hdr;
+      memset(h, 0, sizeof(*h));
+      h->msg_name = &req->addr;
+      h->msg_namelen = (req->addr.ss_family == AF_INET6 ?
+        sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in));
+      h->msg_iov = (struct iovec*) req->bufs;
+      h->msg_iovlen = req->nbufs;
+    }
+
+    if (pkts < 2)
+      return 0;
+
+    do
+      npkts = uv__sendmmsg(handle->io_watcher.fd, msgs, pkts, 0);
+    while (npkts == -1 && errno == EINTR);
+
+    if (npkts == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return -EAGAIN;
+
+      /* sendmmsg() only fails when the first message fails, let
+       * uv__udp_sendmsg() report the error for it.
+       */
+      return 0;
+    }
+
+    /* Datagrams go out whole or not at all, see uv__udp_sendmsg(). */
+    for (i = 0; i < (size_t) npkts; i++) {
+      q = QUEUE_HEAD(&handle->write_queue);
+      req = QUEUE_DATA(q, uv_udp_send_t, queue);
+      req->status = msgs[i].msg_len;
+      QUEUE_REMOVE(&req->queue);
+      QUEUE_INSERT_TAIL(&handle->write_completed_queue, &req->queue);
+    }
+
+    uv__io_feed(handle->loop, &handle->io_watcher);
+
+    if ((size_t) npkts < pkts)
+      return 0;  /* Let sendmsg() find out why the rest didn't go out. */
+  }
+}
+#endif
+
+
 static void uv__udp_sendmsg(uv_udp_t* handle) {
   uv_udp_send_t* req;
   QUEUE* q;
   struct msghdr h;
   ssize_t size;
 
+#if defined(__linux__)
+  if (uv__sendmmsg_avail && uv__udp_sendmmsg(handle) == -EAGAIN) {
+    uv__io_start(handle->loop, &handle->io_watcher, UV__POLLOUT);
+    return;
+  }
+#endif
+
   while (!QUEUE_EMPTY(&handle->write_queue)) {
     q = QUEUE_HEAD(&handle->write_queue);
     assert(q != NULL);
@@ -233,8 +428,13 @@ static void uv__udp_sendmsg(uv_udp_t* handle) {
       size = sendmsg(handle->io_watcher.fd, &h, 0);
     } while (size == -1 && errno == EINTR);
 
-    if (size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    if (size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      /* Not necessarily watching for writability yet when called from
+       * uv__udp_send() or the pending queue.
+       */
+      uv__io_start(handle->loop, &handle->io_watcher, UV__POLLOUT);
       break;
+    }
 
     req->status = (size == -1 ? -errno : size);
 
@@ -419,7 +619,12 @@ int uv__udp_send(uv_udp_send_t* req,
   QUEUE_INSERT_TAIL(&handle->write_queue, &req->queue);
   uv__handle_start(handle);
 
-  if (empty_queue && !(handle->flags & UV_UDP_PROCESSING)) {
+  if (empty_queue && (handle->flags & UV_UDP_SENDMMSG_MODE)) {
+    /* Let the sends made during this loop iteration pile up and flush them
+     * with sendmmsg() from the pending phase of the next one.
+     */
+    uv__io_feed(handle->loop, &handle->io_watcher);
+  } else if (empty_queue && !(handle->flags & UV_UDP_PROCESSING)) {
     uv__udp_sendmsg(handle);
   } else {
     uv__io_start(handle->loop, &handle->io_watcher, UV__POLLOUT);
@@ -565,7 +770,7 @@ int uv_udp_init_ex(uv_loop_t* loop, uv_udp_t* handle, unsigned int flags) {
   if (domain != AF_INET && domain != AF_INET6 && domain != AF_UNSPEC)
     return -EINVAL;
 
-  if (flags & ~0xFF)
+  if (flags & ~(0xFF | UV_UDP_RECVMMSG | UV_UDP_SENDMMSG))
     return -EINVAL;
 
   if (domain != AF_UNSPEC) {
@@ -578,6 +783,15 @@ int uv_udp_init_ex(uv_loop_t* loop, uv_udp_t* handle, unsigned int flags) {
   }
 
   uv__handle_init(loop, (uv_handle_t*)handle, UV_UDP);
+
+#if defined(__linux__)
+  uv_once(&once, uv__udp_mmsg_init);
+  if ((flags & UV_UDP_RECVMMSG) && uv__recvmmsg_avail)
+    handle->flags |= UV_UDP_RECVMMSG_MODE;
+  if ((flags & UV_UDP_SENDMMSG) && uv__sendmmsg_avail)
+    handle->flags |= UV_UDP_SENDMMSG_MODE;
+#endif
+
   handle->alloc_cb = NULL;
   handle->recv_cb = NULL;
   handle->send_queue_size = 0;
@@ -137,6 +137,323 @@ uv_buf_t uv_buf_init(char* base, unsigned int len) {
 }
 
 
+/* Chunks handed out by uv_read_buf_alloc() start with this header, the data
+ * follows it. Chunks whose last reference is dropped go back to the free list
+ * of their pool, which keeps at most UV__READ_BUF_POOL_MAX entries.
+ *
+ * Chunks point to the pool, not to the loop. uv_loop_close() detaches the
+ * pool from the loop, chunks that are still out are freed when they are
+ * released and the last one takes the pool with it.
+ */
+typedef struct uv__read_buf_pool_s uv__read_buf_pool_t;
+
+typedef union uv__read_buf_u {
+  struct {
+    uv__read_buf_pool_t* pool;
+    union uv__read_buf_u* next;
+    unsigned int size;
+    unsigned int refs;
+  } s;
+  double align[4];
+} uv__read_buf_t;
+
+struct uv__read_buf_pool_s {
+  uv__read_buf_t* free;
+  unsigned int nfree;
+  unsigned int nout;    /* Chunks handed out and not released yet. */
+  unsigned int size;    /* Chunks of other sizes are not taken back. */
+  int closed;           /* The loop is gone. */
+};
+
+#define UV__READ_BUF_POOL_MAX 16
+
+
+void uv_read_buf_alloc(uv_handle_t* handle,
+                       size_t suggested_size,
+                       uv_buf_t* buf) {
+  uv__read_buf_pool_t* pool;
+  uv_loop_t* loop;
+  uv__read_buf_t* rb;
+
+  loop = handle->loop;
+  pool = loop->read_buf_pool;
+
+  if (pool == NULL) {
+    pool = uv__malloc(sizeof(*pool));
+    if (pool == NULL) {
+      *buf = uv_buf_init(NULL, 0);
+      return;
+    }
+
+    pool->free = NULL;
+    pool->nfree = 0;
+    pool->nout = 0;
+    pool->size = loop->read_buf_size;
+    pool->closed = 0;
+    loop->read_buf_pool = pool;
+  }
+
+  rb = pool->free;
+  if (rb != NULL) {
+    pool->free = rb->s.next;
+    pool->nfree--;
+  } else {
+    rb = uv__malloc(sizeof(*rb) + pool->size);
+    if (rb == NULL) {
+      *buf = uv_buf_init(NULL, 0);
+      return;
+    }
+
+    rb->s.pool = pool;
+    rb->s.size = pool->size;
+    loop->metrics.read_buf_allocs++;
+  }
+
+  pool->nout++;
+  rb->s.refs = 1;
+  *buf = uv_buf_init((char*) (rb + 1), rb->s.size);
+}
+
+
+void uv_read_buf_ref(char* base) {
+  uv__read_buf_t* rb;
+
+  if (base == NULL)
+    return;
+
+  rb = (uv__read_buf_t*) base - 1;
+  assert(rb->s.refs > 0);
+  rb->s.refs++;
+}
+
+
+void uv_read_buf_unref(char* base) {
+  uv__read_buf_pool_t* pool;
+  uv__read_buf_t* rb;
+
+  if (base == NULL)
+    return;
+
+  rb = (uv__read_buf_t*) base - 1;
+  assert(rb->s.refs > 0);
+  if (--rb->s.refs > 0)
+    return;
+
+  pool = rb->s.pool;
+  assert(pool->nout > 0);
+  pool->nout--;
+
+  if (pool->closed) {
+    uv__free(rb);
+    if (pool->nout == 0)
+      uv__free(pool);
+    return;
+  }
+
+  if (rb->s.size != pool->size || pool->nfree >= UV__READ_BUF_POOL_MAX) {
+    uv__free(rb);
+    return;
+  }
+
+  rb->s.next = pool->free;
+  pool->free = rb;
+  pool->nfree++;
+}
+
+
+static void uv__read_buf_pool_drain(uv__read_buf_pool_t* pool) {
+  uv__read_buf_t* rb;
+
+  while (pool->free != NULL) {
+    rb = pool->free;
+    pool->free = rb->s.next;
+    uv__free(rb);
+  }
+
+  pool->nfree = 0;
+}
+
+
+static void uv__read_buf_pool_close(uv_loop_t* loop) {
+  uv__read_buf_pool_t* pool;
+
+  pool = loop->read_buf_pool;
+  if (pool == NULL)
+    return;
+
+  loop->read_buf_pool = NULL;
+  uv__read_buf_pool_drain(pool);
+
+  if (pool->nout == 0)
+    uv__free(pool);
+  else
+    pool->closed = 1;
+}
+
+
+/* Handles from uv_tcp_alloc() and reqs from uv_write_req_alloc() start with
+ * this header. Recycled ones go back to the free list of their pool, which
+ * keeps at most UV__POOL_MAX entries, the rest is returned to the allocator.
+ *
+ * Like read buffer chunks they point to the pool, not to the loop, so that
+ * a req that is freed after uv_loop_close() doesn't touch the loop.
+ */
+typedef struct uv__pool_s uv__pool_t;
+
+typedef union uv__pooled_u {
+  struct {
+    uv__pool_t* pool;
+    union uv__pooled_u* next;
+  } s;
+  double align[2];
+} uv__pooled_t;
+
+struct uv__pool_s {
+  uv__pooled_t* free;
+  unsigned int nfree;
+  unsigned int nout;    /* Entries handed out and not put back yet. */
+  int closed;           /* The loop is gone. */
+};
+
+#define UV__POOL_MAX 256
+
+
+static void* uv__pool_get(uv_loop_t* loop, void** poolp, size_t size) {
+  uv__pool_t* pool;
+  uv__pooled_t* p;
+
+  pool = *poolp;
+
+  if (pool == NULL) {
+    pool = uv__malloc(sizeof(*pool));
+    if (pool == NULL)
+      return NULL;
+
+    pool->free = NULL;
+    pool->nfree = 0;
+    pool->nout = 0;
+    pool->closed = 0;
+    *poolp = pool;
+  }
+
+  p = pool->free;
+
+  if (p != NULL) {
+    pool->free = p->s.next;
+    pool->nfree--;
+  } else {
+    p = uv__malloc(sizeof(*p) + size);
+    if (p == NULL)
+      return NULL;
+
+    p->s.pool = pool;
+    loop->metrics.pool_allocs++;
+  }
+
+  pool->nout++;
+  p->s.next = NULL;
+  return p + 1;
+}
+
+
+static void uv__pool_put(void* ptr) {
+  uv__pool_t* pool;
+  uv__pooled_t* p;
+
+  p = (uv__pooled_t*) ptr - 1;
+  pool = p->s.pool;
+  assert(pool->nout > 0);
+  pool->nout--;
+
+  if (pool->closed) {
+    uv__free(p);
+    if (pool->nout == 0)
+      uv__free(pool);
+    return;
+  }
+
+  if (pool->nfree >= UV__POOL_MAX) {
+    uv__free(p);
+    return;
+  }
+
+  p->s.next = pool->free;
+  pool->free = p;
+  pool->nfree++;
+}
+
+
+static void uv__pool_close(void** poolp) {
+  uv__pool_t* pool;
+  uv__pooled_t* p;
+
+  pool = *poolp;
+  if (pool == NULL)
+    return;
+
+  *poolp = NULL;
+
+  while (pool->free != NULL) {
+    p = pool->free;
+    pool->free = p->s.next;
+    uv__free(p);
+  }
+
+  pool->nfree = 0;
+
+  if (pool->nout == 0)
+    uv__free(pool);
+  else
+    pool->closed = 1;
+}
+
+
+uv_tcp_t* uv_tcp_alloc(uv_loop_t* loop) {
+  uv_tcp_t* handle;
+
+  handle = uv__pool_get(loop, &loop->tcp_pool, sizeof(*handle));
+  if (handle == NULL)
+    return NULL;
+
+  if (uv_tcp_init(loop, handle)) {
+    uv__pool_put(handle);
+    return NULL;
+  }
+
+  /* Goes back to the pool after the close callback, see uv__finish_close()
+   * and uv__handle_close().
+   */
+  handle->flags |= UV__HANDLE_POOLED;
+  return handle;
+}
+
+
+void uv__handle_recycle(uv_handle_t* handle) {
+  switch (handle->type) {
+    case UV_TCP:
+      uv__pool_put(handle);
+      break;
+
+    default:
+      assert(0);
+      break;
+  }
+}
+
+
+uv_write_t* uv_write_req_alloc(uv_loop_t* loop) {
+  return uv__pool_get(loop, &loop->write_pool, sizeof(uv_write_t));
+}
+
+
+void uv_write_req_free(uv_write_t* req) {
+  if (req == NULL)
+    return;
+
+  uv__pool_put(req);
+}
+
+
 static const char* uv__unknown_err_code(int err) {
   char buf[32];
   char* copy;
@@ -543,12 +860,42 @@ int uv_fs_scandir_next(uv_fs_t* req, uv_dirent_t* ent) {
 
 
 int uv_loop_configure(uv_loop_t* loop, uv_loop_option option, ...) {
+  uv__read_buf_pool_t* pool;
   va_list ap;
+  unsigned int size;
+  int kind;
   int err;
 
   va_start(ap, option);
   /* Any platform-agnostic options should be handled here. */
-  err = uv__loop_configure(loop, option, ap);
+  if (option == UV_LOOP_THREADPOOL_SIZE) {
+    err = uv__threadpool_configure(loop, va_arg(ap, unsigned int));
+  } else if (option == UV_LOOP_THREADPOOL_LIMIT) {
+    kind = va_arg(ap, int);
+    err = uv__threadpool_limit(loop, kind, va_arg(ap, unsigned int));
+  } else if (option == UV_LOOP_FS_WORK_KIND) {
+    kind = va_arg(ap, int);
+    err = UV_EINVAL;
+    if (kind >= 0 && kind < UV_WORK_KIND_MAX) {
+      loop->fs_work_kind = kind;
+      err = 0;
+    }
+  } else if (option == UV_LOOP_READ_BUF_SIZE) {
+    size = va_arg(ap, unsigned int);
+    err = UV_EINVAL;
+    if (size > 0) {
+      /* Chunks of the old size are freed as they are released. */
+      pool = loop->read_buf_pool;
+      if (pool != NULL) {
+        uv__read_buf_pool_drain(pool);
+        pool->size = size;
+      }
+      loop->read_buf_size = size;
+      err = 0;
+    }
+  } else {
+    err = uv__loop_configure(loop, option, ap);
+  }
   va_end(ap);
 
   return err;
@@ -600,6 +947,10 @@ int uv_loop_close(uv_loop_t* loop) {
       return UV_EBUSY;
   }
 
+  uv__threadpool_close(loop);
+  uv__read_buf_pool_close(loop);
+  uv__pool_close(&loop->tcp_pool);
+  uv__pool_close(&loop->write_pool);
   uv__loop_close(loop);
 
 #ifndef NDEBUG
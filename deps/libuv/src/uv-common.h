@@ -54,12 +54,14 @@ enum {
   UV__HANDLE_INTERNAL = 0x8000,
   UV__HANDLE_ACTIVE   = 0x4000,
   UV__HANDLE_REF      = 0x2000,
+  UV__HANDLE_POOLED   = 0x400000,
   UV__HANDLE_CLOSING  = 0 /* no-op on unix */
 };
 #else
 # define UV__HANDLE_INTERNAL  0x80
 # define UV__HANDLE_ACTIVE    0x40
 # define UV__HANDLE_REF       0x20
+# define UV__HANDLE_POOLED    0x04
 # define UV__HANDLE_CLOSING   0x01
 #endif
 
@@ -67,6 +69,8 @@ int uv__loop_configure(uv_loop_t* loop, uv_loop_option option, va_list ap);
 
 void uv__loop_close(uv_loop_t* loop);
 
+void uv__handle_recycle(uv_handle_t* handle);
+
 int uv__tcp_bind(uv_tcp_t* tcp,
                  const struct sockaddr* addr,
                  unsigned int addrlen,
@@ -108,11 +112,22 @@ int uv__getaddrinfo_translate_error(int sys_err);    /* EAI_* error. */
 
 void uv__work_submit(uv_loop_t* loop,
                      struct uv__work *w,
+                     uv_work_kind kind,
                      void (*work)(struct uv__work *w),
                      void (*done)(struct uv__work *w, int status));
 
+void uv__work_complete(uv_loop_t* loop,
+                       struct uv__work* w,
+                       void (*done)(struct uv__work* w, int status));
+
 void uv__work_done(uv_async_t* handle);
 
+int uv__threadpool_configure(uv_loop_t* loop, unsigned int nthreads);
+
+int uv__threadpool_limit(uv_loop_t* loop, int kind, unsigned int limit);
+
+void uv__threadpool_close(uv_loop_t* loop);
+
 size_t uv__count_bufs(const uv_buf_t bufs[], unsigned int nbufs);
 
 int uv__socket_sockopt(uv_handle_t* handle, int optname, int* value);
@@ -43,6 +43,8 @@ int uv_async_init(uv_loop_t* loop, uv_async_t* handle, uv_async_cb async_cb) {
   uv__handle_init(loop, (uv_handle_t*) handle, UV_ASYNC);
   handle->async_sent = 0;
   handle->async_cb = async_cb;
+  handle->msg_cb = NULL;
+  handle->msgs = NULL;
 
   req = &handle->async_req;
   uv_req_init(loop, req);
@@ -55,6 +57,18 @@ int uv_async_init(uv_loop_t* loop, uv_async_t* handle, uv_async_cb async_cb) {
 }
 
 
+int uv_async_init_msg(uv_loop_t* loop,
+                      uv_async_t* handle,
+                      uv_async_msg_cb msg_cb) {
+  if (msg_cb == NULL)
+    return UV_EINVAL;
+
+  uv_async_init(loop, handle, NULL);
+  handle->msg_cb = msg_cb;
+  return 0;
+}
+
+
 void uv_async_close(uv_loop_t* loop, uv_async_t* handle) {
   if (!((uv_async_t*)handle)->async_sent) {
     uv_want_endgame(loop, (uv_handle_t*) handle);
@@ -76,6 +90,10 @@ int uv_async_send(uv_async_t* handle) {
   /* or closed handle. */
   assert(!(handle->flags & UV__HANDLE_CLOSING));
 
+  /* Message handles are signalled by uv_async_send_msg() only. */
+  if (handle->msg_cb != NULL)
+    return UV_EINVAL;
+
   if (!uv__atomic_exchange_set(&handle->async_sent)) {
     POST_COMPLETION_FOR_REQ(loop, &handle->async_req);
   }
@@ -84,15 +102,66 @@ int uv_async_send(uv_async_t* handle) {
 }
 
 
+int uv_async_send_msg(uv_async_t* handle, uv_async_msg_t* msg) {
+  void* head;
+
+  if (handle->msg_cb == NULL)
+    return UV_EINVAL;
+
+  do {
+    head = handle->msgs;
+    msg->next_msg = head;
+  } while (InterlockedCompareExchangePointer(&handle->msgs, msg, head) !=
+           head);
+
+  /* Only the sender that finds the stack empty posts the wakeup. Until the
+   * loop has taken the messages, nobody else touches the handle after
+   * pushing. That's what makes it safe to close the handle from the
+   * callback that receives the last message.
+   */
+  if (head == NULL && !uv__atomic_exchange_set(&handle->async_sent))
+    POST_COMPLETION_FOR_REQ(handle->loop, &handle->async_req);
+
+  return 0;
+}
+
+
+static void uv__async_deliver(uv_async_t* handle) {
+  uv_async_msg_t* next;
+  uv_async_msg_t* msg;
+  void* head;
+
+  /* The messages were pushed onto a stack, restore the order of arrival. */
+  head = InterlockedExchangePointer(&handle->msgs, NULL);
+  msg = NULL;
+  while (head != NULL) {
+    next = head;
+    head = next->next_msg;
+    next->next_msg = msg;
+    msg = next;
+  }
+
+  /* What's left when a callback closes the handle is dropped. */
+  while (msg != NULL && !(handle->flags & UV__HANDLE_CLOSING)) {
+    next = msg->next_msg;
+    handle->msg_cb(handle, msg);
+    msg = next;
+  }
+}
+
+
 void uv_process_async_wakeup_req(uv_loop_t* loop, uv_async_t* handle,
     uv_req_t* req) {
   assert(handle->type == UV_ASYNC);
   assert(req->type == UV_WAKEUP);
 
+  /* Must happen before the messages are taken, see uv_async_send_msg(). */
   handle->async_sent = 0;
 
   if (handle->flags & UV__HANDLE_CLOSING) {
     uv_want_endgame(loop, (uv_handle_t*)handle);
+  } else if (handle->msg_cb != NULL) {
+    uv__async_deliver(handle);
   } else if (handle->async_cb != NULL) {
     handle->async_cb(handle);
   }
@@ -143,6 +143,7 @@ int uv_loop_init(uv_loop_t* loop) {
   QUEUE_INIT(&loop->wq);
   QUEUE_INIT(&loop->handle_queue);
   QUEUE_INIT(&loop->active_reqs);
+  QUEUE_INIT(&loop->fs_poll_groups);
   loop->active_handles = 0;
 
   loop->pending_reqs_tail = NULL;
@@ -167,6 +168,16 @@ int uv_loop_init(uv_loop_t* loop) {
   loop->timer_counter = 0;
   loop->stop_flag = 0;
 
+  loop->wq_pool = NULL;
+  loop->wq_done = NULL;
+  loop->wq_next = 0;
+  loop->fs_work_kind = UV_WORK_FAST_IO;
+  memset(&loop->metrics, 0, sizeof(loop->metrics));
+  loop->read_buf_pool = NULL;
+  loop->read_buf_size = 64 * 1024;
+  loop->tcp_pool = NULL;
+  loop->write_pool = NULL;
+
   err = uv_mutex_init(&loop->wq_mutex);
   if (err)
     goto fail_mutex_init;
@@ -226,6 +237,15 @@ int uv__loop_configure(uv_loop_t* loop, uv_loop_option option, va_list ap) {
 }
 
 
+int uv_loop_metrics(const uv_loop_t* loop, uv_loop_metrics_t* metrics) {
+  if (loop == NULL || metrics == NULL)
+    return UV_EINVAL;
+
+  *metrics = loop->metrics;
+  return 0;
+}
+
+
 int uv_backend_fd(const uv_loop_t* loop) {
   return -1;
 }
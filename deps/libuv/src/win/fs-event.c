@@ -337,6 +337,13 @@ int uv_fs_event_stop(uv_fs_event_t* handle) {
 }
 
 
+int uv_fs_event_set_batching(uv_fs_event_t* handle,
+                             uint64_t window,
+                             uv_fs_event_batch_cb cb) {
+  return UV_ENOSYS;
+}
+
+
 void uv_process_fs_event_req(uv_loop_t* loop, uv_req_t* req,
     uv_fs_event_t* handle) {
   FILE_NOTIFY_INFORMATION* file_info;
@@ -46,7 +46,11 @@
 #define QUEUE_FS_TP_JOB(loop, req)                                          \
   do {                                                                      \
     uv__req_register(loop, req);                                            \
-    uv__work_submit((loop), &(req)->work_req, uv__fs_work, uv__fs_done);    \
+    uv__work_submit((loop),                                                 \
+                    &(req)->work_req,                                       \
+                    (loop)->fs_work_kind,                                   \
+                    uv__fs_work,                                            \
+                    uv__fs_done);                                           \
   } while (0)
 
 #define SET_REQ_RESULT(req, result_value)                                   \
@@ -2002,6 +2006,22 @@ int uv_fs_scandir(uv_loop_t* loop, uv_fs_t* req, const char* path, int flags,
 }
 
 
+int uv_fs_walk(uv_loop_t* loop, uv_fs_t* req, const char* path, int flags,
+    uv_fs_cb cb) {
+  return UV_ENOSYS;
+}
+
+
+int uv_fs_walk_continue(uv_loop_t* loop, uv_fs_t* req, uv_fs_cb cb) {
+  return UV_ENOSYS;
+}
+
+
+int uv_fs_walk_next(uv_fs_t* req, uv_fs_walk_entry_t* ent) {
+  return UV_EOF;
+}
+
+
 int uv_fs_link(uv_loop_t* loop, uv_fs_t* req, const char* path,
     const char* new_path, uv_fs_cb cb) {
   int err;
@@ -80,8 +80,13 @@
                                                                         \
     (handle)->flags |= UV_HANDLE_CLOSED;                                \
                                                                         \
-    if ((handle)->close_cb)                                             \
+    if ((handle)->flags & UV__HANDLE_POOLED) {                          \
+      if ((handle)->close_cb)                                           \
+        (handle)->close_cb((uv_handle_t*) (handle));                    \
+      uv__handle_recycle((uv_handle_t*) (handle));                      \
+    } else if ((handle)->close_cb) {                                    \
       (handle)->close_cb((uv_handle_t*) (handle));                      \
+    }                                                                   \
   } while (0)
 
 
@@ -67,6 +67,7 @@ extern UV_THREAD_LOCAL int uv__crt_assert_enabled;
 #define UV_HANDLE_ENDGAME_QUEUED                0x00000008
 
 /* uv-common.h: #define UV__HANDLE_CLOSING      0x00000001 */
+/* uv-common.h: #define UV__HANDLE_POOLED       0x00000004 */
 /* uv-common.h: #define UV__HANDLE_ACTIVE       0x00000040 */
 /* uv-common.h: #define UV__HANDLE_REF          0x00000020 */
 /* uv-common.h: #define UV_HANDLE_INTERNAL      0x00000080 */
@@ -181,6 +181,16 @@ int uv_write2(uv_write_t* req,
 }
 
 
+int uv_stream_sendfile(uv_write_t* req,
+                       uv_stream_t* handle,
+                       uv_file file,
+                       int64_t offset,
+                       size_t length,
+                       uv_write_cb cb) {
+  return UV_ENOSYS;
+}
+
+
 int uv_try_write(uv_stream_t* stream,
                  const uv_buf_t bufs[],
                  unsigned int nbufs) {
@@ -236,6 +246,16 @@ int uv_is_writable(const uv_stream_t* handle) {
 }
 
 
+int uv_stream_set_write_coalescing(uv_stream_t* handle, int on) {
+  return UV_ENOSYS;
+}
+
+
+int uv_stream_set_read_batching(uv_stream_t* handle, int on) {
+  return UV_ENOSYS;
+}
+
+
 int uv_stream_set_blocking(uv_stream_t* handle, int blocking) {
   if (handle->type != UV_NAMED_PIPE)
     return UV_EINVAL;
@@ -192,6 +192,49 @@ int uv_thread_equal(const uv_thread_t* t1, const uv_thread_t* t2) {
 }
 
 
+int uv_cpumask_size(void) {
+  return (int) (sizeof(DWORD_PTR) * 8);
+}
+
+
+int uv_thread_setaffinity(uv_thread_t* tid,
+                          char* cpumask,
+                          char* oldmask,
+                          size_t mask_size) {
+  DWORD_PTR threadmask;
+  DWORD_PTR procmask;
+  DWORD_PTR sysmask;
+  int cpumasksize;
+  int i;
+
+  cpumasksize = uv_cpumask_size();
+  if (mask_size < (size_t) cpumasksize)
+    return UV_EINVAL;
+
+  if (!GetProcessAffinityMask(GetCurrentProcess(), &procmask, &sysmask))
+    return uv_translate_sys_error(GetLastError());
+
+  threadmask = 0;
+  for (i = 0; i < cpumasksize; i++) {
+    if (cpumask[i]) {
+      if (!(procmask & ((DWORD_PTR) 1 << i)))
+        return UV_EINVAL;
+      threadmask |= (DWORD_PTR) 1 << i;
+    }
+  }
+
+  threadmask = SetThreadAffinityMask(*tid, threadmask);
+  if (threadmask == 0)
+    return uv_translate_sys_error(GetLastError());
+
+  if (oldmask != NULL)
+    for (i = 0; i < cpumasksize; i++)
+      oldmask[i] = (threadmask >> i) & 1;
+
+  return 0;
+}
+
+
 int uv_mutex_init(uv_mutex_t* mutex) {
   InitializeCriticalSection(mutex);
   return 0;
@@ -0,0 +1,171 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "task.h"
+#include "uv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_MSGS  (1000 * 1000)
+
+struct msg {
+  uv_async_msg_t base;
+  struct msg* next;
+};
+
+static uv_async_t handle;
+static uv_mutex_t mutex;
+static struct msg* head;
+static struct msg** tail;
+static unsigned int received;
+static unsigned int expected;
+
+
+static void received_one(void) {
+  if (++received == expected)
+    uv_stop(handle.loop);
+}
+
+
+static void msg_cb(uv_async_t* handle, uv_async_msg_t* msg) {
+  received_one();
+}
+
+
+static void mutex_cb(uv_async_t* handle) {
+  struct msg* msg;
+
+  uv_mutex_lock(&mutex);
+  msg = head;
+  head = NULL;
+  tail = &head;
+  uv_mutex_unlock(&mutex);
+
+  for (; msg != NULL; msg = msg->next)
+    received_one();
+}
+
+
+static void msg_sender(void* arg) {
+  struct msg* msgs;
+  unsigned int i;
+
+  msgs = arg;
+  for (i = 0; i < NUM_MSGS; i++)
+    uv_async_send_msg(&handle, &msgs[i].base);
+}
+
+
+/* What the message API replaces: a mutex-protected queue next to a plain
+ * async handle. The loop can see the last message before its sender gets
+ * to uv_async_send(), so the handle is closed after the senders are joined.
+ */
+static void mutex_sender(void* arg) {
+  struct msg* msgs;
+  unsigned int i;
+
+  msgs = arg;
+  for (i = 0; i < NUM_MSGS; i++) {
+    msgs[i].next = NULL;
+    uv_mutex_lock(&mutex);
+    *tail = &msgs[i];
+    tail = &msgs[i].next;
+    uv_mutex_unlock(&mutex);
+    uv_async_send(&handle);
+  }
+}
+
+
+static int test_async_msg(int nthreads, int use_mutex) {
+  uv_thread_t* tids;
+  struct msg* msgs;
+  uint64_t time;
+  int i;
+
+  tids = calloc(nthreads, sizeof(tids[0]));
+  msgs = calloc(nthreads * NUM_MSGS, sizeof(msgs[0]));
+  ASSERT(tids != NULL);
+  ASSERT(msgs != NULL);
+
+  received = 0;
+  expected = nthreads * NUM_MSGS;
+  head = NULL;
+  tail = &head;
+  ASSERT(0 == uv_mutex_init(&mutex));
+
+  if (use_mutex)
+    ASSERT(0 == uv_async_init(uv_default_loop(), &handle, mutex_cb));
+  else
+    ASSERT(0 == uv_async_init_msg(uv_default_loop(), &handle, msg_cb));
+
+  time = uv_hrtime();
+
+  for (i = 0; i < nthreads; i++)
+    ASSERT(0 == uv_thread_create(tids + i,
+                                 use_mutex ? mutex_sender : msg_sender,
+                                 msgs + i * NUM_MSGS));
+
+  uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+  time = uv_hrtime() - time;
+
+  for (i = 0; i < nthreads; i++)
+    ASSERT(0 == uv_thread_join(tids + i));
+
+  ASSERT(received == expected);
+  uv_close((uv_handle_t*) &handle, NULL);
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  printf("async_msg%s_%d: %s messages in %.2f seconds (%s/sec)\n",
+         use_mutex ? "_mutex" : "",
+         nthreads,
+         fmt(received),
+         time / 1e9,
+         fmt(received / (time / 1e9)));
+
+  uv_mutex_destroy(&mutex);
+  free(msgs);
+  free(tids);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(async_msg_1) {
+  return test_async_msg(1, 0);
+}
+
+
+BENCHMARK_IMPL(async_msg_4) {
+  return test_async_msg(4, 0);
+}
+
+
+BENCHMARK_IMPL(async_msg_mutex_1) {
+  return test_async_msg(1, 1);
+}
+
+
+BENCHMARK_IMPL(async_msg_mutex_4) {
+  return test_async_msg(4, 1);
+}
@@ -0,0 +1,186 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_DIRS    10
+#define NUM_FILES   1000
+#define NUM_ROUNDS  3
+
+static uv_fs_event_t fs_event;
+static uv_timer_t timer;
+static uint64_t events;
+static uint64_t callbacks;
+static int round;
+
+
+static void file_path(char* buf, size_t size, int dir, int file) {
+  snprintf(buf, size, "bench_fs_event/%d/%d", dir, file);
+}
+
+
+static void make_tree(int create) {
+  char path[64];
+  uv_fs_t req;
+  int i;
+  int j;
+  int r;
+
+  if (create) {
+    uv_fs_mkdir(NULL, &req, "bench_fs_event", 0755, NULL);
+    uv_fs_req_cleanup(&req);
+  }
+
+  for (i = 0; i < NUM_DIRS; i++) {
+    snprintf(path, sizeof(path), "bench_fs_event/%d", i);
+    if (create) {
+      uv_fs_mkdir(NULL, &req, path, 0755, NULL);
+      uv_fs_req_cleanup(&req);
+    }
+
+    for (j = 0; j < NUM_FILES; j++) {
+      file_path(path, sizeof(path), i, j);
+      if (create) {
+        r = uv_fs_open(NULL, &req, path, O_WRONLY | O_CREAT, 0644, NULL);
+        ASSERT(r >= 0);
+        uv_fs_req_cleanup(&req);
+        uv_fs_close(NULL, &req, r, NULL);
+      } else {
+        uv_fs_unlink(NULL, &req, path, NULL);
+      }
+      uv_fs_req_cleanup(&req);
+    }
+
+    if (!create) {
+      snprintf(path, sizeof(path), "bench_fs_event/%d", i);
+      uv_fs_rmdir(NULL, &req, path, NULL);
+      uv_fs_req_cleanup(&req);
+    }
+  }
+
+  if (!create) {
+    uv_fs_rmdir(NULL, &req, "bench_fs_event", NULL);
+    uv_fs_req_cleanup(&req);
+  }
+}
+
+
+/* Like a checkout: every file in the tree changes, all at once. */
+static void touch_tree(uv_timer_t* handle) {
+  char path[64];
+  uv_fs_t req;
+  int i;
+  int j;
+
+  if (round++ == NUM_ROUNDS) {
+    uv_close((uv_handle_t*) &fs_event, NULL);
+    uv_close((uv_handle_t*) &timer, NULL);
+    return;
+  }
+
+  for (i = 0; i < NUM_DIRS; i++) {
+    for (j = 0; j < NUM_FILES; j++) {
+      file_path(path, sizeof(path), i, j);
+      ASSERT(0 == uv_fs_utime(NULL, &req, path, round, round, NULL));
+      uv_fs_req_cleanup(&req);
+    }
+  }
+
+  uv_timer_start(&timer, touch_tree, 500, 0);
+}
+
+
+static void fs_event_cb(uv_fs_event_t* handle,
+                        const char* filename,
+                        int ev,
+                        int status) {
+  events++;
+  callbacks++;
+}
+
+
+static void fs_event_batch_cb(uv_fs_event_t* handle,
+                              const uv_fs_event_change_t* changes,
+                              unsigned int nchanges,
+                              int status) {
+  events += nchanges;
+  callbacks++;
+}
+
+
+static int fs_event_burst(uint64_t window) {
+  uv_loop_t* loop;
+  int r;
+
+  loop = uv_default_loop();
+  make_tree(0);
+  make_tree(1);
+
+  ASSERT(0 == uv_fs_event_init(loop, &fs_event));
+  if (window != 0) {
+    r = uv_fs_event_set_batching(&fs_event, window, fs_event_batch_cb);
+    if (r == UV_ENOSYS) {
+      make_tree(0);
+      RETURN_SKIP("Batched fs events not supported on this platform.");
+    }
+    ASSERT(r == 0);
+  }
+
+  r = uv_fs_event_start(&fs_event,
+                        fs_event_cb,
+                        "bench_fs_event",
+                        UV_FS_EVENT_RECURSIVE);
+  if (r == UV_ENOSYS) {
+    make_tree(0);
+    RETURN_SKIP("Recursive fs events not supported on this platform.");
+  }
+  ASSERT(r == 0);
+
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, touch_tree, 100, 0));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  printf("%s: %d rounds of %d changed files, %llu changes in %llu callbacks\n",
+         window == 0 ? "per event" : "batched",
+         NUM_ROUNDS,
+         NUM_DIRS * NUM_FILES,
+         (unsigned long long) events,
+         (unsigned long long) callbacks);
+
+  make_tree(0);
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(fs_event_burst) {
+  return fs_event_burst(0);
+}
+
+
+BENCHMARK_IMPL(fs_event_burst_batched) {
+  return fs_event_burst(50);
+}
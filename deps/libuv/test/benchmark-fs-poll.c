@@ -0,0 +1,239 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_PATHS   10000
+#define INTERVAL    100
+#define WARMUP      500
+#define DURATION    3000
+
+enum {
+  PER_PATH,  /* A timer and a uv_fs_stat() per path, like fs-poll used to. */
+  FILES,     /* uv_fs_poll_t on regular files. */
+  SYMLINKS   /* uv_fs_poll_t on symlinks, which are never watched. */
+};
+
+struct per_path {
+  uv_timer_t timer;
+  uv_fs_t req;
+  char path[32];
+};
+
+static uv_fs_poll_t* poll_handles;
+static struct per_path* per_paths;
+static uv_timer_t timer;
+static uint64_t stats_submitted;
+static double start_cpu;
+static int mode;
+
+
+static double cpu_time(void) {
+  uv_rusage_t ru;
+
+  ASSERT(0 == uv_getrusage(&ru));
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+         ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+
+static uint64_t submitted(void) {
+  uv_work_stats_t stats;
+
+  ASSERT(0 == uv_threadpool_stats(uv_default_loop(), UV_WORK_FAST_IO, &stats));
+  return stats.submitted;
+}
+
+
+static void file_path(char* buf, size_t size, const char* kind, int i) {
+  snprintf(buf, size, "bench_fs_poll/%s%d", kind, i);
+}
+
+
+static int make_tree(int create) {
+  char target[32];
+  char path[32];
+  uv_fs_t req;
+  int i;
+  int r;
+
+  if (create) {
+    uv_fs_mkdir(NULL, &req, "bench_fs_poll", 0755, NULL);
+    uv_fs_req_cleanup(&req);
+  }
+
+  for (i = 0; i < NUM_PATHS; i++) {
+    file_path(path, sizeof(path), "f", i);
+    if (create) {
+      r = uv_fs_open(NULL, &req, path, O_WRONLY | O_CREAT, 0644, NULL);
+      ASSERT(r >= 0);
+      uv_fs_req_cleanup(&req);
+      uv_fs_close(NULL, &req, r, NULL);
+    } else {
+      uv_fs_unlink(NULL, &req, path, NULL);
+    }
+    uv_fs_req_cleanup(&req);
+
+    file_path(path, sizeof(path), "l", i);
+    if (create) {
+      snprintf(target, sizeof(target), "f%d", i);
+      r = uv_fs_symlink(NULL, &req, target, path, 0, NULL);
+      uv_fs_req_cleanup(&req);
+      if (r)
+        return r;
+    } else {
+      uv_fs_unlink(NULL, &req, path, NULL);
+      uv_fs_req_cleanup(&req);
+    }
+  }
+
+  if (!create) {
+    uv_fs_rmdir(NULL, &req, "bench_fs_poll", NULL);
+    uv_fs_req_cleanup(&req);
+  }
+
+  return 0;
+}
+
+
+static void poll_cb(uv_fs_poll_t* handle,
+                    int status,
+                    const uv_stat_t* prev,
+                    const uv_stat_t* curr) {
+  ASSERT(0 && "nothing should change");
+}
+
+
+static void per_path_stat_cb(uv_fs_t* req);
+
+
+static void per_path_timer_cb(uv_timer_t* handle) {
+  struct per_path* p;
+
+  p = container_of(handle, struct per_path, timer);
+  ASSERT(0 == uv_fs_stat(handle->loop, &p->req, p->path, per_path_stat_cb));
+}
+
+
+static void per_path_stat_cb(uv_fs_t* req) {
+  struct per_path* p;
+
+  p = container_of(req, struct per_path, req);
+  ASSERT(req->result == 0);
+  uv_fs_req_cleanup(req);
+
+  if (uv_is_closing((uv_handle_t*) &p->timer))
+    return;
+
+  ASSERT(0 == uv_timer_start(&p->timer, per_path_timer_cb, INTERVAL, 0));
+}
+
+
+static void stop_cb(uv_timer_t* handle) {
+  double cpu;
+  int i;
+
+  cpu = cpu_time() - start_cpu;
+
+  printf("%s: %d paths, %.1f ms CPU per second, %.1f threadpool jobs per "
+         "second\n",
+         mode == PER_PATH ? "per path" : mode == FILES ? "files" : "symlinks",
+         NUM_PATHS,
+         cpu * 1e3 / (DURATION / 1e3),
+         (submitted() - stats_submitted) / (DURATION / 1e3));
+
+  for (i = 0; i < NUM_PATHS; i++) {
+    if (mode == PER_PATH)
+      uv_close((uv_handle_t*) &per_paths[i].timer, NULL);
+    else
+      uv_close((uv_handle_t*) &poll_handles[i], NULL);
+  }
+
+  uv_close((uv_handle_t*) &timer, NULL);
+}
+
+
+static void start_cb(uv_timer_t* handle) {
+  start_cpu = cpu_time();
+  stats_submitted = submitted();
+  ASSERT(0 == uv_timer_start(&timer, stop_cb, DURATION, 0));
+}
+
+
+static int fs_poll_paths(int m) {
+  char path[32];
+  uv_loop_t* loop;
+  int i;
+
+  mode = m;
+  loop = uv_default_loop();
+  make_tree(0);
+  if (make_tree(1)) {
+    make_tree(0);
+    RETURN_SKIP("Symlinks not supported on this platform.");
+  }
+
+  poll_handles = calloc(NUM_PATHS, sizeof(*poll_handles));
+  per_paths = calloc(NUM_PATHS, sizeof(*per_paths));
+  ASSERT(poll_handles != NULL);
+  ASSERT(per_paths != NULL);
+
+  for (i = 0; i < NUM_PATHS; i++) {
+    if (mode == PER_PATH) {
+      file_path(per_paths[i].path, sizeof(per_paths[i].path), "f", i);
+      ASSERT(0 == uv_timer_init(loop, &per_paths[i].timer));
+      per_path_timer_cb(&per_paths[i].timer);
+    } else {
+      file_path(path, sizeof(path), mode == FILES ? "f" : "l", i);
+      ASSERT(0 == uv_fs_poll_init(loop, &poll_handles[i]));
+      ASSERT(0 == uv_fs_poll_start(&poll_handles[i], poll_cb, path, INTERVAL));
+    }
+  }
+
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, start_cb, WARMUP, 0));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  free(poll_handles);
+  free(per_paths);
+  make_tree(0);
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(fs_poll_10k_per_path) {
+  return fs_poll_paths(PER_PATH);
+}
+
+
+BENCHMARK_IMPL(fs_poll_10k_files) {
+  return fs_poll_paths(FILES);
+}
+
+
+BENCHMARK_IMPL(fs_poll_10k_symlinks) {
+  return fs_poll_paths(SYMLINKS);
+}
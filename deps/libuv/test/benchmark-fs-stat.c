@@ -85,7 +85,7 @@ static void stat_cb(uv_fs_t* fs_req) {
   struct async_req* req = container_of(fs_req, struct async_req, fs_req);
   uv_fs_req_cleanup(&req->fs_req);
   if (*req->count == 0) return;
-  uv_fs_stat(uv_default_loop(), &req->fs_req, req->path, stat_cb);
+  uv_fs_stat(fs_req->loop, &req->fs_req, req->path, stat_cb);
   (*req->count)--;
 }
 
@@ -134,3 +134,288 @@ BENCHMARK_IMPL(fs_stat) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+/* Same as the async part of fs_stat but with a fixed number of concurrent
+ * requests and a private thread pool of increasing size, to show how the
+ * thread pool itself scales.
+ */
+BENCHMARK_IMPL(fs_stat_pool_scaling) {
+  struct async_req reqs[4 * MAX_CONCURRENT_REQS];
+  struct async_req* req;
+  const char path[] = ".";
+  unsigned int nthreads;
+  uint64_t before;
+  uint64_t after;
+  uv_loop_t loop;
+  int count;
+
+  warmup(path);
+
+  for (nthreads = 1; nthreads <= 64; nthreads *= 2) {
+    ASSERT(0 == uv_loop_init(&loop));
+    ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_THREADPOOL_SIZE, nthreads));
+    count = NUM_ASYNC_REQS;
+
+    for (req = reqs; req < reqs + ARRAY_SIZE(reqs); req++) {
+      req->path = path;
+      req->count = &count;
+      uv_fs_stat(&loop, &req->fs_req, req->path, stat_cb);
+    }
+
+    before = uv_hrtime();
+    uv_run(&loop, UV_RUN_DEFAULT);
+    after = uv_hrtime();
+    ASSERT(0 == uv_loop_close(&loop));
+
+    printf("%2u threads: %d stats (%d concurrent): %.2fs (%s/s)\n",
+           nthreads,
+           NUM_ASYNC_REQS,
+           (int) ARRAY_SIZE(reqs),
+           (after - before) / 1e9,
+           fmt((1.0 * NUM_ASYNC_REQS) / ((after - before) / 1e9)));
+    fflush(stdout);
+  }
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+/* Same as the async part of fs_stat with the file system requests going
+ * through the thread pool and through io_uring, to compare the two. Loops
+ * on platforms without io_uring only run the thread pool variant.
+ */
+BENCHMARK_IMPL(fs_stat_io_uring) {
+  static const char* const names[] = { "threadpool", "io_uring" };
+  struct async_req reqs[MAX_CONCURRENT_REQS];
+  struct async_req* req;
+  const char path[] = ".";
+  uint64_t before;
+  uint64_t after;
+  uv_loop_t loop;
+  int count;
+  int use;
+  int r;
+
+  warmup(path);
+
+  for (use = 0; use < 2; use++) {
+    ASSERT(0 == uv_loop_init(&loop));
+    r = uv_loop_configure(&loop, UV_LOOP_USE_IO_URING, use);
+    if (r == UV_ENOSYS) {
+      ASSERT(0 == uv_loop_close(&loop));
+      printf("%s: not supported\n", names[use]);
+      continue;
+    }
+    ASSERT(r == 0);
+    count = NUM_ASYNC_REQS;
+
+    for (req = reqs; req < reqs + ARRAY_SIZE(reqs); req++) {
+      req->path = path;
+      req->count = &count;
+      uv_fs_stat(&loop, &req->fs_req, req->path, stat_cb);
+    }
+
+    before = uv_hrtime();
+    uv_run(&loop, UV_RUN_DEFAULT);
+    after = uv_hrtime();
+    ASSERT(0 == uv_loop_close(&loop));
+
+    printf("%s: %d stats (%d concurrent): %.2fs (%s/s)\n",
+           names[use],
+           NUM_ASYNC_REQS,
+           (int) ARRAY_SIZE(reqs),
+           (after - before) / 1e9,
+           fmt((1.0 * NUM_ASYNC_REQS) / ((after - before) / 1e9)));
+    fflush(stdout);
+  }
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#define TREE_DIRS   40
+#define TREE_FILES  500
+
+struct tree_req {
+  uv_fs_t fs_req;
+  char path[64];
+};
+
+static int tree_entries;
+static int tree_requests;
+
+
+static void tree_make(int create) {
+  char path[64];
+  uv_fs_t req;
+  int i;
+  int j;
+  int r;
+
+  for (i = 0; i < TREE_DIRS; i++) {
+    snprintf(path, sizeof(path), "bench_tree/%d", i);
+    if (create) {
+      uv_fs_mkdir(NULL, &req, "bench_tree", 0755, NULL);
+      uv_fs_req_cleanup(&req);
+      uv_fs_mkdir(NULL, &req, path, 0755, NULL);
+      uv_fs_req_cleanup(&req);
+    }
+
+    for (j = 0; j < TREE_FILES; j++) {
+      snprintf(path, sizeof(path), "bench_tree/%d/%d", i, j);
+      if (create) {
+        r = uv_fs_open(NULL, &req, path, O_WRONLY | O_CREAT, 0644, NULL);
+        ASSERT(r >= 0);
+        uv_fs_req_cleanup(&req);
+        uv_fs_close(NULL, &req, r, NULL);
+      } else {
+        uv_fs_unlink(NULL, &req, path, NULL);
+      }
+      uv_fs_req_cleanup(&req);
+    }
+
+    if (!create) {
+      snprintf(path, sizeof(path), "bench_tree/%d", i);
+      uv_fs_rmdir(NULL, &req, path, NULL);
+      uv_fs_req_cleanup(&req);
+    }
+  }
+
+  if (!create) {
+    uv_fs_rmdir(NULL, &req, "bench_tree", NULL);
+    uv_fs_req_cleanup(&req);
+  }
+}
+
+
+static void tree_scandir(uv_loop_t* loop, const char* path);
+
+
+static void tree_stat_cb(uv_fs_t* fs_req) {
+  struct tree_req* req = container_of(fs_req, struct tree_req, fs_req);
+  ASSERT(fs_req->result == 0);
+  uv_fs_req_cleanup(fs_req);
+  free(req);
+  tree_requests++;
+}
+
+
+static void tree_scandir_cb(uv_fs_t* fs_req) {
+  struct tree_req* req = container_of(fs_req, struct tree_req, fs_req);
+  struct tree_req* stat_req;
+  uv_dirent_t ent;
+  int n;
+
+  ASSERT(fs_req->result >= 0);
+  tree_requests++;
+
+  /* The usual way: one stat request per entry. */
+  while (UV_EOF != uv_fs_scandir_next(fs_req, &ent)) {
+    stat_req = malloc(sizeof(*stat_req));
+    ASSERT(stat_req != NULL);
+    n = snprintf(stat_req->path,
+                 sizeof(stat_req->path),
+                 "%s/%s",
+                 req->path,
+                 ent.name);
+    ASSERT(n > 0 && (size_t) n < sizeof(stat_req->path));
+    ASSERT(0 == uv_fs_lstat(fs_req->loop,
+                            &stat_req->fs_req,
+                            stat_req->path,
+                            tree_stat_cb));
+    if (ent.type == UV_DIRENT_DIR)
+      tree_scandir(fs_req->loop, stat_req->path);
+    tree_entries++;
+  }
+
+  uv_fs_req_cleanup(fs_req);
+  free(req);
+}
+
+
+static void tree_scandir(uv_loop_t* loop, const char* path) {
+  struct tree_req* req;
+  int n;
+
+  req = malloc(sizeof(*req));
+  ASSERT(req != NULL);
+  n = snprintf(req->path, sizeof(req->path), "%s", path);
+  ASSERT(n > 0 && (size_t) n < sizeof(req->path));
+  ASSERT(0 == uv_fs_scandir(loop, &req->fs_req, req->path, 0, tree_scandir_cb));
+}
+
+
+static void tree_walk_cb(uv_fs_t* req) {
+  uv_fs_walk_entry_t ent;
+
+  ASSERT(req->result >= 0);
+  tree_requests++;
+
+  if (req->result == 0) {
+    uv_fs_req_cleanup(req);
+    return;
+  }
+
+  while (0 == uv_fs_walk_next(req, &ent))
+    tree_entries++;
+
+  ASSERT(0 == uv_fs_walk_continue(req->loop, req, tree_walk_cb));
+}
+
+
+/* Walks a tree of TREE_DIRS * TREE_FILES files and stats every entry, once
+ * with uv_fs_scandir() plus one uv_fs_lstat() per entry and once with the
+ * batched uv_fs_walk().
+ */
+BENCHMARK_IMPL(fs_stat_tree_walk) {
+  static const char* const names[] = { "scandir+lstat", "walk" };
+  uv_fs_t walk_req;
+  uint64_t before;
+  uint64_t after;
+  int use;
+  int r;
+
+  tree_make(0);
+  tree_make(1);
+
+  for (use = 0; use < 2; use++) {
+    tree_entries = 0;
+    tree_requests = 0;
+    before = uv_hrtime();
+
+    if (use == 0) {
+      tree_scandir(uv_default_loop(), "bench_tree");
+    } else {
+      r = uv_fs_walk(uv_default_loop(),
+                     &walk_req,
+                     "bench_tree",
+                     0,
+                     tree_walk_cb);
+      if (r == UV_ENOSYS) {
+        printf("%s: not supported\n", names[use]);
+        continue;
+      }
+      ASSERT(r == 0);
+    }
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+    after = uv_hrtime();
+
+    ASSERT(tree_entries == TREE_DIRS * (TREE_FILES + 1));
+    printf("%s: %d entries in %d requests: %.2fs (%s/s)\n",
+           names[use],
+           tree_entries,
+           tree_requests,
+           (after - before) / 1e9,
+           fmt(tree_entries / ((after - before) / 1e9)));
+    fflush(stdout);
+  }
+
+  tree_make(0);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
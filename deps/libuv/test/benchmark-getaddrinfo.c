@@ -21,12 +21,17 @@
 
 #include "uv.h"
 #include "task.h"
+#include <stdio.h>
 #include <stdlib.h>
 
 #define CONCURRENT_CALLS 10
 #define TOTAL_CALLS 10000
 
-static const char* name = "localhost";
+#define RESOLV_CONF "benchmark_resolv.conf"
+#define HOSTS       "benchmark_hosts"
+
+static const char* name;
+static struct addrinfo hints;
 
 static uv_loop_t* loop;
 
@@ -58,15 +63,55 @@ static void getaddrinfo_initiate(uv_getaddrinfo_t* handle) {
 
   calls_initiated++;
 
-  r = uv_getaddrinfo(loop, handle, &getaddrinfo_cb, name, NULL, NULL);
+  r = uv_getaddrinfo(loop, handle, &getaddrinfo_cb, name, NULL, &hints);
   ASSERT(r == 0);
 }
 
 
-BENCHMARK_IMPL(getaddrinfo) {
+/* The resolver talks to the dns_server helper, over TCP because that's all
+ * the helper speaks.
+ */
+static int use_resolver(void) {
+  FILE* fp;
+  int r;
+
+  fp = fopen(RESOLV_CONF, "w");
+  ASSERT(fp != NULL);
+  fprintf(fp, "nameserver [127.0.0.1]:%d\noptions use-vc\n", TEST_PORT_2);
+  ASSERT(0 == fclose(fp));
+
+  fp = fopen(HOSTS, "w");
+  ASSERT(fp != NULL);
+  ASSERT(0 == fclose(fp));
+
+  r = uv_loop_configure(loop, UV_LOOP_DNS_RESOLVER, RESOLV_CONF, HOSTS);
+  ASSERT(r == 0 || r == UV_ENOSYS);
+
+  name = "echos.srv";
+  hints.ai_family = AF_INET;
+  return r;
+}
+
+
+static int getaddrinfo_bench(const char* title, int cache, int resolver) {
+  int r;
   int i;
 
   loop = uv_default_loop();
+  name = "localhost";
+
+  if (resolver && use_resolver() == UV_ENOSYS) {
+    remove(RESOLV_CONF);
+    remove(HOSTS);
+    RETURN_SKIP("No stub resolver on this platform.");
+  }
+
+  if (cache) {
+    r = uv_loop_configure(loop, UV_LOOP_DNS_CACHE, 60);
+    if (r == UV_ENOSYS)
+      RETURN_SKIP("No getaddrinfo() cache on this platform.");
+    ASSERT(r == 0);
+  }
 
   uv_update_time(loop);
   start_time = uv_now(loop);
@@ -83,10 +128,36 @@ BENCHMARK_IMPL(getaddrinfo) {
   ASSERT(calls_initiated == TOTAL_CALLS);
   ASSERT(calls_completed == TOTAL_CALLS);
 
-  fprintf(stderr, "getaddrinfo: %.0f req/s\n",
+  fprintf(stderr, "%s: %.0f req/s\n",
+          title,
           (double) calls_completed / (double) (end_time - start_time) * 1000.0);
   fflush(stderr);
 
+  if (resolver) {
+    remove(RESOLV_CONF);
+    remove(HOSTS);
+  }
+
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+BENCHMARK_IMPL(getaddrinfo) {
+  return getaddrinfo_bench("getaddrinfo", 0, 0);
+}
+
+
+BENCHMARK_IMPL(getaddrinfo_cached) {
+  return getaddrinfo_bench("getaddrinfo_cached", 1, 0);
+}
+
+
+BENCHMARK_IMPL(getaddrinfo_resolver) {
+  return getaddrinfo_bench("getaddrinfo_resolver", 0, 1);
+}
+
+
+BENCHMARK_IMPL(getaddrinfo_resolver_cached) {
+  return getaddrinfo_bench("getaddrinfo_resolver_cached", 1, 1);
+}
@@ -21,9 +21,13 @@
 
 BENCHMARK_DECLARE (sizes)
 BENCHMARK_DECLARE (loop_count)
+BENCHMARK_DECLARE (loop_count_metrics)
 BENCHMARK_DECLARE (loop_count_timed)
 BENCHMARK_DECLARE (ping_pongs)
 BENCHMARK_DECLARE (tcp_write_batch)
+BENCHMARK_DECLARE (tcp_write_batch_coalesced)
+BENCHMARK_DECLARE (tcp_sendfile)
+BENCHMARK_DECLARE (tcp_sendfile_copy)
 BENCHMARK_DECLARE (tcp4_pound_100)
 BENCHMARK_DECLARE (tcp4_pound_1000)
 BENCHMARK_DECLARE (pipe_pound_100)
@@ -32,10 +36,20 @@ BENCHMARK_DECLARE (tcp_pump100_client)
 BENCHMARK_DECLARE (tcp_pump1_client)
 BENCHMARK_DECLARE (pipe_pump100_client)
 BENCHMARK_DECLARE (pipe_pump1_client)
+BENCHMARK_DECLARE (tcp_duplex_pump100_client)
+BENCHMARK_DECLARE (pipe_duplex_pump100_client)
+BENCHMARK_DECLARE (tcp_pump100_malloc_client)
+BENCHMARK_DECLARE (tcp_pump100_pool_client)
+BENCHMARK_DECLARE (pipe_pump100_malloc_client)
+BENCHMARK_DECLARE (pipe_pump100_pool_client)
 
 BENCHMARK_DECLARE (tcp_multi_accept2)
 BENCHMARK_DECLARE (tcp_multi_accept4)
 BENCHMARK_DECLARE (tcp_multi_accept8)
+BENCHMARK_DECLARE (tcp_reuseport_accept2)
+BENCHMARK_DECLARE (tcp_reuseport_accept4)
+BENCHMARK_DECLARE (tcp_reuseport_accept8)
+BENCHMARK_DECLARE (tcp_reuseport_pinned_accept4)
 
 /* Run until X packets have been sent/received. */
 BENCHMARK_DECLARE (udp_pummel_1v1)
@@ -60,24 +74,51 @@ BENCHMARK_DECLARE (udp_timed_pummel_10v1000)
 BENCHMARK_DECLARE (udp_timed_pummel_100v100)
 BENCHMARK_DECLARE (udp_timed_pummel_100v1000)
 BENCHMARK_DECLARE (udp_timed_pummel_1000v1000)
+BENCHMARK_DECLARE (udp_timed_pummel_window_1v1)
+BENCHMARK_DECLARE (udp_timed_pummel_mmsg_1v1)
+BENCHMARK_DECLARE (udp_timed_pummel_window_10v10)
+BENCHMARK_DECLARE (udp_timed_pummel_mmsg_10v10)
 
 BENCHMARK_DECLARE (getaddrinfo)
+BENCHMARK_DECLARE (getaddrinfo_cached)
+BENCHMARK_DECLARE (getaddrinfo_resolver)
+BENCHMARK_DECLARE (getaddrinfo_resolver_cached)
 BENCHMARK_DECLARE (fs_stat)
+BENCHMARK_DECLARE (fs_stat_pool_scaling)
+BENCHMARK_DECLARE (fs_stat_io_uring)
+BENCHMARK_DECLARE (fs_stat_tree_walk)
+BENCHMARK_DECLARE (fs_event_burst)
+BENCHMARK_DECLARE (fs_event_burst_batched)
+BENCHMARK_DECLARE (fs_poll_10k_per_path)
+BENCHMARK_DECLARE (fs_poll_10k_files)
+BENCHMARK_DECLARE (fs_poll_10k_symlinks)
 BENCHMARK_DECLARE (async1)
 BENCHMARK_DECLARE (async2)
 BENCHMARK_DECLARE (async4)
 BENCHMARK_DECLARE (async8)
+BENCHMARK_DECLARE (async_msg_1)
+BENCHMARK_DECLARE (async_msg_4)
+BENCHMARK_DECLARE (async_msg_mutex_1)
+BENCHMARK_DECLARE (async_msg_mutex_4)
 BENCHMARK_DECLARE (async_pummel_1)
 BENCHMARK_DECLARE (async_pummel_2)
 BENCHMARK_DECLARE (async_pummel_4)
 BENCHMARK_DECLARE (async_pummel_8)
 BENCHMARK_DECLARE (spawn)
+BENCHMARK_DECLARE (spawn_large_heap)
+BENCHMARK_DECLARE (spawn_large_heap_fork)
 BENCHMARK_DECLARE (thread_create)
+BENCHMARK_DECLARE (thread_pool_scaling)
 BENCHMARK_DECLARE (million_async)
 BENCHMARK_DECLARE (million_timers)
+BENCHMARK_DECLARE (million_timers_wheel)
 HELPER_DECLARE    (tcp4_blackhole_server)
 HELPER_DECLARE    (tcp_pump_server)
 HELPER_DECLARE    (pipe_pump_server)
+HELPER_DECLARE    (tcp_pump_malloc_server)
+HELPER_DECLARE    (tcp_pump_pool_server)
+HELPER_DECLARE    (pipe_pump_malloc_server)
+HELPER_DECLARE    (pipe_pump_pool_server)
 HELPER_DECLARE    (tcp4_echo_server)
 HELPER_DECLARE    (pipe_echo_server)
 HELPER_DECLARE    (dns_server)
@@ -85,6 +126,7 @@ HELPER_DECLARE    (dns_server)
 TASK_LIST_START
   BENCHMARK_ENTRY  (sizes)
   BENCHMARK_ENTRY  (loop_count)
+  BENCHMARK_ENTRY  (loop_count_metrics)
   BENCHMARK_ENTRY  (loop_count_timed)
 
   BENCHMARK_ENTRY  (ping_pongs)
@@ -93,12 +135,30 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (tcp_write_batch)
   BENCHMARK_HELPER (tcp_write_batch, tcp4_blackhole_server)
 
+  BENCHMARK_ENTRY  (tcp_write_batch_coalesced)
+  BENCHMARK_HELPER (tcp_write_batch_coalesced, tcp4_blackhole_server)
+
+  BENCHMARK_ENTRY  (tcp_sendfile)
+  BENCHMARK_HELPER (tcp_sendfile, tcp4_blackhole_server)
+
+  BENCHMARK_ENTRY  (tcp_sendfile_copy)
+  BENCHMARK_HELPER (tcp_sendfile_copy, tcp4_blackhole_server)
+
   BENCHMARK_ENTRY  (tcp_pump100_client)
   BENCHMARK_HELPER (tcp_pump100_client, tcp_pump_server)
 
   BENCHMARK_ENTRY  (tcp_pump1_client)
   BENCHMARK_HELPER (tcp_pump1_client, tcp_pump_server)
 
+  BENCHMARK_ENTRY  (tcp_duplex_pump100_client)
+  BENCHMARK_HELPER (tcp_duplex_pump100_client, tcp_pump_server)
+
+  BENCHMARK_ENTRY  (tcp_pump100_malloc_client)
+  BENCHMARK_HELPER (tcp_pump100_malloc_client, tcp_pump_malloc_server)
+
+  BENCHMARK_ENTRY  (tcp_pump100_pool_client)
+  BENCHMARK_HELPER (tcp_pump100_pool_client, tcp_pump_pool_server)
+
   BENCHMARK_ENTRY  (tcp4_pound_100)
   BENCHMARK_HELPER (tcp4_pound_100, tcp4_echo_server)
 
@@ -111,6 +171,15 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (pipe_pump1_client)
   BENCHMARK_HELPER (pipe_pump1_client, pipe_pump_server)
 
+  BENCHMARK_ENTRY  (pipe_duplex_pump100_client)
+  BENCHMARK_HELPER (pipe_duplex_pump100_client, pipe_pump_server)
+
+  BENCHMARK_ENTRY  (pipe_pump100_malloc_client)
+  BENCHMARK_HELPER (pipe_pump100_malloc_client, pipe_pump_malloc_server)
+
+  BENCHMARK_ENTRY  (pipe_pump100_pool_client)
+  BENCHMARK_HELPER (pipe_pump100_pool_client, pipe_pump_pool_server)
+
   BENCHMARK_ENTRY  (pipe_pound_100)
   BENCHMARK_HELPER (pipe_pound_100, pipe_echo_server)
 
@@ -120,6 +189,10 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (tcp_multi_accept2)
   BENCHMARK_ENTRY  (tcp_multi_accept4)
   BENCHMARK_ENTRY  (tcp_multi_accept8)
+  BENCHMARK_ENTRY  (tcp_reuseport_accept2)
+  BENCHMARK_ENTRY  (tcp_reuseport_accept4)
+  BENCHMARK_ENTRY  (tcp_reuseport_accept8)
+  BENCHMARK_ENTRY  (tcp_reuseport_pinned_accept4)
 
   BENCHMARK_ENTRY  (udp_pummel_1v1)
   BENCHMARK_ENTRY  (udp_pummel_1v10)
@@ -142,22 +215,49 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (udp_timed_pummel_100v100)
   BENCHMARK_ENTRY  (udp_timed_pummel_100v1000)
   BENCHMARK_ENTRY  (udp_timed_pummel_1000v1000)
+  BENCHMARK_ENTRY  (udp_timed_pummel_window_1v1)
+  BENCHMARK_ENTRY  (udp_timed_pummel_mmsg_1v1)
+  BENCHMARK_ENTRY  (udp_timed_pummel_window_10v10)
+  BENCHMARK_ENTRY  (udp_timed_pummel_mmsg_10v10)
 
   BENCHMARK_ENTRY  (getaddrinfo)
+  BENCHMARK_ENTRY  (getaddrinfo_cached)
+
+  BENCHMARK_ENTRY  (getaddrinfo_resolver)
+  BENCHMARK_HELPER (getaddrinfo_resolver, dns_server)
+
+  BENCHMARK_ENTRY  (getaddrinfo_resolver_cached)
+  BENCHMARK_HELPER (getaddrinfo_resolver_cached, dns_server)
 
   BENCHMARK_ENTRY  (fs_stat)
+  BENCHMARK_ENTRY  (fs_stat_pool_scaling)
+  BENCHMARK_ENTRY  (fs_stat_io_uring)
+  BENCHMARK_ENTRY  (fs_stat_tree_walk)
+  BENCHMARK_ENTRY  (fs_event_burst)
+  BENCHMARK_ENTRY  (fs_event_burst_batched)
+  BENCHMARK_ENTRY  (fs_poll_10k_per_path)
+  BENCHMARK_ENTRY  (fs_poll_10k_files)
+  BENCHMARK_ENTRY  (fs_poll_10k_symlinks)
 
   BENCHMARK_ENTRY  (async1)
   BENCHMARK_ENTRY  (async2)
   BENCHMARK_ENTRY  (async4)
   BENCHMARK_ENTRY  (async8)
+  BENCHMARK_ENTRY  (async_msg_1)
+  BENCHMARK_ENTRY  (async_msg_4)
+  BENCHMARK_ENTRY  (async_msg_mutex_1)
+  BENCHMARK_ENTRY  (async_msg_mutex_4)
   BENCHMARK_ENTRY  (async_pummel_1)
   BENCHMARK_ENTRY  (async_pummel_2)
   BENCHMARK_ENTRY  (async_pummel_4)
   BENCHMARK_ENTRY  (async_pummel_8)
 
   BENCHMARK_ENTRY  (spawn)
+  BENCHMARK_ENTRY  (spawn_large_heap)
+  BENCHMARK_ENTRY  (spawn_large_heap_fork)
   BENCHMARK_ENTRY  (thread_create)
+  BENCHMARK_ENTRY  (thread_pool_scaling)
   BENCHMARK_ENTRY  (million_async)
   BENCHMARK_ENTRY  (million_timers)
+  BENCHMARK_ENTRY  (million_timers_wheel)
 TASK_LIST_END
@@ -49,9 +49,17 @@ static void timer_cb(uv_timer_t* handle) {
 }
 
 
-BENCHMARK_IMPL(loop_count) {
+static int loop_count(int metrics) {
   uv_loop_t* loop = uv_default_loop();
   uint64_t ns;
+  int r;
+
+  if (metrics) {
+    r = uv_loop_configure(loop, UV_LOOP_METRICS, 1);
+    if (r == UV_ENOSYS)
+      RETURN_SKIP("UV_LOOP_METRICS not supported on this platform.");
+    ASSERT(r == 0);
+  }
 
   uv_idle_init(loop, &idle_handle);
   uv_idle_start(&idle_handle, idle_cb);
@@ -62,7 +70,8 @@ BENCHMARK_IMPL(loop_count) {
 
   ASSERT(ticks == NUM_TICKS);
 
-  fprintf(stderr, "loop_count: %d ticks in %.2fs (%.0f/s)\n",
+  fprintf(stderr, "loop_count%s: %d ticks in %.2fs (%.0f/s)\n",
+          metrics ? "_metrics" : "",
           NUM_TICKS,
           ns / 1e9,
           NUM_TICKS / (ns / 1e9));
@@ -73,6 +82,16 @@ BENCHMARK_IMPL(loop_count) {
 }
 
 
+BENCHMARK_IMPL(loop_count) {
+  return loop_count(0);
+}
+
+
+BENCHMARK_IMPL(loop_count_metrics) {
+  return loop_count(1);
+}
+
+
 BENCHMARK_IMPL(loop_count_timed) {
   uv_loop_t* loop = uv_default_loop();
 
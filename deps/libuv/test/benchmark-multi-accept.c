@@ -63,6 +63,19 @@ struct ipc_client_ctx {
   char scratch[16];
 };
 
+/* How the worker threads obtain their listen socket:
+ *
+ *  SHARED_HANDLE     one socket, handed out over IPC, all threads accept on it.
+ *  REUSEPORT         each thread binds its own socket with UV_TCP_REUSEPORT
+ *                    and the kernel spreads incoming connections over them.
+ *  REUSEPORT_PINNED  like REUSEPORT, but each thread is also pinned to a CPU.
+ */
+enum accept_mode {
+  SHARED_HANDLE,
+  REUSEPORT,
+  REUSEPORT_PINNED
+};
+
 /* Used in the actual benchmark. */
 struct server_ctx {
   handle_storage_t server_handle;
@@ -70,6 +83,9 @@ struct server_ctx {
   uv_async_t async_handle;
   uv_thread_t thread_id;
   uv_sem_t semaphore;
+  enum accept_mode mode;
+  int cpu;
+  uint64_t pool_allocs;
 };
 
 struct client_ctx {
@@ -250,7 +266,40 @@ static void get_listen_handle(uv_loop_t* loop, uv_stream_t* server_handle) {
 }
 
 
+static void bind_listen_handle(uv_loop_t* loop, struct server_ctx* ctx) {
+  uv_tcp_t* server_handle;
+
+  server_handle = (uv_tcp_t*) &ctx->server_handle;
+  server_handle->data = "server handle";
+
+  ASSERT(0 == uv_tcp_init(loop, server_handle));
+  ASSERT(0 == uv_tcp_bind(server_handle,
+                          (const struct sockaddr*) &listen_addr,
+                          UV_TCP_REUSEPORT));
+}
+
+
+static void pin_thread(int cpu) {
+  uv_thread_t self;
+  char* cpumask;
+  int masksize;
+
+  masksize = uv_cpumask_size();
+  ASSERT(masksize > 0);
+  ASSERT(cpu < masksize);
+
+  cpumask = calloc(masksize, 1);
+  ASSERT(cpumask != NULL);
+  cpumask[cpu] = 1;
+
+  self = uv_thread_self();
+  ASSERT(0 == uv_thread_setaffinity(&self, cpumask, NULL, masksize));
+  free(cpumask);
+}
+
+
 static void server_cb(void *arg) {
+  uv_loop_metrics_t metrics;
   struct server_ctx *ctx;
   uv_loop_t loop;
 
@@ -260,17 +309,30 @@ static void server_cb(void *arg) {
   ASSERT(0 == uv_async_init(&loop, &ctx->async_handle, sv_async_cb));
   uv_unref((uv_handle_t*) &ctx->async_handle);
 
-  /* Wait until the main thread is ready. */
-  uv_sem_wait(&ctx->semaphore);
-  get_listen_handle(&loop, (uv_stream_t*) &ctx->server_handle);
-  uv_sem_post(&ctx->semaphore);
+  if (ctx->mode == SHARED_HANDLE) {
+    /* Wait until the main thread is ready. */
+    uv_sem_wait(&ctx->semaphore);
+    get_listen_handle(&loop, (uv_stream_t*) &ctx->server_handle);
+  } else {
+    if (ctx->mode == REUSEPORT_PINNED)
+      pin_thread(ctx->cpu);
+    bind_listen_handle(&loop, ctx);
+  }
 
-  /* Now start the actual benchmark. */
+  /* Listen before signalling the main thread, the clients connect as soon
+   * as every thread has checked in.
+   */
   ASSERT(0 == uv_listen((uv_stream_t*) &ctx->server_handle,
                         128,
                         sv_connection_cb));
+  uv_sem_post(&ctx->semaphore);
+
+  /* Now start the actual benchmark. */
   ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
 
+  ASSERT(0 == uv_loop_metrics(&loop, &metrics));
+  ctx->pool_allocs = metrics.pool_allocs;
+
   uv_loop_close(&loop);
 }
 
@@ -284,24 +346,26 @@ static void sv_async_cb(uv_async_t* handle) {
 
 
 static void sv_connection_cb(uv_stream_t* server_handle, int status) {
-  handle_storage_t* storage;
+  uv_stream_t* stream;
   struct server_ctx* ctx;
 
   ctx = container_of(server_handle, struct server_ctx, server_handle);
   ASSERT(status == 0);
 
-  storage = malloc(sizeof(*storage));
-  ASSERT(storage != NULL);
-
-  if (server_handle->type == UV_TCP)
-    ASSERT(0 == uv_tcp_init(server_handle->loop, (uv_tcp_t*) storage));
-  else if (server_handle->type == UV_NAMED_PIPE)
-    ASSERT(0 == uv_pipe_init(server_handle->loop, (uv_pipe_t*) storage, 0));
-  else
+  /* TCP handles come from the loop's pool and go back to it on close. */
+  if (server_handle->type == UV_TCP) {
+    stream = (uv_stream_t*) uv_tcp_alloc(server_handle->loop);
+    ASSERT(stream != NULL);
+  } else if (server_handle->type == UV_NAMED_PIPE) {
+    stream = malloc(sizeof(uv_pipe_t));
+    ASSERT(stream != NULL);
+    ASSERT(0 == uv_pipe_init(server_handle->loop, (uv_pipe_t*) stream, 0));
+  } else {
     ASSERT(0);
+  }
 
-  ASSERT(0 == uv_accept(server_handle, (uv_stream_t*) storage));
-  ASSERT(0 == uv_read_start((uv_stream_t*) storage, sv_alloc_cb, sv_read_cb));
+  ASSERT(0 == uv_accept(server_handle, stream));
+  ASSERT(0 == uv_read_start(stream, sv_alloc_cb, sv_read_cb));
   ctx->num_connects++;
 }
 
@@ -319,7 +383,10 @@ static void sv_read_cb(uv_stream_t* handle,
                        ssize_t nread,
                        const uv_buf_t* buf) {
   ASSERT(nread == UV_EOF);
-  uv_close((uv_handle_t*) handle, (uv_close_cb) free);
+  if (handle->type == UV_TCP)
+    uv_close((uv_handle_t*) handle, NULL);
+  else
+    uv_close((uv_handle_t*) handle, (uv_close_cb) free);
 }
 
 
@@ -355,12 +422,20 @@ static void cl_close_cb(uv_handle_t* handle) {
 }
 
 
-static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
+static int test_tcp(unsigned int num_servers,
+                    unsigned int num_clients,
+                    enum accept_mode mode) {
+  static const char* const mode_names[] = {
+    "", "_reuseport", "_reuseport_pinned"
+  };
   struct server_ctx* servers;
   struct client_ctx* clients;
+  uv_cpu_info_t* cpus;
   uv_loop_t* loop;
   uv_tcp_t* handle;
   unsigned int i;
+  size_t rss;
+  int ncpus;
   double time;
 
   ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &listen_addr));
@@ -371,17 +446,30 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
   ASSERT(servers != NULL);
   ASSERT(clients != NULL);
 
+  ncpus = 1;
+  if (mode == REUSEPORT_PINNED) {
+    ASSERT(0 == uv_cpu_info(&cpus, &ncpus));
+    uv_free_cpu_info(cpus, ncpus);
+  }
+
   /* We're making the assumption here that from the perspective of the
    * OS scheduler, threads are functionally equivalent to and interchangeable
    * with full-blown processes.
    */
   for (i = 0; i < num_servers; i++) {
     struct server_ctx* ctx = servers + i;
+    ctx->mode = mode;
+    ctx->cpu = i % ncpus;
     ASSERT(0 == uv_sem_init(&ctx->semaphore, 0));
     ASSERT(0 == uv_thread_create(&ctx->thread_id, server_cb, ctx));
   }
 
-  send_listen_handles(UV_TCP, num_servers, servers);
+  if (mode == SHARED_HANDLE) {
+    send_listen_handles(UV_TCP, num_servers, servers);
+  } else {
+    for (i = 0; i < num_servers; i++)
+      uv_sem_wait(&servers[i].semaphore);
+  }
 
   for (i = 0; i < num_clients; i++) {
     struct client_ctx* ctx = clients + i;
@@ -410,18 +498,23 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
     uv_sem_destroy(&ctx->semaphore);
   }
 
-  printf("accept%u: %.0f accepts/sec (%u total)\n",
+  ASSERT(0 == uv_resident_set_memory(&rss));
+  printf("accept%u%s: %.0f accepts/sec (%u total, %.1f MB RSS)\n",
          num_servers,
+         mode_names[mode],
          NUM_CONNECTS / time,
-         NUM_CONNECTS);
+         NUM_CONNECTS,
+         rss / 1e6);
 
   for (i = 0; i < num_servers; i++) {
     struct server_ctx* ctx = servers + i;
-    printf("  thread #%u: %.0f accepts/sec (%u total, %.1f%%)\n",
+    printf("  thread #%u: %.0f accepts/sec (%u total, %.1f%%, "
+           "%u handles allocated)\n",
            i,
            ctx->num_connects / time,
            ctx->num_connects,
-           ctx->num_connects * 100.0 / NUM_CONNECTS);
+           ctx->num_connects * 100.0 / NUM_CONNECTS,
+           (unsigned int) ctx->pool_allocs);
   }
 
   free(clients);
@@ -433,15 +526,35 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
 
 
 BENCHMARK_IMPL(tcp_multi_accept2) {
-  return test_tcp(2, 40);
+  return test_tcp(2, 40, SHARED_HANDLE);
 }
 
 
 BENCHMARK_IMPL(tcp_multi_accept4) {
-  return test_tcp(4, 40);
+  return test_tcp(4, 40, SHARED_HANDLE);
 }
 
 
 BENCHMARK_IMPL(tcp_multi_accept8) {
-  return test_tcp(8, 40);
+  return test_tcp(8, 40, SHARED_HANDLE);
+}
+
+
+BENCHMARK_IMPL(tcp_reuseport_accept2) {
+  return test_tcp(2, 40, REUSEPORT);
+}
+
+
+BENCHMARK_IMPL(tcp_reuseport_accept4) {
+  return test_tcp(4, 40, REUSEPORT);
+}
+
+
+BENCHMARK_IMPL(tcp_reuseport_accept8) {
+  return test_tcp(8, 40, REUSEPORT);
+}
+
+
+BENCHMARK_IMPL(tcp_reuseport_pinned_accept4) {
+  return test_tcp(4, 40, REUSEPORT_PINNED);
 }
@@ -73,6 +73,27 @@ static char write_buffer[WRITE_BUFFER_SIZE];
 
 static stream_type type;
 
+/* When set, the client behaves like the upstream leg of a proxy: it reads
+ * from its connections and writes from outside the write callback, once per
+ * loop iteration. The server never writes so nothing actually arrives but the
+ * connections stay registered for readability while every write that doesn't
+ * complete immediately toggles writability on and off.
+ */
+static int duplex;
+static uv_prepare_t duplex_handle;
+
+/* How the server allocates its read buffers: from the benchmark's own free
+ * list, with a malloc() and free() per read like most embedders do, or from
+ * the loop's read buffer pool with read batching turned on.
+ */
+static enum {
+  BUF_FREELIST,
+  BUF_MALLOC,
+  BUF_POOL
+} buf_mode;
+static int64_t buf_mallocs;
+static int64_t nreads;
+
 static uv_tcp_t tcp_write_handles[MAX_WRITE_HANDLES];
 static uv_pipe_t pipe_write_handles[MAX_WRITE_HANDLES];
 
@@ -86,6 +107,7 @@ static double gbit(int64_t bytes, int64_t passed_ms) {
 
 
 static void show_stats(uv_timer_t* handle) {
+  uv_loop_metrics_t metrics;
   int64_t diff;
   int i;
 
@@ -102,10 +124,14 @@ static void show_stats(uv_timer_t* handle) {
     uv_update_time(loop);
     diff = uv_now(loop) - start_time;
 
-    fprintf(stderr, "%s_pump%d_client: %.1f gbit/s\n",
+    ASSERT(0 == uv_loop_metrics(loop, &metrics));
+
+    fprintf(stderr, "%s_%spump%d_client: %.1f gbit/s, %.3f poll_ctl/write\n",
             type == TCP ? "tcp" : "pipe",
+            duplex ? "duplex_" : "",
             write_sockets,
-            gbit(nsent_total, diff));
+            gbit(nsent_total, diff),
+            (double) metrics.poll_ctl / (nsent_total / sizeof write_buffer));
     fflush(stderr);
 
     for (i = 0; i < write_sockets; i++) {
@@ -125,15 +151,27 @@ static void show_stats(uv_timer_t* handle) {
 
 
 static void read_show_stats(void) {
+  uv_loop_metrics_t metrics;
+  static const char* const modes[] = { "", "malloc_", "pool_" };
+  double mb;
   int64_t diff;
 
   uv_update_time(loop);
   diff = uv_now(loop) - start_time;
 
-  fprintf(stderr, "%s_pump%d_server: %.1f gbit/s\n",
+  ASSERT(0 == uv_loop_metrics(loop, &metrics));
+  if (buf_mode == BUF_POOL)
+    buf_mallocs = metrics.read_buf_allocs;
+
+  mb = (double) nrecv_total / (1024 * 1024);
+  fprintf(stderr,
+          "%s_%spump%d_server: %.1f gbit/s, %.3f allocs/MB, %.1f reads/MB\n",
           type == TCP ? "tcp" : "pipe",
+          modes[buf_mode],
           max_read_sockets,
-          gbit(nrecv_total, diff));
+          gbit(nrecv_total, diff),
+          buf_mallocs / mb,
+          nreads / mb);
   fflush(stderr);
 }
 
@@ -182,11 +220,22 @@ static void read_cb(uv_stream_t* stream, ssize_t bytes, const uv_buf_t* buf) {
 
   buf_free(buf);
 
+  if (bytes > 0)
+    nreads++;
   nrecv += bytes;
   nrecv_total += bytes;
 }
 
 
+static void client_read_cb(uv_stream_t* stream,
+                           ssize_t bytes,
+                           const uv_buf_t* buf) {
+  ASSERT(bytes <= 0);
+  if (buf->base != NULL)
+    buf_free(buf);
+}
+
+
 static void write_cb(uv_write_t* req, int status) {
   ASSERT(status == 0);
 
@@ -195,7 +244,28 @@ static void write_cb(uv_write_t* req, int status) {
   nsent += sizeof write_buffer;
   nsent_total += sizeof write_buffer;
 
-  do_write((uv_stream_t*) req->handle);
+  if (duplex)
+    req->handle->data = NULL;  /* Picked up by duplex_cb(). */
+  else
+    do_write((uv_stream_t*) req->handle);
+}
+
+
+static void duplex_cb(uv_prepare_t* handle) {
+  uv_stream_t* stream;
+  int i;
+
+  for (i = 0; i < write_sockets; i++) {
+    if (type == TCP)
+      stream = (uv_stream_t*) &tcp_write_handles[i];
+    else
+      stream = (uv_stream_t*) &pipe_write_handles[i];
+
+    if (stream->data == NULL) {
+      stream->data = stream;
+      do_write(stream);
+    }
+  }
 }
 
 
@@ -215,6 +285,7 @@ static void do_write(uv_stream_t* stream) {
 
 static void connect_cb(uv_connect_t* req, int status) {
   int i;
+  int r;
 
   if (status) {
     fprintf(stderr, "%s", uv_strerror(status));
@@ -223,6 +294,12 @@ static void connect_cb(uv_connect_t* req, int status) {
   ASSERT(status == 0);
 
   write_sockets++;
+
+  if (duplex) {
+    r = uv_read_start(req->handle, buf_alloc, client_read_cb);
+    ASSERT(r == 0);
+  }
+
   req_free((uv_req_t*) req);
 
   maybe_connect_some();
@@ -231,6 +308,12 @@ static void connect_cb(uv_connect_t* req, int status) {
     start_stats_collection();
 
     /* Yay! start writing */
+    if (duplex) {
+      ASSERT(0 == uv_prepare_init(loop, &duplex_handle));
+      ASSERT(0 == uv_prepare_start(&duplex_handle, duplex_cb));
+      return;
+    }
+
     for (i = 0; i < write_sockets; i++) {
       if (type == TCP)
         do_write((uv_stream_t*) &tcp_write_handles[i]);
@@ -294,7 +377,12 @@ static void connection_cb(uv_stream_t* s, int status) {
   r = uv_accept(s, stream);
   ASSERT(r == 0);
 
-  r = uv_read_start(stream, buf_alloc, read_cb);
+  if (buf_mode == BUF_POOL) {
+    ASSERT(0 == uv_stream_set_read_batching(stream, 1));
+    r = uv_read_start(stream, uv_read_buf_alloc, read_cb);
+  } else {
+    r = uv_read_start(stream, buf_alloc, read_cb);
+  }
   ASSERT(r == 0);
 
   read_sockets++;
@@ -353,10 +441,17 @@ static buf_list_t* buf_freelist = NULL;
 static void buf_alloc(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
   buf_list_t* ab;
 
+  if (buf_mode == BUF_MALLOC) {
+    buf_mallocs++;
+    *buf = uv_buf_init(malloc(size), size);
+    return;
+  }
+
   ab = buf_freelist;
   if (ab != NULL)
     buf_freelist = ab->next;
   else {
+    buf_mallocs++;
     ab = malloc(size + sizeof(*ab));
     ab->uv_buf_t.len = size;
     ab->uv_buf_t.base = (char*) (ab + 1);
@@ -367,16 +462,29 @@ static void buf_alloc(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
 
 
 static void buf_free(const uv_buf_t* buf) {
-  buf_list_t* ab = (buf_list_t*) buf->base - 1;
+  buf_list_t* ab;
+
+  if (buf_mode == BUF_MALLOC) {
+    free(buf->base);
+    return;
+  }
+
+  if (buf_mode == BUF_POOL) {
+    uv_read_buf_unref(buf->base);
+    return;
+  }
+
+  ab = (buf_list_t*) buf->base - 1;
   ab->next = buf_freelist;
   buf_freelist = ab;
 }
 
 
-HELPER_IMPL(tcp_pump_server) {
+static int tcp_pump_server(int mode) {
   int r;
 
   type = TCP;
+  buf_mode = mode;
   loop = uv_default_loop();
 
   ASSERT(0 == uv_ip4_addr("0.0.0.0", TEST_PORT, &listen_addr));
@@ -396,9 +504,10 @@ HELPER_IMPL(tcp_pump_server) {
 }
 
 
-HELPER_IMPL(pipe_pump_server) {
+static int pipe_pump_server(int mode) {
   int r;
   type = PIPE;
+  buf_mode = mode;
 
   loop = uv_default_loop();
 
@@ -418,8 +527,39 @@ HELPER_IMPL(pipe_pump_server) {
 }
 
 
-static void tcp_pump(int n) {
+HELPER_IMPL(tcp_pump_server) {
+  return tcp_pump_server(BUF_FREELIST);
+}
+
+
+HELPER_IMPL(tcp_pump_malloc_server) {
+  return tcp_pump_server(BUF_MALLOC);
+}
+
+
+HELPER_IMPL(tcp_pump_pool_server) {
+  return tcp_pump_server(BUF_POOL);
+}
+
+
+HELPER_IMPL(pipe_pump_server) {
+  return pipe_pump_server(BUF_FREELIST);
+}
+
+
+HELPER_IMPL(pipe_pump_malloc_server) {
+  return pipe_pump_server(BUF_MALLOC);
+}
+
+
+HELPER_IMPL(pipe_pump_pool_server) {
+  return pipe_pump_server(BUF_POOL);
+}
+
+
+static void tcp_pump(int n, int full_duplex) {
   ASSERT(n <= MAX_WRITE_HANDLES);
+  duplex = full_duplex;
   TARGET_CONNECTIONS = n;
   type = TCP;
 
@@ -436,8 +576,9 @@ static void tcp_pump(int n) {
 }
 
 
-static void pipe_pump(int n) {
+static void pipe_pump(int n, int full_duplex) {
   ASSERT(n <= MAX_WRITE_HANDLES);
+  duplex = full_duplex;
   TARGET_CONNECTIONS = n;
   type = PIPE;
 
@@ -453,24 +594,60 @@ static void pipe_pump(int n) {
 
 
 BENCHMARK_IMPL(tcp_pump100_client) {
-  tcp_pump(100);
+  tcp_pump(100, 0);
   return 0;
 }
 
 
 BENCHMARK_IMPL(tcp_pump1_client) {
-  tcp_pump(1);
+  tcp_pump(1, 0);
   return 0;
 }
 
 
 BENCHMARK_IMPL(pipe_pump100_client) {
-  pipe_pump(100);
+  pipe_pump(100, 0);
   return 0;
 }
 
 
 BENCHMARK_IMPL(pipe_pump1_client) {
-  pipe_pump(1);
+  pipe_pump(1, 0);
+  return 0;
+}
+
+
+BENCHMARK_IMPL(tcp_duplex_pump100_client) {
+  tcp_pump(100, 1);
+  return 0;
+}
+
+
+BENCHMARK_IMPL(pipe_duplex_pump100_client) {
+  pipe_pump(100, 1);
+  return 0;
+}
+
+
+BENCHMARK_IMPL(tcp_pump100_malloc_client) {
+  tcp_pump(100, 0);
+  return 0;
+}
+
+
+BENCHMARK_IMPL(tcp_pump100_pool_client) {
+  tcp_pump(100, 0);
+  return 0;
+}
+
+
+BENCHMARK_IMPL(pipe_pump100_malloc_client) {
+  pipe_pump(100, 0);
+  return 0;
+}
+
+
+BENCHMARK_IMPL(pipe_pump100_pool_client) {
+  pipe_pump(100, 0);
   return 0;
 }
@@ -0,0 +1,214 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+# include <fcntl.h>
+#endif
+
+#define FILE_NAME   "benchmark_sendfile_file"
+#define FILE_SIZE   (64 * 1024 * 1024)
+#define CHUNK_SIZE  (64 * 1024)
+#define NUM_SENDS   16
+
+static uv_tcp_t tcp_client;
+static uv_connect_t connect_req;
+static uv_write_t write_req;
+static uv_shutdown_t shutdown_req;
+
+static uv_file file;
+static char* chunk;
+static int64_t file_offset;
+static int sends;
+static int use_sendfile;
+
+static void write_cb(uv_write_t* req, int status);
+
+
+static void close_cb(uv_handle_t* handle) {
+}
+
+
+static void shutdown_cb(uv_shutdown_t* req, int status) {
+  ASSERT(status == 0);
+  uv_close((uv_handle_t*) &tcp_client, close_cb);
+}
+
+
+static void send_next(void) {
+  uv_fs_t fs_req;
+  uv_buf_t buf;
+  int r;
+
+  if (file_offset == FILE_SIZE) {
+    file_offset = 0;
+    sends++;
+  }
+
+  if (sends == NUM_SENDS) {
+    r = uv_shutdown(&shutdown_req, (uv_stream_t*) &tcp_client, shutdown_cb);
+    ASSERT(r == 0);
+    return;
+  }
+
+  if (use_sendfile) {
+    r = uv_stream_sendfile(&write_req,
+                           (uv_stream_t*) &tcp_client,
+                           file,
+                           0,
+                           FILE_SIZE,
+                           write_cb);
+    ASSERT(r == 0);
+    file_offset = FILE_SIZE;
+    return;
+  }
+
+  /* The copying way: read a chunk into user memory, then write it out. */
+  buf = uv_buf_init(chunk, CHUNK_SIZE);
+  r = uv_fs_read(NULL, &fs_req, file, &buf, 1, file_offset, NULL);
+  ASSERT(r == CHUNK_SIZE);
+  uv_fs_req_cleanup(&fs_req);
+
+  r = uv_write(&write_req, (uv_stream_t*) &tcp_client, &buf, 1, write_cb);
+  ASSERT(r == 0);
+  file_offset += CHUNK_SIZE;
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  send_next();
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  send_next();
+}
+
+
+static void make_file(void) {
+  uv_fs_t req;
+  uv_buf_t buf;
+  int64_t off;
+  int r;
+
+  chunk = malloc(CHUNK_SIZE);
+  ASSERT(chunk != NULL);
+  memset(chunk, 'x', CHUNK_SIZE);
+
+  file = uv_fs_open(NULL,
+                    &req,
+                    FILE_NAME,
+                    O_RDWR | O_CREAT | O_TRUNC,
+                    S_IRUSR | S_IWUSR,
+                    NULL);
+  ASSERT(file >= 0);
+  uv_fs_req_cleanup(&req);
+
+  buf = uv_buf_init(chunk, CHUNK_SIZE);
+  for (off = 0; off < FILE_SIZE; off += CHUNK_SIZE) {
+    r = uv_fs_write(NULL, &req, file, &buf, 1, off, NULL);
+    ASSERT(r == CHUNK_SIZE);
+    uv_fs_req_cleanup(&req);
+  }
+}
+
+
+static void remove_file(void) {
+  uv_fs_t req;
+
+  uv_fs_close(NULL, &req, file, NULL);
+  uv_fs_req_cleanup(&req);
+  uv_fs_unlink(NULL, &req, FILE_NAME, NULL);
+  uv_fs_req_cleanup(&req);
+  free(chunk);
+}
+
+
+static double cpu_time(void) {
+  uv_rusage_t ru;
+
+  ASSERT(0 == uv_getrusage(&ru));
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+         ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+
+static int sendfile_bench(int sendfile) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+  uint64_t start;
+  uint64_t stop;
+  double cpu;
+  double mb;
+  int r;
+
+  make_file();
+  use_sendfile = sendfile;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(loop, &tcp_client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &tcp_client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  cpu = cpu_time();
+  start = uv_hrtime();
+
+  r = uv_run(loop, UV_RUN_DEFAULT);
+  ASSERT(r == 0);
+
+  stop = uv_hrtime();
+  cpu = cpu_time() - cpu;
+
+  ASSERT(sends == NUM_SENDS);
+  remove_file();
+
+  mb = (double) FILE_SIZE * NUM_SENDS / (1024 * 1024);
+  printf("%s: %.0f MB in %.2fs, %.1f MB/s, %.2fs cpu\n",
+         sendfile ? "sendfile" : "read+write",
+         mb,
+         (stop - start) / 1e9,
+         mb / ((stop - start) / 1e9),
+         cpu);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(tcp_sendfile) {
+  return sendfile_bench(1);
+}
+
+
+BENCHMARK_IMPL(tcp_sendfile_copy) {
+  return sendfile_bench(0);
+}
@@ -19,13 +19,20 @@
  * IN THE SOFTWARE.
  */
 
-/* This benchmark spawns itself 1000 times. */
+/* This benchmark spawns itself 1000 times. The large_heap variants first
+ * allocate and touch LARGE_HEAP_SIZE bytes, which is what makes fork()
+ * expensive: every spawn copies the page tables of the parent.
+ */
 
 #include "task.h"
 #include "uv.h"
 
+#include <string.h>
+
 static uv_loop_t* loop;
 
+#define LARGE_HEAP_SIZE ((size_t) 4 << 30)
+
 static int N = 1000;
 static int done;
 
@@ -134,10 +141,19 @@ static void spawn(void) {
 }
 
 
-BENCHMARK_IMPL(spawn) {
+static int spawn_bench(const char* name, size_t heap_size, int count) {
   int r;
   static int64_t start_time, end_time;
+  char* heap;
 
+  heap = NULL;
+  if (heap_size > 0) {
+    heap = malloc(heap_size);
+    ASSERT(heap != NULL);
+    memset(heap, 1, heap_size);
+  }
+
+  N = count;
   loop = uv_default_loop();
 
   r = uv_exepath(exepath, &exepath_size);
@@ -155,10 +171,34 @@ BENCHMARK_IMPL(spawn) {
   uv_update_time(loop);
   end_time = uv_now(loop);
 
-  fprintf(stderr, "spawn: %.0f spawns/s\n",
+  fprintf(stderr, "%s: %.0f spawns/s\n",
+          name,
           (double) N / (double) (end_time - start_time) * 1000.0);
   fflush(stderr);
 
+  free(heap);
+
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+BENCHMARK_IMPL(spawn) {
+  return spawn_bench("spawn", 0, 1000);
+}
+
+
+BENCHMARK_IMPL(spawn_large_heap) {
+  return spawn_bench("spawn_large_heap", LARGE_HEAP_SIZE, 200);
+}
+
+
+BENCHMARK_IMPL(spawn_large_heap_fork) {
+#ifdef _WIN32
+  RETURN_SKIP("Windows doesn't fork().");
+#else
+  /* Takes the fork() + execvp() path even where posix_spawn() is used. */
+  setenv("UV_SPAWN_USE_FORK", "1", 1);
+  return spawn_bench("spawn_large_heap_fork", LARGE_HEAP_SIZE, 200);
+#endif
+}
@@ -94,7 +94,8 @@ static void close_cb(uv_handle_t* handle) {
 }
 
 
-BENCHMARK_IMPL(tcp_write_batch) {
+static int tcp_write_batch(int coalesce) {
+  uv_loop_metrics_t metrics;
   struct sockaddr_in addr;
   uv_loop_t* loop;
   uint64_t start;
@@ -117,6 +118,9 @@ BENCHMARK_IMPL(tcp_write_batch) {
   r = uv_tcp_init(loop, &tcp_client);
   ASSERT(r == 0);
 
+  r = uv_stream_set_write_coalescing((uv_stream_t*) &tcp_client, coalesce);
+  ASSERT(r == 0);
+
   r = uv_tcp_connect(&connect_req,
                      &tcp_client,
                      (const struct sockaddr*) &addr,
@@ -135,10 +139,23 @@ BENCHMARK_IMPL(tcp_write_batch) {
   ASSERT(shutdown_cb_called == 1);
   ASSERT(close_cb_called == 1);
 
-  printf("%ld write requests in %.2fs.\n",
+  ASSERT(0 == uv_loop_metrics(loop, &metrics));
+
+  printf("%ld write requests in %.2fs, %.4f syscalls per request.\n",
          (long)NUM_WRITE_REQS,
-         (stop - start) / 1e9);
+         (stop - start) / 1e9,
+         (double) metrics.stream_writes / NUM_WRITE_REQS);
 
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+BENCHMARK_IMPL(tcp_write_batch) {
+  return tcp_write_batch(0);
+}
+
+
+BENCHMARK_IMPL(tcp_write_batch_coalesced) {
+  return tcp_write_batch(1);
+}
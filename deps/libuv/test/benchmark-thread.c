@@ -26,8 +26,11 @@
 #include <stdlib.h>
 
 #define NUM_THREADS (20 * 1000)
+#define NUM_WORK_REQS (200 * 1000)
+#define MAX_CONCURRENT_WORK_REQS 256
 
 static volatile int num_threads;
+static int work_reqs_left;
 
 
 static void thread_entry(void* arg) {
@@ -62,3 +65,60 @@ BENCHMARK_IMPL(thread_create) {
 
   return 0;
 }
+
+
+static void work_cb(uv_work_t* req) {
+  volatile unsigned int i;
+
+  /* Just enough work to make the queueing overhead measurable. */
+  for (i = 0; i < 1000; i++);
+}
+
+
+static void after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+
+  if (work_reqs_left == 0)
+    return;
+
+  work_reqs_left--;
+  ASSERT(0 == uv_queue_work(req->loop, req, work_cb, after_work_cb));
+}
+
+
+/* Measures how well uv_queue_work() throughput scales with the size of the
+ * thread pool. Every run gets a private pool through uv_loop_configure().
+ */
+BENCHMARK_IMPL(thread_pool_scaling) {
+  uv_work_t reqs[MAX_CONCURRENT_WORK_REQS];
+  unsigned int nthreads;
+  uint64_t start_time;
+  double duration;
+  uv_loop_t loop;
+  unsigned int i;
+
+  for (nthreads = 1; nthreads <= 64; nthreads *= 2) {
+    ASSERT(0 == uv_loop_init(&loop));
+    ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_THREADPOOL_SIZE, nthreads));
+
+    work_reqs_left = NUM_WORK_REQS - ARRAY_SIZE(reqs);
+    start_time = uv_hrtime();
+
+    for (i = 0; i < ARRAY_SIZE(reqs); i++)
+      ASSERT(0 == uv_queue_work(&loop, reqs + i, work_cb, after_work_cb));
+
+    ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+    duration = (uv_hrtime() - start_time) / 1e9;
+    ASSERT(0 == uv_loop_close(&loop));
+
+    printf("%2u threads: %d work reqs in %.2f seconds (%.0f/s)\n",
+           nthreads,
+           NUM_WORK_REQS,
+           duration,
+           NUM_WORK_REQS / duration);
+    fflush(stdout);
+  }
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
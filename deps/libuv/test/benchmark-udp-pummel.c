@@ -32,9 +32,12 @@
 
 #define BASE_PORT 12345
 
+/* Sends each sender keeps in flight in the windowed modes. */
+#define SEND_WINDOW 32
+
 struct sender_state {
   struct sockaddr_in addr;
-  uv_udp_send_t send_req;
+  uv_udp_send_t send_reqs[SEND_WINDOW];
   uv_udp_t udp_handle;
 };
 
@@ -62,10 +65,11 @@ static int exiting;
 static void alloc_cb(uv_handle_t* handle,
                      size_t suggested_size,
                      uv_buf_t* buf) {
-  static char slab[65536];
+  /* Big enough for a full recvmmsg() batch. */
+  static char slab[20 * 65536];
   ASSERT(suggested_size <= sizeof(slab));
   buf->base = slab;
-  buf->len = sizeof(slab);
+  buf->len = suggested_size;
 }
 
 
@@ -82,8 +86,7 @@ static void send_cb(uv_udp_send_t* req, int status) {
   if (exiting)
     return;
 
-  s = container_of(req, struct sender_state, send_req);
-  ASSERT(req->handle == &s->udp_handle);
+  s = container_of(req->handle, struct sender_state, udp_handle);
 
   if (timed)
     goto send;
@@ -96,7 +99,7 @@ static void send_cb(uv_udp_send_t* req, int status) {
   packet_counter--;
 
 send:
-  ASSERT(0 == uv_udp_send(&s->send_req,
+  ASSERT(0 == uv_udp_send(req,
                           &s->udp_handle,
                           bufs,
                           ARRAY_SIZE(bufs),
@@ -147,11 +150,14 @@ static void timeout_cb(uv_timer_t* timer) {
 
 static int pummel(unsigned int n_senders,
                   unsigned int n_receivers,
-                  unsigned long timeout) {
+                  unsigned long timeout,
+                  unsigned int window,
+                  int mmsg) {
   uv_timer_t timer_handle;
   uint64_t duration;
   uv_loop_t* loop;
   unsigned int i;
+  unsigned int j;
 
   ASSERT(n_senders <= ARRAY_SIZE(senders));
   ASSERT(n_receivers <= ARRAY_SIZE(receivers));
@@ -173,7 +179,9 @@ static int pummel(unsigned int n_senders,
     struct receiver_state* s = receivers + i;
     struct sockaddr_in addr;
     ASSERT(0 == uv_ip4_addr("0.0.0.0", BASE_PORT + i, &addr));
-    ASSERT(0 == uv_udp_init(loop, &s->udp_handle));
+    ASSERT(0 == uv_udp_init_ex(loop,
+                               &s->udp_handle,
+                               mmsg ? UV_UDP_RECVMMSG : AF_UNSPEC));
     ASSERT(0 == uv_udp_bind(&s->udp_handle, (const struct sockaddr*) &addr, 0));
     ASSERT(0 == uv_udp_recv_start(&s->udp_handle, alloc_cb, recv_cb));
     uv_unref((uv_handle_t*)&s->udp_handle);
@@ -190,13 +198,16 @@ static int pummel(unsigned int n_senders,
     ASSERT(0 == uv_ip4_addr("127.0.0.1",
                             BASE_PORT + (i % n_receivers),
                             &s->addr));
-    ASSERT(0 == uv_udp_init(loop, &s->udp_handle));
-    ASSERT(0 == uv_udp_send(&s->send_req,
-                            &s->udp_handle,
-                            bufs,
-                            ARRAY_SIZE(bufs),
-                            (const struct sockaddr*) &s->addr,
-                            send_cb));
+    ASSERT(0 == uv_udp_init_ex(loop,
+                               &s->udp_handle,
+                               mmsg ? UV_UDP_SENDMMSG : AF_UNSPEC));
+    for (j = 0; j < window; j++)
+      ASSERT(0 == uv_udp_send(&s->send_reqs[j],
+                              &s->udp_handle,
+                              bufs,
+                              ARRAY_SIZE(bufs),
+                              (const struct sockaddr*) &s->addr,
+                              send_cb));
   }
 
   duration = uv_hrtime();
@@ -205,8 +216,9 @@ static int pummel(unsigned int n_senders,
   /* convert from nanoseconds to milliseconds */
   duration = duration / (uint64_t) 1e6;
 
-  printf("udp_pummel_%dv%d: %.0f/s received, %.0f/s sent. "
+  printf("udp_pummel_%s%dv%d: %.0f/s received, %.0f/s sent. "
          "%u received, %u sent in %.1f seconds.\n",
+         mmsg ? "mmsg_" : window > 1 ? "window_" : "",
          n_receivers,
          n_senders,
          recv_cb_called / (duration / 1000.0),
@@ -222,10 +234,10 @@ static int pummel(unsigned int n_senders,
 
 #define X(a, b)                                                               \
   BENCHMARK_IMPL(udp_pummel_##a##v##b) {                                      \
-    return pummel(a, b, 0);                                                   \
+    return pummel(a, b, 0, 1, 0);                                             \
   }                                                                           \
   BENCHMARK_IMPL(udp_timed_pummel_##a##v##b) {                                \
-    return pummel(a, b, TEST_DURATION);                                       \
+    return pummel(a, b, TEST_DURATION, 1, 0);                                 \
   }
 
 X(1, 1)
@@ -241,3 +253,19 @@ X(100, 1000)
 X(1000, 1000)
 
 #undef X
+
+/* Same traffic with SEND_WINDOW sends in flight per sender, one datagram per
+ * syscall versus batched with recvmmsg() and sendmmsg().
+ */
+#define X(a, b)                                                               \
+  BENCHMARK_IMPL(udp_timed_pummel_window_##a##v##b) {                         \
+    return pummel(a, b, TEST_DURATION, SEND_WINDOW, 0);                       \
+  }                                                                           \
+  BENCHMARK_IMPL(udp_timed_pummel_mmsg_##a##v##b) {                           \
+    return pummel(a, b, TEST_DURATION, SEND_WINDOW, 1);                       \
+  }
+
+X(1, 1)
+X(10, 10)
+
+#undef X
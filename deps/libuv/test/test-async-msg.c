@@ -0,0 +1,202 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdlib.h>
+
+#define NUM_THREADS   4
+#define NUM_MSGS      10000
+#define NUM_HANDLES   1000
+
+struct msg {
+  uv_async_msg_t base;
+  unsigned int thread;
+  unsigned int seq;
+};
+
+static uv_async_t msg_handle;
+static uv_async_t handles[NUM_HANDLES];
+static int handle_cb_called[NUM_HANDLES];
+static unsigned int next_seq[NUM_THREADS];
+static unsigned int msgs_received;
+static int close_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void sender(void* arg) {
+  struct msg* msgs;
+  unsigned int i;
+
+  msgs = arg;
+  for (i = 0; i < NUM_MSGS; i++)
+    ASSERT(0 == uv_async_send_msg(&msg_handle, &msgs[i].base));
+}
+
+
+static void msg_cb(uv_async_t* handle, uv_async_msg_t* base) {
+  struct msg* msg;
+
+  msg = container_of(base, struct msg, base);
+  ASSERT(handle == &msg_handle);
+  ASSERT(msg->base.data == &msg_handle);
+  ASSERT(msg->thread < NUM_THREADS);
+  /* Messages from one thread arrive in the order they were sent. The last
+   * one closes the handle while the other senders may still be running.
+   */
+  ASSERT(msg->seq == next_seq[msg->thread]);
+  next_seq[msg->thread]++;
+
+  if (++msgs_received == NUM_THREADS * NUM_MSGS)
+    uv_close((uv_handle_t*) handle, close_cb);
+}
+
+
+TEST_IMPL(async_msg) {
+  uv_thread_t threads[NUM_THREADS];
+  struct msg* msgs;
+  unsigned int i;
+  unsigned int j;
+
+  msgs = calloc(NUM_THREADS * NUM_MSGS, sizeof(*msgs));
+  ASSERT(msgs != NULL);
+
+  for (i = 0; i < NUM_THREADS; i++) {
+    for (j = 0; j < NUM_MSGS; j++) {
+      msgs[i * NUM_MSGS + j].base.data = &msg_handle;
+      msgs[i * NUM_MSGS + j].thread = i;
+      msgs[i * NUM_MSGS + j].seq = j;
+    }
+  }
+
+  ASSERT(UV_EINVAL == uv_async_init_msg(uv_default_loop(), &msg_handle, NULL));
+  ASSERT(0 == uv_async_init_msg(uv_default_loop(), &msg_handle, msg_cb));
+  ASSERT(UV_EINVAL == uv_async_send(&msg_handle));
+
+  for (i = 0; i < NUM_THREADS; i++)
+    ASSERT(0 == uv_thread_create(threads + i, sender, msgs + i * NUM_MSGS));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  for (i = 0; i < NUM_THREADS; i++) {
+    ASSERT(0 == uv_thread_join(threads + i));
+    ASSERT(next_seq[i] == NUM_MSGS);
+  }
+
+  ASSERT(msgs_received == NUM_THREADS * NUM_MSGS);
+  ASSERT(close_cb_called == 1);
+
+  free(msgs);
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void handle_cb(uv_async_t* handle) {
+  int i;
+
+  i = handle - handles;
+  ASSERT(i % 7 == 0);
+  handle_cb_called[i]++;
+
+  /* The last one to be signalled closes them all. */
+  if (i == (NUM_HANDLES - 1) / 7 * 7)
+    for (i = 0; i < NUM_HANDLES; i++)
+      uv_close((uv_handle_t*) &handles[i], close_cb);
+}
+
+
+static void signaller(void* arg) {
+  int i;
+
+  for (i = 0; i < NUM_HANDLES; i += 7)
+    ASSERT(0 == uv_async_send(&handles[i]));
+}
+
+
+TEST_IMPL(async_many_handles) {
+  uv_thread_t thread;
+  int i;
+
+  for (i = 0; i < NUM_HANDLES; i++)
+    ASSERT(0 == uv_async_init(uv_default_loop(), &handles[i], handle_cb));
+
+  ASSERT(UV_EINVAL == uv_async_send_msg(&handles[0], NULL));
+
+  ASSERT(0 == uv_thread_create(&thread, signaller, NULL));
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(0 == uv_thread_join(&thread));
+
+  /* Callbacks run in the order the handles were signalled, so every one of
+   * them ran before the last one closed the lot.
+   */
+  for (i = 0; i < NUM_HANDLES; i++)
+    ASSERT(handle_cb_called[i] == (i % 7 == 0));
+
+  ASSERT(close_cb_called == NUM_HANDLES);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void fail_cb(uv_async_t* handle) {
+  ASSERT(0 && "fail_cb called");
+}
+
+
+static void free_close_cb(uv_handle_t* handle) {
+  free(handle);
+  close_cb_called++;
+}
+
+
+static void last_cb(uv_async_t* handle) {
+  handle_cb_called[0]++;
+  uv_close((uv_handle_t*) handle, close_cb);
+}
+
+
+TEST_IMPL(async_close_pending) {
+  uv_async_t* handle;
+
+  handle = malloc(sizeof(*handle));
+  ASSERT(handle != NULL);
+
+  /* Signalled, then closed and freed before the loop got to it. */
+  ASSERT(0 == uv_async_init(uv_default_loop(), &handles[0], last_cb));
+  ASSERT(0 == uv_async_init(uv_default_loop(), handle, fail_cb));
+  ASSERT(0 == uv_async_send(handle));
+  ASSERT(0 == uv_async_send(&handles[0]));
+  uv_close((uv_handle_t*) handle, free_close_cb);
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(handle_cb_called[0] == 1);
+  ASSERT(close_cb_called == 2);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -38,7 +38,7 @@
 static uv_fs_event_t fs_event;
 static const char file_prefix[] = "fsevent-";
 static const int fs_event_file_count = 16;
-#if defined(__APPLE__) || defined(_WIN32)
+#if defined(__APPLE__) || defined(_WIN32) || defined(__linux__)
 static const char file_prefix_in_subdir[] = "subdir";
 #endif
 static uv_timer_t timer;
@@ -191,7 +191,7 @@ static void fs_event_cb_dir_multi_file(uv_fs_event_t* handle,
   }
 }
 
-#if defined(__APPLE__) || defined(_WIN32)
+#if defined(__APPLE__) || defined(_WIN32) || defined(__linux__)
 static const char* fs_event_get_filename_in_subdir(int i) {
   snprintf(fs_event_filename,
            sizeof(fs_event_filename),
@@ -364,7 +364,7 @@ TEST_IMPL(fs_event_watch_dir) {
 }
 
 TEST_IMPL(fs_event_watch_dir_recursive) {
-#if defined(__APPLE__) || defined(_WIN32)
+#if defined(__APPLE__) || defined(_WIN32) || defined(__linux__)
   uv_loop_t* loop;
   int r;
 
@@ -881,3 +881,138 @@ TEST_IMPL(fs_event_error_reporting) {
 }
 
 #endif  /* defined(__APPLE__) */
+
+#if defined(__linux__)
+static int batch_cb_called;
+static unsigned int batch_seen;
+
+static void fs_event_cb_new_subdir(uv_fs_event_t* handle,
+                                   const char* filename,
+                                   int events,
+                                   int status) {
+  ASSERT(handle == &fs_event);
+  ASSERT(status == 0);
+  fs_event_cb_called++;
+
+  /* Files in directories created after the watch started are seen, too. */
+  if (strcmp(filename, "newdir/deeper/file1") == 0) {
+    uv_close((uv_handle_t*) &timer, close_cb);
+    uv_close((uv_handle_t*) handle, close_cb);
+  }
+}
+
+static void timer_cb_new_subdir(uv_timer_t* handle) {
+  if (++timer_cb_called == 1) {
+    create_dir("watch_dir/newdir");
+    create_dir("watch_dir/newdir/deeper");
+  } else {
+    create_file("watch_dir/newdir/deeper/file1");
+  }
+
+  if (timer_cb_called < 2)
+    ASSERT(0 == uv_timer_start(&timer, timer_cb_new_subdir, 50, 0));
+}
+
+static void timer_cb_batch(uv_timer_t* handle) {
+  int i;
+
+  /* All of these land within one window. */
+  for (i = 0; i < fs_event_file_count; i++)
+    create_file(fs_event_get_filename(i));
+  for (i = 0; i < fs_event_file_count; i++)
+    touch_file(fs_event_get_filename(i));
+
+  uv_close((uv_handle_t*) handle, close_cb);
+}
+
+static void fs_event_batch_cb(uv_fs_event_t* handle,
+                              const uv_fs_event_change_t* changes,
+                              unsigned int nchanges,
+                              int status) {
+  unsigned int i;
+  int n;
+
+  ASSERT(handle == &fs_event);
+  ASSERT(status == 0);
+  ASSERT(nchanges == (unsigned int) fs_event_file_count);
+  batch_cb_called++;
+
+  for (i = 0; i < nchanges; i++) {
+    ASSERT(changes[i].events == (UV_RENAME | UV_CHANGE));
+    ASSERT(1 == sscanf(changes[i].filename, "fsevent-%d", &n));
+    ASSERT(n >= 0 && n < fs_event_file_count);
+    ASSERT((batch_seen & (1u << n)) == 0);
+    batch_seen |= 1u << n;
+  }
+
+  /* Freeing the batch from within its callback is fine. */
+  uv_close((uv_handle_t*) handle, close_cb);
+}
+#endif
+
+TEST_IMPL(fs_event_watch_dir_recursive_new_subdir) {
+#if defined(__linux__)
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  remove("watch_dir/newdir/deeper/file1");
+  remove("watch_dir/newdir/deeper");
+  remove("watch_dir/newdir");
+  remove("watch_dir/");
+  create_dir("watch_dir");
+
+  ASSERT(0 == uv_fs_event_init(loop, &fs_event));
+  ASSERT(0 == uv_fs_event_start(&fs_event,
+                                fs_event_cb_new_subdir,
+                                "watch_dir",
+                                UV_FS_EVENT_RECURSIVE));
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, timer_cb_new_subdir, 10, 0));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(timer_cb_called == 2);
+  ASSERT(fs_event_cb_called >= 2);
+  ASSERT(close_cb_called == 2);
+
+  remove("watch_dir/newdir/deeper/file1");
+  remove("watch_dir/newdir/deeper");
+  remove("watch_dir/newdir");
+  remove("watch_dir/");
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#else
+  RETURN_SKIP("Recursive directory watching not supported on this platform.");
+#endif
+}
+
+TEST_IMPL(fs_event_batching) {
+#if defined(__linux__)
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  fs_event_unlink_files(NULL);
+  remove("watch_dir/");
+  create_dir("watch_dir");
+
+  ASSERT(0 == uv_fs_event_init(loop, &fs_event));
+  ASSERT(0 == uv_fs_event_set_batching(&fs_event, 100, fs_event_batch_cb));
+  ASSERT(0 == uv_fs_event_start(&fs_event, fail_cb, "watch_dir", 0));
+  ASSERT(UV_EINVAL == uv_fs_event_set_batching(&fs_event, 0, NULL));
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, timer_cb_batch, 10, 0));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(batch_cb_called == 1);
+  ASSERT(batch_seen == (1u << fs_event_file_count) - 1);
+  ASSERT(close_cb_called == 2);
+
+  fs_event_unlink_files(NULL);
+  remove("watch_dir/");
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#else
+  RETURN_SKIP("Batched fs events not supported on this platform.");
+#endif
+}
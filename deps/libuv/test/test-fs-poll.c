@@ -22,9 +22,16 @@
 #include "uv.h"
 #include "task.h"
 
+#include <stdio.h>
 #include <string.h>
 
 #define FIXTURE "testfile"
+#define FIXTURE_NEW "testfile.new"
+#define FIXTURE_DIR "fs_poll_dir"
+#define FIXTURE_DIR_OLD "fs_poll_dir.old"
+#define FIXTURE_DIR_FILE FIXTURE_DIR "/file"
+#define FIXTURE_DIR_OLD_FILE FIXTURE_DIR_OLD "/file"
+#define NUM_MANY 16
 
 static void timer_cb(uv_timer_t* handle);
 static void close_cb(uv_handle_t* handle);
@@ -184,3 +191,252 @@ TEST_IMPL(fs_poll_getpath) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+static uv_fs_poll_t many_handles[NUM_MANY];
+static int many_cb_called[NUM_MANY];
+
+
+static void many_path(char* buf, size_t size, int i) {
+  snprintf(buf, size, "%s.%d", FIXTURE, i);
+}
+
+
+static void write_file(const char* path, const char* mode, const char* data) {
+  FILE* fp;
+
+  ASSERT((fp = fopen(path, mode)));
+  ASSERT(fputs(data, fp) >= 0);
+  ASSERT(0 == fclose(fp));
+}
+
+
+static void many_poll_cb(uv_fs_poll_t* handle,
+                         int status,
+                         const uv_stat_t* prev,
+                         const uv_stat_t* curr) {
+  int i;
+
+  i = handle - many_handles;
+  ASSERT(i >= 0 && i < NUM_MANY);
+  ASSERT(i % 2 == 0);
+  ASSERT(status == 0);
+  ASSERT(prev->st_size == 1);
+  ASSERT(curr->st_size == 2);
+  ASSERT(many_cb_called[i] == 0);
+  many_cb_called[i]++;
+  poll_cb_called++;
+}
+
+
+static void many_close_cb(uv_timer_t* handle) {
+  int i;
+
+  for (i = 0; i < NUM_MANY; i++)
+    uv_close((uv_handle_t*) &many_handles[i], close_cb);
+}
+
+
+static void many_touch_cb(uv_timer_t* handle) {
+  char path[64];
+  int i;
+
+  for (i = 0; i < NUM_MANY; i += 2) {
+    many_path(path, sizeof(path), i);
+    write_file(path, "a", "*");
+  }
+
+  ASSERT(0 == uv_timer_start(handle, many_close_cb, 400, 0));
+}
+
+
+TEST_IMPL(fs_poll_many) {
+  char path[64];
+  int i;
+
+  loop = uv_default_loop();
+
+  /* Two intervals, so that two groups of handles share a sweep each. */
+  for (i = 0; i < NUM_MANY; i++) {
+    many_path(path, sizeof(path), i);
+    write_file(path, "w", "*");
+    ASSERT(0 == uv_fs_poll_init(loop, &many_handles[i]));
+    ASSERT(0 == uv_fs_poll_start(&many_handles[i],
+                                 many_poll_cb,
+                                 path,
+                                 i < NUM_MANY / 2 ? 50 : 60));
+  }
+
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, many_touch_cb, 150, 0));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(poll_cb_called == NUM_MANY / 2);
+  for (i = 0; i < NUM_MANY; i++)
+    ASSERT(many_cb_called[i] == (i % 2 == 0));
+
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(close_cb_called == NUM_MANY);
+
+  for (i = 0; i < NUM_MANY; i++) {
+    many_path(path, sizeof(path), i);
+    remove(path);
+  }
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void replace_timer_cb(uv_timer_t* handle) {
+  uv_fs_t req;
+
+  if (timer_cb_called++ == 0) {
+    /* Swap in a different file, the poller must follow the path. */
+    write_file(FIXTURE_NEW, "w", "**");
+    ASSERT(0 == uv_fs_rename(NULL, &req, FIXTURE_NEW, FIXTURE, NULL));
+    uv_fs_req_cleanup(&req);
+  } else {
+    /* Then modify the new file in place. */
+    write_file(FIXTURE, "a", "*");
+  }
+}
+
+
+static void replace_poll_cb(uv_fs_poll_t* handle,
+                            int status,
+                            const uv_stat_t* prev,
+                            const uv_stat_t* curr) {
+  ASSERT(handle == &poll_handle);
+  ASSERT(status == 0);
+
+  switch (poll_cb_called++) {
+  case 0:
+    ASSERT(prev->st_size == 1);
+    ASSERT(curr->st_size == 2);
+    ASSERT(0 == uv_timer_start(&timer_handle, replace_timer_cb, 150, 0));
+    break;
+
+  case 1:
+    ASSERT(prev->st_size == 2);
+    ASSERT(curr->st_size == 3);
+    ASSERT(prev->st_ino == curr->st_ino);
+    uv_close((uv_handle_t*) handle, close_cb);
+    uv_close((uv_handle_t*) &timer_handle, close_cb);
+    break;
+
+  default:
+    ASSERT(0);
+  }
+}
+
+
+TEST_IMPL(fs_poll_replace) {
+  loop = uv_default_loop();
+
+  remove(FIXTURE_NEW);
+  write_file(FIXTURE, "w", "*");
+
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, replace_timer_cb, 150, 0));
+  ASSERT(0 == uv_fs_poll_init(loop, &poll_handle));
+  ASSERT(0 == uv_fs_poll_start(&poll_handle, replace_poll_cb, FIXTURE, 50));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(poll_cb_called == 2);
+  ASSERT(timer_cb_called == 2);
+  ASSERT(close_cb_called == 2);
+
+  remove(FIXTURE);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void parent_rmdir(const char* dir, const char* file) {
+  uv_fs_t req;
+
+  remove(file);
+  uv_fs_rmdir(NULL, &req, dir, NULL);
+  uv_fs_req_cleanup(&req);
+}
+
+
+static void parent_timer_cb(uv_timer_t* handle) {
+  uv_fs_t req;
+
+  if (timer_cb_called++ == 0) {
+    /* Replace the directory, the file itself doesn't change. */
+    ASSERT(0 == uv_fs_rename(NULL, &req, FIXTURE_DIR, FIXTURE_DIR_OLD, NULL));
+    uv_fs_req_cleanup(&req);
+    ASSERT(0 == uv_fs_mkdir(NULL, &req, FIXTURE_DIR, 0755, NULL));
+    uv_fs_req_cleanup(&req);
+    write_file(FIXTURE_DIR_FILE, "w", "**");
+  } else {
+    /* Then modify the file in the new directory. */
+    write_file(FIXTURE_DIR_FILE, "a", "*");
+  }
+}
+
+
+static void parent_poll_cb(uv_fs_poll_t* handle,
+                           int status,
+                           const uv_stat_t* prev,
+                           const uv_stat_t* curr) {
+  ASSERT(handle == &poll_handle);
+  ASSERT(status == 0);
+
+  switch (poll_cb_called++) {
+  case 0:
+    ASSERT(prev->st_size == 1);
+    ASSERT(curr->st_size == 2);
+    ASSERT(prev->st_ino != curr->st_ino);
+    ASSERT(0 == uv_timer_start(&timer_handle, parent_timer_cb, 150, 0));
+    break;
+
+  case 1:
+    ASSERT(prev->st_size == 2);
+    ASSERT(curr->st_size == 3);
+    ASSERT(prev->st_ino == curr->st_ino);
+    uv_close((uv_handle_t*) handle, close_cb);
+    uv_close((uv_handle_t*) &timer_handle, close_cb);
+    break;
+
+  default:
+    ASSERT(0);
+  }
+}
+
+
+TEST_IMPL(fs_poll_parent_replaced) {
+  uv_fs_t req;
+
+  loop = uv_default_loop();
+
+  parent_rmdir(FIXTURE_DIR, FIXTURE_DIR_FILE);
+  parent_rmdir(FIXTURE_DIR_OLD, FIXTURE_DIR_OLD_FILE);
+  ASSERT(0 == uv_fs_mkdir(NULL, &req, FIXTURE_DIR, 0755, NULL));
+  uv_fs_req_cleanup(&req);
+  write_file(FIXTURE_DIR_FILE, "w", "*");
+
+  ASSERT(0 == uv_timer_init(loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, parent_timer_cb, 150, 0));
+  ASSERT(0 == uv_fs_poll_init(loop, &poll_handle));
+  ASSERT(0 == uv_fs_poll_start(&poll_handle,
+                               parent_poll_cb,
+                               FIXTURE_DIR_FILE,
+                               50));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(poll_cb_called == 2);
+  ASSERT(timer_cb_called == 2);
+  ASSERT(close_cb_called == 2);
+
+  parent_rmdir(FIXTURE_DIR, FIXTURE_DIR_FILE);
+  parent_rmdir(FIXTURE_DIR_OLD, FIXTURE_DIR_OLD_FILE);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
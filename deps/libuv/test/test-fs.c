@@ -2538,3 +2538,332 @@ TEST_IMPL(fs_read_write_null_arguments) {
 
   return 0;
 }
+
+
+static uv_stat_t many_reqs_statbuf;
+static int many_reqs_cb_count;
+
+
+static void many_reqs_cb(uv_fs_t* req) {
+  uv_stat_t* s;
+
+  if (req->fs_type == UV_FS_READ) {
+    ASSERT(req->result == sizeof(test_buf));
+    ASSERT(memcmp(req->data, test_buf, sizeof(test_buf)) == 0);
+  } else {
+    ASSERT(req->result == 0);
+    s = req->ptr;
+    ASSERT(s == &req->statbuf);
+    ASSERT(s->st_dev == many_reqs_statbuf.st_dev);
+    ASSERT(s->st_ino == many_reqs_statbuf.st_ino);
+    ASSERT(s->st_mode == many_reqs_statbuf.st_mode);
+    ASSERT(s->st_nlink == many_reqs_statbuf.st_nlink);
+    ASSERT(s->st_size == many_reqs_statbuf.st_size);
+    ASSERT(s->st_mtim.tv_sec == many_reqs_statbuf.st_mtim.tv_sec);
+    ASSERT(s->st_mtim.tv_nsec == many_reqs_statbuf.st_mtim.tv_nsec);
+    ASSERT(s->st_birthtim.tv_sec == many_reqs_statbuf.st_birthtim.tv_sec);
+  }
+
+  uv_fs_req_cleanup(req);
+  many_reqs_cb_count++;
+}
+
+
+/* More requests in flight than any batching or ring in the fs backend can
+ * take at once, the overflow must still complete correctly.
+ */
+TEST_IMPL(fs_many_concurrent_reqs) {
+  static uv_fs_t reqs[1024];
+  static char bufs[ARRAY_SIZE(reqs)][sizeof(test_buf)];
+  uv_fs_t req;
+  uv_file file;
+  unsigned int i;
+  int r;
+
+  /* Setup. */
+  unlink("test_file");
+
+  loop = uv_default_loop();
+
+  /* Overflow the io_uring ring too where there is one. */
+  r = uv_loop_configure(loop, UV_LOOP_USE_IO_URING, 1);
+  ASSERT(r == 0 || r == UV_ENOSYS);
+
+  r = uv_fs_open(NULL, &req, "test_file", O_RDWR | O_CREAT,
+      S_IWUSR | S_IRUSR, NULL);
+  ASSERT(r >= 0);
+  file = req.result;
+  uv_fs_req_cleanup(&req);
+
+  iov = uv_buf_init(test_buf, sizeof(test_buf));
+  r = uv_fs_write(NULL, &req, file, &iov, 1, -1, NULL);
+  ASSERT(r == sizeof(test_buf));
+  uv_fs_req_cleanup(&req);
+
+  r = uv_fs_stat(NULL, &req, "test_file", NULL);
+  ASSERT(r == 0);
+  many_reqs_statbuf = req.statbuf;
+  uv_fs_req_cleanup(&req);
+
+  for (i = 0; i < ARRAY_SIZE(reqs); i++) {
+    switch (i % 4) {
+    case 0:
+    case 2:
+      iov = uv_buf_init(bufs[i], sizeof(bufs[i]));
+      r = uv_fs_read(loop, reqs + i, file, &iov, 1, 0, many_reqs_cb);
+      break;
+    case 1:
+      r = uv_fs_stat(loop, reqs + i, "test_file", many_reqs_cb);
+      break;
+    case 3:
+      r = uv_fs_fstat(loop, reqs + i, file, many_reqs_cb);
+      break;
+    }
+    ASSERT(r == 0);
+    reqs[i].data = bufs[i];
+  }
+
+  r = uv_run(loop, UV_RUN_DEFAULT);
+  ASSERT(r == 0);
+  ASSERT(many_reqs_cb_count == ARRAY_SIZE(reqs));
+
+  r = uv_fs_close(NULL, &req, file, NULL);
+  ASSERT(r == 0);
+  uv_fs_req_cleanup(&req);
+
+  /* Cleanup */
+  unlink("test_file");
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static const char* walk_names[] = {
+  "a",
+  "link",
+  "sub",
+  "sub/b",
+  "sub/deeper",
+  "sub/deeper/c"
+};
+static const uv_dirent_type_t walk_types[] = {
+  UV_DIRENT_FILE,
+  UV_DIRENT_LINK,  /* Reported, not followed. */
+  UV_DIRENT_DIR,
+  UV_DIRENT_FILE,
+  UV_DIRENT_DIR,
+  UV_DIRENT_FILE
+};
+static int walk_seen[ARRAY_SIZE(walk_names)];
+static int walk_cb_count;
+
+
+static void walk_check(uv_fs_t* req) {
+  uv_fs_walk_entry_t ent;
+  unsigned int i;
+  int n;
+
+  n = 0;
+  while (0 == uv_fs_walk_next(req, &ent)) {
+    for (i = 0; i < ARRAY_SIZE(walk_names); i++)
+      if (strcmp(ent.name, walk_names[i]) == 0)
+        break;
+
+    ASSERT(i < ARRAY_SIZE(walk_names));
+    ASSERT(walk_seen[i] == 0);
+    walk_seen[i] = 1;
+
+    ASSERT(ent.type == walk_types[i]);
+    if (ent.type == UV_DIRENT_FILE)
+      ASSERT(ent.statbuf.st_size == (uint64_t) strlen(ent.name));
+    else if (ent.type == UV_DIRENT_DIR)
+      ASSERT((ent.statbuf.st_mode & S_IFMT) == S_IFDIR);
+
+    n++;
+  }
+
+  ASSERT(n == req->result);
+}
+
+
+static void walk_cb(uv_fs_t* req) {
+  ASSERT(req->fs_type == UV_FS_WALK);
+  ASSERT(req->result >= 0);
+  walk_cb_count++;
+
+  if (req->result == 0) {
+    uv_fs_req_cleanup(req);
+    ASSERT(req->ptr == NULL);
+    return;
+  }
+
+  walk_check(req);
+  ASSERT(0 == uv_fs_walk_continue(req->loop, req, walk_cb));
+}
+
+
+static void walk_make_file(const char* path) {
+  uv_fs_t req;
+  uv_buf_t buf;
+  int r;
+
+  r = uv_fs_open(NULL, &req, path, O_WRONLY | O_CREAT, S_IWUSR | S_IRUSR, NULL);
+  ASSERT(r >= 0);
+  uv_fs_req_cleanup(&req);
+
+  /* The file names its own size, see walk_check(). */
+  buf = uv_buf_init((char*) path + strlen("test_walk/"),
+                    strlen(path) - strlen("test_walk/"));
+  ASSERT(buf.len == (size_t) uv_fs_write(NULL, &req, r, &buf, 1, 0, NULL));
+  uv_fs_req_cleanup(&req);
+
+  ASSERT(0 == uv_fs_close(NULL, &req, r, NULL));
+  uv_fs_req_cleanup(&req);
+}
+
+
+static void walk_cleanup(void) {
+  unlink("test_walk/sub/deeper/c");
+  rmdir("test_walk/sub/deeper");
+  unlink("test_walk/sub/b");
+  rmdir("test_walk/sub");
+  unlink("test_walk/link");
+  unlink("test_walk/a");
+  rmdir("test_walk");
+}
+
+
+TEST_IMPL(fs_walk) {
+  uv_fs_t req;
+  unsigned int i;
+  int r;
+
+  walk_cleanup();
+  loop = uv_default_loop();
+
+  r = uv_fs_walk(NULL, &req, ".", 0, NULL);
+  if (r == UV_ENOSYS)
+    RETURN_SKIP("uv_fs_walk() is not supported on this platform.");
+  uv_fs_req_cleanup(&req);
+
+  ASSERT(0 == uv_fs_mkdir(NULL, &req, "test_walk", 0755, NULL));
+  uv_fs_req_cleanup(&req);
+  ASSERT(0 == uv_fs_mkdir(NULL, &req, "test_walk/sub", 0755, NULL));
+  uv_fs_req_cleanup(&req);
+  ASSERT(0 == uv_fs_mkdir(NULL, &req, "test_walk/sub/deeper", 0755, NULL));
+  uv_fs_req_cleanup(&req);
+  walk_make_file("test_walk/a");
+  walk_make_file("test_walk/sub/b");
+  walk_make_file("test_walk/sub/deeper/c");
+  ASSERT(0 == uv_fs_symlink(NULL, &req, "sub", "test_walk/link", 0, NULL));
+  uv_fs_req_cleanup(&req);
+
+  /* Everything fits into one batch, the second one is empty. */
+  r = uv_fs_walk(NULL, &req, "test_walk", 0, NULL);
+  ASSERT(r == ARRAY_SIZE(walk_names));
+  walk_check(&req);
+  ASSERT(0 == uv_fs_walk_continue(NULL, &req, NULL));
+  ASSERT(UV_EOF == uv_fs_walk_next(&req, NULL));
+  uv_fs_req_cleanup(&req);
+  ASSERT(req.ptr == NULL);
+
+  for (i = 0; i < ARRAY_SIZE(walk_names); i++) {
+    ASSERT(walk_seen[i] == 1);
+    walk_seen[i] = 0;
+  }
+
+  r = uv_fs_walk(loop, &req, "test_walk", 0, walk_cb);
+  ASSERT(r == 0);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(walk_cb_count == 2);
+
+  for (i = 0; i < ARRAY_SIZE(walk_names); i++)
+    ASSERT(walk_seen[i] == 1);
+
+  walk_cleanup();
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(fs_walk_batches) {
+  uv_fs_walk_entry_t ent;
+  char path[64];
+  uv_fs_t req;
+  int batches;
+  int count;
+  int i;
+  int r;
+
+  r = uv_fs_walk(NULL, &req, ".", 0, NULL);
+  if (r == UV_ENOSYS)
+    RETURN_SKIP("uv_fs_walk() is not supported on this platform.");
+  uv_fs_req_cleanup(&req);
+
+  uv_fs_mkdir(NULL, &req, "test_walk_many", 0755, NULL);
+  uv_fs_req_cleanup(&req);
+
+  for (i = 0; i < 3000; i++) {
+    snprintf(path, sizeof(path), "test_walk_many/%d", i);
+    r = uv_fs_open(NULL, &req, path, O_WRONLY | O_CREAT, S_IWUSR, NULL);
+    ASSERT(r >= 0);
+    uv_fs_req_cleanup(&req);
+    uv_fs_close(NULL, &req, r, NULL);
+    uv_fs_req_cleanup(&req);
+  }
+
+  batches = 0;
+  count = 0;
+  r = uv_fs_walk(NULL, &req, "test_walk_many", UV_FS_WALK_NOSTAT, NULL);
+
+  while (r > 0) {
+    while (0 == uv_fs_walk_next(&req, &ent)) {
+      ASSERT(ent.type == UV_DIRENT_FILE);
+      ASSERT(ent.statbuf.st_size == 0);
+      ASSERT(ent.statbuf.st_mode == 0);
+      count++;
+    }
+    batches++;
+    r = uv_fs_walk_continue(NULL, &req, NULL);
+  }
+
+  ASSERT(r == 0);
+  ASSERT(count == 3000);
+  ASSERT(batches > 1);
+  uv_fs_req_cleanup(&req);
+
+  for (i = 0; i < 3000; i++) {
+    snprintf(path, sizeof(path), "test_walk_many/%d", i);
+    unlink(path);
+  }
+  rmdir("test_walk_many");
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(fs_walk_error) {
+  uv_fs_t req;
+  int r;
+
+  r = uv_fs_walk(NULL, &req, ".", 0, NULL);
+  if (r == UV_ENOSYS)
+    RETURN_SKIP("uv_fs_walk() is not supported on this platform.");
+  uv_fs_req_cleanup(&req);
+
+  r = uv_fs_walk(NULL, &req, "no_such_dir", 0, NULL);
+  ASSERT(r == UV_ENOENT);
+  ASSERT(req.ptr == NULL);
+  ASSERT(UV_EINVAL == uv_fs_walk_continue(NULL, &req, NULL));
+  uv_fs_req_cleanup(&req);
+
+  r = uv_fs_walk(NULL, &req, "test/fixtures/empty_file", 0, NULL);
+  ASSERT(r == UV_ENOTDIR);
+  uv_fs_req_cleanup(&req);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,366 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RESOLV_CONF "test_resolv.conf"
+#define HOSTS       "test_hosts"
+
+static uv_loop_t loop;
+static uv_udp_t server;
+static uv_getaddrinfo_t req;
+static struct addrinfo hints;
+static int queries;
+static int truncate_answers;
+static int lookups;
+static int in_getaddrinfo;
+
+
+static void write_file(const char* path, const char* contents) {
+  FILE* fp;
+
+  fp = fopen(path, "w");
+  ASSERT(fp != NULL);
+  ASSERT(strlen(contents) == fwrite(contents, 1, strlen(contents), fp));
+  ASSERT(0 == fclose(fp));
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[512];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void send_cb(uv_udp_send_t* send_req, int status) {
+  ASSERT(status == 0);
+  free(send_req);
+}
+
+
+/* Answers A questions for "known.test" with 192.0.2.1 and everything else
+ * with NXDOMAIN.
+ */
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* rcvbuf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  static const unsigned char known[] = "\5known\4test";
+  static const unsigned char answer[] = {
+    0xc0, 0x0c, 0, 1, 0, 1, 0, 0, 1, 44, 0, 4, 192, 0, 2, 1
+  };
+  static const unsigned char soa[] = {
+    0xc0, 0x0c, 0, 6, 0, 1, 0, 0, 14, 16, 0, 22, 0, 0,
+    0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 60
+  };
+  uv_udp_send_t* send_req;
+  unsigned char* msg;
+  unsigned char* rsp;
+  uv_buf_t buf;
+  size_t qlen;
+  size_t len;
+
+  if (nread == 0)
+    return;
+
+  ASSERT(nread > 12);
+  msg = (unsigned char*) rcvbuf->base;
+  qlen = strlen((char*) msg + 12) + 1 + 4;
+  ASSERT(12 + qlen == (size_t) nread);
+  queries++;
+
+  send_req = malloc(sizeof(*send_req) + 512);
+  ASSERT(send_req != NULL);
+  rsp = (unsigned char*) (send_req + 1);
+
+  memcpy(rsp, msg, 12 + qlen);
+  rsp[2] = 0x81;
+  rsp[3] = 0x80;
+  rsp[6] = rsp[7] = rsp[8] = rsp[9] = rsp[10] = rsp[11] = 0;
+  len = 12 + qlen;
+
+  if (truncate_answers) {
+    rsp[2] |= 0x02;
+  } else if (memcmp(msg + 12, known, sizeof(known)) == 0 &&
+             msg[12 + qlen - 3] == 1) {
+    rsp[7] = 1;
+    memcpy(rsp + len, answer, sizeof(answer));
+    len += sizeof(answer);
+  } else {
+    rsp[3] |= 3;
+    rsp[9] = 1;
+    memcpy(rsp + len, soa, sizeof(soa));
+    len += sizeof(soa);
+  }
+
+  buf = uv_buf_init((char*) rsp, len);
+  ASSERT(0 == uv_udp_send(send_req, handle, &buf, 1, addr, send_cb));
+}
+
+
+static void start_server(int port) {
+  struct sockaddr_in addr;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", port, &addr));
+  ASSERT(0 == uv_udp_init(&loop, &server));
+  ASSERT(0 == uv_udp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_udp_recv_start(&server, alloc_cb, recv_cb));
+}
+
+
+static void check_ipv4(struct addrinfo* res, const char* expected, int port) {
+  char name[INET_ADDRSTRLEN];
+  struct sockaddr_in* sin;
+
+  ASSERT(res != NULL);
+  ASSERT(res->ai_family == AF_INET);
+  sin = (struct sockaddr_in*) res->ai_addr;
+  ASSERT(0 == uv_ip4_name(sin, name, sizeof(name)));
+  ASSERT(0 == strcmp(name, expected));
+  ASSERT(ntohs(sin->sin_port) == port);
+}
+
+
+static void lookup(uv_getaddrinfo_cb cb, const char* name) {
+  in_getaddrinfo = 1;
+  ASSERT(0 == uv_getaddrinfo(&loop, &req, cb, name, NULL, &hints));
+  in_getaddrinfo = 0;
+}
+
+
+static void cache_cb(uv_getaddrinfo_t* handle,
+                     int status,
+                     struct addrinfo* res) {
+  ASSERT(status == 0);
+  ASSERT(res != NULL);
+  uv_freeaddrinfo(res);
+
+  if (++lookups == 1)
+    lookup(cache_cb, "localhost");
+}
+
+
+TEST_IMPL(getaddrinfo_cache) {
+  uv_work_stats_t stats;
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+  r = uv_loop_configure(&loop, UV_LOOP_DNS_CACHE, 60);
+  if (r == UV_ENOSYS)
+    RETURN_SKIP("No getaddrinfo() cache on this platform.");
+  ASSERT(r == 0);
+
+  lookup(cache_cb, "localhost");
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(lookups == 2);
+
+  /* Synchronous lookups use the cache too. */
+  ASSERT(0 == uv_getaddrinfo(&loop, &req, NULL, "localhost", NULL, NULL));
+  ASSERT(req.addrinfo != NULL);
+  uv_freeaddrinfo(req.addrinfo);
+
+  ASSERT(0 == uv_threadpool_stats(&loop, UV_WORK_SLOW_IO, &stats));
+  ASSERT(stats.submitted == 1);
+
+  ASSERT(0 == uv_loop_close(&loop));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void udp_cb(uv_getaddrinfo_t* handle,
+                   int status,
+                   struct addrinfo* res) {
+  ASSERT(!in_getaddrinfo);
+  lookups++;
+
+  switch (lookups) {
+  case 1:
+  case 2:
+    /* The second answer comes from the cache. */
+    ASSERT(status == 0);
+    ASSERT(queries == 1);
+    check_ipv4(res, "192.0.2.1", 0);
+    ASSERT(res->ai_next != NULL);  /* SOCK_STREAM, SOCK_DGRAM, SOCK_RAW */
+    uv_freeaddrinfo(res);
+    lookup(udp_cb, lookups == 1 ? "known.test" : "missing.test");
+    break;
+
+  case 3:
+  case 4:
+    ASSERT(status == UV_EAI_NONAME);
+    ASSERT(res == NULL);
+    ASSERT(queries == 2);
+    if (lookups == 3)
+      lookup(udp_cb, "missing.test");
+    else
+      uv_close((uv_handle_t*) &server, NULL);
+    break;
+  }
+}
+
+
+TEST_IMPL(getaddrinfo_resolver_udp) {
+  char conf[128];
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+  r = uv_loop_configure(&loop, UV_LOOP_DNS_RESOLVER, RESOLV_CONF, HOSTS);
+  if (r == UV_ENOSYS)
+    RETURN_SKIP("No stub resolver on this platform.");
+  ASSERT(r == 0);
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_DNS_CACHE, 60));
+
+  snprintf(conf, sizeof(conf), "nameserver [127.0.0.1]:%d\n", TEST_PORT);
+  write_file(RESOLV_CONF, conf);
+  write_file(HOSTS, "");
+
+  start_server(TEST_PORT);
+  hints.ai_family = AF_INET;
+  lookup(udp_cb, "known.test");
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(lookups == 4);
+
+  ASSERT(0 == uv_loop_close(&loop));
+  remove(RESOLV_CONF);
+  remove(HOSTS);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void tcp_cb(uv_getaddrinfo_t* handle,
+                   int status,
+                   struct addrinfo* res) {
+  ASSERT(status == 0);
+  ASSERT(queries == 1);
+  check_ipv4(res, "10.0.1.1", 80);
+  ASSERT(res->ai_socktype == SOCK_STREAM);
+  ASSERT(res->ai_next == NULL);
+  uv_freeaddrinfo(res);
+  lookups++;
+  uv_close((uv_handle_t*) &server, NULL);
+}
+
+
+/* Truncated UDP answers make the resolver ask again over TCP, the dns_server
+ * helper answers those.
+ */
+TEST_IMPL(getaddrinfo_resolver_tcp) {
+  char conf[128];
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+  r = uv_loop_configure(&loop, UV_LOOP_DNS_RESOLVER, RESOLV_CONF, HOSTS);
+  if (r == UV_ENOSYS)
+    RETURN_SKIP("No stub resolver on this platform.");
+  ASSERT(r == 0);
+
+  snprintf(conf, sizeof(conf), "nameserver [127.0.0.1]:%d\n", TEST_PORT_2);
+  write_file(RESOLV_CONF, conf);
+  write_file(HOSTS, "");
+
+  start_server(TEST_PORT_2);
+  truncate_answers = 1;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  ASSERT(0 == uv_getaddrinfo(&loop, &req, tcp_cb, "echos.srv", "80", &hints));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(lookups == 1);
+
+  ASSERT(0 == uv_loop_close(&loop));
+  remove(RESOLV_CONF);
+  remove(HOSTS);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void hosts_cb(uv_getaddrinfo_t* handle,
+                     int status,
+                     struct addrinfo* res) {
+  struct addrinfo* ai;
+  int families;
+  int n;
+
+  ASSERT(!in_getaddrinfo);
+  ASSERT(status == 0);
+  lookups++;
+
+  if (lookups == 1) {
+    /* Both addresses, each as SOCK_STREAM, SOCK_DGRAM and SOCK_RAW. */
+    families = 0;
+    for (n = 0, ai = res; ai != NULL; ai = ai->ai_next, n++)
+      families |= ai->ai_family == AF_INET ? 1 : 2;
+    ASSERT(n == 6);
+    ASSERT(families == 3);
+    uv_freeaddrinfo(res);
+
+    lookup(hosts_cb, "ALIAS");
+    return;
+  }
+
+  check_ipv4(res, "192.0.2.7", 0);
+  ASSERT(res->ai_next != NULL);
+  ASSERT(res->ai_next->ai_family == AF_INET);
+  uv_freeaddrinfo(res);
+}
+
+
+TEST_IMPL(getaddrinfo_resolver_hosts) {
+  char conf[128];
+  int r;
+
+  /* Nothing listens on the port, any query would fail. */
+  ASSERT(0 == uv_loop_init(&loop));
+  r = uv_loop_configure(&loop, UV_LOOP_DNS_RESOLVER, RESOLV_CONF, HOSTS);
+  if (r == UV_ENOSYS)
+    RETURN_SKIP("No stub resolver on this platform.");
+  ASSERT(r == 0);
+
+  snprintf(conf, sizeof(conf), "nameserver [127.0.0.1]:%d\n", TEST_PORT);
+  write_file(RESOLV_CONF, conf);
+  write_file(HOSTS,
+             "# comment\n"
+             "192.0.2.7 host.test alias  # trailing comment\n"
+             "2001:db8::7\tHost.Test\n");
+
+  lookup(hosts_cb, "host.test");
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(lookups == 2);
+
+  ASSERT(0 == uv_loop_close(&loop));
+  remove(RESOLV_CONF);
+  remove(HOSTS);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
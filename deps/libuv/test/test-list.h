@@ -30,6 +30,10 @@ TEST_DECLARE   (loop_stop)
 TEST_DECLARE   (loop_update_time)
 TEST_DECLARE   (loop_backend_timeout)
 TEST_DECLARE   (loop_configure)
+TEST_DECLARE   (loop_metrics)
+TEST_DECLARE   (loop_metrics_many_fds)
+TEST_DECLARE   (loop_metrics_phases)
+TEST_DECLARE   (loop_metrics_threaded)
 TEST_DECLARE   (default_loop_close)
 TEST_DECLARE   (barrier_1)
 TEST_DECLARE   (barrier_2)
@@ -76,6 +80,8 @@ TEST_DECLARE   (tcp_bind_error_fault)
 TEST_DECLARE   (tcp_bind_error_inval)
 TEST_DECLARE   (tcp_bind_localhost_ok)
 TEST_DECLARE   (tcp_bind_invalid_flags)
+TEST_DECLARE   (tcp_reuseport)
+TEST_DECLARE   (tcp_reuseport_bind_error)
 TEST_DECLARE   (tcp_listen_without_bind)
 TEST_DECLARE   (tcp_connect_error_fault)
 TEST_DECLARE   (tcp_connect_timeout)
@@ -85,12 +91,21 @@ TEST_DECLARE   (tcp_create_early)
 TEST_DECLARE   (tcp_create_early_bad_bind)
 TEST_DECLARE   (tcp_create_early_bad_domain)
 TEST_DECLARE   (tcp_create_early_accept)
+TEST_DECLARE   (tcp_alloc)
+TEST_DECLARE   (tcp_alloc_accept)
+TEST_DECLARE   (tcp_alloc_free_after_loop_close)
 #ifndef _WIN32
 TEST_DECLARE   (tcp_close_accept)
 TEST_DECLARE   (tcp_oob)
 #endif
 TEST_DECLARE   (tcp_flags)
 TEST_DECLARE   (tcp_write_to_half_open_connection)
+TEST_DECLARE   (stream_sendfile)
+TEST_DECLARE   (stream_sendfile_eof)
+TEST_DECLARE   (stream_sendfile_einval)
+#ifndef _WIN32
+TEST_DECLARE   (stream_sendfile_pipe)
+#endif
 TEST_DECLARE   (tcp_unexpected_read)
 TEST_DECLARE   (tcp_read_stop)
 TEST_DECLARE   (tcp_bind6_error_addrinuse)
@@ -105,6 +120,8 @@ TEST_DECLARE   (udp_create_early_bad_bind)
 TEST_DECLARE   (udp_create_early_bad_domain)
 TEST_DECLARE   (udp_send_and_recv)
 TEST_DECLARE   (udp_send_immediate)
+TEST_DECLARE   (udp_mmsg)
+TEST_DECLARE   (udp_mmsg_flags)
 TEST_DECLARE   (udp_send_unreachable)
 TEST_DECLARE   (udp_multicast_join)
 TEST_DECLARE   (udp_multicast_join6)
@@ -152,6 +169,7 @@ TEST_DECLARE   (timer_huge_repeat)
 TEST_DECLARE   (timer_run_once)
 TEST_DECLARE   (timer_from_check)
 TEST_DECLARE   (timer_null_callback)
+TEST_DECLARE   (timer_wheel)
 TEST_DECLARE   (idle_starvation)
 TEST_DECLARE   (loop_handles)
 TEST_DECLARE   (get_loadavg)
@@ -183,12 +201,18 @@ TEST_DECLARE   (pipe_ref4)
 TEST_DECLARE   (pipe_close_stdout_read_stdin)
 #endif
 TEST_DECLARE   (pipe_set_non_blocking)
+TEST_DECLARE   (pipe_write_coalescing)
+TEST_DECLARE   (read_buf_pool)
+TEST_DECLARE   (read_buf_pool_batching)
 TEST_DECLARE   (process_ref)
 TEST_DECLARE   (has_ref)
 TEST_DECLARE   (active)
 TEST_DECLARE   (embed)
 TEST_DECLARE   (async)
 TEST_DECLARE   (async_null_cb)
+TEST_DECLARE   (async_msg)
+TEST_DECLARE   (async_many_handles)
+TEST_DECLARE   (async_close_pending)
 TEST_DECLARE   (get_currentexe)
 TEST_DECLARE   (process_title)
 TEST_DECLARE   (cwd_and_chdir)
@@ -201,6 +225,10 @@ TEST_DECLARE   (getaddrinfo_fail_sync)
 TEST_DECLARE   (getaddrinfo_basic)
 TEST_DECLARE   (getaddrinfo_basic_sync)
 TEST_DECLARE   (getaddrinfo_concurrent)
+TEST_DECLARE   (getaddrinfo_cache)
+TEST_DECLARE   (getaddrinfo_resolver_udp)
+TEST_DECLARE   (getaddrinfo_resolver_tcp)
+TEST_DECLARE   (getaddrinfo_resolver_hosts)
 TEST_DECLARE   (getnameinfo_basic_ip4)
 TEST_DECLARE   (getnameinfo_basic_ip4_sync)
 TEST_DECLARE   (getnameinfo_basic_ip6)
@@ -235,6 +263,9 @@ TEST_DECLARE   (spawn_reads_child_path)
 TEST_DECLARE   (spawn_inherit_streams)
 TEST_DECLARE   (fs_poll)
 TEST_DECLARE   (fs_poll_getpath)
+TEST_DECLARE   (fs_poll_many)
+TEST_DECLARE   (fs_poll_replace)
+TEST_DECLARE   (fs_poll_parent_replaced)
 TEST_DECLARE   (kill)
 TEST_DECLARE   (fs_file_noent)
 TEST_DECLARE   (fs_file_nametoolong)
@@ -261,6 +292,8 @@ TEST_DECLARE   (fs_stat_missing_path)
 TEST_DECLARE   (fs_read_file_eof)
 TEST_DECLARE   (fs_event_watch_dir)
 TEST_DECLARE   (fs_event_watch_dir_recursive)
+TEST_DECLARE   (fs_event_watch_dir_recursive_new_subdir)
+TEST_DECLARE   (fs_event_batching)
 TEST_DECLARE   (fs_event_watch_file)
 TEST_DECLARE   (fs_event_watch_file_twice)
 TEST_DECLARE   (fs_event_watch_file_current_dir)
@@ -274,14 +307,21 @@ TEST_DECLARE   (fs_event_error_reporting)
 TEST_DECLARE   (fs_event_getpath)
 TEST_DECLARE   (fs_scandir_empty_dir)
 TEST_DECLARE   (fs_scandir_file)
+TEST_DECLARE   (fs_walk)
+TEST_DECLARE   (fs_walk_batches)
+TEST_DECLARE   (fs_walk_error)
 TEST_DECLARE   (fs_open_dir)
 TEST_DECLARE   (fs_rename_to_existing_file)
 TEST_DECLARE   (fs_write_multiple_bufs)
 TEST_DECLARE   (fs_read_write_null_arguments)
+TEST_DECLARE   (fs_many_concurrent_reqs)
 TEST_DECLARE   (fs_write_alotof_bufs)
 TEST_DECLARE   (fs_write_alotof_bufs_with_offset)
 TEST_DECLARE   (threadpool_queue_work_simple)
 TEST_DECLARE   (threadpool_queue_work_einval)
+TEST_DECLARE   (threadpool_loop_configure)
+TEST_DECLARE   (threadpool_queue_work_ex)
+TEST_DECLARE   (threadpool_limit_private)
 TEST_DECLARE   (threadpool_multiple_event_loops)
 TEST_DECLARE   (threadpool_cancel_getaddrinfo)
 TEST_DECLARE   (threadpool_cancel_getnameinfo)
@@ -289,6 +329,7 @@ TEST_DECLARE   (threadpool_cancel_work)
 TEST_DECLARE   (threadpool_cancel_fs)
 TEST_DECLARE   (threadpool_cancel_single)
 TEST_DECLARE   (thread_local_storage)
+TEST_DECLARE   (thread_affinity)
 TEST_DECLARE   (thread_mutex)
 TEST_DECLARE   (thread_rwlock)
 TEST_DECLARE   (thread_rwlock_trylock)
@@ -333,6 +374,7 @@ HELPER_DECLARE (tcp4_echo_server)
 HELPER_DECLARE (tcp6_echo_server)
 HELPER_DECLARE (udp4_echo_server)
 HELPER_DECLARE (pipe_echo_server)
+HELPER_DECLARE (dns_server)
 
 
 TASK_LIST_START
@@ -350,6 +392,10 @@ TASK_LIST_START
   TEST_ENTRY  (loop_update_time)
   TEST_ENTRY  (loop_backend_timeout)
   TEST_ENTRY  (loop_configure)
+  TEST_ENTRY  (loop_metrics)
+  TEST_ENTRY  (loop_metrics_many_fds)
+  TEST_ENTRY  (loop_metrics_phases)
+  TEST_ENTRY  (loop_metrics_threaded)
   TEST_ENTRY  (default_loop_close)
   TEST_ENTRY  (barrier_1)
   TEST_ENTRY  (barrier_2)
@@ -372,6 +418,9 @@ TASK_LIST_START
   TEST_ENTRY  (pipe_close_stdout_read_stdin)
 #endif
   TEST_ENTRY  (pipe_set_non_blocking)
+  TEST_ENTRY  (pipe_write_coalescing)
+  TEST_ENTRY  (read_buf_pool)
+  TEST_ENTRY  (read_buf_pool_batching)
   TEST_ENTRY  (tty)
   TEST_ENTRY  (tty_file)
   TEST_ENTRY  (stdio_over_pipes)
@@ -425,6 +474,8 @@ TASK_LIST_START
   TEST_ENTRY  (tcp_bind_error_inval)
   TEST_ENTRY  (tcp_bind_localhost_ok)
   TEST_ENTRY  (tcp_bind_invalid_flags)
+  TEST_ENTRY  (tcp_reuseport)
+  TEST_ENTRY  (tcp_reuseport_bind_error)
   TEST_ENTRY  (tcp_listen_without_bind)
   TEST_ENTRY  (tcp_connect_error_fault)
   TEST_ENTRY  (tcp_connect_timeout)
@@ -434,12 +485,21 @@ TASK_LIST_START
   TEST_ENTRY  (tcp_create_early_bad_bind)
   TEST_ENTRY  (tcp_create_early_bad_domain)
   TEST_ENTRY  (tcp_create_early_accept)
+  TEST_ENTRY  (tcp_alloc)
+  TEST_ENTRY  (tcp_alloc_accept)
+  TEST_ENTRY  (tcp_alloc_free_after_loop_close)
 #ifndef _WIN32
   TEST_ENTRY  (tcp_close_accept)
   TEST_ENTRY  (tcp_oob)
 #endif
   TEST_ENTRY  (tcp_flags)
   TEST_ENTRY  (tcp_write_to_half_open_connection)
+  TEST_ENTRY  (stream_sendfile)
+  TEST_ENTRY  (stream_sendfile_eof)
+  TEST_ENTRY  (stream_sendfile_einval)
+#ifndef _WIN32
+  TEST_ENTRY  (stream_sendfile_pipe)
+#endif
   TEST_ENTRY  (tcp_unexpected_read)
 
   TEST_ENTRY  (tcp_read_stop)
@@ -458,6 +518,8 @@ TASK_LIST_START
   TEST_ENTRY  (udp_create_early_bad_domain)
   TEST_ENTRY  (udp_send_and_recv)
   TEST_ENTRY  (udp_send_immediate)
+  TEST_ENTRY  (udp_mmsg)
+  TEST_ENTRY  (udp_mmsg_flags)
   TEST_ENTRY  (udp_send_unreachable)
   TEST_ENTRY  (udp_dgram_too_big)
   TEST_ENTRY  (udp_dual_stack)
@@ -516,6 +578,7 @@ TASK_LIST_START
   TEST_ENTRY  (timer_run_once)
   TEST_ENTRY  (timer_from_check)
   TEST_ENTRY  (timer_null_callback)
+  TEST_ENTRY  (timer_wheel)
 
   TEST_ENTRY  (idle_starvation)
 
@@ -560,6 +623,9 @@ TASK_LIST_START
 
   TEST_ENTRY  (async)
   TEST_ENTRY  (async_null_cb)
+  TEST_ENTRY  (async_msg)
+  TEST_ENTRY  (async_many_handles)
+  TEST_ENTRY  (async_close_pending)
 
   TEST_ENTRY  (get_currentexe)
 
@@ -584,6 +650,12 @@ TASK_LIST_START
   TEST_ENTRY  (getaddrinfo_basic_sync)
   TEST_ENTRY  (getaddrinfo_concurrent)
 
+  TEST_ENTRY  (getaddrinfo_cache)
+  TEST_ENTRY  (getaddrinfo_resolver_udp)
+  TEST_ENTRY  (getaddrinfo_resolver_tcp)
+  TEST_HELPER (getaddrinfo_resolver_tcp, dns_server)
+  TEST_ENTRY  (getaddrinfo_resolver_hosts)
+
   TEST_ENTRY  (getnameinfo_basic_ip4)
   TEST_ENTRY  (getnameinfo_basic_ip4_sync)
   TEST_ENTRY  (getnameinfo_basic_ip6)
@@ -623,6 +695,9 @@ TASK_LIST_START
   TEST_ENTRY  (spawn_inherit_streams)
   TEST_ENTRY  (fs_poll)
   TEST_ENTRY  (fs_poll_getpath)
+  TEST_ENTRY  (fs_poll_many)
+  TEST_ENTRY  (fs_poll_replace)
+  TEST_ENTRY  (fs_poll_parent_replaced)
   TEST_ENTRY  (kill)
 
 #ifdef _WIN32
@@ -678,6 +753,8 @@ TASK_LIST_START
   TEST_ENTRY  (fs_file_open_append)
   TEST_ENTRY  (fs_event_watch_dir)
   TEST_ENTRY  (fs_event_watch_dir_recursive)
+  TEST_ENTRY  (fs_event_watch_dir_recursive_new_subdir)
+  TEST_ENTRY  (fs_event_batching)
   TEST_ENTRY  (fs_event_watch_file)
   TEST_ENTRY  (fs_event_watch_file_twice)
   TEST_ENTRY  (fs_event_watch_file_current_dir)
@@ -691,14 +768,21 @@ TASK_LIST_START
   TEST_ENTRY  (fs_event_getpath)
   TEST_ENTRY  (fs_scandir_empty_dir)
   TEST_ENTRY  (fs_scandir_file)
+  TEST_ENTRY  (fs_walk)
+  TEST_ENTRY  (fs_walk_batches)
+  TEST_ENTRY  (fs_walk_error)
   TEST_ENTRY  (fs_open_dir)
   TEST_ENTRY  (fs_rename_to_existing_file)
   TEST_ENTRY  (fs_write_multiple_bufs)
   TEST_ENTRY  (fs_write_alotof_bufs)
   TEST_ENTRY  (fs_write_alotof_bufs_with_offset)
   TEST_ENTRY  (fs_read_write_null_arguments)
+  TEST_ENTRY  (fs_many_concurrent_reqs)
   TEST_ENTRY  (threadpool_queue_work_simple)
   TEST_ENTRY  (threadpool_queue_work_einval)
+  TEST_ENTRY  (threadpool_loop_configure)
+  TEST_ENTRY  (threadpool_queue_work_ex)
+  TEST_ENTRY  (threadpool_limit_private)
   TEST_ENTRY  (threadpool_multiple_event_loops)
   TEST_ENTRY  (threadpool_cancel_getaddrinfo)
   TEST_ENTRY  (threadpool_cancel_getnameinfo)
@@ -706,6 +790,7 @@ TASK_LIST_START
   TEST_ENTRY  (threadpool_cancel_fs)
   TEST_ENTRY  (threadpool_cancel_single)
   TEST_ENTRY  (thread_local_storage)
+  TEST_ENTRY  (thread_affinity)
   TEST_ENTRY  (thread_mutex)
   TEST_ENTRY  (thread_rwlock)
   TEST_ENTRY  (thread_rwlock_trylock)
@@ -0,0 +1,288 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
+
+static int poll_cb_called;
+
+
+#ifndef _WIN32
+static void poll_cb(uv_poll_t* handle, int status, int events) {
+  ASSERT(status == 0);
+  ASSERT(events == UV_READABLE);
+  poll_cb_called++;
+  uv_close((uv_handle_t*) handle, NULL);
+}
+#endif
+
+
+TEST_IMPL(loop_metrics) {
+  uv_loop_metrics_t metrics;
+  uv_loop_t loop;
+#ifndef _WIN32
+  uv_poll_t poll_handle;
+  int fds[2];
+#endif
+
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(UV_EINVAL == uv_loop_metrics(&loop, NULL));
+  ASSERT(0 == uv_loop_metrics(&loop, &metrics));
+  ASSERT(0 == metrics.poll_ctl);
+
+#ifndef _WIN32
+  ASSERT(0 == pipe(fds));
+  ASSERT(1 == write(fds[1], "x", 1));
+  ASSERT(0 == uv_poll_init(&loop, &poll_handle, fds[0]));
+  ASSERT(0 == uv_poll_start(&poll_handle, UV_READABLE, poll_cb));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(1 == poll_cb_called);
+
+  ASSERT(0 == uv_loop_metrics(&loop, &metrics));
+  ASSERT(0 == metrics.iterations);  /* Not enabled. */
+#if defined(__linux__)
+  /* At least the EPOLL_CTL_ADD that started the watcher. */
+  ASSERT(metrics.poll_ctl > 0);
+  ASSERT(metrics.poll_wakeups > 0);
+  ASSERT(metrics.poll_events > 0);
+#endif
+
+  ASSERT(0 == close(fds[0]));
+  ASSERT(0 == close(fds[1]));
+#endif
+
+  ASSERT(0 == uv_loop_close(&loop));
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#ifndef _WIN32
+static void many_fds_poll_cb(uv_poll_t* handle, int status, int events) {
+  char c;
+
+  ASSERT(status == 0);
+  ASSERT(events == UV_READABLE);
+  ASSERT(1 == read(handle->io_watcher.fd, &c, 1));
+  poll_cb_called++;
+  uv_close((uv_handle_t*) handle, NULL);
+}
+#endif
+
+
+TEST_IMPL(loop_metrics_many_fds) {
+#ifdef _WIN32
+  RETURN_SKIP("Test uses pipe(2) with uv_poll_t.");
+#else
+  /* More ready file descriptors than fit in the smallest event buffer. */
+  uv_poll_t poll_handles[1500];
+  int fds[ARRAY_SIZE(poll_handles)][2];
+  uv_loop_metrics_t metrics;
+  uv_loop_t loop;
+  unsigned int i;
+
+  TEST_FILE_LIMIT(ARRAY_SIZE(fds) * 2 + 32);
+
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(UV_EINVAL == uv_loop_configure(&loop, UV_LOOP_POLL_BUDGET, 0));
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_POLL_BUDGET, 2));
+
+  for (i = 0; i < ARRAY_SIZE(fds); i++) {
+    ASSERT(0 == pipe(fds[i]));
+    ASSERT(1 == write(fds[i][1], "x", 1));
+    ASSERT(0 == uv_poll_init(&loop, poll_handles + i, fds[i][0]));
+    ASSERT(0 == uv_poll_start(poll_handles + i, UV_READABLE, many_fds_poll_cb));
+  }
+
+  poll_cb_called = 0;
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(ARRAY_SIZE(fds) == (unsigned int) poll_cb_called);
+
+  ASSERT(0 == uv_loop_metrics(&loop, &metrics));
+#if defined(__linux__)
+  ASSERT(metrics.poll_events >= ARRAY_SIZE(fds));
+  ASSERT(metrics.poll_wakeups > 0);
+  ASSERT(metrics.poll_wakeups <= metrics.poll_events);
+#endif
+
+  for (i = 0; i < ARRAY_SIZE(fds); i++) {
+    ASSERT(0 == close(fds[i][0]));
+    ASSERT(0 == close(fds[i][1]));
+  }
+
+  ASSERT(0 == uv_loop_close(&loop));
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
+
+
+static uv_loop_t metered_loop;
+static uv_idle_t idle_handle;
+static uv_timer_t timer_handle;
+static uv_work_t work_req;
+static int work_cb_called;
+static int after_work_cb_called;
+static int idle_cb_called;
+static volatile int reader_done;
+
+
+static void busy_wait(uint64_t ms) {
+  uint64_t start;
+
+  start = uv_hrtime();
+  while (uv_hrtime() - start < ms * 1000000)
+    ;
+}
+
+
+static void lag_timer_cb(uv_timer_t* handle) {
+  busy_wait(20);
+  uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+static void work_cb(uv_work_t* req) {
+  work_cb_called++;
+}
+
+
+static void after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  after_work_cb_called++;
+}
+
+
+static uint64_t lag_total(const uv_loop_metrics_t* metrics) {
+  uint64_t total;
+  unsigned int i;
+
+  total = 0;
+  for (i = 0; i < UV_LOOP_LAG_BUCKETS; i++)
+    total += metrics->lag[i];
+
+  return total;
+}
+
+
+TEST_IMPL(loop_metrics_phases) {
+  uv_loop_metrics_t metrics;
+  unsigned int i;
+  int r;
+
+  ASSERT(0 == uv_loop_init(&metered_loop));
+  r = uv_loop_configure(&metered_loop, UV_LOOP_METRICS, 1);
+  if (r == UV_ENOSYS) {
+    ASSERT(0 == uv_loop_close(&metered_loop));
+    RETURN_SKIP("UV_LOOP_METRICS not supported on this platform.");
+  }
+  ASSERT(r == 0);
+
+  ASSERT(0 == uv_timer_init(&metered_loop, &timer_handle));
+  ASSERT(0 == uv_timer_start(&timer_handle, lag_timer_cb, 1, 0));
+  ASSERT(0 == uv_queue_work(&metered_loop, &work_req, work_cb, after_work_cb));
+  ASSERT(0 == uv_run(&metered_loop, UV_RUN_DEFAULT));
+  ASSERT(1 == work_cb_called);
+  ASSERT(1 == after_work_cb_called);
+
+  ASSERT(0 == uv_loop_metrics(&metered_loop, &metrics));
+  ASSERT(metrics.iterations > 0);
+  ASSERT(metrics.iterations == lag_total(&metrics));
+  ASSERT(metrics.phase_time[UV_PHASE_TIMERS] >= 20 * 1000000);
+  ASSERT(metrics.max_callback_time >= 20 * 1000000);
+  /* The timer, the thread pool wakeup and the timer's close. */
+  ASSERT(metrics.callbacks >= 2);
+  ASSERT(metrics.max_callbacks >= 1);
+  ASSERT(metrics.work_completed == 1);
+
+  /* 20 ms goes in the bucket for [16384, 32768) microseconds or later. */
+  for (r = 0, i = 15; i < UV_LOOP_LAG_BUCKETS; i++)
+    r += (int) metrics.lag[i];
+  ASSERT(r == 1);
+
+  /* Disabling freezes the extended counters. */
+  ASSERT(0 == uv_loop_configure(&metered_loop, UV_LOOP_METRICS, 0));
+  ASSERT(0 == uv_timer_init(&metered_loop, &timer_handle));
+  uv_close((uv_handle_t*) &timer_handle, NULL);
+  ASSERT(0 == uv_run(&metered_loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_metrics(&metered_loop, &metrics));
+  ASSERT(metrics.iterations == lag_total(&metrics));
+
+  ASSERT(0 == uv_loop_close(&metered_loop));
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void reader_thread(void* arg) {
+  uv_loop_metrics_t metrics;
+  uint64_t iterations;
+
+  iterations = 0;
+  while (!reader_done) {
+    ASSERT(0 == uv_loop_metrics(&metered_loop, &metrics));
+    /* A torn read would break the invariant or go back in time. */
+    ASSERT(metrics.iterations == lag_total(&metrics));
+    ASSERT(metrics.iterations >= iterations);
+    iterations = metrics.iterations;
+  }
+}
+
+
+static void idle_cb(uv_idle_t* handle) {
+  if (++idle_cb_called == 100000)
+    uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+TEST_IMPL(loop_metrics_threaded) {
+  uv_loop_metrics_t metrics;
+  uv_thread_t thread;
+  int r;
+
+  ASSERT(0 == uv_loop_init(&metered_loop));
+  r = uv_loop_configure(&metered_loop, UV_LOOP_METRICS, 1);
+  if (r == UV_ENOSYS) {
+    ASSERT(0 == uv_loop_close(&metered_loop));
+    RETURN_SKIP("UV_LOOP_METRICS not supported on this platform.");
+  }
+  ASSERT(r == 0);
+
+  ASSERT(0 == uv_idle_init(&metered_loop, &idle_handle));
+  ASSERT(0 == uv_idle_start(&idle_handle, idle_cb));
+  ASSERT(0 == uv_thread_create(&thread, reader_thread, NULL));
+  ASSERT(0 == uv_run(&metered_loop, UV_RUN_DEFAULT));
+  reader_done = 1;
+  ASSERT(0 == uv_thread_join(&thread));
+
+  ASSERT(0 == uv_loop_metrics(&metered_loop, &metrics));
+  ASSERT(metrics.iterations >= 100000);
+  ASSERT(metrics.callbacks >= 100000);
+
+  ASSERT(0 == uv_loop_close(&metered_loop));
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
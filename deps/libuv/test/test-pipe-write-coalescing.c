@@ -0,0 +1,100 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#ifdef _WIN32
+
+TEST_IMPL(pipe_write_coalescing) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+#else  /* !_WIN32 */
+
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define NUM_WRITES 100
+
+static uv_write_t write_reqs[NUM_WRITES];
+static int write_cb_called;
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  /* Callbacks still fire in submission order. */
+  ASSERT(req == &write_reqs[write_cb_called]);
+  write_cb_called++;
+}
+
+
+TEST_IMPL(pipe_write_coalescing) {
+  uv_loop_metrics_t metrics;
+  uv_pipe_t pipe_handle;
+  uv_buf_t buf;
+  char data[NUM_WRITES * 2];
+  char expected[NUM_WRITES * 2];
+  ssize_t n;
+  int fd[2];
+  int i;
+
+  ASSERT(0 == uv_pipe_init(uv_default_loop(), &pipe_handle, 0));
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fd));
+  ASSERT(0 == uv_pipe_open(&pipe_handle, fd[0]));
+  ASSERT(0 == uv_stream_set_write_coalescing((uv_stream_t*) &pipe_handle, 1));
+
+  for (i = 0; i < NUM_WRITES; i++) {
+    expected[2 * i] = 'a' + i % 26;
+    expected[2 * i + 1] = '.';
+    buf = uv_buf_init(expected + 2 * i, 2);
+    ASSERT(0 == uv_write(&write_reqs[i],
+                         (uv_stream_t*) &pipe_handle,
+                         &buf,
+                         1,
+                         write_cb));
+  }
+
+  /* Nothing is written until the loop runs. */
+  ASSERT(pipe_handle.write_queue_size == sizeof(expected));
+  ASSERT(write_cb_called == 0);
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_ONCE));
+  ASSERT(write_cb_called == NUM_WRITES);
+  ASSERT(pipe_handle.write_queue_size == 0);
+
+  ASSERT(0 == uv_loop_metrics(uv_default_loop(), &metrics));
+  ASSERT(metrics.stream_writes == 1);
+
+  n = read(fd[1], data, sizeof(data));
+  ASSERT(n == sizeof(data));
+  ASSERT(0 == memcmp(data, expected, sizeof(data)));
+
+  uv_close((uv_handle_t*) &pipe_handle, NULL);
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(0 == close(fd[1]));  /* fd[0] is closed by uv_close(). */
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif  /* !_WIN32 */
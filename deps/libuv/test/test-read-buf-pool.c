@@ -0,0 +1,159 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+
+TEST_IMPL(read_buf_pool) {
+  uv_loop_metrics_t metrics;
+  uv_idle_t idle;
+  uv_loop_t loop;
+  uv_buf_t a;
+  uv_buf_t b;
+  char* base;
+
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_idle_init(&loop, &idle));
+
+  uv_read_buf_alloc((uv_handle_t*) &idle, 1, &a);
+  ASSERT(a.base != NULL);
+  ASSERT(a.len == 64 * 1024);
+  memset(a.base, 'x', a.len);
+
+  /* A released chunk is handed out again without a new allocation. */
+  base = a.base;
+  uv_read_buf_unref(a.base);
+  uv_read_buf_alloc((uv_handle_t*) &idle, 1, &a);
+  ASSERT(a.base == base);
+  ASSERT(0 == uv_loop_metrics(&loop, &metrics));
+  ASSERT(metrics.read_buf_allocs == 1);
+
+  /* An extra reference keeps the chunk out of the pool. */
+  uv_read_buf_ref(a.base);
+  uv_read_buf_unref(a.base);
+  uv_read_buf_alloc((uv_handle_t*) &idle, 1, &b);
+  ASSERT(b.base != a.base);
+  uv_read_buf_unref(a.base);
+  uv_read_buf_unref(b.base);
+  uv_read_buf_unref(NULL);
+
+  ASSERT(UV_EINVAL == uv_loop_configure(&loop, UV_LOOP_READ_BUF_SIZE, 0));
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_READ_BUF_SIZE, 512));
+  uv_read_buf_alloc((uv_handle_t*) &idle, 1, &a);
+  ASSERT(a.len == 512);
+  uv_read_buf_unref(a.base);
+  ASSERT(0 == uv_loop_metrics(&loop, &metrics));
+  ASSERT(metrics.read_buf_allocs == 3);
+
+  /* A chunk may outlive its loop. */
+  uv_read_buf_alloc((uv_handle_t*) &idle, 1, &a);
+  uv_read_buf_ref(a.base);
+  uv_close((uv_handle_t*) &idle, NULL);
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+  memset(a.base, 'x', a.len);
+  uv_read_buf_unref(a.base);
+  uv_read_buf_unref(a.base);
+
+  return 0;
+}
+
+
+#ifndef _WIN32
+
+static char expected[100];
+static char received[sizeof(expected)];
+static size_t nreceived;
+static int read_cb_called;
+static int eof_cb_called;
+
+
+static void batch_read_cb(uv_stream_t* stream,
+                          ssize_t nread,
+                          const uv_buf_t* buf) {
+  if (nread == UV_EOF) {
+    /* The data that came before EOF has been handed out already. */
+    ASSERT(buf->base == NULL);
+    eof_cb_called++;
+    uv_close((uv_handle_t*) stream, NULL);
+    return;
+  }
+
+  ASSERT(nread >= 0);
+  ASSERT(nreceived + nread <= sizeof(received));
+  memcpy(received + nreceived, buf->base, nread);
+  nreceived += nread;
+  if (nread > 0)
+    read_cb_called++;
+
+  uv_read_buf_unref(buf->base);
+}
+
+#endif
+
+
+TEST_IMPL(read_buf_pool_batching) {
+#ifdef _WIN32
+  RETURN_SKIP("Read batching is not supported on Windows.");
+#else
+  uv_pipe_t pipe_handle;
+  uv_loop_t* loop;
+  size_t i;
+  int fd[2];
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_READ_BUF_SIZE, 64));
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fd));
+  ASSERT(0 == uv_pipe_init(loop, &pipe_handle, 0));
+  ASSERT(0 == uv_pipe_open(&pipe_handle, fd[0]));
+  ASSERT(0 == uv_stream_set_read_batching((uv_stream_t*) &pipe_handle, 1));
+
+  for (i = 0; i < sizeof(expected); i++)
+    expected[i] = 'a' + i % 26;
+
+  /* Data in small pieces followed by EOF. */
+  for (i = 0; i < sizeof(expected); i += 10)
+    ASSERT(10 == write(fd[1], expected + i, 10));
+  ASSERT(0 == close(fd[1]));
+
+  ASSERT(0 == uv_read_start((uv_stream_t*) &pipe_handle,
+                            uv_read_buf_alloc,
+                            batch_read_cb));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  /* 100 bytes in 64 byte chunks: one full chunk, then the rest. */
+  ASSERT(nreceived == sizeof(expected));
+  ASSERT(0 == memcmp(received, expected, sizeof(expected)));
+  ASSERT(read_cb_called == 2);
+  ASSERT(eof_cb_called == 1);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
@@ -0,0 +1,420 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#define FILE_NAME   "test_sendfile_file"
+#define FILE_SIZE   (4 * 1024 * 1024)
+#define PIPE_SIZE   (1024 * 1024)
+#define HEAD        "HEAD"
+#define TAIL        "TAIL"
+
+static uv_tcp_t server;
+static uv_tcp_t conn;
+static uv_tcp_t client;
+static uv_connect_t connect_req;
+static uv_write_t head_req;
+static uv_write_t file_req;
+static uv_write_t tail_req;
+static uv_shutdown_t shutdown_req;
+static uv_timer_t timer;
+
+static char* expected;
+static size_t expected_len;
+static char* received;
+static size_t received_len;
+
+static uv_file file;
+static int64_t file_offset;
+static size_t file_length;
+static int file_status;
+static int tail_status;
+static int pipe_fds[2];
+static size_t pipe_written;
+
+static int write_cb_called;
+static int close_cb_called;
+
+
+static char pattern(size_t i) {
+  return (char) (i * 31 % 251);
+}
+
+
+static void make_file(void) {
+  uv_fs_t req;
+  uv_buf_t buf;
+  char* data;
+  size_t i;
+
+  data = malloc(FILE_SIZE);
+  ASSERT(data != NULL);
+  for (i = 0; i < FILE_SIZE; i++)
+    data[i] = pattern(i);
+
+  file = uv_fs_open(NULL,
+                    &req,
+                    FILE_NAME,
+                    O_RDWR | O_CREAT | O_TRUNC,
+                    S_IRUSR | S_IWUSR,
+                    NULL);
+  ASSERT(file >= 0);
+  uv_fs_req_cleanup(&req);
+
+  buf = uv_buf_init(data, FILE_SIZE);
+  ASSERT(FILE_SIZE == uv_fs_write(NULL, &req, file, &buf, 1, 0, NULL));
+  uv_fs_req_cleanup(&req);
+  free(data);
+}
+
+
+static void close_file(void) {
+  uv_fs_t req;
+
+  ASSERT(0 == uv_fs_close(NULL, &req, file, NULL));
+  uv_fs_req_cleanup(&req);
+  ASSERT(0 == uv_fs_unlink(NULL, &req, FILE_NAME, NULL));
+  uv_fs_req_cleanup(&req);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  buf->base = received + received_len;
+  buf->len = expected_len + 1 - received_len;
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (nread > 0) {
+    received_len += nread;
+    ASSERT(received_len <= expected_len);
+    return;
+  }
+
+  if (nread == 0)
+    return;
+
+  ASSERT(nread == UV_EOF);
+  uv_close((uv_handle_t*) stream, close_cb);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_read_start((uv_stream_t*) &client, alloc_cb, read_cb));
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  if (req == &head_req)
+    ASSERT(status == 0);
+  else if (req == &tail_req)
+    tail_status = status;
+  else if (req == &file_req)
+    file_status = status;
+  else
+    ASSERT(0 && "unexpected write_cb");
+
+  /* Like any other failed write, the stream is useless now. */
+  if (req == &file_req && status != 0)
+    uv_close((uv_handle_t*) &conn, close_cb);
+
+  write_cb_called++;
+}
+
+
+static void shutdown_cb(uv_shutdown_t* req, int status) {
+  if (status == 0)
+    uv_close((uv_handle_t*) &conn, close_cb);
+}
+
+
+static void connection_cb(uv_stream_t* stream, int status) {
+  uv_buf_t buf;
+  int r;
+
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(stream->loop, &conn));
+  ASSERT(0 == uv_accept(stream, (uv_stream_t*) &conn));
+  uv_close((uv_handle_t*) &server, close_cb);
+
+  /* The file must go out between the other two writes. */
+  buf = uv_buf_init(HEAD, sizeof(HEAD) - 1);
+  ASSERT(0 == uv_write(&head_req, (uv_stream_t*) &conn, &buf, 1, write_cb));
+
+  r = uv_stream_sendfile(&file_req,
+                         (uv_stream_t*) &conn,
+                         file,
+                         file_offset,
+                         file_length,
+                         write_cb);
+  ASSERT(r == 0);
+
+  buf = uv_buf_init(TAIL, sizeof(TAIL) - 1);
+  ASSERT(0 == uv_write(&tail_req, (uv_stream_t*) &conn, &buf, 1, write_cb));
+  ASSERT(0 == uv_shutdown(&shutdown_req, (uv_stream_t*) &conn, shutdown_cb));
+}
+
+
+static void expect(const char* data, size_t len) {
+  memcpy(expected + expected_len, data, len);
+  expected_len += len;
+}
+
+
+static void expect_file(int64_t offset, size_t len) {
+  size_t i;
+
+  for (i = 0; i < len; i++)
+    expected[expected_len++] = pattern(offset + i);
+}
+
+
+static void run(void) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 1, connection_cb));
+
+  ASSERT(0 == uv_tcp_init(loop, &client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  received = malloc(expected_len + 1);
+  ASSERT(received != NULL);
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(write_cb_called == 3);
+
+  ASSERT(received_len == expected_len);
+  ASSERT(0 == memcmp(received, expected, expected_len));
+
+  free(received);
+  free(expected);
+}
+
+
+TEST_IMPL(stream_sendfile) {
+  uv_write_t req;
+  uv_tcp_t tcp;
+  int r;
+
+  make_file();
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &tcp));
+  r = uv_stream_sendfile(&req, (uv_stream_t*) &tcp, file, 0, 1, write_cb);
+  if (r == UV_ENOSYS)
+    RETURN_SKIP("uv_stream_sendfile() is not supported on this platform.");
+  uv_close((uv_handle_t*) &tcp, NULL);
+  uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+  /* A range out of the middle of the file, like a HTTP range request. */
+  file_offset = 12345;
+  file_length = FILE_SIZE - 2 * 12345;
+
+  expected = malloc(FILE_SIZE + 16);
+  ASSERT(expected != NULL);
+  expect(HEAD, sizeof(HEAD) - 1);
+  expect_file(file_offset, file_length);
+  expect(TAIL, sizeof(TAIL) - 1);
+
+  run();
+  ASSERT(file_status == 0);
+  ASSERT(tail_status == 0);
+  ASSERT(close_cb_called == 3);
+
+  close_file();
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(stream_sendfile_eof) {
+  make_file();
+
+  /* Runs past the end of the file. What is there goes out, then the request
+   * fails. Like with any failed write, what was queued behind it is not held
+   * back; it is up to the user to close the stream.
+   */
+  file_offset = FILE_SIZE - 100;
+  file_length = 1000;
+
+  expected = malloc(128);
+  ASSERT(expected != NULL);
+  expect(HEAD, sizeof(HEAD) - 1);
+  expect_file(file_offset, 100);
+  expect(TAIL, sizeof(TAIL) - 1);
+
+  run();
+  ASSERT(file_status == UV_EOF);
+  ASSERT(tail_status == 0);
+  ASSERT(close_cb_called == 3);
+
+  close_file();
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(stream_sendfile_einval) {
+  uv_write_t req;
+  uv_tcp_t tcp;
+  uv_fs_t fs_req;
+  int r;
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &tcp));
+  make_file();
+
+  r = uv_stream_sendfile(&req, (uv_stream_t*) &tcp, file, 0, 0, write_cb);
+  if (r == UV_ENOSYS)
+    RETURN_SKIP("uv_stream_sendfile() is not supported on this platform.");
+  ASSERT(r == UV_EINVAL);
+
+  /* Files need an offset. */
+  r = uv_stream_sendfile(&req, (uv_stream_t*) &tcp, file, -1, 1, write_cb);
+  ASSERT(r == UV_EINVAL);
+
+  close_file();
+
+  r = uv_stream_sendfile(&req, (uv_stream_t*) &tcp, file, 0, 1, write_cb);
+  ASSERT(r == UV_EBADF);
+
+  /* Directories can't be sent. */
+  r = uv_fs_open(NULL, &fs_req, ".", O_RDONLY, 0, NULL);
+  ASSERT(r >= 0);
+  uv_fs_req_cleanup(&fs_req);
+  file = r;
+  r = uv_stream_sendfile(&req, (uv_stream_t*) &tcp, file, 0, 1, write_cb);
+  ASSERT(r == UV_EINVAL);
+  ASSERT(0 == uv_fs_close(NULL, &fs_req, file, NULL));
+  uv_fs_req_cleanup(&fs_req);
+
+  uv_close((uv_handle_t*) &tcp, NULL);
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(write_cb_called == 0);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#ifndef _WIN32
+
+/* Feeds the pipe in small steps so the request keeps finding it empty. */
+static void timer_cb(uv_timer_t* handle) {
+  char buf[8192];
+  size_t len;
+  size_t i;
+  ssize_t n;
+
+  len = PIPE_SIZE - pipe_written;
+  if (len > sizeof(buf))
+    len = sizeof(buf);
+
+  for (i = 0; i < len; i++)
+    buf[i] = pattern(pipe_written + i);
+
+  n = write(pipe_fds[1], buf, len);
+  if (n == -1) {
+    ASSERT(errno == EAGAIN);
+    return;
+  }
+
+  pipe_written += n;
+  if (pipe_written == PIPE_SIZE) {
+    ASSERT(0 == close(pipe_fds[1]));
+    uv_close((uv_handle_t*) handle, close_cb);
+  }
+}
+
+
+TEST_IMPL(stream_sendfile_pipe) {
+  uv_write_t req;
+  uv_tcp_t tcp;
+  int r;
+
+  ASSERT(0 == pipe(pipe_fds));
+  ASSERT(0 == fcntl(pipe_fds[1], F_SETFL, O_NONBLOCK));
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &tcp));
+  r = uv_stream_sendfile(&req, (uv_stream_t*) &tcp, pipe_fds[0], -1, 1, NULL);
+  uv_close((uv_handle_t*) &tcp, NULL);
+  uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+  if (r == UV_ENOTSUP || r == UV_ENOSYS)
+    RETURN_SKIP("Pipes can't be sent on this platform.");
+
+  ASSERT(r == UV_EBADF);  /* The socket isn't open yet. */
+
+  /* Pipes have no offset. */
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &tcp));
+  r = uv_stream_sendfile(&req, (uv_stream_t*) &tcp, pipe_fds[0], 0, 1, NULL);
+  ASSERT(r == UV_EINVAL);
+  uv_close((uv_handle_t*) &tcp, NULL);
+  uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+  file = pipe_fds[0];
+  file_offset = -1;
+  file_length = PIPE_SIZE;
+
+  expected = malloc(PIPE_SIZE + 16);
+  ASSERT(expected != NULL);
+  expect(HEAD, sizeof(HEAD) - 1);
+  expect_file(0, PIPE_SIZE);
+  expect(TAIL, sizeof(TAIL) - 1);
+
+  ASSERT(0 == uv_timer_init(uv_default_loop(), &timer));
+  ASSERT(0 == uv_timer_start(&timer, timer_cb, 1, 1));
+
+  run();
+  ASSERT(file_status == 0);
+  ASSERT(tail_status == 0);
+  ASSERT(close_cb_called == 4);
+
+  ASSERT(0 == close(pipe_fds[0]));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif  /* !_WIN32 */
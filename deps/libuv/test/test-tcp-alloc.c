@@ -0,0 +1,206 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#define NUM_CONNS 10
+
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_connect_t connect_req;
+static int connections;
+static int close_cb_called;
+static int write_cb_called;
+static int eof_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+TEST_IMPL(tcp_alloc) {
+  uv_loop_metrics_t metrics;
+  uv_write_t* req;
+  uv_write_t* req2;
+  uv_tcp_t* handle;
+  uv_tcp_t* handle2;
+  uv_loop_t loop;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  handle = uv_tcp_alloc(&loop);
+  ASSERT(handle != NULL);
+  ASSERT(handle->type == UV_TCP);
+  ASSERT(handle->loop == &loop);
+
+  /* The memory is recycled after the close callback ran. */
+  uv_close((uv_handle_t*) handle, close_cb);
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(close_cb_called == 1);
+  handle2 = uv_tcp_alloc(&loop);
+  ASSERT(handle2 == handle);
+
+  req = uv_write_req_alloc(&loop);
+  ASSERT(req != NULL);
+  uv_write_req_free(req);
+  req2 = uv_write_req_alloc(&loop);
+  ASSERT(req2 == req);
+  uv_write_req_free(req2);
+  uv_write_req_free(NULL);
+
+  ASSERT(0 == uv_loop_metrics(&loop, &metrics));
+  ASSERT(metrics.pool_allocs == 2);
+
+  /* Closing the loop frees what's left in the pools. */
+  uv_close((uv_handle_t*) handle2, close_cb);
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(close_cb_called == 2);
+  ASSERT(0 == uv_loop_close(&loop));
+
+  return 0;
+}
+
+
+static void connect_cb(uv_connect_t* req, int status);
+
+
+static void connect_next(void) {
+  struct sockaddr_in addr;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+}
+
+
+static void client_close_cb(uv_handle_t* handle) {
+  if (++eof_cb_called < NUM_CONNS)
+    connect_next();
+  else
+    uv_close((uv_handle_t*) &server, NULL);
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[64];
+  *buf = uv_buf_init(slab, sizeof(slab));
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (nread == UV_EOF)
+    uv_close((uv_handle_t*) stream, client_close_cb);
+  else
+    ASSERT(nread >= 0);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_read_start((uv_stream_t*) &client, alloc_cb, read_cb));
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  write_cb_called++;
+  uv_close((uv_handle_t*) req->handle, close_cb);
+  uv_write_req_free(req);
+}
+
+
+static void connection_cb(uv_stream_t* stream, int status) {
+  uv_write_t* req;
+  uv_tcp_t* conn;
+  uv_buf_t buf;
+
+  ASSERT(status == 0);
+  connections++;
+
+  conn = uv_tcp_alloc(stream->loop);
+  ASSERT(conn != NULL);
+  ASSERT(0 == uv_accept(stream, (uv_stream_t*) conn));
+
+  req = uv_write_req_alloc(stream->loop);
+  ASSERT(req != NULL);
+  buf = uv_buf_init("hello", 5);
+  ASSERT(0 == uv_write(req, (uv_stream_t*) conn, &buf, 1, write_cb));
+}
+
+
+TEST_IMPL(tcp_alloc_accept) {
+  uv_loop_metrics_t metrics;
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("0.0.0.0", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  /* One connection at a time, so every one of them can reuse the handle and
+   * the write request of the one before it.
+   */
+  connect_next();
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(connections == NUM_CONNS);
+  ASSERT(write_cb_called == NUM_CONNS);
+  ASSERT(close_cb_called == NUM_CONNS);
+  ASSERT(eof_cb_called == NUM_CONNS);
+  ASSERT(0 == uv_loop_metrics(loop, &metrics));
+  ASSERT(metrics.pool_allocs == 2);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(tcp_alloc_free_after_loop_close) {
+  uv_write_t* req;
+  uv_write_t* req2;
+  uv_loop_t* loop;
+
+  loop = malloc(sizeof(*loop));
+  ASSERT(loop != NULL);
+  ASSERT(0 == uv_loop_init(loop));
+
+  req = uv_write_req_alloc(loop);
+  ASSERT(req != NULL);
+  req2 = uv_write_req_alloc(loop);
+  ASSERT(req2 != NULL);
+  uv_write_req_free(req2);
+
+  /* Requests that are still out outlive the loop and go straight back to
+   * the allocator, the last one takes the detached pool with it.
+   */
+  ASSERT(0 == uv_loop_close(loop));
+  free(loop);
+  uv_write_req_free(req);
+
+  return 0;
+}
@@ -0,0 +1,149 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#define NUM_CLIENTS 8
+
+static uv_tcp_t servers[2];
+static uv_tcp_t clients[NUM_CLIENTS];
+static uv_connect_t connect_reqs[NUM_CLIENTS];
+static uv_tcp_t accepted[NUM_CLIENTS];
+static int accepted_count;
+static int connect_cb_called;
+static int close_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void close_all(void) {
+  int i;
+
+  for (i = 0; i < NUM_CLIENTS; i++)
+    uv_close((uv_handle_t*) &clients[i], close_cb);
+  for (i = 0; i < accepted_count; i++)
+    uv_close((uv_handle_t*) &accepted[i], close_cb);
+  uv_close((uv_handle_t*) &servers[0], close_cb);
+  uv_close((uv_handle_t*) &servers[1], close_cb);
+}
+
+
+static void connection_cb(uv_stream_t* server, int status) {
+  ASSERT(status == 0);
+  ASSERT(accepted_count < NUM_CLIENTS);
+
+  ASSERT(0 == uv_tcp_init(server->loop, &accepted[accepted_count]));
+  ASSERT(0 == uv_accept(server, (uv_stream_t*) &accepted[accepted_count]));
+  accepted_count++;
+
+  if (accepted_count == NUM_CLIENTS && connect_cb_called == NUM_CLIENTS)
+    close_all();
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  connect_cb_called++;
+
+  if (accepted_count == NUM_CLIENTS && connect_cb_called == NUM_CLIENTS)
+    close_all();
+}
+
+
+TEST_IMPL(tcp_reuseport) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+  int r;
+  int i;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  ASSERT(0 == uv_tcp_init(loop, &servers[0]));
+  r = uv_tcp_bind(&servers[0], (const struct sockaddr*) &addr,
+                  UV_TCP_REUSEPORT);
+  if (r == UV_ENOTSUP) {
+    uv_close((uv_handle_t*) &servers[0], NULL);
+    uv_run(loop, UV_RUN_DEFAULT);
+    MAKE_VALGRIND_HAPPY();
+    RETURN_SKIP("SO_REUSEPORT load balancing is not supported.");
+  }
+  ASSERT(r == 0);
+  ASSERT(0 == uv_listen((uv_stream_t*) &servers[0], 128, connection_cb));
+
+  /* A second listener on the same address only succeeds with the flag. */
+  ASSERT(0 == uv_tcp_init(loop, &servers[1]));
+  ASSERT(0 == uv_tcp_bind(&servers[1], (const struct sockaddr*) &addr,
+                          UV_TCP_REUSEPORT));
+  ASSERT(0 == uv_listen((uv_stream_t*) &servers[1], 128, connection_cb));
+
+  for (i = 0; i < NUM_CLIENTS; i++) {
+    ASSERT(0 == uv_tcp_init(loop, &clients[i]));
+    ASSERT(0 == uv_tcp_connect(&connect_reqs[i],
+                               &clients[i],
+                               (const struct sockaddr*) &addr,
+                               connect_cb));
+  }
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(connect_cb_called == NUM_CLIENTS);
+  ASSERT(accepted_count == NUM_CLIENTS);
+  ASSERT(close_cb_called == 2 * NUM_CLIENTS + 2);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(tcp_reuseport_bind_error) {
+  struct sockaddr_in addr;
+  uv_tcp_t server1;
+  uv_tcp_t server2;
+  int r;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  /* Without the flag on both sockets the address is still exclusive. */
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &server1));
+  r = uv_tcp_bind(&server1, (const struct sockaddr*) &addr, UV_TCP_REUSEPORT);
+  if (r == 0) {
+    ASSERT(0 == uv_listen((uv_stream_t*) &server1, 128, NULL));
+    ASSERT(0 == uv_tcp_init(uv_default_loop(), &server2));
+    r = uv_tcp_bind(&server2, (const struct sockaddr*) &addr, 0);
+    if (r == 0)
+      r = uv_listen((uv_stream_t*) &server2, 128, NULL);
+    ASSERT(r == UV_EADDRINUSE);
+    uv_close((uv_handle_t*) &server2, NULL);
+  } else {
+    ASSERT(r == UV_ENOTSUP);
+  }
+  uv_close((uv_handle_t*) &server1, NULL);
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -209,3 +209,51 @@ TEST_IMPL(thread_local_storage) {
   uv_key_delete(&tls_key);
   return 0;
 }
+
+
+TEST_IMPL(thread_affinity) {
+  uv_thread_t self;
+  char* cpumask;
+  char* oldmask;
+  int masksize;
+  int cpu;
+  int i;
+
+  masksize = uv_cpumask_size();
+  if (masksize == UV_ENOTSUP)
+    RETURN_SKIP("Thread affinity is not supported on this platform.");
+  ASSERT(masksize > 0);
+
+  cpumask = calloc(masksize, 1);
+  oldmask = calloc(masksize, 1);
+  ASSERT(cpumask != NULL);
+  ASSERT(oldmask != NULL);
+
+  self = uv_thread_self();
+  ASSERT(UV_EINVAL == uv_thread_setaffinity(&self,
+                                            cpumask,
+                                            NULL,
+                                            masksize - 1));
+
+  /* Read back the current mask; the thread may run on any of them. */
+  memset(cpumask, 1, masksize);
+  ASSERT(0 == uv_thread_setaffinity(&self, cpumask, oldmask, masksize));
+
+  for (cpu = 0; cpu < masksize; cpu++)
+    if (oldmask[cpu])
+      break;
+  ASSERT(cpu < masksize);
+
+  /* Pin to the first of them, then restore the original mask. */
+  memset(cpumask, 0, masksize);
+  cpumask[cpu] = 1;
+  ASSERT(0 == uv_thread_setaffinity(&self, cpumask, NULL, masksize));
+  ASSERT(0 == uv_thread_setaffinity(&self, oldmask, cpumask, masksize));
+
+  for (i = 0; i < masksize; i++)
+    ASSERT(cpumask[i] == (i == cpu));
+
+  free(cpumask);
+  free(oldmask);
+  return 0;
+}
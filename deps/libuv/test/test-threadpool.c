@@ -74,3 +74,188 @@ TEST_IMPL(threadpool_queue_work_einval) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+static int pool_after_work_cb_count;
+
+
+static void pool_work_cb(uv_work_t* req) {
+  ASSERT(req->data == &data);
+}
+
+
+static void pool_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(req->data == &data);
+  pool_after_work_cb_count++;
+}
+
+
+TEST_IMPL(threadpool_loop_configure) {
+  uv_work_t reqs[64];
+  uv_loop_t loop;
+  unsigned int i;
+
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(UV_EINVAL == uv_loop_configure(&loop, UV_LOOP_THREADPOOL_SIZE, 129));
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_THREADPOOL_SIZE, 8));
+
+  for (i = 0; i < ARRAY_SIZE(reqs); i++) {
+    reqs[i].data = &data;
+    ASSERT(0 == uv_queue_work(&loop, reqs + i, pool_work_cb,
+                              pool_after_work_cb));
+  }
+
+  /* Can't swap out the pool while it still has work. */
+  ASSERT(UV_EBUSY == uv_loop_configure(&loop, UV_LOOP_THREADPOOL_SIZE, 2));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(pool_after_work_cb_count == ARRAY_SIZE(reqs));
+
+  /* Shrink the pool, then go back to the shared pool. */
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_THREADPOOL_SIZE, 1));
+  ASSERT(0 == uv_queue_work(&loop, reqs, pool_work_cb, pool_after_work_cb));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_THREADPOOL_SIZE, 0));
+  ASSERT(0 == uv_queue_work(&loop, reqs, pool_work_cb, pool_after_work_cb));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(pool_after_work_cb_count == ARRAY_SIZE(reqs) + 2);
+
+  /* A loop that still owns a private pool tears it down on close. */
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_THREADPOOL_SIZE, 4));
+  ASSERT(0 == uv_loop_close(&loop));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static uv_sem_t slow_sem;
+static int slow_after_work_cb_count;
+static int fast_after_work_cb_count;
+
+
+static void slow_work_cb(uv_work_t* req) {
+  uv_sem_wait(&slow_sem);
+}
+
+
+static void slow_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  slow_after_work_cb_count++;
+}
+
+
+static void fast_after_work_cb(uv_work_t* req, int status) {
+  uv_work_stats_t stats;
+
+  ASSERT(status == 0);
+  fast_after_work_cb_count++;
+
+  /* One slow request holds the only slow lane slot, the other one waits. */
+  ASSERT(slow_after_work_cb_count == 0);
+  ASSERT(0 == uv_threadpool_stats(req->loop, UV_WORK_SLOW_IO, &stats));
+  ASSERT(stats.submitted == 2);
+  ASSERT(stats.running == 1);
+  ASSERT(stats.queued == 1);
+  ASSERT(stats.limit == 1);
+
+  uv_sem_post(&slow_sem);
+  uv_sem_post(&slow_sem);
+}
+
+
+TEST_IMPL(threadpool_queue_work_ex) {
+  uv_work_stats_t stats;
+  uv_work_t slow_reqs[2];
+  uv_work_t fast_req;
+  uv_loop_t loop;
+
+  ASSERT(0 == uv_sem_init(&slow_sem, 0));
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_THREADPOOL_SIZE, 2));
+  ASSERT(0 == uv_loop_configure(&loop,
+                                UV_LOOP_THREADPOOL_LIMIT,
+                                UV_WORK_SLOW_IO,
+                                1));
+  ASSERT(UV_EINVAL == uv_loop_configure(&loop,
+                                        UV_LOOP_THREADPOOL_LIMIT,
+                                        UV_WORK_KIND_MAX,
+                                        1));
+  ASSERT(UV_EINVAL == uv_queue_work_ex(&loop,
+                                       &fast_req,
+                                       UV_WORK_KIND_MAX,
+                                       work_cb,
+                                       fast_after_work_cb));
+
+  ASSERT(0 == uv_queue_work_ex(&loop,
+                               slow_reqs + 0,
+                               UV_WORK_SLOW_IO,
+                               slow_work_cb,
+                               slow_after_work_cb));
+  ASSERT(0 == uv_queue_work_ex(&loop,
+                               slow_reqs + 1,
+                               UV_WORK_SLOW_IO,
+                               slow_work_cb,
+                               slow_after_work_cb));
+
+  /* Must not get stuck behind the slow requests. */
+  fast_req.data = &data;
+  ASSERT(0 == uv_queue_work_ex(&loop,
+                               &fast_req,
+                               UV_WORK_FAST_IO,
+                               pool_work_cb,
+                               fast_after_work_cb));
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(fast_after_work_cb_count == 1);
+  ASSERT(slow_after_work_cb_count == 2);
+
+  ASSERT(0 == uv_threadpool_stats(&loop, UV_WORK_SLOW_IO, &stats));
+  ASSERT(stats.completed == 2);
+  ASSERT(stats.running == 0);
+  ASSERT(stats.queued == 0);
+  ASSERT(stats.max_wait_time > 0);
+  ASSERT(stats.wait_time >= stats.max_wait_time);
+
+  ASSERT(0 == uv_loop_close(&loop));
+  uv_sem_destroy(&slow_sem);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(threadpool_limit_private) {
+  uv_work_stats_t stats;
+  unsigned int shared_limit;
+  uv_loop_t shared;
+  uv_loop_t loop;
+
+  ASSERT(0 == uv_loop_init(&shared));
+  ASSERT(0 == uv_loop_init(&loop));
+
+  /* Loops on the global pool can't set a limit... */
+  ASSERT(0 == uv_threadpool_stats(&shared, UV_WORK_SLOW_IO, &stats));
+  shared_limit = stats.limit;
+  ASSERT(UV_EINVAL == uv_loop_configure(&shared,
+                                        UV_LOOP_THREADPOOL_LIMIT,
+                                        UV_WORK_SLOW_IO,
+                                        1));
+
+  /* ...and one set on a private pool stays with that pool. */
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_THREADPOOL_SIZE, 2));
+  ASSERT(0 == uv_loop_configure(&loop,
+                                UV_LOOP_THREADPOOL_LIMIT,
+                                UV_WORK_SLOW_IO,
+                                1));
+  ASSERT(0 == uv_threadpool_stats(&loop, UV_WORK_SLOW_IO, &stats));
+  ASSERT(stats.limit == 1);
+  ASSERT(0 == uv_threadpool_stats(&shared, UV_WORK_SLOW_IO, &stats));
+  ASSERT(stats.limit == shared_limit);
+
+  ASSERT(0 == uv_loop_close(&loop));
+  ASSERT(0 == uv_loop_close(&shared));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -301,3 +301,94 @@ TEST_IMPL(timer_null_callback) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+static uint64_t wheel_timeouts[] = { 0, 1, 2, 7, 62, 63, 64, 65, 100, 513, 1200 };
+static uv_timer_t wheel_timers[ARRAY_SIZE(wheel_timeouts)];
+static uv_timer_t wheel_stopped_timer;
+static uv_timer_t wheel_repeat_timer;
+static unsigned int wheel_cb_called;
+static unsigned int wheel_repeat_cb_called;
+
+
+static void wheel_cb(uv_timer_t* handle) {
+  uint64_t timeout;
+
+  timeout = wheel_timeouts[handle - wheel_timers];
+
+  /* Timers on the coarser levels may run late but never early. */
+  ASSERT(uv_now(handle->loop) >= start_time + timeout);
+  wheel_cb_called++;
+
+  if (wheel_cb_called == ARRAY_SIZE(wheel_timers)) {
+    ASSERT(UV_EBUSY == uv_loop_configure(handle->loop,
+                                         UV_LOOP_TIMER_WHEEL,
+                                         0));
+    uv_close((uv_handle_t*) &wheel_repeat_timer, NULL);
+    uv_close((uv_handle_t*) &huge_timer1, NULL);
+  }
+
+  uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+static void wheel_repeat_cb(uv_timer_t* handle) {
+  ASSERT(handle == &wheel_repeat_timer);
+  wheel_repeat_cb_called++;
+}
+
+
+TEST_IMPL(timer_wheel) {
+  uv_loop_t* loop;
+  unsigned int i;
+
+#ifdef _WIN32
+  RETURN_SKIP("The timer wheel is not implemented on Windows.");
+#endif
+
+  loop = uv_default_loop();
+
+  /* Can't switch with timers running. */
+  ASSERT(0 == uv_timer_init(loop, &tiny_timer));
+  ASSERT(0 == uv_timer_start(&tiny_timer, never_cb, 100, 0));
+  ASSERT(UV_EBUSY == uv_loop_configure(loop, UV_LOOP_TIMER_WHEEL, 1));
+  uv_close((uv_handle_t*) &tiny_timer, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_TIMER_WHEEL, 1));
+
+  start_time = uv_now(loop);
+
+  for (i = 0; i < ARRAY_SIZE(wheel_timers); i++) {
+    ASSERT(0 == uv_timer_init(loop, wheel_timers + i));
+    ASSERT(0 == uv_timer_start(wheel_timers + i,
+                               wheel_cb,
+                               wheel_timeouts[i],
+                               0));
+  }
+
+  /* Stopped and restarted timers must not linger in their old slot. */
+  ASSERT(0 == uv_timer_init(loop, &wheel_stopped_timer));
+  ASSERT(0 == uv_timer_start(&wheel_stopped_timer, never_cb, 10, 0));
+  ASSERT(0 == uv_timer_start(&wheel_stopped_timer, never_cb, 500, 0));
+  ASSERT(0 == uv_timer_stop(&wheel_stopped_timer));
+
+  ASSERT(0 == uv_timer_init(loop, &wheel_repeat_timer));
+  ASSERT(0 == uv_timer_start(&wheel_repeat_timer, wheel_repeat_cb, 5, 5));
+
+  /* Further out than the wheel reaches. */
+  ASSERT(0 == uv_timer_init(loop, &huge_timer1));
+  ASSERT(0 == uv_timer_start(&huge_timer1, never_cb, (uint64_t) -1, 0));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(wheel_cb_called == ARRAY_SIZE(wheel_timers));
+  ASSERT(wheel_repeat_cb_called > 1);
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_TIMER_WHEEL, 0));
+
+  uv_close((uv_handle_t*) &wheel_stopped_timer, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,157 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_SENDS 50
+
+static uv_udp_t server;
+static uv_udp_t client;
+static uv_udp_send_t send_reqs[NUM_SENDS];
+
+static int send_cb_called;
+static int recv_cb_called;
+static int chunk_cb_called;
+static int free_cb_called;
+static int alloc_cb_called;
+static int close_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle,
+                     size_t suggested_size,
+                     uv_buf_t* buf) {
+  ASSERT(handle == (uv_handle_t*) &server);
+  buf->base = malloc(suggested_size);
+  ASSERT(buf->base != NULL);
+  buf->len = suggested_size;
+  alloc_cb_called++;
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void send_cb(uv_udp_send_t* req, int status) {
+  ASSERT(status == 0);
+  /* Sends complete in the order they were made. */
+  ASSERT(req == &send_reqs[send_cb_called]);
+  send_cb_called++;
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  ASSERT(nread >= 0);
+
+  if (flags & UV_UDP_MMSG_CHUNK) {
+    chunk_cb_called++;
+  } else {
+    if (flags & UV_UDP_MMSG_FREE) {
+      ASSERT(nread == 0);
+      ASSERT(addr == NULL);
+      free_cb_called++;
+    }
+    free(buf->base);
+  }
+
+  if (nread == 0)
+    return;
+
+  ASSERT(addr != NULL);
+  ASSERT(nread == 4);
+  ASSERT(0 == memcmp("PING", buf->base, nread));
+
+  if (++recv_cb_called == NUM_SENDS) {
+    uv_close((uv_handle_t*) &server, close_cb);
+    uv_close((uv_handle_t*) &client, close_cb);
+  }
+}
+
+
+TEST_IMPL(udp_mmsg) {
+  struct sockaddr_in addr;
+  uv_buf_t buf;
+  int i;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  ASSERT(0 == uv_udp_init_ex(uv_default_loop(),
+                             &server,
+                             AF_INET | UV_UDP_RECVMMSG));
+  ASSERT(0 == uv_udp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_udp_recv_start(&server, alloc_cb, recv_cb));
+
+  ASSERT(0 == uv_udp_init_ex(uv_default_loop(),
+                             &client,
+                             AF_INET | UV_UDP_SENDMMSG));
+
+  buf = uv_buf_init("PING", 4);
+  for (i = 0; i < NUM_SENDS; i++)
+    ASSERT(0 == uv_udp_send(&send_reqs[i],
+                            &client,
+                            &buf,
+                            1,
+                            (const struct sockaddr*) &addr,
+                            send_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(send_cb_called == NUM_SENDS);
+  ASSERT(recv_cb_called == NUM_SENDS);
+  ASSERT(close_cb_called == 2);
+#ifdef __linux__
+  /* At most 20 datagrams per recvmmsg() call. */
+  ASSERT(chunk_cb_called == NUM_SENDS);
+  ASSERT(free_cb_called >= NUM_SENDS / 20);
+  ASSERT(free_cb_called <= alloc_cb_called);
+#endif
+
+  ASSERT(client.send_queue_size == 0);
+  ASSERT(server.send_queue_size == 0);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(udp_mmsg_flags) {
+  uv_udp_t handle;
+
+  ASSERT(UV_EINVAL == uv_udp_init_ex(uv_default_loop(), &handle, 1024));
+  ASSERT(0 == uv_udp_init_ex(uv_default_loop(),
+                             &handle,
+                             UV_UDP_RECVMMSG | UV_UDP_SENDMMSG));
+  uv_close((uv_handle_t*) &handle, NULL);
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
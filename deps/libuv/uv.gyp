@@ -134,6 +134,7 @@
             'src/unix/atomic-ops.h',
             'src/unix/core.c',
             'src/unix/dl.c',
+            'src/unix/dns.c',
             'src/unix/fs.c',
             'src/unix/getaddrinfo.c',
             'src/unix/getnameinfo.c',
@@ -199,6 +200,7 @@
           'sources': [
             'src/unix/linux-core.c',
             'src/unix/linux-inotify.c',
+            'src/unix/linux-iouring.c',
             'src/unix/linux-syscalls.c',
             'src/unix/linux-syscalls.h',
           ],
@@ -210,6 +212,7 @@
           'sources': [
             'src/unix/linux-core.c',
             'src/unix/linux-inotify.c',
+            'src/unix/linux-iouring.c',
             'src/unix/linux-syscalls.c',
             'src/unix/linux-syscalls.h',
             'src/unix/pthread-fixes.c',
@@ -276,6 +279,7 @@
       'dependencies': [ 'libuv' ],
       'sources': [
         'test/blackhole-server.c',
+        'test/dns-server.c',
         'test/echo-server.c',
         'test/run-tests.c',
         'test/runner.c',
@@ -284,6 +288,7 @@
         'test/task.h',
         'test/test-active.c',
         'test/test-async.c',
+        'test/test-async-msg.c',
         'test/test-async-null-cb.c',
         'test/test-callback-stack.c',
         'test/test-callback-order.c',
@@ -302,6 +307,7 @@
         'test/test-get-currentexe.c',
         'test/test-get-memory.c',
         'test/test-getaddrinfo.c',
+        'test/test-getaddrinfo-resolver.c',
         'test/test-getnameinfo.c',
         'test/test-getsockname.c',
         'test/test-handle-fileno.c',
@@ -318,6 +324,7 @@
         'test/test-loop-stop.c',
         'test/test-loop-time.c',
         'test/test-loop-configure.c',
+        'test/test-loop-metrics.c',
         'test/test-walk-handles.c',
         'test/test-watcher-cross-stop.c',
         'test/test-multiple-listen.c',
@@ -334,12 +341,14 @@
         'test/test-pipe-server-close.c',
         'test/test-pipe-close-stdout-read-stdin.c',
         'test/test-pipe-set-non-blocking.c',
+        'test/test-pipe-write-coalescing.c',
         'test/test-platform-output.c',
         'test/test-poll.c',
         'test/test-poll-close.c',
         'test/test-poll-close-doesnt-corrupt-stack.c',
         'test/test-poll-closesocket.c',
         'test/test-process-title.c',
+        'test/test-read-buf-pool.c',
         'test/test-ref.c',
         'test/test-run-nowait.c',
         'test/test-run-once.c',
@@ -353,6 +362,8 @@
         'test/test-spawn.c',
         'test/test-fs-poll.c',
         'test/test-stdio-over-pipes.c',
+        'test/test-stream-sendfile.c',
+        'test/test-tcp-alloc.c',
         'test/test-tcp-bind-error.c',
         'test/test-tcp-bind6-error.c',
         'test/test-tcp-close.c',
@@ -374,6 +385,7 @@
         'test/test-tcp-unexpected-read.c',
         'test/test-tcp-oob.c',
         'test/test-tcp-read-stop.c',
+        'test/test-tcp-reuseport.c',
         'test/test-tcp-write-queue-order.c',
         'test/test-threadpool.c',
         'test/test-threadpool-cancel.c',
@@ -390,6 +402,7 @@
         'test/test-udp-create-socket-early.c',
         'test/test-udp-dgram-too-big.c',
         'test/test-udp-ipv6.c',
+        'test/test-udp-mmsg.c',
         'test/test-udp-open.c',
         'test/test-udp-options.c',
         'test/test-udp-send-and-recv.c',
@@ -448,7 +461,10 @@
       'dependencies': [ 'libuv' ],
       'sources': [
         'test/benchmark-async.c',
+        'test/benchmark-async-msg.c',
         'test/benchmark-async-pummel.c',
+        'test/benchmark-fs-event.c',
+        'test/benchmark-fs-poll.c',
         'test/benchmark-fs-stat.c',
         'test/benchmark-getaddrinfo.c',
         'test/benchmark-list.h',
@@ -459,6 +475,7 @@
         'test/benchmark-ping-pongs.c',
         'test/benchmark-pound.c',
         'test/benchmark-pump.c',
+        'test/benchmark-sendfile.c',
         'test/benchmark-sizes.c',
         'test/benchmark-spawn.c',
         'test/benchmark-thread.c',
@@ -0,0 +1,74 @@
+// Copyright 2015 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Builds a large, long-lived object graph and reports the time the mutator
+// spends updating it and the time full garbage collections take. It is meant
+// to compare heap configurations such as --huge-pages and builds with larger
+// pages (make x64.release pagesizebits=21), see large-heap.json.
+//
+// Usage: d8 --expose-gc large-heap.js [-- <heap size in MB>]
+
+var kHeapSizeMB = arguments.length > 0 ? parseInt(arguments[0]) : 512;
+// A node is about 64 bytes including its payload array header.
+var kNodeCount = (kHeapSizeMB * 1024 * 1024 / 64) | 0;
+var kMutations = 4 * 1000 * 1000;
+var kFullGCs = 5;
+
+function Node(id) {
+  this.id = id;
+  this.left = null;
+  this.right = null;
+  this.payload = [id, id + 1];
+}
+
+function BuildGraph(count) {
+  var nodes = new Array(count);
+  for (var i = 0; i < count; i++) nodes[i] = new Node(i);
+  // Connect the nodes in a pseudo-random order so that traversals touch
+  // pages all over the heap.
+  var seed = 49734321;
+  for (var i = 0; i < count; i++) {
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+    nodes[i].left = nodes[seed % count];
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+    nodes[i].right = nodes[seed % count];
+  }
+  return nodes;
+}
+
+function Mutate(nodes, mutations) {
+  var count = nodes.length;
+  var seed = 12345;
+  var sum = 0;
+  for (var i = 0; i < mutations; i++) {
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+    var node = nodes[seed % count];
+    sum += node.left.id + node.right.payload[0];
+    // Replace some payloads to keep allocating and writing old-to-new
+    // pointers into the old generation.
+    if ((i & 7) == 0) node.payload = [sum, i];
+    node.right = node.left.right;
+  }
+  return sum;
+}
+
+function Main() {
+  var start = performance.now();
+  var nodes = BuildGraph(kNodeCount);
+  print("Build: " + (performance.now() - start).toFixed(2));
+
+  start = performance.now();
+  var result = Mutate(nodes, kMutations);
+  print("Mutator: " + (performance.now() - start).toFixed(2));
+
+  start = performance.now();
+  for (var i = 0; i < kFullGCs; i++) gc();
+  print("FullGC: " + ((performance.now() - start) / kFullGCs).toFixed(2));
+
+  if (nodes.length != kNodeCount || isNaN(result)) {
+    throw new Error("large-heap: unexpected result");
+  }
+}
+
+Main();
@@ -180,8 +180,14 @@
 #endif
 
 // Number of bits to represent the page size for paged spaces. The value of 20
-// gives 1Mb bytes per page.
-#if V8_HOST_ARCH_PPC && V8_TARGET_ARCH_PPC && V8_OS_LINUX
+// gives 1Mb bytes per page. Builds can override it with V8_PAGE_SIZE_BITS,
+// e.g. 21 for pages that the OS can back with 2Mb huge pages.
+#if defined(V8_PAGE_SIZE_BITS)
+#if V8_PAGE_SIZE_BITS < 20 || V8_PAGE_SIZE_BITS > 22
+#error "V8_PAGE_SIZE_BITS must be between 20 and 22"
+#endif
+const int kPageSizeBits = V8_PAGE_SIZE_BITS;
+#elif V8_HOST_ARCH_PPC && V8_TARGET_ARCH_PPC && V8_OS_LINUX
 // Bump up for Power Linux due to larger (64K) page size.
 const int kPageSizeBits = 22;
 #else
@@ -239,5 +239,11 @@ bool VirtualMemory::ReleaseRegion(void* base, size_t size) {
 
 
 bool VirtualMemory::HasLazyCommits() { return true; }
+
+
+bool VirtualMemory::UseHugePages(void* base, size_t size, bool is_executable,
+                                 bool explicit_huge_pages) {
+  return false;
+}
 }  // namespace base
 }  // namespace v8
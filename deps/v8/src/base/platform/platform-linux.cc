@@ -388,5 +388,38 @@ bool VirtualMemory::HasLazyCommits() {
   return true;
 }
 
+
+bool VirtualMemory::UseHugePages(void* base, size_t size, bool is_executable,
+                                 bool explicit_huge_pages) {
+  uint8_t* start = RoundUp(static_cast<uint8_t*>(base), kHugePageSize);
+  uint8_t* end = RoundDown(static_cast<uint8_t*>(base) + size, kHugePageSize);
+  if (start >= end) return false;
+  size_t huge_size = static_cast<size_t>(end - start);
+  if (explicit_huge_pages) {
+#if defined(MAP_HUGETLB) && !V8_OS_NACL
+    int prot = PROT_READ | PROT_WRITE | (is_executable ? PROT_EXEC : 0);
+    if (mmap(start, huge_size, prot,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB, kMmapFd,
+             kMmapFdOffset) != MAP_FAILED) {
+      return true;
+    }
+    // The kernel drops the old mapping before it reserves the huge pages, so
+    // an exhausted pool leaves a hole. Commit regular pages again.
+    void* result = mmap(start, huge_size, prot,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, kMmapFd,
+                        kMmapFdOffset);
+    CHECK(result != MAP_FAILED);
+    return false;
+#else
+    return false;
+#endif
+  }
+#if defined(MADV_HUGEPAGE)
+  return madvise(start, huge_size, MADV_HUGEPAGE) == 0;
+#else
+  return false;
+#endif
+}
+
 }  // namespace base
 }  // namespace v8
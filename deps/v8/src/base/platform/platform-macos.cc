@@ -249,5 +249,11 @@ bool VirtualMemory::HasLazyCommits() {
   return false;
 }
 
+
+bool VirtualMemory::UseHugePages(void* base, size_t size, bool is_executable,
+                                 bool explicit_huge_pages) {
+  return false;
+}
+
 }  // namespace base
 }  // namespace v8
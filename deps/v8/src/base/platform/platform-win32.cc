@@ -1301,6 +1301,12 @@ bool VirtualMemory::HasLazyCommits() {
 }
 
 
+bool VirtualMemory::UseHugePages(void* base, size_t size, bool is_executable,
+                                 bool explicit_huge_pages) {
+  return false;
+}
+
+
 // ----------------------------------------------------------------------------
 // Win32 thread support.
 
@@ -361,6 +361,18 @@ class VirtualMemory {
   // Otherwise returns false.
   static bool HasLazyCommits();
 
+  // Size of the huge pages used by UseHugePages.
+  static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+  // Asks the OS to back the parts of the committed region [base, base + size)
+  // that are aligned to kHugePageSize with huge pages. Explicit huge pages are
+  // taken from the pool the system reserved for them, which replaces the
+  // committed memory and its contents; if the pool is exhausted the region
+  // keeps its regular pages. Otherwise the region is marked as eligible for
+  // transparent huge pages. Returns whether the OS accepted the request.
+  static bool UseHugePages(void* base, size_t size, bool is_executable,
+                           bool explicit_huge_pages);
+
  private:
   bool InVM(void* address, size_t size) {
     return (reinterpret_cast<uintptr_t>(address_) <=
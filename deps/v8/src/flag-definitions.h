@@ -664,7 +664,13 @@ DEFINE_INT(min_progress_during_object_groups_marking, 128,
 DEFINE_INT(max_object_groups_marking_rounds, 3,
            "at most try this many times to over approximate the weak closure")
 DEFINE_BOOL(concurrent_sweeping, true, "use concurrent sweeping")
-DEFINE_BOOL(parallel_compaction, false, "use parallel compaction")
+DEFINE_BOOL(parallel_compaction, true,
+            "use parallel compaction and pointer updating on multi-core hosts")
+DEFINE_BOOL(parallel_scavenge, false, "use parallel scavenge")
+DEFINE_BOOL(parallel_marking, false,
+            "use background tasks for marking in the mark-compact pause")
+DEFINE_BOOL(parallel_incremental_marking, false,
+            "use background tasks for the work of incremental marking steps")
 DEFINE_BOOL(trace_incremental_marking, false,
             "trace progress of the incremental marking")
 DEFINE_BOOL(track_gc_object_stats, false,
@@ -682,6 +688,12 @@ DEFINE_BOOL(verify_heap, false, "verify heap pointers before and after GC")
 #endif
 DEFINE_BOOL(move_object_start, false, "enable moving of object starts")
 DEFINE_BOOL(memory_reducer, true, "use memory reducer")
+DEFINE_BOOL(huge_pages, false,
+            "back old, code and large object space with transparent huge "
+            "pages (paged spaces need v8_page_size_bits >= 21 for this)")
+DEFINE_BOOL(explicit_huge_pages, false,
+            "take the huge pages from the system's huge page pool")
+DEFINE_IMPLICATION(explicit_huge_pages, huge_pages)
 
 // counters.cc
 DEFINE_INT(histogram_interval, 600000,
@@ -818,6 +830,8 @@ DEFINE_NEG_IMPLICATION(predictable, concurrent_recompilation)
 DEFINE_NEG_IMPLICATION(predictable, concurrent_osr)
 DEFINE_NEG_IMPLICATION(predictable, concurrent_sweeping)
 DEFINE_NEG_IMPLICATION(predictable, parallel_compaction)
+DEFINE_NEG_IMPLICATION(predictable, parallel_incremental_marking)
+DEFINE_NEG_IMPLICATION(predictable, parallel_marking)
 
 // mark-compact.cc
 DEFINE_BOOL(force_marking_deque_overflows, false,
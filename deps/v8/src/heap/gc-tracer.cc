@@ -408,6 +408,9 @@ void GCTracer::PrintNVP() const {
              current_.scopes[Scope::SCAVENGER_OLD_TO_NEW_POINTERS]);
       PrintF("weak=%.2f ", current_.scopes[Scope::SCAVENGER_WEAK]);
       PrintF("roots=%.2f ", current_.scopes[Scope::SCAVENGER_ROOTS]);
+      PrintF("parallel=%.2f ", current_.scopes[Scope::SCAVENGER_PARALLEL]);
+      PrintF("parallel_roots=%.2f ",
+             current_.scopes[Scope::SCAVENGER_PARALLEL_ROOTS]);
       PrintF("code=%.2f ",
              current_.scopes[Scope::SCAVENGER_CODE_FLUSH_CANDIDATES]);
       PrintF("semispace=%.2f ", current_.scopes[Scope::SCAVENGER_SEMISPACE]);
@@ -422,6 +425,8 @@ void GCTracer::PrintNVP() const {
     case Event::INCREMENTAL_MARK_COMPACTOR:
       PrintF("external=%.1f ", current_.scopes[Scope::EXTERNAL]);
       PrintF("mark=%.1f ", current_.scopes[Scope::MC_MARK]);
+      PrintF("mark_roots=%.1f ", current_.scopes[Scope::MC_MARK_ROOTS]);
+      PrintF("mark_parallel=%.1f ", current_.scopes[Scope::MC_MARK_PARALLEL]);
       PrintF("sweep=%.2f ", current_.scopes[Scope::MC_SWEEP]);
       PrintF("sweepns=%.2f ", current_.scopes[Scope::MC_SWEEP_NEWSPACE]);
       PrintF("sweepos=%.2f ", current_.scopes[Scope::MC_SWEEP_OLDSPACE]);
@@ -439,6 +444,8 @@ void GCTracer::PrintNVP() const {
              current_.scopes[Scope::MC_UPDATE_POINTERS_TO_EVACUATED]);
       PrintF("intracompaction_ptrs=%.1f ",
              current_.scopes[Scope::MC_UPDATE_POINTERS_BETWEEN_EVACUATED]);
+      PrintF("parallel_ptrs=%.1f ",
+             current_.scopes[Scope::MC_UPDATE_POINTERS_PARALLEL]);
       PrintF("misc_compaction=%.1f ",
              current_.scopes[Scope::MC_UPDATE_MISC_POINTERS]);
       PrintF("weak_closure=%.1f ", current_.scopes[Scope::MC_WEAKCLOSURE]);
@@ -99,6 +99,8 @@ class GCTracer {
     enum ScopeId {
       EXTERNAL,
       MC_MARK,
+      MC_MARK_ROOTS,
+      MC_MARK_PARALLEL,
       MC_SWEEP,
       MC_SWEEP_NEWSPACE,
       MC_SWEEP_OLDSPACE,
@@ -111,6 +113,7 @@ class GCTracer {
       MC_UPDATE_OLD_TO_NEW_POINTERS,
       MC_UPDATE_POINTERS_TO_EVACUATED,
       MC_UPDATE_POINTERS_BETWEEN_EVACUATED,
+      MC_UPDATE_POINTERS_PARALLEL,
       MC_UPDATE_MISC_POINTERS,
       MC_INCREMENTAL_WEAKCLOSURE,
       MC_WEAKCLOSURE,
@@ -123,6 +126,8 @@ class GCTracer {
       SCAVENGER_CODE_FLUSH_CANDIDATES,
       SCAVENGER_OBJECT_GROUPS,
       SCAVENGER_OLD_TO_NEW_POINTERS,
+      SCAVENGER_PARALLEL,
+      SCAVENGER_PARALLEL_ROOTS,
       SCAVENGER_ROOTS,
       SCAVENGER_SCAVENGE,
       SCAVENGER_SEMISPACE,
@@ -468,11 +468,17 @@ void Heap::MoveBlock(Address dst, Address src, int byte_size) {
 
 
 AllocationMemento* Heap::FindAllocationMemento(HeapObject* object) {
+  return FindAllocationMemento(object, object->Size());
+}
+
+
+AllocationMemento* Heap::FindAllocationMemento(HeapObject* object,
+                                               int object_size) {
   // Check if there is potentially a memento behind the object. If
   // the last word of the memento is on another page we return
   // immediately.
   Address object_address = object->address();
-  Address memento_address = object_address + object->Size();
+  Address memento_address = object_address + object_size;
   Address last_memento_word_address = memento_address + kPointerSize;
   if (!NewSpacePage::OnSamePage(object_address, last_memento_word_address)) {
     return NULL;
@@ -79,7 +79,6 @@ Heap::Heap()
       always_allocate_scope_count_(0),
       contexts_disposed_(0),
       global_ic_age_(0),
-      scan_on_scavenge_pages_(0),
       new_space_(this),
       old_space_(NULL),
       code_space_(NULL),
@@ -100,7 +99,6 @@ Heap::Heap()
       old_gen_exhausted_(false),
       optimize_for_memory_usage_(false),
       inline_allocation_disabled_(false),
-      store_buffer_rebuilder_(store_buffer()),
       total_regexp_code_generated_(0),
       tracer_(nullptr),
       high_survival_rate_period_length_(0),
@@ -441,8 +439,6 @@ void Heap::GarbageCollectionPrologue() {
   ReportStatisticsBeforeGC();
 #endif  // DEBUG
 
-  store_buffer()->GCPrologue();
-
   if (isolate()->concurrent_osr_enabled()) {
     isolate()->optimizing_compile_dispatcher()->AgeBufferedOsrJobs();
   }
@@ -1500,12 +1496,6 @@ static bool IsUnscavengedHeapObject(Heap* heap, Object** p) {
 }
 
 
-void Heap::ScavengeStoreBufferCallback(Heap* heap, MemoryChunk* page,
-                                       StoreBufferEvent event) {
-  heap->store_buffer_rebuilder_.Callback(page, event);
-}
-
-
 void PromotionQueue::Initialize() {
   // The last to-space page may be used for promotion queue. On promotion
   // conflict, we use the emergency stack.
@@ -1618,19 +1608,31 @@ void Heap::Scavenge() {
   promotion_queue_.Initialize();
 
   ScavengeVisitor scavenge_visitor(this);
-  {
-    // Copy roots.
-    GCTracer::Scope gc_scope(tracer(), GCTracer::Scope::SCAVENGER_ROOTS);
-    IterateRoots(&scavenge_visitor, VISIT_ALL_IN_SCAVENGE);
-  }
+  if (scavenge_collector_->CanScavengeInParallel()) {
+    {
+      // Copy objects reachable from roots and from the old generation,
+      // including everything reachable from the copies.
+      GCTracer::Scope gc_scope(tracer(), GCTracer::Scope::SCAVENGER_PARALLEL);
+      scavenge_collector_->ScavengeInParallel();
+    }
 
-  {
-    // Copy objects reachable from the old generation.
-    GCTracer::Scope gc_scope(tracer(),
-                             GCTracer::Scope::SCAVENGER_OLD_TO_NEW_POINTERS);
-    StoreBufferRebuildScope scope(this, store_buffer(),
-                                  &ScavengeStoreBufferCallback);
-    store_buffer()->IteratePointersToNewSpace(&Scavenger::ScavengeObject);
+    // The parallel tasks did not use the promotion queue and already visited
+    // all objects they copied to to-space.
+    new_space_front = new_space_.top();
+    promotion_queue_.SetNewLimit(new_space_front);
+  } else {
+    {
+      // Copy roots.
+      GCTracer::Scope gc_scope(tracer(), GCTracer::Scope::SCAVENGER_ROOTS);
+      IterateRoots(&scavenge_visitor, VISIT_ALL_IN_SCAVENGE);
+    }
+
+    {
+      // Copy objects reachable from the old generation.
+      GCTracer::Scope gc_scope(tracer(),
+                               GCTracer::Scope::SCAVENGER_OLD_TO_NEW_POINTERS);
+      store_buffer()->IteratePointersToNewSpace(&Scavenger::ScavengeObject);
+    }
   }
 
   {
@@ -1876,17 +1878,14 @@ Address Heap::DoScavenge(ObjectVisitor* scavenge_visitor,
 
     // Promote and process all the to-be-promoted objects.
     {
-      StoreBufferRebuildScope scope(this, store_buffer(),
-                                    &ScavengeStoreBufferCallback);
       while (!promotion_queue()->is_empty()) {
         HeapObject* target;
         int size;
         promotion_queue()->remove(&target, &size);
 
-        // Promoted object might be already partially visited
-        // during old space pointer iteration. Thus we search specifically
-        // for pointers to from semispace instead of looking for pointers
-        // to new space.
+        // Promoted object might point to objects that were already copied.
+        // Thus we search specifically for pointers to from semispace instead
+        // of looking for pointers to new space.
         DCHECK(!target->IsMap());
         Address obj_address = target->address();
 
@@ -4447,10 +4446,6 @@ void Heap::IterateAndMarkPointersToFromSpace(HeapObject* object, Address start,
   while (slot_address < end) {
     Object** slot = reinterpret_cast<Object**>(slot_address);
     Object* target = *slot;
-    // If the store buffer becomes overfull we mark pages as being exempt from
-    // the store buffer.  These pages are scanned to find pointers that point
-    // to the new space.  In that case we may hit newly promoted objects and
-    // fix the pointers before the promotion queue gets to them.  Thus the 'if'.
     if (target->IsHeapObject()) {
       if (Heap::InFromSpace(target)) {
         callback(reinterpret_cast<HeapObject**>(slot),
@@ -5977,14 +5972,17 @@ void Heap::QueueMemoryChunkForFree(MemoryChunk* chunk) {
 
 void Heap::FilterStoreBufferEntriesOnAboutToBeFreedPages() {
   if (chunks_queued_for_free_ == NULL) return;
+  // Buffered entries may point into the chunks. Moving them to the
+  // remembered set hands them to the slot sets of the chunks, which are
+  // released together with the chunks.
+  store_buffer()->MoveEntriesToRememberedSet();
   MemoryChunk* next;
   MemoryChunk* chunk;
   for (chunk = chunks_queued_for_free_; chunk != NULL; chunk = next) {
     next = chunk->next_chunk();
     chunk->SetFlag(MemoryChunk::ABOUT_TO_BE_FREED);
+    chunk->ReleaseOldToNewSlots();
   }
-  store_buffer()->Compact();
-  store_buffer()->Filter(MemoryChunk::ABOUT_TO_BE_FREED);
 }
 
 
@@ -848,20 +848,6 @@ class Heap {
   // Notify the heap that a context has been disposed.
   int NotifyContextDisposed(bool dependant_context);
 
-  inline void increment_scan_on_scavenge_pages() {
-    scan_on_scavenge_pages_++;
-    if (FLAG_gc_verbose) {
-      PrintF("Scan-on-scavenge pages: %d\n", scan_on_scavenge_pages_);
-    }
-  }
-
-  inline void decrement_scan_on_scavenge_pages() {
-    scan_on_scavenge_pages_--;
-    if (FLAG_gc_verbose) {
-      PrintF("Scan-on-scavenge pages: %d\n", scan_on_scavenge_pages_);
-    }
-  }
-
   void set_native_contexts_list(Object* object) {
     native_contexts_list_ = object;
   }
@@ -914,6 +900,11 @@ class Heap {
   // return NULL;
   inline AllocationMemento* FindAllocationMemento(HeapObject* object);
 
+  // Same as above, but does not read the map of |object|. Used when the map
+  // word may be replaced concurrently by a forwarding address.
+  inline AllocationMemento* FindAllocationMemento(HeapObject* object,
+                                                  int object_size);
+
   // Returns false if not able to reserve.
   bool ReserveSpace(Reservation* reservations);
 
@@ -1648,9 +1639,6 @@ class Heap {
   static String* UpdateNewSpaceReferenceInExternalStringTableEntry(
       Heap* heap, Object** pointer);
 
-  static void ScavengeStoreBufferCallback(Heap* heap, MemoryChunk* page,
-                                          StoreBufferEvent event);
-
   // Selects the proper allocation space based on the pretenuring decision.
   static AllocationSpace SelectSpace(PretenureFlag pretenure) {
     return (pretenure == TENURED) ? OLD_SPACE : NEW_SPACE;
@@ -2154,8 +2142,6 @@ class Heap {
 
   int global_ic_age_;
 
-  int scan_on_scavenge_pages_;
-
   NewSpace new_space_;
   OldSpace* old_space_;
   OldSpace* code_space_;
@@ -2224,8 +2210,6 @@ class Heap {
 
   Object* encountered_weak_cells_;
 
-  StoreBufferRebuilder store_buffer_rebuilder_;
-
   List<GCCallbackPair> gc_epilogue_callbacks_;
   List<GCCallbackPair> gc_prologue_callbacks_;
 
@@ -2369,6 +2353,7 @@ class Heap {
   friend class NewSpace;
   friend class ObjectStatsVisitor;
   friend class Page;
+  friend class RememberedSetParts;
   friend class Scavenger;
   friend class StoreBuffer;
 
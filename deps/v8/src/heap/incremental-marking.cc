@@ -12,6 +12,7 @@
 #include "src/heap/mark-compact-inl.h"
 #include "src/heap/objects-visiting.h"
 #include "src/heap/objects-visiting-inl.h"
+#include "src/heap/parallel-marking.h"
 #include "src/v8.h"
 
 namespace v8 {
@@ -728,6 +729,37 @@ void IncrementalMarking::MarkObject(Heap* heap, HeapObject* obj) {
 }
 
 
+// Parallel steps stay opt-in. The mutator is stopped while the tasks run, so
+// they only shorten a step, and most steps are too small to repay starting
+// and joining the tasks.
+bool IncrementalMarking::CanProcessMarkingDequeInParallel(
+    intptr_t bytes_to_process) {
+  return FLAG_parallel_incremental_marking &&
+         bytes_to_process >= kMinBytesForParallelStep &&
+         ParallelMarking::NumberOfTasks() > 1 &&
+         !heap_->mark_compact_collector()->marking_deque()->IsEmpty();
+}
+
+
+intptr_t IncrementalMarking::ProcessMarkingDequeInParallel(
+    intptr_t bytes_to_process) {
+  // The mutator does not run until all tasks are done, so the tasks neither
+  // race with the write barrier nor with changes of object layouts.
+  ParallelMarking marking(heap_, ParallelMarking::INCREMENTAL_MARKING,
+                          bytes_to_process);
+  List<HeapObject*> bailouts;
+  intptr_t bytes_processed = marking.Run(&bailouts);
+  // Objects that could not be visited go on top, so that the main thread
+  // gets to them first.
+  MarkingDeque* marking_deque =
+      heap_->mark_compact_collector()->marking_deque();
+  for (int i = 0; i < bailouts.length(); i++) {
+    marking_deque->Push(bailouts[i]);
+  }
+  return bytes_processed;
+}
+
+
 intptr_t IncrementalMarking::ProcessMarkingDeque(intptr_t bytes_to_process) {
   intptr_t bytes_processed = 0;
   Map* filler_map = heap_->one_pointer_filler_map();
@@ -1068,7 +1100,13 @@ intptr_t IncrementalMarking::Step(intptr_t allocated_bytes,
         StartMarking();
       }
     } else if (state_ == MARKING) {
-      bytes_processed = ProcessMarkingDeque(bytes_to_process);
+      if (CanProcessMarkingDequeInParallel(bytes_to_process)) {
+        bytes_processed = ProcessMarkingDequeInParallel(bytes_to_process);
+      }
+      // Objects the parallel tasks handed back are processed here.
+      bytes_processed +=
+          ProcessMarkingDeque(Max(bytes_to_process - bytes_processed,
+                                  static_cast<intptr_t>(0)));
       if (heap_->mark_compact_collector()->marking_deque()->IsEmpty()) {
         if (completion == FORCE_COMPLETION ||
             IsIdleMarkingDelayCounterLimitReached()) {
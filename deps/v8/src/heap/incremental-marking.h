@@ -127,6 +127,8 @@ class IncrementalMarking {
   // This is how much we increase the marking/allocating factor by.
   static const intptr_t kMarkingSpeedAccelleration = 2;
   static const intptr_t kMaxMarkingSpeed = 1000;
+  // Steps smaller than this are not worth splitting between background tasks.
+  static const intptr_t kMinBytesForParallelStep = 256 * KB;
 
   // This is the upper bound for how many times we allow finalization of
   // incremental marking to be postponed.
@@ -239,6 +241,12 @@ class IncrementalMarking {
 
   INLINE(void VisitObject(Map* map, HeapObject* obj, int size));
 
+  bool CanProcessMarkingDequeInParallel(intptr_t bytes_to_process);
+
+  // Splits the marking work of a step between the main thread and background
+  // tasks. Returns the number of bytes marked.
+  intptr_t ProcessMarkingDequeInParallel(intptr_t bytes_to_process);
+
   void IncrementIdleMarkingDelayCounter();
 
   Heap* heap_;
@@ -21,6 +21,7 @@
 #include "src/heap/object-stats.h"
 #include "src/heap/objects-visiting.h"
 #include "src/heap/objects-visiting-inl.h"
+#include "src/heap/parallel-marking.h"
 #include "src/heap/slots-buffer.h"
 #include "src/heap/spaces-inl.h"
 #include "src/ic/ic.h"
@@ -1525,6 +1526,13 @@ class RootMarkingVisitor : public ObjectVisitor {
     MarkBit mark_bit = Marking::MarkBitFrom(object);
     if (Marking::IsBlackOrGrey(mark_bit)) return;
 
+    // Leave the transitive closure to the parallel marker, which works best on
+    // a full marking deque.
+    if (collector_->UseParallelMarking()) {
+      collector_->MarkObject(object, mark_bit);
+      return;
+    }
+
     Map* map = object->map();
     // Mark the object.
     collector_->SetMark(object, mark_bit);
@@ -1807,11 +1815,9 @@ void MarkCompactCollector::MarkRoots(RootMarkingVisitor* visitor) {
   // Handle the string table specially.
   MarkStringTable(visitor);
 
-  // There may be overflowed objects in the heap.  Visit them now.
-  while (marking_deque_.overflowed()) {
-    RefillMarkingDeque();
-    EmptyMarkingDeque();
-  }
+  // Mark objects reachable from the roots, including overflowed objects in
+  // the heap.
+  ProcessMarkingDeque();
 }
 
 
@@ -1851,6 +1857,10 @@ void MarkCompactCollector::MarkImplicitRefGroups(
 // After: the marking stack is empty, and all objects reachable from the
 // marking stack have been marked, or are overflowed in the heap.
 void MarkCompactCollector::EmptyMarkingDeque() {
+  if (UseParallelMarking()) {
+    EmptyMarkingDequeInParallel();
+    return;
+  }
   Map* filler_map = heap_->one_pointer_filler_map();
   while (!marking_deque_.IsEmpty()) {
     HeapObject* object = marking_deque_.Pop();
@@ -1871,6 +1881,35 @@ void MarkCompactCollector::EmptyMarkingDeque() {
 }
 
 
+bool MarkCompactCollector::UseParallelMarking() {
+  // Object statistics are collected by the sequential marking visitor.
+  return FLAG_parallel_marking && !FLAG_track_gc_object_stats &&
+         ParallelMarking::NumberOfTasks() > 1;
+}
+
+
+void MarkCompactCollector::EmptyMarkingDequeInParallel() {
+  GCTracer::Scope gc_scope(heap()->tracer(), GCTracer::Scope::MC_MARK_PARALLEL);
+  List<HeapObject*> bailouts;
+  while (!marking_deque_.IsEmpty()) {
+    ParallelMarking marking(heap(), ParallelMarking::FULL_MARKING, 0);
+    marking.Run(&bailouts);
+    DCHECK(marking_deque_.IsEmpty());
+
+    // Visit the objects the tasks could not handle. Their unmarked fields are
+    // pushed on the marking deque for the next round.
+    for (int i = 0; i < bailouts.length(); i++) {
+      HeapObject* object = bailouts[i];
+      Map* map = object->map();
+      MarkBit map_mark = Marking::MarkBitFrom(map);
+      MarkObject(map, map_mark);
+      MarkCompactMarkingVisitor::IterateBody(map, object);
+    }
+    bailouts.Rewind(0);
+  }
+}
+
+
 // Sweep the heap for overflowed objects, clear their overflow bits, and
 // push them on the marking stack.  Stop early if the marking stack fills
 // before sweeping completes.  If sweeping completes, there are no remaining
@@ -2129,7 +2168,10 @@ void MarkCompactCollector::MarkLiveObjects() {
   PrepareForCodeFlushing();
 
   RootMarkingVisitor root_visitor(heap());
-  MarkRoots(&root_visitor);
+  {
+    GCTracer::Scope gc_scope(heap()->tracer(), GCTracer::Scope::MC_MARK_ROOTS);
+    MarkRoots(&root_visitor);
+  }
 
   ProcessTopOptimizedFrame(&root_visitor);
 
@@ -3063,6 +3105,190 @@ static void UpdatePointer(HeapObject** address, HeapObject* object) {
 }
 
 
+// Updates an old-to-new slot in a part of the remembered set claimed by a
+// PointersUpdatingJob and drops the slot if it no longer points to new space.
+class OldToNewSlotUpdater {
+ public:
+  explicit OldToNewSlotUpdater(Heap* heap) : heap_(heap) {}
+
+  SlotSet::CallbackResult operator()(Address slot_address) {
+    Object** slot = reinterpret_cast<Object**>(slot_address);
+    if (heap_->InFromSpace(*slot)) {
+      PointersUpdatingVisitor::UpdateSlot(heap_, slot);
+    }
+    return heap_->InToSpace(*slot) ? SlotSet::KEEP_SLOT : SlotSet::REMOVE_SLOT;
+  }
+
+ private:
+  Heap* heap_;
+};
+
+
+// State shared by all tasks updating pointers after evacuation. The work items
+// (slots buffers, to-space pages and parts of the remembered set) are claimed
+// through atomic counters. Pointer slots are updated with a compare-and-swap,
+// so a slot reached through more than one item is still updated consistently.
+// Typed slots patch code and are handed back to the main thread.
+class PointersUpdatingJob {
+ public:
+  explicit PointersUpdatingJob(Heap* heap)
+      : heap_(heap),
+        remembered_set_parts_(heap),
+        next_buffer_(0),
+        next_page_(0),
+        pending_tasks_semaphore_(0) {}
+
+  void AddSlotsBuffers(SlotsBuffer* buffer) {
+    for (; buffer != NULL; buffer = buffer->next()) slots_buffers_.Add(buffer);
+  }
+
+  void AddToSpacePages(NewSpace* space) {
+    Address top = space->top();
+    NewSpacePage* last_page = NewSpacePage::FromLimit(top);
+    NewSpacePageIterator it(space->bottom(), top);
+    while (it.has_next()) {
+      NewSpacePage* page = it.next();
+      to_space_areas_.Add(page->area_start());
+      to_space_areas_.Add(page == last_page ? top : page->area_end());
+    }
+  }
+
+  // Updates pointers until all work items are claimed. Typed slots are added
+  // to {typed_slots} as pairs of encoded slot type and address.
+  void Run(List<SlotsBuffer::ObjectSlot>* typed_slots) {
+    intptr_t index;
+    while (Claim(&next_buffer_, slots_buffers_.length(), 1, &index)) {
+      SlotsBuffer* buffer = slots_buffers_[static_cast<int>(index)];
+      size_t buffer_size = buffer->Size();
+      for (size_t slot_idx = 0; slot_idx < buffer_size; ++slot_idx) {
+        SlotsBuffer::ObjectSlot slot = buffer->Get(slot_idx);
+        if (!SlotsBuffer::IsTypedSlot(slot)) {
+          PointersUpdatingVisitor::UpdateSlot(heap_, slot);
+        } else {
+          ++slot_idx;
+          DCHECK(slot_idx < buffer_size);
+          typed_slots->Add(slot);
+          typed_slots->Add(buffer->Get(slot_idx));
+        }
+      }
+    }
+
+    PointersUpdatingVisitor updating_visitor(heap_);
+    while (Claim(&next_page_, to_space_areas_.length() / 2, 1, &index)) {
+      Address current = to_space_areas_[static_cast<int>(2 * index)];
+      Address limit = to_space_areas_[static_cast<int>(2 * index + 1)];
+      while (current < limit) {
+        HeapObject* object = HeapObject::FromAddress(current);
+        Map* map = object->map();
+        int size = object->SizeFromMap(map);
+        object->IterateBody(map->instance_type(), size, &updating_visitor);
+        current += size;
+      }
+    }
+
+    OldToNewSlotUpdater slot_updater(heap_);
+    SlotSet* slot_set;
+    int start_bucket;
+    int end_bucket;
+    while (remembered_set_parts_.Claim(&slot_set, &start_bucket, &end_bucket)) {
+      slot_set->Iterate(&slot_updater, start_bucket, end_bucket);
+    }
+  }
+
+  void NotifyTaskDone() { pending_tasks_semaphore_.Signal(); }
+  void WaitForTask() { pending_tasks_semaphore_.Wait(); }
+
+ private:
+  static bool Claim(base::AtomicWord* next, intptr_t length, intptr_t step,
+                    intptr_t* index) {
+    *index = base::NoBarrier_AtomicIncrement(next, step) - step;
+    return *index < length;
+  }
+
+  Heap* heap_;
+  List<SlotsBuffer*> slots_buffers_;
+  // Pairs of start and limit of the used area of each to-space page.
+  List<Address> to_space_areas_;
+  RememberedSetParts remembered_set_parts_;
+  base::AtomicWord next_buffer_;
+  base::AtomicWord next_page_;
+  base::Semaphore pending_tasks_semaphore_;
+
+  DISALLOW_COPY_AND_ASSIGN(PointersUpdatingJob);
+};
+
+
+class PointersUpdatingTask : public v8::Task {
+ public:
+  PointersUpdatingTask(PointersUpdatingJob* job,
+                       List<SlotsBuffer::ObjectSlot>* typed_slots)
+      : job_(job), typed_slots_(typed_slots) {}
+
+  virtual ~PointersUpdatingTask() {}
+
+ private:
+  // v8::Task overrides.
+  void Run() override {
+    job_->Run(typed_slots_);
+    job_->NotifyTaskDone();
+  }
+
+  PointersUpdatingJob* job_;
+  List<SlotsBuffer::ObjectSlot>* typed_slots_;
+
+  DISALLOW_COPY_AND_ASSIGN(PointersUpdatingTask);
+};
+
+
+int MarkCompactCollector::NumberOfPointersUpdatingTasks() {
+  if (!FLAG_parallel_compaction) return 1;
+  // The tasks need no compaction spaces and the main thread takes part, so we
+  // use one task per core, capped by a hard limit.
+  const int kMaxPointersUpdatingTasks = 8;
+  return Min(kMaxPointersUpdatingTasks, base::SysInfo::NumberOfProcessors());
+}
+
+
+void MarkCompactCollector::UpdatePointersInParallel() {
+  const int num_tasks = NumberOfPointersUpdatingTasks();
+  PointersUpdatingJob job(heap());
+  job.AddSlotsBuffers(migration_slots_buffer_);
+  for (int i = 0; i < evacuation_slots_buffers_.length(); i++) {
+    job.AddSlotsBuffers(evacuation_slots_buffers_[i]);
+  }
+  for (int i = 0; i < evacuation_candidates_.length(); i++) {
+    Page* p = evacuation_candidates_[i];
+    if (p->IsEvacuationCandidate()) job.AddSlotsBuffers(p->slots_buffer());
+  }
+  job.AddToSpacePages(heap()->new_space());
+
+  List<SlotsBuffer::ObjectSlot>* typed_slots =
+      new List<SlotsBuffer::ObjectSlot>[num_tasks];
+
+  // Kick off parallel tasks.
+  for (int i = 1; i < num_tasks; i++) {
+    V8::GetCurrentPlatform()->CallOnBackgroundThread(
+        new PointersUpdatingTask(&job, &typed_slots[i]),
+        v8::Platform::kShortRunningTask);
+  }
+
+  // Contribute in main thread.
+  job.Run(&typed_slots[0]);
+  for (int i = 1; i < num_tasks; i++) job.WaitForTask();
+
+  // Finalize sequentially.
+  PointersUpdatingVisitor updating_visitor(heap());
+  for (int i = 0; i < num_tasks; i++) {
+    List<SlotsBuffer::ObjectSlot>* slots = &typed_slots[i];
+    for (int j = 0; j < slots->length(); j += 2) {
+      UpdateSlot(isolate(), &updating_visitor, DecodeSlotType(slots->at(j)),
+                 reinterpret_cast<Address>(slots->at(j + 1)));
+    }
+  }
+  delete[] typed_slots;
+}
+
+
 static String* UpdateReferenceInExternalStringTableEntry(Heap* heap,
                                                          Object** p) {
   MapWord map_word = HeapObject::cast(*p)->map_word();
@@ -3707,10 +3933,31 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
     EvacuatePagesInParallel();
   }
 
+  // The objects on evacuated pages are dead now, so are the old-to-new slots
+  // recorded on these pages.
+  heap_->store_buffer()->MoveEntriesToRememberedSet();
+  for (int i = 0; i < evacuation_candidates_.length(); i++) {
+    Page* p = evacuation_candidates_[i];
+    if (p->IsEvacuationCandidate()) p->ReleaseOldToNewSlots();
+  }
+
+  // Second pass: find pointers to new space and update them.
+  PointersUpdatingVisitor updating_visitor(heap());
+
+  const bool update_in_parallel = NumberOfPointersUpdatingTasks() > 1;
+  if (update_in_parallel) {
+    // The slots buffers, to-space and the remembered set are processed by
+    // background tasks. The roots are updated afterwards on the main thread,
+    // which also deallocates the slots buffers.
+    GCTracer::Scope gc_scope(heap()->tracer(),
+                             GCTracer::Scope::MC_UPDATE_POINTERS_PARALLEL);
+    UpdatePointersInParallel();
+  }
+
   {
     GCTracer::Scope gc_scope(heap()->tracer(),
                              GCTracer::Scope::MC_UPDATE_POINTERS_TO_EVACUATED);
-    UpdateSlotsRecordedIn(migration_slots_buffer_);
+    if (!update_in_parallel) UpdateSlotsRecordedIn(migration_slots_buffer_);
     if (FLAG_trace_fragmentation_verbose) {
       PrintF("  migration slots buffer: %d\n",
              SlotsBuffer::SizeOfChain(migration_slots_buffer_));
@@ -3718,21 +3965,16 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
     slots_buffer_allocator_->DeallocateChain(&migration_slots_buffer_);
     DCHECK(migration_slots_buffer_ == NULL);
 
-    // TODO(hpayer): Process the slots buffers in parallel. This has to be done
-    // after evacuation of all pages finishes.
     int buffers = evacuation_slots_buffers_.length();
     for (int i = 0; i < buffers; i++) {
       SlotsBuffer* buffer = evacuation_slots_buffers_[i];
-      UpdateSlotsRecordedIn(buffer);
+      if (!update_in_parallel) UpdateSlotsRecordedIn(buffer);
       slots_buffer_allocator_->DeallocateChain(&buffer);
     }
     evacuation_slots_buffers_.Rewind(0);
   }
 
-  // Second pass: find pointers to new space and update them.
-  PointersUpdatingVisitor updating_visitor(heap());
-
-  {
+  if (!update_in_parallel) {
     GCTracer::Scope gc_scope(heap()->tracer(),
                              GCTracer::Scope::MC_UPDATE_NEW_TO_NEW_POINTERS);
     // Update pointers in to space.
@@ -3752,11 +3994,9 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
     heap_->IterateRoots(&updating_visitor, VISIT_ALL_IN_SWEEP_NEWSPACE);
   }
 
-  {
+  if (!update_in_parallel) {
     GCTracer::Scope gc_scope(heap()->tracer(),
                              GCTracer::Scope::MC_UPDATE_OLD_TO_NEW_POINTERS);
-    StoreBufferRebuildScope scope(heap_, heap_->store_buffer(),
-                                  &Heap::ScavengeStoreBufferCallback);
     heap_->store_buffer()->IteratePointersToNewSpace(&UpdatePointer);
   }
 
@@ -3771,7 +4011,7 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
              p->IsFlagSet(Page::RESCAN_ON_EVACUATION));
 
       if (p->IsEvacuationCandidate()) {
-        UpdateSlotsRecordedIn(p->slots_buffer());
+        if (!update_in_parallel) UpdateSlotsRecordedIn(p->slots_buffer());
         if (FLAG_trace_fragmentation_verbose) {
           PrintF("  page %p slots buffer: %d\n", reinterpret_cast<void*>(p),
                  SlotsBuffer::SizeOfChain(p->slots_buffer()));
@@ -3864,7 +4104,7 @@ void MarkCompactCollector::ReleaseEvacuationCandidates() {
     if (!p->IsEvacuationCandidate()) continue;
     PagedSpace* space = static_cast<PagedSpace*>(p->owner());
     space->Free(p->area_start(), p->area_size());
-    p->set_scan_on_scavenge(false);
+    DCHECK(p->old_to_new_slots() == NULL);
     p->ResetLiveBytes();
     CHECK(p->WasSwept());
     space->ReleasePage(p);
@@ -119,6 +119,26 @@ class Marking : public AllStatic {
     markbit.Next().Set();
   }
 
+  // Variants for marking tasks running in parallel. Only the task that marks
+  // a white object owns it, so transitions of owned objects only have to be
+  // atomic with respect to the other bits of the cell.
+  // Returns false if the object was not white.
+  INLINE(static bool WhiteToGreyAtomic(MarkBit markbit)) {
+    if (!markbit.SetAtomic()) return false;
+    markbit.Next().SetAtomic();
+    return true;
+  }
+
+  // Returns false if the object was not white.
+  INLINE(static bool WhiteToBlackAtomic(MarkBit markbit)) {
+    return markbit.SetAtomic();
+  }
+
+  INLINE(static void MarkBlackAtomic(MarkBit markbit)) {
+    markbit.SetAtomic();
+    markbit.Next().ClearAtomic();
+  }
+
   static void TransferMark(Heap* heap, Address old_start, Address new_start);
 
 #ifdef DEBUG
@@ -631,6 +651,13 @@ class MarkCompactCollector {
   // overflow flag will be set.
   void EmptyMarkingDeque();
 
+  // Whether the marking deque is emptied by background tasks and the main
+  // thread together, see ParallelMarking.
+  bool UseParallelMarking();
+
+  // Parallel version of {EmptyMarkingDeque}.
+  void EmptyMarkingDequeInParallel();
+
   // Refill the marking stack with overflowed objects from the heap.  This
   // function either leaves the marking stack full or clears the overflow
   // flag on the marking stack.
@@ -714,6 +741,15 @@ class MarkCompactCollector {
 
   void WaitUntilCompactionCompleted();
 
+  // The number of tasks updating pointers after evacuation, including the
+  // main thread.
+  int NumberOfPointersUpdatingTasks();
+
+  // Updates the slots recorded in the slots buffers of the evacuation, the
+  // pointers in to-space and the old-to-new slots in the remembered set,
+  // using background tasks.
+  void UpdatePointersInParallel();
+
   void EvacuateNewSpaceAndCandidates();
 
   void ReleaseEvacuationCandidates();
@@ -0,0 +1,371 @@
+// Copyright 2015 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/heap/parallel-marking.h"
+
+#include "src/base/sys-info.h"
+#include "src/heap/heap.h"
+#include "src/heap/mark-compact-inl.h"
+#include "src/heap/objects-visiting.h"
+#include "src/list-inl.h"
+#include "src/objects-inl.h"
+#include "src/v8.h"
+
+namespace v8 {
+namespace internal {
+
+// The part of a parallel marking done by one task. Mirrors the marking
+// visitors for the supported visitor ids.
+class ParallelMarker : public Malloced {
+ public:
+  ParallelMarker(ParallelMarking* marking, int task_id)
+      : marking_(marking),
+        heap_(marking->heap()),
+        task_id_(task_id),
+        visitor_(this),
+        host_(NULL),
+        bytes_processed_(0) {}
+
+  void Push(HeapObject* object) { worklist_.Add(object); }
+
+  // Processes the worklist and then helps the other tasks until there is no
+  // work left or the budget is used up.
+  void Run() {
+    do {
+      ProcessWorklist();
+    } while (marking_->Steal(task_id_, &worklist_));
+  }
+
+  // Records the slots found by Run and hands the remaining objects back.
+  // Called on the main thread once all tasks are done.
+  void Finalize(List<HeapObject*>* bailouts) {
+    MarkCompactCollector* collector = heap_->mark_compact_collector();
+    for (int i = 0; i < recorded_slots_.length(); i++) {
+      RecordedSlot& recorded = recorded_slots_[i];
+      collector->RecordSlot(recorded.host, recorded.slot, *recorded.slot);
+    }
+    DCHECK(marking_->mode() == ParallelMarking::INCREMENTAL_MARKING ||
+           worklist_.is_empty());
+    MarkingDeque* marking_deque = collector->marking_deque();
+    for (int i = 0; i < worklist_.length(); i++) {
+      marking_deque->Push(worklist_[i]);
+    }
+    bailouts->AddAll(bailout_);
+  }
+
+  List<HeapObject*>* worklist() { return &worklist_; }
+  intptr_t bytes_processed() { return bytes_processed_; }
+
+ private:
+  // ObjectVisitor is embedded-only, so it cannot be the base of a heap
+  // allocated marker.
+  class Visitor : public ObjectVisitor {
+   public:
+    explicit Visitor(ParallelMarker* marker) : marker_(marker) {}
+
+    void VisitPointer(Object** p) override { marker_->MarkObjectByPointer(p); }
+
+    void VisitPointers(Object** start, Object** end) override {
+      for (Object** p = start; p < end; p++) marker_->MarkObjectByPointer(p);
+    }
+
+   private:
+    ParallelMarker* marker_;
+  };
+
+  struct RecordedSlot {
+    RecordedSlot(HeapObject* host, Object** slot) : host(host), slot(slot) {}
+    HeapObject* host;
+    Object** slot;
+  };
+
+  // Processed bytes are published to the budget in chunks of this size.
+  static const intptr_t kBudgetCheckInterval = 64 * KB;
+
+  static bool IsInRange(int id, StaticVisitorBase::VisitorId first,
+                        StaticVisitorBase::VisitorId last) {
+    return first <= id && id <= last;
+  }
+
+  void ProcessWorklist() {
+    Map* filler_map = heap_->one_pointer_filler_map();
+    intptr_t unpublished_bytes = 0;
+    while (!worklist_.is_empty() && !marking_->BudgetExhausted()) {
+      HeapObject* object = worklist_.RemoveLast();
+
+      // Explicitly skip one word fillers. Incremental markbit patterns are
+      // correct only for objects that occupy at least two words.
+      Map* map = object->map();
+      if (map == filler_map) continue;
+
+      int size = object->SizeFromMap(map);
+      MarkObject(map);
+      if (!VisitObject(map, object, size)) {
+        bailout_.Add(object);
+        continue;
+      }
+      if (marking_->mode() == ParallelMarking::INCREMENTAL_MARKING) {
+        MarkBit mark_bit = Marking::MarkBitFrom(object);
+        if (!Marking::IsBlack(mark_bit)) {
+          Marking::MarkBlackAtomic(mark_bit);
+          MemoryChunk::FromAddress(object->address())
+              ->IncrementLiveBytesAtomic(size);
+        }
+      }
+      bytes_processed_ += size;
+      unpublished_bytes += size;
+      if (unpublished_bytes >= kBudgetCheckInterval) {
+        marking_->AddProcessedBytes(unpublished_bytes);
+        unpublished_bytes = 0;
+      }
+      if (worklist_.length() > 2 * ParallelMarking::kSegmentSize &&
+          marking_->HasWaitingTasks()) {
+        marking_->Share(task_id_, &worklist_);
+      }
+    }
+    marking_->AddProcessedBytes(unpublished_bytes);
+  }
+
+  // Returns false if the object has to be visited by the main thread.
+  bool VisitObject(Map* map, HeapObject* object, int size) {
+    host_ = object;
+    int id = map->visitor_id();
+    switch (id) {
+      case StaticVisitorBase::kVisitSeqOneByteString:
+      case StaticVisitorBase::kVisitSeqTwoByteString:
+      case StaticVisitorBase::kVisitByteArray:
+      case StaticVisitorBase::kVisitFreeSpace:
+      case StaticVisitorBase::kVisitFixedDoubleArray:
+      case StaticVisitorBase::kVisitFixedTypedArray:
+      case StaticVisitorBase::kVisitFixedFloat64Array:
+        return true;
+      case StaticVisitorBase::kVisitFixedArray:
+        // Incremental marking scans large arrays with a progress bar.
+        if (marking_->mode() == ParallelMarking::INCREMENTAL_MARKING &&
+            MemoryChunk::FromAddress(object->address())->owner()->identity() ==
+                LO_SPACE) {
+          return false;
+        }
+        FixedArray::BodyDescriptor::IterateBody(object, size, &visitor_);
+        return true;
+      case StaticVisitorBase::kVisitShortcutCandidate:
+      case StaticVisitorBase::kVisitConsString:
+        ConsString::BodyDescriptor::IterateBody(object, &visitor_);
+        return true;
+      case StaticVisitorBase::kVisitSlicedString:
+        SlicedString::BodyDescriptor::IterateBody(object, &visitor_);
+        return true;
+      case StaticVisitorBase::kVisitSymbol:
+        Symbol::BodyDescriptor::IterateBody(object, &visitor_);
+        return true;
+      case StaticVisitorBase::kVisitOddball:
+        Oddball::BodyDescriptor::IterateBody(object, &visitor_);
+        return true;
+      case StaticVisitorBase::kVisitCell:
+        Cell::BodyDescriptor::IterateBody(object, &visitor_);
+        return true;
+      default:
+        break;
+    }
+    if (IsInRange(id, StaticVisitorBase::kVisitDataObject,
+                  StaticVisitorBase::kVisitDataObjectGeneric)) {
+      return true;
+    }
+    if (IsInRange(id, StaticVisitorBase::kVisitJSObject,
+                  StaticVisitorBase::kVisitJSObjectGeneric)) {
+      JSObject::BodyDescriptor::IterateBody(object, size, &visitor_);
+      return true;
+    }
+    if (IsInRange(id, StaticVisitorBase::kVisitStruct,
+                  StaticVisitorBase::kVisitStructGeneric)) {
+      StructBodyDescriptor::IterateBody(object, size, &visitor_);
+      return true;
+    }
+    return false;
+  }
+
+  void MarkObject(HeapObject* object) {
+    MarkBit mark_bit = Marking::MarkBitFrom(object);
+    if (marking_->mode() == ParallelMarking::INCREMENTAL_MARKING) {
+      if (Marking::WhiteToGreyAtomic(mark_bit)) worklist_.Add(object);
+    } else {
+      if (Marking::WhiteToBlackAtomic(mark_bit)) {
+        MemoryChunk::FromAddress(object->address())
+            ->IncrementLiveBytesAtomic(object->Size());
+        worklist_.Add(object);
+      }
+    }
+  }
+
+  void MarkObjectByPointer(Object** p) {
+    Object* target = *p;
+    if (!target->IsHeapObject()) return;
+    // The slots buffers are not thread-safe, so slots pointing into evacuation
+    // candidates are recorded by the main thread in Finalize.
+    if (Page::FromAddress(reinterpret_cast<Address>(target))
+            ->IsEvacuationCandidate()) {
+      recorded_slots_.Add(RecordedSlot(host_, p));
+    }
+    MarkObject(HeapObject::cast(target));
+  }
+
+  ParallelMarking* marking_;
+  Heap* heap_;
+  int task_id_;
+  Visitor visitor_;
+  HeapObject* host_;
+  intptr_t bytes_processed_;
+  List<HeapObject*> worklist_;
+  List<HeapObject*> bailout_;
+  List<RecordedSlot> recorded_slots_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMarker);
+};
+
+
+class ParallelMarkingTask : public v8::Task {
+ public:
+  ParallelMarkingTask(ParallelMarking* marking, ParallelMarker* marker)
+      : marking_(marking), marker_(marker) {}
+
+  virtual ~ParallelMarkingTask() {}
+
+ private:
+  // v8::Task overrides.
+  void Run() override {
+    marker_->Run();
+    marking_->pending_tasks_semaphore_.Signal();
+  }
+
+  ParallelMarking* marking_;
+  ParallelMarker* marker_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMarkingTask);
+};
+
+
+ParallelMarking::ParallelMarking(Heap* heap, Mode mode,
+                                 intptr_t bytes_to_process)
+    : heap_(heap),
+      mode_(mode),
+      num_tasks_(NumberOfTasks()),
+      segments_(new Segments[num_tasks_]),
+      bytes_to_process_(bytes_to_process),
+      bytes_processed_(0),
+      active_tasks_(num_tasks_),
+      waiting_tasks_(0),
+      pending_tasks_semaphore_(0) {}
+
+
+ParallelMarking::~ParallelMarking() {
+#ifdef DEBUG
+  for (int i = 0; i < num_tasks_; i++) DCHECK(segments_[i].list.is_empty());
+#endif
+  delete[] segments_;
+}
+
+
+int ParallelMarking::NumberOfTasks() {
+  // The main thread takes part as well, so we use one task per core, capped
+  // by a hard limit.
+  const int kMaxMarkingTasks = 8;
+  return Min(kMaxMarkingTasks, base::SysInfo::NumberOfProcessors());
+}
+
+
+void ParallelMarking::Share(int task_id, List<HeapObject*>* worklist) {
+  List<HeapObject*>* segment = new List<HeapObject*>(kSegmentSize);
+  for (int i = 0; i < kSegmentSize; i++) segment->Add(worklist->RemoveLast());
+  {
+    base::LockGuard<base::Mutex> guard(&segments_[task_id].mutex);
+    segments_[task_id].list.Add(segment);
+  }
+  base::LockGuard<base::Mutex> guard(&mutex_);
+  cv_.NotifyOne();
+}
+
+
+bool ParallelMarking::TryPop(int task_id, List<HeapObject*>* worklist) {
+  // Look at the own segments first, then steal from the other tasks.
+  for (int i = 0; i < num_tasks_; i++) {
+    Segments* segments = &segments_[(task_id + i) % num_tasks_];
+    List<HeapObject*>* segment = NULL;
+    {
+      base::LockGuard<base::Mutex> guard(&segments->mutex);
+      if (!segments->list.is_empty()) segment = segments->list.RemoveLast();
+    }
+    if (segment != NULL) {
+      worklist->AddAll(*segment);
+      delete segment;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+bool ParallelMarking::Steal(int task_id, List<HeapObject*>* worklist) {
+  base::LockGuard<base::Mutex> guard(&mutex_);
+  active_tasks_--;
+  // Announce the waiting task before looking for segments, so that a task
+  // sharing a segment after the lookup failed wakes us up.
+  base::Barrier_AtomicIncrement(&waiting_tasks_, 1);
+  bool found = false;
+  while (!BudgetExhausted()) {
+    found = TryPop(task_id, worklist);
+    if (found || active_tasks_ == 0) break;
+    cv_.Wait(&mutex_);
+  }
+  base::Barrier_AtomicIncrement(&waiting_tasks_, -1);
+  if (found) {
+    active_tasks_++;
+    return true;
+  }
+  cv_.NotifyAll();
+  return false;
+}
+
+
+intptr_t ParallelMarking::Run(List<HeapObject*>* bailouts) {
+  MarkingDeque* marking_deque =
+      heap_->mark_compact_collector()->marking_deque();
+  ParallelMarker** markers = new ParallelMarker*[num_tasks_];
+  for (int i = 0; i < num_tasks_; i++) {
+    markers[i] = new ParallelMarker(this, i);
+  }
+
+  // Hand out the marking deque round-robin. Incremental marking steps only
+  // take its top, the rest stays on the deque for later steps.
+  int max_objects = mode_ == INCREMENTAL_MARKING
+                        ? num_tasks_ * kIncrementalObjectsPerTask
+                        : kMaxInt;
+  for (int i = 0; i < max_objects && !marking_deque->IsEmpty(); i++) {
+    markers[i % num_tasks_]->Push(marking_deque->Pop());
+  }
+
+  for (int i = 1; i < num_tasks_; i++) {
+    V8::GetCurrentPlatform()->CallOnBackgroundThread(
+        new ParallelMarkingTask(this, markers[i]),
+        v8::Platform::kShortRunningTask);
+  }
+  markers[0]->Run();
+  for (int i = 1; i < num_tasks_; i++) pending_tasks_semaphore_.Wait();
+
+  // Segments are left over only if the budget was used up.
+  for (int i = 0; i < num_tasks_; i++) {
+    while (TryPop(i, markers[i]->worklist())) {
+    }
+  }
+
+  intptr_t bytes_processed = 0;
+  for (int i = 0; i < num_tasks_; i++) {
+    markers[i]->Finalize(bailouts);
+    bytes_processed += markers[i]->bytes_processed();
+    delete markers[i];
+  }
+  delete[] markers;
+  return bytes_processed;
+}
+}  // namespace internal
+}  // namespace v8
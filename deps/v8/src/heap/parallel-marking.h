@@ -0,0 +1,113 @@
+// Copyright 2015 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_HEAP_PARALLEL_MARKING_H_
+#define V8_HEAP_PARALLEL_MARKING_H_
+
+#include "src/base/atomicops.h"
+#include "src/base/platform/condition-variable.h"
+#include "src/base/platform/mutex.h"
+#include "src/base/platform/semaphore.h"
+#include "src/list.h"
+
+namespace v8 {
+namespace internal {
+
+class Heap;
+class HeapObject;
+
+// Drains the marking deque with the main thread and background tasks. Every
+// task works on its own worklist, shares segments of it when others run out of
+// work and steals them from the others when it runs out itself.
+//
+// The tasks only visit object types whose marking visitors do nothing besides
+// marking fields and recording slots. Everything else (maps, code, functions,
+// weak objects, ...) is handed back to the main thread. The mutator must not
+// run while the tasks are marking.
+class ParallelMarking {
+ public:
+  enum Mode {
+    // Incremental marking step: discovered objects are marked grey and turn
+    // black once their fields have been visited. Marking stops after the
+    // given number of bytes.
+    INCREMENTAL_MARKING,
+    // Mark-compact pause: discovered objects are marked black right away and
+    // marking runs to completion.
+    FULL_MARKING
+  };
+
+  // Number of objects moved between worklists at once.
+  static const int kSegmentSize = 64;
+  // Number of objects a task of an incremental marking step starts with.
+  static const int kIncrementalObjectsPerTask = 256;
+
+  ParallelMarking(Heap* heap, Mode mode, intptr_t bytes_to_process);
+  ~ParallelMarking();
+
+  static int NumberOfTasks();
+
+  // Marks objects from the marking deque and objects reachable from them.
+  // Objects the tasks could not visit are added to {bailouts}; they are grey
+  // in INCREMENTAL_MARKING and black in FULL_MARKING mode. Objects left over
+  // when the budget is used up go back to the marking deque. Returns the
+  // number of bytes marked.
+  intptr_t Run(List<HeapObject*>* bailouts);
+
+  Heap* heap() { return heap_; }
+  Mode mode() { return mode_; }
+
+  bool BudgetExhausted() {
+    return mode_ == INCREMENTAL_MARKING &&
+           base::NoBarrier_Load(&bytes_processed_) >= bytes_to_process_;
+  }
+
+  void AddProcessedBytes(intptr_t bytes) {
+    base::NoBarrier_AtomicIncrement(&bytes_processed_, bytes);
+  }
+
+  // A hint for tasks with a long worklist that sharing would help.
+  bool HasWaitingTasks() {
+    return base::Acquire_Load(&waiting_tasks_) > 0;
+  }
+
+  // Moves kSegmentSize objects from {worklist} to the segments of task
+  // {task_id}, where other tasks can steal them.
+  void Share(int task_id, List<HeapObject*>* worklist);
+
+  // Called by a task that ran out of work. Refills {worklist} from the
+  // segments of this or another task and returns true, or returns false once
+  // all tasks ran out of work or the budget is used up.
+  bool Steal(int task_id, List<HeapObject*>* worklist);
+
+ private:
+  struct Segments {
+    base::Mutex mutex;
+    List<List<HeapObject*>*> list;
+  };
+
+  bool TryPop(int task_id, List<HeapObject*>* worklist);
+
+  Heap* heap_;
+  Mode mode_;
+  int num_tasks_;
+  Segments* segments_;
+  intptr_t bytes_to_process_;
+  base::AtomicWord bytes_processed_;
+
+  // Guards active_tasks_.
+  base::Mutex mutex_;
+  base::ConditionVariable cv_;
+  int active_tasks_;
+  base::Atomic32 waiting_tasks_;
+
+  base::Semaphore pending_tasks_semaphore_;
+
+  friend class ParallelMarkingTask;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMarking);
+};
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_HEAP_PARALLEL_MARKING_H_
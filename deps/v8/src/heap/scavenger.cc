@@ -4,13 +4,22 @@
 
 #include "src/heap/scavenger.h"
 
+#include "src/base/platform/condition-variable.h"
+#include "src/base/platform/mutex.h"
+#include "src/base/platform/semaphore.h"
+#include "src/base/sys-info.h"
 #include "src/contexts.h"
+#include "src/heap/array-buffer-tracker.h"
+#include "src/heap/gc-tracer.h"
 #include "src/heap/heap.h"
 #include "src/heap/objects-visiting-inl.h"
 #include "src/heap/scavenger-inl.h"
+#include "src/heap/spaces-inl.h"
+#include "src/heap/store-buffer-inl.h"
 #include "src/isolate.h"
 #include "src/log.h"
 #include "src/profiler/cpu-profiler.h"
+#include "src/v8.h"
 
 namespace v8 {
 namespace internal {
@@ -431,12 +440,16 @@ void Scavenger::ScavengeObjectSlow(HeapObject** p, HeapObject* object) {
 }
 
 
+bool Scavenger::IsLoggingOrProfiling() {
+  return FLAG_verify_predictable || isolate()->logger()->is_logging() ||
+         isolate()->cpu_profiler()->is_profiling() ||
+         (isolate()->heap_profiler() != NULL &&
+          isolate()->heap_profiler()->is_tracking_object_moves());
+}
+
+
 void Scavenger::SelectScavengingVisitorsTable() {
-  bool logging_and_profiling =
-      FLAG_verify_predictable || isolate()->logger()->is_logging() ||
-      isolate()->cpu_profiler()->is_profiling() ||
-      (isolate()->heap_profiler() != NULL &&
-       isolate()->heap_profiler()->is_tracking_object_moves());
+  bool logging_and_profiling = IsLoggingOrProfiling();
 
   if (!heap()->incremental_marking()->IsMarking()) {
     if (!logging_and_profiling) {
@@ -473,6 +486,537 @@ void Scavenger::SelectScavengingVisitorsTable() {
 }
 
 
+// -----------------------------------------------------------------------------
+// Parallel scavenging of the roots and the old-to-new slots.
+//
+// Every participating task owns a ParallelScavenger that copies objects into
+// its own linear allocation buffers in to-space and in old space. The task
+// that installs the forwarding address first (a compare-and-swap on the map
+// word of the original) wins; the others give their copy back and use the
+// winner's. Copied objects are visited by the task that copied them, and
+// surplus work is published to a pool shared by all tasks of the job. Anything
+// that is not thread-safe (store buffer, pretenuring feedback, array buffer
+// tracking, statistics) is buffered per task and applied on the main thread
+// once all tasks are done.
+
+
+// A linear allocation buffer owned by a single task.
+class ScavengingAllocationBuffer {
+ public:
+  explicit ScavengingAllocationBuffer(Heap* heap)
+      : heap_(heap), top_(nullptr), limit_(nullptr) {}
+
+  HeapObject* Allocate(int size_in_bytes, AllocationAlignment alignment) {
+    if (top_ == nullptr) return nullptr;
+    int filler_size = Heap::GetFillToAlign(top_, alignment);
+    if (limit_ - top_ < filler_size + size_in_bytes) return nullptr;
+    HeapObject* object = HeapObject::FromAddress(top_);
+    top_ += filler_size + size_in_bytes;
+    if (filler_size > 0) object = heap_->PrecedeWithFiller(object, filler_size);
+    return object;
+  }
+
+  // Gives back the most recent allocation if {object} is the last object in
+  // the buffer.
+  bool TryUndoAllocation(HeapObject* object, int size_in_bytes) {
+    if (object->address() + size_in_bytes != top_) return false;
+    top_ = object->address();
+    return true;
+  }
+
+  // Switches to a new buffer, leaving a filler in the rest of the old one.
+  void Reset(Address top, Address limit) {
+    Close();
+    top_ = top;
+    limit_ = limit;
+  }
+
+  void Close() {
+    if (top_ != nullptr && top_ < limit_) {
+      heap_->CreateFillerObjectAt(top_, static_cast<int>(limit_ - top_));
+    }
+    top_ = limit_ = nullptr;
+  }
+
+ private:
+  Heap* heap_;
+  Address top_;
+  Address limit_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScavengingAllocationBuffer);
+};
+
+
+// State shared by all tasks of a parallel scavenge.
+class ParallelScavengeJob {
+ public:
+  // Number of objects moved from a task's worklist to the shared pool at once.
+  static const int kSegmentSize = 64;
+
+  ParallelScavengeJob(Heap* heap, int num_tasks)
+      : heap_(heap),
+        remembered_set_parts_(heap),
+        active_tasks_(num_tasks),
+        waiting_tasks_(0),
+        pending_tasks_semaphore_(0) {}
+
+  ~ParallelScavengeJob() { DCHECK(pool_.is_empty()); }
+
+  Heap* heap() { return heap_; }
+
+  // Hands out the next part of the remembered set, if any.
+  bool ClaimSlots(SlotSet** slot_set, int* start_bucket, int* end_bucket) {
+    return remembered_set_parts_.Claim(slot_set, start_bucket, end_bucket);
+  }
+
+  // A hint for tasks with a long worklist that sharing would help.
+  bool HasWaitingTasks() { return base::NoBarrier_Load(&waiting_tasks_) > 0; }
+
+  // Moves kSegmentSize objects from {worklist} to the shared pool.
+  void Share(List<HeapObject*>* worklist) {
+    List<HeapObject*>* segment = new List<HeapObject*>(kSegmentSize);
+    for (int i = 0; i < kSegmentSize; i++) segment->Add(worklist->RemoveLast());
+    base::LockGuard<base::Mutex> guard(&mutex_);
+    pool_.Add(segment);
+    cv_.NotifyOne();
+  }
+
+  // Called by a task that ran out of work. Refills {worklist} from the shared
+  // pool and returns true, or returns false once all tasks ran out of work.
+  bool Steal(List<HeapObject*>* worklist) {
+    base::LockGuard<base::Mutex> guard(&mutex_);
+    active_tasks_--;
+    while (pool_.is_empty()) {
+      if (active_tasks_ == 0) {
+        cv_.NotifyAll();
+        return false;
+      }
+      base::NoBarrier_AtomicIncrement(&waiting_tasks_, 1);
+      cv_.Wait(&mutex_);
+      base::NoBarrier_AtomicIncrement(&waiting_tasks_, -1);
+    }
+    List<HeapObject*>* segment = pool_.RemoveLast();
+    worklist->AddAll(*segment);
+    delete segment;
+    active_tasks_++;
+    return true;
+  }
+
+  void NotifyTaskDone() { pending_tasks_semaphore_.Signal(); }
+  void WaitForTask() { pending_tasks_semaphore_.Wait(); }
+
+ private:
+  Heap* heap_;
+  RememberedSetParts remembered_set_parts_;
+
+  // Guards pool_ and active_tasks_.
+  base::Mutex mutex_;
+  base::ConditionVariable cv_;
+  List<List<HeapObject*>*> pool_;
+  int active_tasks_;
+  base::Atomic32 waiting_tasks_;
+
+  base::Semaphore pending_tasks_semaphore_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelScavengeJob);
+};
+
+
+// The part of a parallel scavenge done by one task. Mirrors the evacuation
+// strategies of ScavengingVisitor<IGNORE_MARKS, LOGGING_AND_PROFILING_DISABLED>
+// except that cons strings are never short-circuited.
+class ParallelScavenger : public Malloced {
+ public:
+  explicit ParallelScavenger(ParallelScavengeJob* job)
+      : job_(job),
+        heap_(job->heap()),
+        visitor_(this),
+        new_space_buffer_(heap_),
+        old_space_buffer_(heap_),
+        record_slots_(false),
+        semi_space_copied_size_(0),
+        promoted_size_(0) {}
+
+  // Scavenges the visited pointers, e.g. the roots.
+  ObjectVisitor* visitor() { return &visitor_; }
+
+  // Called for the slots of the claimed parts of the remembered set. Slots
+  // that no longer point to new space are removed from it.
+  SlotSet::CallbackResult operator()(Address slot_address) {
+    Object** slot = reinterpret_cast<Object**>(slot_address);
+    ScavengePointer(slot);
+    return heap_->InToSpace(*slot) ? SlotSet::KEEP_SLOT : SlotSet::REMOVE_SLOT;
+  }
+
+  // Processes parts of the remembered set and then helps the other tasks
+  // until there is no work left.
+  void Run() {
+    ProcessWorklist();
+    SlotSet* slot_set;
+    int start_bucket;
+    int end_bucket;
+    while (job_->ClaimSlots(&slot_set, &start_bucket, &end_bucket)) {
+      slot_set->Iterate(this, start_bucket, end_bucket);
+      ProcessWorklist();
+    }
+    do {
+      ProcessWorklist();
+    } while (job_->Steal(&worklist_));
+  }
+
+  void CloseAllocationBuffers() {
+    new_space_buffer_.Close();
+    old_space_buffer_.Close();
+  }
+
+  int semi_space_copied_size() { return semi_space_copied_size_; }
+  int promoted_size() { return promoted_size_; }
+
+  // Slots in promoted objects that still point to new space.
+  List<Address>* old_to_new_slots() { return &old_to_new_slots_; }
+
+  // Allocation sites of scavenged objects that had a memento.
+  List<AllocationSite*>* allocation_sites() { return &allocation_sites_; }
+
+  List<JSArrayBuffer*>* live_array_buffers() { return &live_array_buffers_; }
+  List<JSArrayBuffer*>* promoted_array_buffers() {
+    return &promoted_array_buffers_;
+  }
+
+ private:
+  // ObjectVisitor is embedded-only, so it cannot be the base of a heap
+  // allocated scavenger.
+  class Visitor : public ObjectVisitor {
+   public:
+    explicit Visitor(ParallelScavenger* scavenger) : scavenger_(scavenger) {}
+
+    void VisitPointer(Object** p) override { scavenger_->ScavengePointer(p); }
+
+    void VisitPointers(Object** start, Object** end) override {
+      for (Object** p = start; p < end; p++) scavenger_->ScavengePointer(p);
+    }
+
+   private:
+    ParallelScavenger* scavenger_;
+  };
+
+  static const int kBufferSize = 16 * KB;
+  static const int kMaxBufferedObjectSize = kBufferSize / 4;
+
+  static bool ContainsPointers(int visitor_id) {
+    switch (visitor_id) {
+      case StaticVisitorBase::kVisitSeqOneByteString:
+      case StaticVisitorBase::kVisitSeqTwoByteString:
+      case StaticVisitorBase::kVisitByteArray:
+      case StaticVisitorBase::kVisitFixedDoubleArray:
+      case StaticVisitorBase::kVisitFixedTypedArray:
+      case StaticVisitorBase::kVisitFixedFloat64Array:
+        return false;
+      default:
+        return visitor_id < StaticVisitorBase::kVisitDataObject ||
+               visitor_id > StaticVisitorBase::kVisitDataObjectGeneric;
+    }
+  }
+
+  void ScavengePointer(Object** p) {
+    Object* object = *p;
+    if (!heap_->InFromSpace(object)) return;
+    ScavengeObject(reinterpret_cast<HeapObject**>(p),
+                   reinterpret_cast<HeapObject*>(object));
+    if (record_slots_ && heap_->InNewSpace(*p)) {
+      old_to_new_slots_.Add(reinterpret_cast<Address>(p));
+    }
+  }
+
+  void ScavengeObject(HeapObject** slot, HeapObject* object) {
+    MapWord first_word = object->synchronized_map_word();
+    if (first_word.IsForwardingAddress()) {
+      *slot = first_word.ToForwardingAddress();
+      return;
+    }
+
+    Map* map = first_word.ToMap();
+    int object_size = object->SizeFromMap(map);
+    SLOW_DCHECK(object_size <= Page::kMaxRegularHeapObjectSize);
+    int visitor_id = map->visitor_id();
+    AllocationAlignment alignment =
+        (visitor_id == StaticVisitorBase::kVisitFixedDoubleArray ||
+         visitor_id == StaticVisitorBase::kVisitFixedFloat64Array)
+            ? kDoubleAligned
+            : kWordAligned;
+
+    // Same order of preference as ScavengingVisitor::EvacuateObject.
+    HeapObject* target = nullptr;
+    bool promoted = false;
+    if (!heap_->ShouldBePromoted(object->address(), object_size)) {
+      target = AllocateInNewSpace(object_size, alignment);
+    }
+    if (target == nullptr) {
+      target = AllocateInOldSpace(object_size, alignment);
+      promoted = target != nullptr;
+    }
+    if (target == nullptr) target = AllocateInNewSpace(object_size, alignment);
+    if (target == nullptr) {
+      V8::FatalProcessOutOfMemory("Scavenger: semi-space copy");
+    }
+
+    heap_->CopyBlock(target->address(), object->address(), object_size);
+    // The copy may already contain a forwarding address installed by another
+    // task; restore the map in that case.
+    target->set_map_word(first_word);
+
+    if (!object->synchronized_compare_and_swap_map_word(
+            first_word, MapWord::FromForwardingAddress(target))) {
+      // Another task copied the object first. Give our copy back.
+      ScavengingAllocationBuffer* buffer =
+          promoted ? &old_space_buffer_ : &new_space_buffer_;
+      if (!buffer->TryUndoAllocation(target, object_size)) {
+        heap_->CreateFillerObjectAt(target->address(), object_size);
+      }
+      *slot = object->synchronized_map_word().ToForwardingAddress();
+      return;
+    }
+    *slot = target;
+
+    if (visitor_id == StaticVisitorBase::kVisitFixedTypedArray ||
+        visitor_id == StaticVisitorBase::kVisitFixedFloat64Array) {
+      FixedTypedArrayBase* array =
+          reinterpret_cast<FixedTypedArrayBase*>(target);
+      if (array->base_pointer() != Smi::FromInt(0))
+        array->set_base_pointer(array, SKIP_WRITE_BARRIER);
+    }
+
+    if (FLAG_allocation_site_pretenuring &&
+        AllocationSite::CanTrack(map->instance_type())) {
+      AllocationMemento* memento =
+          heap_->FindAllocationMemento(object, object_size);
+      if (memento != nullptr) {
+        allocation_sites_.Add(memento->GetAllocationSite());
+      }
+    }
+
+    if (promoted) {
+      promoted_size_ += object_size;
+      if (visitor_id == StaticVisitorBase::kVisitJSArrayBuffer) {
+        promoted_array_buffers_.Add(JSArrayBuffer::cast(target));
+      }
+    } else {
+      semi_space_copied_size_ += object_size;
+      if (visitor_id == StaticVisitorBase::kVisitJSArrayBuffer &&
+          !JSArrayBuffer::cast(target)->is_external()) {
+        live_array_buffers_.Add(JSArrayBuffer::cast(target));
+      }
+    }
+
+    if (ContainsPointers(visitor_id)) worklist_.Add(target);
+  }
+
+  // Visits the body of a copied object, like StaticScavengeVisitor does for
+  // objects in to-space and Heap::DoScavenge for promoted ones.
+  void VisitObject(HeapObject* object) {
+    Map* map = object->map();
+    int visitor_id = map->visitor_id();
+    bool promoted = !heap_->InNewSpace(object);
+    record_slots_ = promoted;
+    if (visitor_id == StaticVisitorBase::kVisitJSFunction) {
+      // The code entry is not a tagged pointer and the fields after
+      // kNonWeakFieldsEndOffset are weak.
+      visitor_.VisitPointers(
+          HeapObject::RawField(object, JSFunction::kPropertiesOffset),
+          HeapObject::RawField(object, JSFunction::kCodeEntryOffset));
+      visitor_.VisitPointers(
+          HeapObject::RawField(object,
+                               JSFunction::kCodeEntryOffset + kPointerSize),
+          HeapObject::RawField(object, JSFunction::kNonWeakFieldsEndOffset));
+    } else if (visitor_id == StaticVisitorBase::kVisitNativeContext &&
+               !promoted) {
+      Context::ScavengeBodyDescriptor::IterateBody(object, &visitor_);
+    } else {
+      object->IterateBody(map->instance_type(), object->SizeFromMap(map),
+                          &visitor_);
+    }
+    record_slots_ = false;
+  }
+
+  void ProcessWorklist() {
+    while (!worklist_.is_empty()) {
+      if (worklist_.length() >= 2 * ParallelScavengeJob::kSegmentSize &&
+          job_->HasWaitingTasks()) {
+        job_->Share(&worklist_);
+      }
+      VisitObject(worklist_.RemoveLast());
+    }
+  }
+
+  HeapObject* AllocateInNewSpace(int size_in_bytes,
+                                 AllocationAlignment alignment) {
+    HeapObject* object = new_space_buffer_.Allocate(size_in_bytes, alignment);
+    if (object != nullptr) return object;
+    NewSpace* space = heap_->new_space();
+    HeapObject* buffer = nullptr;
+    if (size_in_bytes <= kMaxBufferedObjectSize &&
+        space->AllocateRawSynchronized(kBufferSize, kWordAligned).To(&buffer)) {
+      new_space_buffer_.Reset(buffer->address(),
+                              buffer->address() + kBufferSize);
+      return new_space_buffer_.Allocate(size_in_bytes, alignment);
+    }
+    // Large object, or to-space is too fragmented for a whole buffer.
+    if (space->AllocateRawSynchronized(size_in_bytes, alignment).To(&object)) {
+      return object;
+    }
+    return nullptr;
+  }
+
+  HeapObject* AllocateInOldSpace(int size_in_bytes,
+                                 AllocationAlignment alignment) {
+    HeapObject* object = old_space_buffer_.Allocate(size_in_bytes, alignment);
+    if (object != nullptr) return object;
+    OldSpace* space = heap_->old_space();
+    HeapObject* buffer = nullptr;
+    if (size_in_bytes <= kMaxBufferedObjectSize &&
+        space->AllocateRawUnalignedSynchronized(kBufferSize).To(&buffer)) {
+      old_space_buffer_.Reset(buffer->address(),
+                              buffer->address() + kBufferSize);
+      return old_space_buffer_.Allocate(size_in_bytes, alignment);
+    }
+    int allocation_size =
+        size_in_bytes + Heap::GetMaximumFillToAlign(alignment);
+    if (!space->AllocateRawUnalignedSynchronized(allocation_size)
+             .To(&object)) {
+      return nullptr;
+    }
+    if (allocation_size > size_in_bytes) {
+      object = heap_->AlignWithFiller(object, size_in_bytes, allocation_size,
+                                      alignment);
+    }
+    return object;
+  }
+
+  ParallelScavengeJob* job_;
+  Heap* heap_;
+  Visitor visitor_;
+  List<HeapObject*> worklist_;
+  ScavengingAllocationBuffer new_space_buffer_;
+  ScavengingAllocationBuffer old_space_buffer_;
+
+  // Set while visiting a promoted object, whose slots into new space have to
+  // end up in the store buffer.
+  bool record_slots_;
+
+  int semi_space_copied_size_;
+  int promoted_size_;
+  List<Address> old_to_new_slots_;
+  List<AllocationSite*> allocation_sites_;
+  List<JSArrayBuffer*> live_array_buffers_;
+  List<JSArrayBuffer*> promoted_array_buffers_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelScavenger);
+};
+
+
+class ParallelScavengeTask : public v8::Task {
+ public:
+  ParallelScavengeTask(ParallelScavengeJob* job, ParallelScavenger* scavenger)
+      : job_(job), scavenger_(scavenger) {}
+
+  virtual ~ParallelScavengeTask() {}
+
+ private:
+  // v8::Task overrides.
+  void Run() override {
+    scavenger_->Run();
+    job_->NotifyTaskDone();
+  }
+
+  ParallelScavengeJob* job_;
+  ParallelScavenger* scavenger_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelScavengeTask);
+};
+
+
+int Scavenger::NumberOfParallelScavengeTasks() {
+  // The main thread takes part as well, so we use one task per core, capped
+  // by a hard limit.
+  const int kMaxScavengeTasks = 8;
+  return Min(kMaxScavengeTasks, base::SysInfo::NumberOfProcessors());
+}
+
+
+bool Scavenger::CanScavengeInParallel() {
+  return FLAG_parallel_scavenge &&
+         !heap()->incremental_marking()->IsMarking() &&
+         !IsLoggingOrProfiling() && NumberOfParallelScavengeTasks() > 1;
+}
+
+
+void Scavenger::ScavengeInParallel() {
+  const int num_tasks = NumberOfParallelScavengeTasks();
+  ParallelScavengeJob job(heap(), num_tasks);
+  ParallelScavenger** scavengers = new ParallelScavenger*[num_tasks];
+  for (int i = 0; i < num_tasks; i++) {
+    scavengers[i] = new ParallelScavenger(&job);
+  }
+
+  // Kick off parallel tasks.
+  for (int i = 1; i < num_tasks; i++) {
+    V8::GetCurrentPlatform()->CallOnBackgroundThread(
+        new ParallelScavengeTask(&job, scavengers[i]),
+        v8::Platform::kShortRunningTask);
+  }
+
+  // Contribute in main thread, which is the only one allowed to visit the
+  // roots.
+  {
+    GCTracer::Scope gc_scope(heap()->tracer(),
+                             GCTracer::Scope::SCAVENGER_PARALLEL_ROOTS);
+    heap()->IterateRoots(scavengers[0]->visitor(), VISIT_ALL_IN_SCAVENGE);
+  }
+  scavengers[0]->Run();
+  for (int i = 1; i < num_tasks; i++) job.WaitForTask();
+
+  // Finalize sequentially.
+  StoreBuffer* store_buffer = heap()->store_buffer();
+  for (int i = 0; i < num_tasks; i++) {
+    ParallelScavenger* scavenger = scavengers[i];
+    scavenger->CloseAllocationBuffers();
+    // A task may have had nothing to copy or promote.
+    if (scavenger->semi_space_copied_size() > 0) {
+      heap()->IncrementSemiSpaceCopiedObjectSize(
+          scavenger->semi_space_copied_size());
+    }
+    if (scavenger->promoted_size() > 0) {
+      heap()->IncrementPromotedObjectsSize(scavenger->promoted_size());
+    }
+
+    List<Address>* slots = scavenger->old_to_new_slots();
+    for (int j = 0; j < slots->length(); j++) {
+      store_buffer->EnterDirectlyIntoStoreBuffer(slots->at(j));
+    }
+
+    List<AllocationSite*>* sites = scavenger->allocation_sites();
+    for (int j = 0; j < sites->length(); j++) {
+      AllocationSite* site = sites->at(j);
+      if (site->IncrementMementoFoundCount()) {
+        heap()->AddAllocationSiteToScratchpad(site,
+                                              Heap::IGNORE_SCRATCHPAD_SLOT);
+      }
+    }
+
+    List<JSArrayBuffer*>* buffers = scavenger->live_array_buffers();
+    for (int j = 0; j < buffers->length(); j++) {
+      heap()->array_buffer_tracker()->MarkLive(buffers->at(j));
+    }
+    buffers = scavenger->promoted_array_buffers();
+    for (int j = 0; j < buffers->length(); j++) {
+      heap()->array_buffer_tracker()->Promote(buffers->at(j));
+    }
+    delete scavenger;
+  }
+  delete[] scavengers;
+}
+
+
 Isolate* Scavenger::isolate() { return heap()->isolate(); }
 
 
@@ -33,10 +33,26 @@ class Scavenger {
   // of the heap (i.e. incremental marking, logging and profiling).
   void SelectScavengingVisitorsTable();
 
+  // Returns true if the roots and the old-to-new slots of the current
+  // scavenge can be processed by ScavengeInParallel, i.e. the flag is on,
+  // there is more than one core available and neither incremental marking
+  // nor logging and profiling need to observe the moved objects.
+  bool CanScavengeInParallel();
+
+  // Copies the objects reachable from the roots and from the old-to-new slots
+  // in the remembered set and everything transitively reachable from them,
+  // using several tasks. The tasks process disjoint parts of the remembered
+  // set and drop the slots that no longer point to new space; the slots of
+  // promoted objects are added to the remembered set before returning.
+  void ScavengeInParallel();
+
   Isolate* isolate();
   Heap* heap() { return heap_; }
 
  private:
+  bool IsLoggingOrProfiling();
+  int NumberOfParallelScavengeTasks();
+
   Heap* heap_;
   VisitorDispatchTable<ScavengingCallback> scavenging_visitors_table_;
 };
@@ -0,0 +1,166 @@
+// Copyright 2015 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_HEAP_SLOT_SET_H_
+#define V8_HEAP_SLOT_SET_H_
+
+#include "src/allocation.h"
+#include "src/base/bits.h"
+#include "src/globals.h"
+
+namespace v8 {
+namespace internal {
+
+// Data structure for maintaining a set of slots in a page-sized part of a
+// memory chunk. The start address of that part must be set with SetPageStart
+// before any other operation. Slots are pointer-size aligned; the valid slot
+// offsets [0, 1 << kPageSizeBits) are split into kBuckets buckets. A bucket is
+// a bitmap with one bit per slot offset and is allocated on the first insert
+// into it, so sets of pages with few recorded slots stay small.
+//
+// Insertion and removal take constant time. The set is not thread-safe, but
+// disjoint ranges of buckets can be iterated by different threads.
+class SlotSet : public Malloced {
+ public:
+  enum CallbackResult { KEEP_SLOT, REMOVE_SLOT };
+
+  SlotSet() : page_start_(NULL) {
+    for (int i = 0; i < kBuckets; i++) bucket_[i] = NULL;
+  }
+
+  ~SlotSet() {
+    for (int i = 0; i < kBuckets; i++) ReleaseBucket(i);
+  }
+
+  void SetPageStart(Address page_start) { page_start_ = page_start; }
+  Address page_start() { return page_start_; }
+
+  // The slot offset specifies a slot at address page_start_ + slot_offset.
+  void Insert(int slot_offset) {
+    int bucket_index, cell_index, bit_index;
+    SlotToIndices(slot_offset, &bucket_index, &cell_index, &bit_index);
+    if (bucket_[bucket_index] == NULL) {
+      bucket_[bucket_index] = AllocateBucket();
+    }
+    bucket_[bucket_index][cell_index] |= 1u << bit_index;
+  }
+
+  void Remove(int slot_offset) {
+    int bucket_index, cell_index, bit_index;
+    SlotToIndices(slot_offset, &bucket_index, &cell_index, &bit_index);
+    if (bucket_[bucket_index] != NULL) {
+      bucket_[bucket_index][cell_index] &= ~(1u << bit_index);
+    }
+  }
+
+  bool Lookup(int slot_offset) {
+    int bucket_index, cell_index, bit_index;
+    SlotToIndices(slot_offset, &bucket_index, &cell_index, &bit_index);
+    if (bucket_[bucket_index] == NULL) return false;
+    return (bucket_[bucket_index][cell_index] & (1u << bit_index)) != 0;
+  }
+
+  // Iterates over the slots in the buckets [start_bucket, end_bucket) and
+  // calls {callback} with the address of each slot. The callback returns
+  // either KEEP_SLOT or REMOVE_SLOT. Buckets that become empty are released.
+  // Slots inserted by the callback into a bucket that has not been visited
+  // yet are visited as well. Returns the number of slots that are kept.
+  //
+  // Sample usage:
+  // Iterate(&callback_object, 0, SlotSet::kBuckets) with
+  //   CallbackResult operator()(Address slot_address) {
+  //     if (good(slot_address)) return KEEP_SLOT;
+  //     else return REMOVE_SLOT;
+  //   }
+  template <typename Callback>
+  int Iterate(Callback* callback, int start_bucket, int end_bucket) {
+    DCHECK(0 <= start_bucket && start_bucket <= end_bucket &&
+           end_bucket <= kBuckets);
+    int new_count = 0;
+    for (int bucket_index = start_bucket; bucket_index < end_bucket;
+         bucket_index++) {
+      uint32_t* bucket = bucket_[bucket_index];
+      if (bucket == NULL) continue;
+      int in_bucket_count = 0;
+      int cell_offset = bucket_index * kBitsPerBucket;
+      for (int i = 0; i < kCellsPerBucket; i++, cell_offset += kBitsPerCell) {
+        uint32_t cell = bucket[i];
+        if (cell == 0) continue;
+        uint32_t removed = 0;
+        while (cell != 0) {
+          int bit_offset = base::bits::CountTrailingZeros32(cell);
+          uint32_t bit_mask = 1u << bit_offset;
+          cell ^= bit_mask;
+          Address slot = page_start_ + ((cell_offset + bit_offset)
+                                        << kPointerSizeLog2);
+          if ((*callback)(slot) == KEEP_SLOT) {
+            in_bucket_count++;
+          } else {
+            removed |= bit_mask;
+          }
+        }
+        // Clear only the removed bits, the callback may have added slots to
+        // this cell in the meantime.
+        if (removed != 0) bucket[i] &= ~removed;
+      }
+      if (in_bucket_count == 0 && IsBucketEmpty(bucket)) {
+        ReleaseBucket(bucket_index);
+      }
+      new_count += in_bucket_count;
+    }
+    return new_count;
+  }
+
+  template <typename Callback>
+  int Iterate(Callback* callback) {
+    return Iterate(callback, 0, kBuckets);
+  }
+
+  static const int kMaxSlots = (1 << kPageSizeBits) / kPointerSize;
+  static const int kCellsPerBucket = 32;
+  static const int kCellsPerBucketLog2 = 5;
+  static const int kBitsPerCell = 32;
+  static const int kBitsPerCellLog2 = 5;
+  static const int kBitsPerBucket = kCellsPerBucket * kBitsPerCell;
+  static const int kBitsPerBucketLog2 = kCellsPerBucketLog2 + kBitsPerCellLog2;
+  static const int kBuckets = kMaxSlots / kCellsPerBucket / kBitsPerCell;
+
+ private:
+  uint32_t* AllocateBucket() {
+    uint32_t* result = NewArray<uint32_t>(kCellsPerBucket);
+    for (int i = 0; i < kCellsPerBucket; i++) result[i] = 0;
+    return result;
+  }
+
+  void ReleaseBucket(int bucket_index) {
+    DeleteArray<uint32_t>(bucket_[bucket_index]);
+    bucket_[bucket_index] = NULL;
+  }
+
+  static bool IsBucketEmpty(uint32_t* bucket) {
+    for (int i = 0; i < kCellsPerBucket; i++) {
+      if (bucket[i] != 0) return false;
+    }
+    return true;
+  }
+
+  // Converts the slot offset into bucket/cell/bit index.
+  static void SlotToIndices(int slot_offset, int* bucket_index, int* cell_index,
+                            int* bit_index) {
+    DCHECK_EQ(slot_offset % kPointerSize, 0);
+    DCHECK(0 <= slot_offset && slot_offset < (1 << kPageSizeBits));
+    int slot = slot_offset >> kPointerSizeLog2;
+    *bucket_index = slot >> kBitsPerBucketLog2;
+    *cell_index = (slot >> kBitsPerCellLog2) & (kCellsPerBucket - 1);
+    *bit_index = slot & (kBitsPerCell - 1);
+  }
+
+  uint32_t* bucket_[kBuckets];
+  Address page_start_;
+};
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_HEAP_SLOT_SET_H_
@@ -7,6 +7,7 @@
 #include "src/base/bits.h"
 #include "src/base/platform/platform.h"
 #include "src/full-codegen/full-codegen.h"
+#include "src/heap/slot-set.h"
 #include "src/heap/slots-buffer.h"
 #include "src/macro-assembler.h"
 #include "src/msan.h"
@@ -466,6 +467,7 @@ MemoryChunk* MemoryChunk::Initialize(Heap* heap, Address base, size_t size,
   chunk->InitializeReservedMemory();
   chunk->slots_buffer_ = NULL;
   chunk->skip_list_ = NULL;
+  chunk->old_to_new_slots_ = NULL;
   chunk->write_barrier_counter_ = kWriteBarrierCounterGranularity;
   chunk->progress_bar_ = 0;
   chunk->high_water_mark_.SetValue(static_cast<intptr_t>(area_start - base));
@@ -568,6 +570,43 @@ void MemoryChunk::Unlink() {
 }
 
 
+// Returns whether a chunk of {owner} should be backed by huge pages. Only whole
+// huge pages inside a chunk can be, so regular pages need a page size of at
+// least base::VirtualMemory::kHugePageSize and large object chunks need to be
+// at least that large. Other chunks would only waste address space on the
+// huge page alignment.
+static bool ShouldUseHugePages(Space* owner, intptr_t reserve_area_size) {
+  if (!FLAG_huge_pages || owner == NULL) return false;
+  const intptr_t huge_page_size =
+      static_cast<intptr_t>(base::VirtualMemory::kHugePageSize);
+  switch (owner->identity()) {
+    case OLD_SPACE:
+    case CODE_SPACE:
+      return Page::kPageSize >= huge_page_size;
+    case LO_SPACE:
+      return reserve_area_size >= huge_page_size;
+    default:
+      return false;
+  }
+}
+
+
+// Backs the huge pages that fit in [start, end) with huge pages. The range
+// must be committed and must not be uncommitted or guarded in parts later on,
+// which would split the huge pages again.
+static void UseHugePagesInRange(Address start, Address end,
+                                Executability executable) {
+  const intptr_t huge_page_size =
+      static_cast<intptr_t>(base::VirtualMemory::kHugePageSize);
+  Address huge_start = RoundUp(start, huge_page_size);
+  Address huge_end = RoundDown(end, huge_page_size);
+  if (huge_start >= huge_end) return;
+  base::VirtualMemory::UseHugePages(
+      huge_start, static_cast<size_t>(huge_end - huge_start),
+      executable == EXECUTABLE, FLAG_explicit_huge_pages);
+}
+
+
 MemoryChunk* MemoryAllocator::AllocateChunk(intptr_t reserve_area_size,
                                             intptr_t commit_area_size,
                                             Executability executable,
@@ -580,6 +619,13 @@ MemoryChunk* MemoryAllocator::AllocateChunk(intptr_t reserve_area_size,
   base::VirtualMemory reservation;
   Address area_start = NULL;
   Address area_end = NULL;
+  const bool use_huge_pages = ShouldUseHugePages(owner, reserve_area_size);
+  // Reservations for huge pages start at a huge page boundary, so large
+  // object chunks get as many huge pages as possible.
+  const size_t alignment =
+      use_huge_pages ? Max(static_cast<size_t>(MemoryChunk::kAlignment),
+                           base::VirtualMemory::kHugePageSize)
+                     : static_cast<size_t>(MemoryChunk::kAlignment);
 
   //
   // MemoryChunk layout:
@@ -646,14 +692,21 @@ MemoryChunk* MemoryAllocator::AllocateChunk(intptr_t reserve_area_size,
       // Update executable memory size.
       size_executable_.Increment(static_cast<intptr_t>(chunk_size));
     } else {
-      base = AllocateAlignedMemory(chunk_size, commit_size,
-                                   MemoryChunk::kAlignment, executable,
-                                   &reservation);
+      base = AllocateAlignedMemory(chunk_size, commit_size, alignment,
+                                   executable, &reservation);
       if (base == NULL) return NULL;
       // Update executable memory size.
       size_executable_.Increment(static_cast<intptr_t>(reservation.size()));
     }
 
+    if (use_huge_pages) {
+      // Only the committed body; the header and the guard pages keep their
+      // regular pages.
+      Address body = base + CodePageAreaStartOffset();
+      UseHugePagesInRange(body, body + commit_size - CodePageGuardStartOffset(),
+                          executable);
+    }
+
     if (Heap::ShouldZapGarbage()) {
       ZapBlock(base, CodePageGuardStartOffset());
       ZapBlock(base + CodePageAreaStartOffset(), commit_area_size);
@@ -667,12 +720,15 @@ MemoryChunk* MemoryAllocator::AllocateChunk(intptr_t reserve_area_size,
     size_t commit_size =
         RoundUp(MemoryChunk::kObjectStartOffset + commit_area_size,
                 base::OS::CommitPageSize());
-    base =
-        AllocateAlignedMemory(chunk_size, commit_size, MemoryChunk::kAlignment,
-                              executable, &reservation);
+    base = AllocateAlignedMemory(chunk_size, commit_size, alignment,
+                                 executable, &reservation);
 
     if (base == NULL) return NULL;
 
+    if (use_huge_pages) {
+      UseHugePagesInRange(base, base + commit_size, executable);
+    }
+
     if (Heap::ShouldZapGarbage()) {
       ZapBlock(base, Page::kObjectStartOffset + commit_area_size);
     }
@@ -934,6 +990,29 @@ void MemoryChunk::ReleaseAllocatedMemory() {
   delete slots_buffer_;
   delete skip_list_;
   delete mutex_;
+  ReleaseOldToNewSlots();
+}
+
+
+static SlotSet* AllocateSlotSet(int pages, Address page_start) {
+  DCHECK(pages > 0);
+  SlotSet* slot_set = new SlotSet[pages];
+  for (int i = 0; i < pages; i++) {
+    slot_set[i].SetPageStart(page_start + i * Page::kPageSize);
+  }
+  return slot_set;
+}
+
+
+void MemoryChunk::AllocateOldToNewSlots() {
+  DCHECK(old_to_new_slots_ == NULL);
+  old_to_new_slots_ = AllocateSlotSet(NumberOfSlotSets(), address());
+}
+
+
+void MemoryChunk::ReleaseOldToNewSlots() {
+  delete[] old_to_new_slots_;
+  old_to_new_slots_ = NULL;
 }
 
 
@@ -1143,11 +1222,6 @@ void PagedSpace::ReleasePage(Page* page) {
     DCHECK_EQ(AreaSize(), static_cast<int>(size));
   }
 
-  if (page->IsFlagSet(MemoryChunk::SCAN_ON_SCAVENGE)) {
-    heap()->decrement_scan_on_scavenge_pages();
-    page->ClearFlag(MemoryChunk::SCAN_ON_SCAVENGE);
-  }
-
   DCHECK(!free_list_.ContainsPageFreeListItems(page));
 
   if (Page::FromAllocationTop(allocation_info_.top()) == page) {
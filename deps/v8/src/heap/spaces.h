@@ -129,6 +129,29 @@ class MarkBit {
   inline bool Get() { return (*cell_ & mask_) != 0; }
   inline void Clear() { *cell_ &= ~mask_; }
 
+  // Variants of Set and Clear that can race with other threads updating
+  // different bits of the same cell. SetAtomic returns false if the bit was
+  // already set.
+  inline bool SetAtomic() {
+    base::Atomic32* cell = reinterpret_cast<base::Atomic32*>(cell_);
+    base::Atomic32 old_value;
+    do {
+      old_value = base::NoBarrier_Load(cell);
+      if ((old_value & mask_) != 0) return false;
+    } while (base::Release_CompareAndSwap(cell, old_value,
+                                          old_value | mask_) != old_value);
+    return true;
+  }
+
+  inline void ClearAtomic() {
+    base::Atomic32* cell = reinterpret_cast<base::Atomic32*>(cell_);
+    base::Atomic32 old_value;
+    do {
+      old_value = base::NoBarrier_Load(cell);
+    } while (base::Release_CompareAndSwap(cell, old_value,
+                                          old_value & ~mask_) != old_value);
+  }
+
   CellType* cell_;
   CellType mask_;
 
@@ -281,6 +304,7 @@ class Bitmap {
 
 
 class SkipList;
+class SlotSet;
 class SlotsBuffer;
 
 // MemoryChunk represents a memory region owned by a specific space.
@@ -294,6 +318,8 @@ class MemoryChunk {
     ABOUT_TO_BE_FREED,
     POINTERS_TO_HERE_ARE_INTERESTING,
     POINTERS_FROM_HERE_ARE_INTERESTING,
+    // Set on new space pages. The write barrier does not record slots on
+    // these pages.
     SCAN_ON_SCAVENGE,
     IN_FROM_SPACE,  // Mutually exclusive with IN_TO_SPACE.
     IN_TO_SPACE,    // All pages in new space has one of these two set.
@@ -384,15 +410,15 @@ class MemoryChunk {
       + kPointerSize              // Address area_end_
       + 2 * kPointerSize          // base::VirtualMemory reservation_
       + kPointerSize              // Address owner_
-      + kPointerSize              // Heap* heap_
-      + kIntSize;                 // int store_buffer_counter_
+      + kPointerSize;             // Heap* heap_
 
   static const size_t kSlotsBufferOffset =
-      kLiveBytesOffset + kIntSize;  // int live_byte_count_
+      kLiveBytesOffset + kPointerSize;  // int live_byte_count_ (padded)
 
   static const size_t kWriteBarrierCounterOffset =
       kSlotsBufferOffset + kPointerSize  // SlotsBuffer* slots_buffer_;
-      + kPointerSize;                    // SkipList* skip_list_;
+      + kPointerSize                     // SkipList* skip_list_;
+      + kPointerSize;                    // SlotSet* old_to_new_slots_;
 
   static const size_t kMinHeaderSize =
       kWriteBarrierCounterOffset +
@@ -506,12 +532,15 @@ class MemoryChunk {
       ClearFlag(SCAN_ON_SCAVENGE);
     }
   }
-  inline void set_scan_on_scavenge(bool scan);
 
-  int store_buffer_counter() { return store_buffer_counter_; }
-  void set_store_buffer_counter(int counter) {
-    store_buffer_counter_ = counter;
+  // The remembered set of slots on this chunk that may point to new space.
+  // Large object chunks have one slot set per Page::kPageSize of their size.
+  inline SlotSet* old_to_new_slots() { return old_to_new_slots_; }
+  int NumberOfSlotSets() {
+    return static_cast<int>((size_ + kAlignment - 1) >> kPageSizeBits);
   }
+  void AllocateOldToNewSlots();
+  void ReleaseOldToNewSlots();
 
   bool Contains(Address addr) {
     return addr >= area_start() && addr < area_end();
@@ -593,6 +622,11 @@ class MemoryChunk {
     live_byte_count_ += by;
     DCHECK_LE(static_cast<unsigned>(live_byte_count_), size_);
   }
+  // Used by marking tasks running in parallel.
+  void IncrementLiveBytesAtomic(int by) {
+    base::NoBarrier_AtomicIncrement(
+        reinterpret_cast<base::Atomic32*>(&live_byte_count_), by);
+  }
   int LiveBytes() {
     DCHECK(static_cast<unsigned>(live_byte_count_) <= size_);
     return live_byte_count_;
@@ -734,13 +768,11 @@ class MemoryChunk {
   // in a fixed array.
   Address owner_;
   Heap* heap_;
-  // Used by the store buffer to keep track of which pages to mark scan-on-
-  // scavenge.
-  int store_buffer_counter_;
   // Count of bytes marked black on page.
   int live_byte_count_;
   SlotsBuffer* slots_buffer_;
   SkipList* skip_list_;
+  SlotSet* old_to_new_slots_;
   intptr_t write_barrier_counter_;
   // Used by the incremental marker to keep track of the scanning progress in
   // large objects that have a progress bar and are scanned in increments.
@@ -2645,6 +2677,11 @@ class NewSpace : public Space {
   MUST_USE_RESULT INLINE(AllocationResult AllocateRaw(
       int size_in_bytes, AllocationAlignment alignment));
 
+  // Same as AllocateRaw, but may be called from several threads at once, e.g.
+  // by the tasks of a parallel scavenge refilling their local buffers.
+  MUST_USE_RESULT inline AllocationResult AllocateRawSynchronized(
+      int size_in_bytes, AllocationAlignment alignment);
+
   // Reset the allocation pointer to the beginning of the active semispace.
   void ResetAllocationInfo();
 
@@ -2758,6 +2795,9 @@ class NewSpace : public Space {
   HistogramInfo* allocated_histogram_;
   HistogramInfo* promoted_histogram_;
 
+  // Guards allocation_info_ in AllocateRawSynchronized.
+  base::Mutex mutex_;
+
   bool EnsureAllocation(int size_in_bytes, AllocationAlignment alignment);
 
   // If we are doing inline allocation in steps, this method performs the 'step'
@@ -19,7 +19,7 @@ void StoreBuffer::Mark(Address addr) {
   heap_->set_store_buffer_top(reinterpret_cast<Smi*>(top));
   if ((reinterpret_cast<uintptr_t>(top) & kStoreBufferOverflowBit) != 0) {
     DCHECK(top == limit_);
-    Compact();
+    MoveEntriesToRememberedSet();
   } else {
     DCHECK(top < limit_);
   }
@@ -33,20 +33,21 @@ inline void StoreBuffer::MarkSynchronized(Address addr) {
 
 
 void StoreBuffer::EnterDirectlyIntoStoreBuffer(Address addr) {
-  if (store_buffer_rebuilding_enabled_) {
-    SLOW_DCHECK(!heap_->code_space()->Contains(addr) &&
-                !heap_->new_space()->Contains(addr));
-    Address* top = old_top_;
-    *top++ = addr;
-    old_top_ = top;
-    old_buffer_is_sorted_ = false;
-    old_buffer_is_filtered_ = false;
-    if (top >= old_limit_) {
-      DCHECK(callback_ != NULL);
-      (*callback_)(heap_, MemoryChunk::FromAnyPointerAddress(heap_, addr),
-                   kStoreBufferFullEvent);
-    }
+  SLOW_DCHECK(!heap_->code_space()->Contains(addr) &&
+              !heap_->new_space()->Contains(addr));
+  InsertIntoRememberedSet(MemoryChunk::FromAnyPointerAddress(heap_, addr),
+                          addr);
+}
+
+
+void StoreBuffer::InsertIntoRememberedSet(MemoryChunk* chunk, Address addr) {
+  DCHECK(chunk->Contains(addr));
+  if (chunk->old_to_new_slots() == NULL) {
+    chunk->AllocateOldToNewSlots();
   }
+  uintptr_t offset = addr - chunk->address();
+  chunk->old_to_new_slots()[offset >> kPageSizeBits].Insert(
+      static_cast<int>(offset & Page::kPageAlignmentMask));
 }
 }  // namespace internal
 }  // namespace v8
@@ -1465,6 +1465,17 @@ void HeapObject::synchronized_set_map_word(MapWord map_word) {
 }
 
 
+bool HeapObject::synchronized_compare_and_swap_map_word(MapWord old_map_word,
+                                                        MapWord new_map_word) {
+  base::AtomicWord old_value =
+      static_cast<base::AtomicWord>(old_map_word.value_);
+  return base::Release_CompareAndSwap(
+             reinterpret_cast<base::AtomicWord*>(FIELD_ADDR(this, kMapOffset)),
+             old_value, static_cast<base::AtomicWord>(new_map_word.value_)) ==
+         old_value;
+}
+
+
 int HeapObject::Size() {
   return SizeFromMap(map());
 }
@@ -18,6 +18,7 @@
   V(ObjectGroups)            \
   V(Promotion)               \
   V(Regression39128)         \
+  V(RememberedSet)           \
   V(ResetWeakHandle)         \
   V(StressHandles)           \
   V(TestSizeOfObjects)       \
@@ -492,6 +492,123 @@ TEST(GarbageCollection) {
 }
 
 
+TEST(ParallelScavenge) {
+  i::FLAG_parallel_scavenge = true;
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Heap* heap = isolate->heap();
+  Factory* factory = isolate->factory();
+  HandleScope sc(isolate);
+
+  // An old-space array whose elements are new-space arrays: these are only
+  // reachable through the store buffer.
+  const int kLength = 256;
+  Handle<FixedArray> old_array = factory->NewFixedArray(kLength, TENURED);
+  CHECK(!heap->InNewSpace(*old_array));
+  for (int i = 0; i < kLength; i++) {
+    HandleScope inner_scope(isolate);
+    Handle<FixedArray> young = factory->NewFixedArray(2);
+    young->set(0, Smi::FromInt(i));
+    young->set(1, *factory->NewHeapNumber(i + 0.5));
+    old_array->set(i, *young);
+  }
+  // A new-space array that is only reachable from a handle, sharing the
+  // elements of the old-space array.
+  Handle<FixedArray> young_array = factory->NewFixedArray(kLength);
+  for (int i = 0; i < kLength; i++) young_array->set(i, old_array->get(i));
+
+  // The first scavenge copies everything within new space, the second one
+  // promotes it.
+  for (int gc = 0; gc < 2; gc++) {
+    heap->CollectGarbage(NEW_SPACE);
+    for (int i = 0; i < kLength; i++) {
+      FixedArray* young = FixedArray::cast(old_array->get(i));
+      CHECK_EQ(young, young_array->get(i));
+      CHECK_EQ(Smi::FromInt(i), young->get(0));
+      CHECK_EQ(i + 0.5, HeapNumber::cast(young->get(1))->value());
+    }
+  }
+#ifdef VERIFY_HEAP
+  heap->Verify();
+#endif
+}
+
+
+// Fills an old-space array with objects of the kinds marked by parallel
+// marking tasks, mixed with objects they hand back to the main thread.
+static Handle<FixedArray> AllocateParallelMarkingGraph(Isolate* isolate,
+                                                       int length) {
+  Factory* factory = isolate->factory();
+  Handle<FixedArray> roots = factory->NewFixedArray(length, TENURED);
+  Handle<JSFunction> function = factory->NewFunction(factory->empty_string());
+  for (int i = 0; i < length; i++) {
+    HandleScope inner_scope(isolate);
+    Handle<FixedArray> array = factory->NewFixedArray(8, TENURED);
+    array->set(0, Smi::FromInt(i));
+    array->set(1, *factory->NewHeapNumber(i + 0.5, IMMUTABLE, TENURED));
+    array->set(2, *factory->NewJSObject(function, TENURED));
+    array->set(3, *factory->NewConsString(factory->NewStringFromAsciiChecked(
+                                              "parallel marking "),
+                                          factory->NumberToString(
+                                              factory->NewNumberFromInt(i)))
+                       .ToHandleChecked());
+    array->set(4, *factory->NewFixedArray(16));
+    // Garbage between the live objects.
+    factory->NewFixedArray(8, TENURED);
+    roots->set(i, *array);
+  }
+  return roots;
+}
+
+
+static void CheckParallelMarkingGraph(Heap* heap, Handle<FixedArray> roots) {
+  for (int i = 0; i < roots->length(); i++) {
+    FixedArray* array = FixedArray::cast(roots->get(i));
+    CHECK_EQ(Smi::FromInt(i), array->get(0));
+    CHECK_EQ(i + 0.5, HeapNumber::cast(array->get(1))->value());
+    CHECK(array->get(2)->IsJSObject());
+    CHECK(String::cast(array->get(3))->length() > 0);
+    CHECK_EQ(16, FixedArray::cast(array->get(4))->length());
+  }
+#ifdef VERIFY_HEAP
+  heap->Verify();
+#endif
+}
+
+
+TEST(ParallelIncrementalMarking) {
+  i::FLAG_parallel_incremental_marking = true;
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Heap* heap = isolate->heap();
+  HandleScope sc(isolate);
+
+  // Enough objects to make the steps large enough to be split.
+  Handle<FixedArray> roots = AllocateParallelMarkingGraph(isolate, 4096);
+  SimulateIncrementalMarking(heap);
+  heap->CollectAllGarbage();
+  CheckParallelMarkingGraph(heap, roots);
+}
+
+
+TEST(ParallelMarking) {
+  i::FLAG_parallel_marking = true;
+  i::FLAG_incremental_marking = false;
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Heap* heap = isolate->heap();
+  HandleScope sc(isolate);
+
+  Handle<FixedArray> roots = AllocateParallelMarkingGraph(isolate, 4096);
+  // Collections that reduce the memory footprint compact fragmented pages,
+  // which makes the tasks record slots.
+  for (int gc = 0; gc < 2; gc++) {
+    heap->CollectAllGarbage(Heap::kReduceMemoryFootprintMask);
+    CheckParallelMarkingGraph(heap, roots);
+  }
+}
+
+
 static void VerifyStringAllocation(Isolate* isolate, const char* string) {
   HandleScope scope(isolate);
   Handle<String> s = isolate->factory()->NewStringFromUtf8(
@@ -4176,6 +4293,9 @@ TEST(Regress165495) {
 TEST(Regress169209) {
   i::FLAG_stress_compaction = false;
   i::FLAG_allow_natives_syntax = true;
+  // The candidate list below depends on the order in which the marking deque
+  // is processed, which parallel steps do not preserve.
+  i::FLAG_parallel_incremental_marking = false;
 
   CcTest::InitializeVM();
   Isolate* isolate = CcTest::i_isolate();
@@ -4622,6 +4742,84 @@ TEST(LargeObjectSlotRecording) {
 }
 
 
+TEST(ParallelPointersUpdating) {
+  FLAG_parallel_compaction = true;
+  FLAG_manual_evacuation_candidates_selection = true;
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Heap* heap = isolate->heap();
+  Factory* factory = isolate->factory();
+  HandleScope scope(isolate);
+  const int kLength = 1024;
+
+  // Old-to-new pointers go through the store buffer, new-to-new pointers are
+  // found in to-space and pointers to the evacuation candidate are recorded
+  // in slots buffers.
+  Handle<FixedArray> old_holder =
+      factory->NewFixedArray(kLength + 1, TENURED);
+  Handle<FixedArray> young_holder = factory->NewFixedArray(kLength + 1);
+  SimulateFullSpace(heap->old_space());
+  Handle<FixedArray> lit = factory->NewFixedArray(kLength, TENURED);
+  Page* evac_page = Page::FromAddress(lit->address());
+  evac_page->SetFlag(MemoryChunk::FORCE_EVACUATION_CANDIDATE_FOR_TESTING);
+  FixedArray* old_location = *lit;
+
+  for (int i = 0; i < kLength; i++) {
+    Handle<HeapNumber> number = factory->NewHeapNumber(i);
+    old_holder->set(i, *number);
+    young_holder->set(i, *number);
+    lit->set(i, *number);
+  }
+  old_holder->set(kLength, *lit);
+  young_holder->set(kLength, *lit);
+
+  heap->CollectAllGarbage();
+
+  CHECK(*lit != old_location);
+  CHECK_EQ(*lit, old_holder->get(kLength));
+  CHECK_EQ(*lit, young_holder->get(kLength));
+  for (int i = 0; i < kLength; i++) {
+    Object* number = old_holder->get(i);
+    CHECK_EQ(static_cast<double>(i), HeapNumber::cast(number)->value());
+    CHECK_EQ(number, young_holder->get(i));
+    CHECK_EQ(number, lit->get(i));
+  }
+}
+
+
+HEAP_TEST(RememberedSet) {
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  v8::HandleScope scope(CcTest::isolate());
+
+  Handle<FixedArray> old_array = factory->NewFixedArray(2, TENURED);
+  Handle<HeapNumber> number = factory->NewHeapNumber(42.5);
+  CHECK(heap->InNewSpace(*number));
+  old_array->set(0, *number);
+  old_array->set(1, *number);
+  Address slot = old_array->address() + FixedArray::OffsetOfElementAt(0);
+  Address stale_slot =
+      old_array->address() + FixedArray::OffsetOfElementAt(1);
+
+  // The write barrier recorded the slots. They stay in the remembered set as
+  // long as they point to new space, and are dropped once the number is
+  // promoted or the slot is overwritten.
+  CHECK(heap->store_buffer()->Contains(slot));
+  CHECK(heap->store_buffer()->Contains(stale_slot));
+  old_array->set(1, Smi::FromInt(0));
+  for (int i = 0; i < 3; i++) {
+    heap->CollectGarbage(NEW_SPACE);
+    CHECK_EQ(*number, old_array->get(0));
+    CHECK_EQ(heap->InNewSpace(*number), heap->store_buffer()->Contains(slot));
+    CHECK(!heap->store_buffer()->Contains(stale_slot));
+  }
+  CHECK(!heap->InNewSpace(*number));
+  CHECK_EQ(42.5, number->value());
+}
+
+
 class DummyVisitor : public ObjectVisitor {
  public:
   void VisitPointers(Object** start, Object** end) { }
@@ -1393,10 +1393,6 @@ TEST(StoreBufferScanOnScavenge) {
   Handle<HeapNumber> boom_number = factory->NewHeapNumber(boom_value, MUTABLE);
   obj->FastPropertyAtPut(field_index, *boom_number);
 
-  // Enforce scan on scavenge for the obj's page.
-  MemoryChunk* chunk = MemoryChunk::FromAddress(obj->address());
-  chunk->set_scan_on_scavenge(true);
-
   // Trigger GCs and force evacuation. Should not crash there.
   CcTest::heap()->CollectAllGarbage();
 
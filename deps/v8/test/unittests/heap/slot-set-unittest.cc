@@ -0,0 +1,160 @@
+// Copyright 2015 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/globals.h"
+#include "src/heap/slot-set.h"
+#include "src/heap/spaces.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace v8 {
+namespace internal {
+
+TEST(SlotSet, InsertAndLookup1) {
+  SlotSet set;
+  set.SetPageStart(0);
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    EXPECT_FALSE(set.Lookup(i));
+  }
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    set.Insert(i);
+  }
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    EXPECT_TRUE(set.Lookup(i));
+  }
+}
+
+
+TEST(SlotSet, InsertAndLookup2) {
+  SlotSet set;
+  set.SetPageStart(0);
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    if (i % 7 == 0) {
+      set.Insert(i);
+    }
+  }
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    if (i % 7 == 0) {
+      EXPECT_TRUE(set.Lookup(i));
+    } else {
+      EXPECT_FALSE(set.Lookup(i));
+    }
+  }
+}
+
+
+class KeepMultiplesOfThree {
+ public:
+  KeepMultiplesOfThree() : visited_(0) {}
+
+  SlotSet::CallbackResult operator()(Address slot_address) {
+    visited_++;
+    uintptr_t intaddr = reinterpret_cast<uintptr_t>(slot_address);
+    if (intaddr % 3 == 0) return SlotSet::KEEP_SLOT;
+    return SlotSet::REMOVE_SLOT;
+  }
+
+  int visited() { return visited_; }
+
+ private:
+  int visited_;
+};
+
+
+TEST(SlotSet, Iterate) {
+  SlotSet set;
+  set.SetPageStart(0);
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    if (i % 7 == 0) {
+      set.Insert(i);
+    }
+  }
+
+  KeepMultiplesOfThree callback;
+  int kept = set.Iterate(&callback);
+  int expected_visited = 0;
+  int expected_kept = 0;
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    if (i % 7 == 0) {
+      expected_visited++;
+      if (i % 3 == 0) expected_kept++;
+    }
+  }
+  EXPECT_EQ(expected_visited, callback.visited());
+  EXPECT_EQ(expected_kept, kept);
+
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    if (i % 21 == 0) {
+      EXPECT_TRUE(set.Lookup(i));
+    } else {
+      EXPECT_FALSE(set.Lookup(i));
+    }
+  }
+}
+
+
+class KeepSlots {
+ public:
+  KeepSlots() : visited_(0) {}
+
+  SlotSet::CallbackResult operator()(Address slot_address) {
+    visited_++;
+    return SlotSet::KEEP_SLOT;
+  }
+
+  int visited() { return visited_; }
+
+ private:
+  int visited_;
+};
+
+
+TEST(SlotSet, IterateBucketRanges) {
+  SlotSet set;
+  set.SetPageStart(0);
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    set.Insert(i);
+  }
+  // Disjoint ranges of buckets together cover every slot exactly once.
+  const int kBucketsPerRange = 16;
+  KeepSlots callback;
+  int kept = 0;
+  for (int start = 0; start < SlotSet::kBuckets; start += kBucketsPerRange) {
+    int end = start + kBucketsPerRange;
+    if (end > SlotSet::kBuckets) end = SlotSet::kBuckets;
+    kept += set.Iterate(&callback, start, end);
+  }
+  // EXPECT_EQ takes its arguments by reference, which would need a definition
+  // of the static constant.
+  int max_slots = SlotSet::kMaxSlots;
+  EXPECT_EQ(max_slots, kept);
+  EXPECT_EQ(max_slots, callback.visited());
+}
+
+
+TEST(SlotSet, Remove) {
+  SlotSet set;
+  set.SetPageStart(0);
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    if (i % 7 == 0) {
+      set.Insert(i);
+    }
+  }
+
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    if (i % 3 != 0) {
+      set.Remove(i);
+    }
+  }
+
+  for (int i = 0; i < Page::kPageSize; i += kPointerSize) {
+    if (i % 21 == 0) {
+      EXPECT_TRUE(set.Lookup(i));
+    } else {
+      EXPECT_FALSE(set.Lookup(i));
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace v8